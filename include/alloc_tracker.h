@@ -0,0 +1,235 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+   @file alloc_tracker.h
+
+   Registry of the live allocations made through the QUDA allocators,
+   shared by the target malloc implementations.  It is safe to
+   allocate and free from concurrent host threads: entries are spread
+   over independently locked shards chosen by pointer hash, each an
+   open-addressing table with O(1) insert and erase, and the per-type
+   byte counters and their high-water marks are atomics.
+ */
+
+namespace quda
+{
+
+  enum AllocType { DEVICE, DEVICE_PINNED, HOST, PINNED, MAPPED, MANAGED, N_ALLOC_TYPE };
+
+  /**
+     Record of a single allocation.  The call site is held as the
+     string pointers passed by the allocation macros (__func__ and
+     file_name(__FILE__)), which have static storage duration, so the
+     strings are interned by the compiler and a record is trivially
+     cheap to copy.
+   */
+  struct MemAlloc {
+    const char *func;
+    const char *file;
+    int line;
+    size_t size;
+    size_t base_size;
+#ifdef QUDA_BACKWARDSCPP
+    backward::StackTrace st;
+#endif
+
+    MemAlloc() : func(""), file(""), line(-1), size(0), base_size(0) {}
+
+    MemAlloc(const char *func, const char *file, int line) : func(func), file(file), line(line), size(0), base_size(0)
+    {
+#ifdef QUDA_BACKWARDSCPP
+      st.load_here(32);
+      st.skip_n_firsts(1);
+#endif
+    }
+  };
+
+  class AllocTracker
+  {
+    /** slot of a shard's open-addressing table; a null ptr marks an empty slot */
+    struct Slot {
+      void *ptr;
+      AllocType type;
+      MemAlloc a;
+      Slot() : ptr(nullptr), type(N_ALLOC_TYPE) { }
+    };
+
+    static constexpr int n_shard = 64;
+
+    /** each shard is padded to its own cache line to avoid false sharing */
+    struct alignas(64) Shard {
+      std::mutex mutex;
+      std::vector<Slot> slot; // linear probing, kept at most half full
+      size_t size = 0;
+    };
+
+    Shard shard[n_shard];
+    std::atomic<long> count[N_ALLOC_TYPE];
+    std::atomic<long> total_bytes[N_ALLOC_TYPE];
+    std::atomic<long> max_total_bytes[N_ALLOC_TYPE];
+    std::atomic<long> total_host_bytes;
+    std::atomic<long> max_total_host_bytes;
+    std::atomic<long> total_pinned_bytes;
+    std::atomic<long> max_total_pinned_bytes;
+
+    /** Fibonacci hashing so that aligned pointers spread evenly: the
+        top bits select the shard, the middle bits the home slot */
+    static uint64_t hash(const void *ptr) { return reinterpret_cast<uintptr_t>(ptr) * 0x9E3779B97F4A7C15ull; }
+    Shard &shardOf(const void *ptr) { return shard[hash(ptr) >> 58]; }
+    static size_t home(const Shard &s, const void *ptr) { return (hash(ptr) >> 26) & (s.slot.size() - 1); }
+
+    /** @return The slot holding ptr, or the empty slot where it would go */
+    static size_t probe(const Shard &s, const void *ptr)
+    {
+      const size_t mask = s.slot.size() - 1;
+      size_t i = home(s, ptr);
+      while (s.slot[i].ptr && s.slot[i].ptr != ptr) i = (i + 1) & mask;
+      return i;
+    }
+
+    static void grow(Shard &s)
+    {
+      std::vector<Slot> old(std::max<size_t>(16, 2 * s.slot.size()));
+      std::swap(old, s.slot);
+      for (auto &o : old)
+        if (o.ptr) s.slot[probe(s, o.ptr)] = o;
+    }
+
+    /** remove slot i, shifting back the entries of its probe chain so no tombstones are needed */
+    static void remove(Shard &s, size_t i)
+    {
+      const size_t mask = s.slot.size() - 1;
+      for (size_t j = (i + 1) & mask; s.slot[j].ptr; j = (j + 1) & mask) {
+        size_t k = home(s, s.slot[j].ptr);
+        // move slot j into the hole unless its home lies cyclically in (i, j]
+        if ((j > i && (k <= i || k > j)) || (j < i && k <= i && k > j)) {
+          s.slot[i] = s.slot[j];
+          i = j;
+        }
+      }
+      s.slot[i] = Slot();
+      s.size--;
+    }
+
+    static void add(std::atomic<long> &total, std::atomic<long> &max_total, long bytes)
+    {
+      long t = total.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+      long m = max_total.load(std::memory_order_relaxed);
+      while (t > m && !max_total.compare_exchange_weak(m, t, std::memory_order_relaxed)) { }
+    }
+
+    void account(AllocType type, long n, long bytes)
+    {
+      count[type].fetch_add(n, std::memory_order_relaxed);
+      add(total_bytes[type], max_total_bytes[type], bytes);
+      if (type != DEVICE && type != DEVICE_PINNED) add(total_host_bytes, max_total_host_bytes, bytes);
+      if (type == PINNED || type == MAPPED) add(total_pinned_bytes, max_total_pinned_bytes, bytes);
+    }
+
+  public:
+    AllocTracker() : total_host_bytes(0), max_total_host_bytes(0), total_pinned_bytes(0), max_total_pinned_bytes(0)
+    {
+      static_assert((1 << (64 - 58)) == n_shard, "shard hash does not match the shard count");
+      for (int i = 0; i < N_ALLOC_TYPE; i++) {
+        count[i] = 0;
+        total_bytes[i] = 0;
+        max_total_bytes[i] = 0;
+      }
+    }
+
+    /**
+       @brief Record a new allocation
+       @param[in] type Allocation type
+       @param[in] ptr Allocated pointer
+       @param[in] a Record of the allocation
+     */
+    void insert(AllocType type, void *ptr, const MemAlloc &a)
+    {
+      Shard &s = shardOf(ptr);
+      {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (2 * (s.size + 1) > s.slot.size()) grow(s);
+        Slot &slot = s.slot[probe(s, ptr)];
+        if (!slot.ptr) s.size++;
+        slot.ptr = ptr;
+        slot.type = type;
+        slot.a = a;
+      }
+      account(type, 1, a.base_size);
+    }
+
+    /**
+       @brief Remove an allocation of the given type.  This must be
+       called before the memory is returned to the system, so that a
+       concurrent allocation that reuses the address cannot be removed
+       in its place.
+       @param[in] type Allocation type
+       @param[in] ptr Pointer being freed
+       @param[out] a Record of the allocation (optional)
+       @return Whether ptr was a live allocation of this type
+     */
+    bool erase(AllocType type, void *ptr, MemAlloc *a = nullptr)
+    {
+      Shard &s = shardOf(ptr);
+      size_t base_size;
+      {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (s.slot.empty()) return false;
+        size_t i = probe(s, ptr);
+        if (!s.slot[i].ptr || s.slot[i].type != type) return false;
+        base_size = s.slot[i].a.base_size;
+        if (a) *a = s.slot[i].a;
+        remove(s, i);
+      }
+      account(type, -1, -static_cast<long>(base_size));
+      return true;
+    }
+
+    /**
+       @return The type of the live allocation ptr, or N_ALLOC_TYPE if
+       ptr is not one
+     */
+    AllocType find(const void *ptr)
+    {
+      Shard &s = shardOf(ptr);
+      std::lock_guard<std::mutex> lock(s.mutex);
+      if (s.slot.empty()) return N_ALLOC_TYPE;
+      const Slot &slot = s.slot[probe(s, ptr)];
+      return slot.ptr ? slot.type : N_ALLOC_TYPE;
+    }
+
+    /** @return Whether there are no live allocations of this type */
+    bool empty(AllocType type) const { return count[type].load(std::memory_order_relaxed) == 0; }
+
+    /**
+       @return The live allocations of this type ordered by address
+     */
+    std::vector<std::pair<void *, MemAlloc>> entries(AllocType type)
+    {
+      std::vector<std::pair<void *, MemAlloc>> list;
+      for (auto &s : shard) {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        for (auto &slot : s.slot)
+          if (slot.ptr && slot.type == type) list.push_back(std::make_pair(slot.ptr, slot.a));
+      }
+      std::sort(list.begin(), list.end(),
+                [](const std::pair<void *, MemAlloc> &a, const std::pair<void *, MemAlloc> &b) {
+                  return std::less<void *>()(a.first, b.first);
+                });
+      return list;
+    }
+
+    long peak(AllocType type) const { return max_total_bytes[type].load(std::memory_order_relaxed); }
+    long peak_host() const { return max_total_host_bytes.load(std::memory_order_relaxed); }
+    long peak_pinned() const { return max_total_pinned_bytes.load(std::memory_order_relaxed); }
+  };
+
+} // namespace quda
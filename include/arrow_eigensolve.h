@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <complex_quda.h>
+
+namespace quda
+{
+
+  /**
+     @brief Eigendecomposition of the Hermitian arrow matrix produced
+     by the thick restarted Lanczos solvers.  The matrix is diagonal in
+     the rows preceding arrow_pos, row/column arrow_pos couples to
+     every one of those rows, and the trailing block from arrow_pos
+     onwards is tridiagonal.  With arrow_pos = 0 this is a plain
+     tridiagonal matrix.
+
+     Rather than forming the dense matrix, the structure is solved
+     directly: the trailing tridiagonal block is decomposed by
+     divide-and-conquer, which leaves an arrowhead matrix whose
+     eigenvalues are the roots of a secular equation.  The
+     eigenvectors are then recovered from Lowner's formula and
+     back-transformed with matrix-matrix products.  This takes
+     O(dim^2) work for the eigenvalues and level-3 BLAS for the
+     eigenvectors, against the O(dim^3) reduction of a dense solver.
+
+     @param[out] evals The eigenvalues in ascending order
+     @param[out] evecs The eigenvectors, column major (eigenvector i
+     occupies evecs[dim * i, dim * (i + 1)))
+     @param[in] diag The diagonal of the matrix (length dim)
+     @param[in] off The lower off-diagonal entries (length dim - 1):
+     off[i] is A(arrow_pos, i) for i < arrow_pos, and A(i + 1, i)
+     otherwise.  The upper entries are their conjugates.
+     @param[in] arrow_pos Row of the arrow
+  */
+  template <typename T>
+  void arrowEigensolve(std::vector<double> &evals, std::vector<T> &evecs, const std::vector<double> &diag,
+                       const std::vector<T> &off, int arrow_pos);
+
+} // namespace quda
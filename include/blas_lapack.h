@@ -20,6 +20,14 @@
 #define FLOPS_ZGETRI(n_) (6. * FMULS_GETRI((double)(n_)) + 2.0 * FADDS_GETRI((double)(n_)))
 #define FLOPS_CGETRI(n_) (6. * FMULS_GETRI((double)(n_)) + 2.0 * FADDS_GETRI((double)(n_)))
 
+#define FMULS_GEMM(m_, n_, k_) ((double)(m_) * (double)(n_) * (double)(k_))
+#define FADDS_GEMM(m_, n_, k_) ((double)(m_) * (double)(n_) * (double)(k_))
+
+#define FLOPS_ZGEMM(m_, n_, k_) (6. * FMULS_GEMM((m_), (n_), (k_)) + 2.0 * FADDS_GEMM((m_), (n_), (k_)))
+#define FLOPS_CGEMM(m_, n_, k_) (6. * FMULS_GEMM((m_), (n_), (k_)) + 2.0 * FADDS_GEMM((m_), (n_), (k_)))
+#define FLOPS_DGEMM(m_, n_, k_) (FMULS_GEMM((m_), (n_), (k_)) + FADDS_GEMM((m_), (n_), (k_)))
+#define FLOPS_SGEMM(m_, n_, k_) (FMULS_GEMM((m_), (n_), (k_)) + FADDS_GEMM((m_), (n_), (k_)))
+
 namespace quda
 {
 
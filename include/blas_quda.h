@@ -440,6 +440,62 @@ namespace quda {
     */
     void cDotProductCopy(Complex* result, std::vector<ColorSpinorField*>& a, std::vector<ColorSpinorField*>& b, std::vector<ColorSpinorField*>& c);
 
+    /**
+       @brief A blas reduction whose global sum is left in flight, so
+       that latency-bound solvers can overlap it with other work, e.g.,
+       the next matrix-vector product.  The reduction passed to the
+       constructor is evaluated with global reductions disabled, and
+       the global sum of its result is then started; wait() completes
+       it and returns the global result.  The in-flight sum writes into
+       this object, so it can be neither copied nor moved.
+
+       Example:
+         blas::AsyncReduction<double3> rr([&]() { return blas::tripleCGReduction(x, y, z); });
+         mat(Ap, p);
+         double3 xyz = rr.wait();
+    */
+    template <typename reduce_t> class AsyncReduction
+    {
+      reduce_t value;
+      ReduceHandle *handle;
+
+    public:
+      /**
+         @brief Compute the local reduction and start its global sum
+         @param[in] reduction Callable returning the reduction result
+         (double, Complex, double2, double3 or double4)
+      */
+      template <typename Reduction> AsyncReduction(Reduction &&reduction) : handle(nullptr)
+      {
+        static_assert(sizeof(reduce_t) % sizeof(double) == 0, "Reduction result must be an aggregate of doubles");
+        const bool global_reduce = commGlobalReduction();
+        commGlobalReductionSet(false);
+        value = reduction();
+        commGlobalReductionSet(global_reduce);
+        handle = reduceDoubleArrayAsync(reinterpret_cast<double *>(&value), sizeof(reduce_t) / sizeof(double));
+      }
+
+      AsyncReduction(const AsyncReduction &) = delete;
+      AsyncReduction &operator=(const AsyncReduction &) = delete;
+
+      ~AsyncReduction() { comm_allreduce_wait(&handle); }
+
+      /**
+         @return Whether the global sum is still in flight
+      */
+      bool pending() const { return handle != nullptr; }
+
+      /**
+         @brief Complete the global sum
+         @return The globally reduced result
+      */
+      reduce_t wait()
+      {
+        comm_allreduce_wait(&handle);
+        return value;
+      }
+    };
+
   } // namespace blas
 
 } // namespace quda
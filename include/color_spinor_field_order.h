@@ -983,7 +983,7 @@ namespace quda {
       static constexpr int M_ghost = length_ghost / N_ghost;
       using Accessor = FloatNOrder<Float, Ns, Nc, N, spin_project, huge_alloc>;
       using real = typename mapper<Float>::type;
-      using complex = complex<real>;
+      using complex = quda::complex<real>;
       using Vector = typename VectorType<Float, N>::type;
       using GhostVector = typename VectorType<Float, N_ghost>::type;
       using AllocInt = typename AllocType<huge_alloc>::type;
@@ -1249,7 +1249,7 @@ namespace quda {
       struct SpaceColorSpinorOrder {
       using Accessor = SpaceColorSpinorOrder<Float, Ns, Nc>;
       using real = typename mapper<Float>::type;
-      using complex = complex<real>;
+      using complex = quda::complex<real>;
       static const int length = 2 * Ns * Nc;
       Float *field;
       size_t offset;
@@ -1367,7 +1367,7 @@ namespace quda {
       struct SpaceSpinorColorOrder {
       using Accessor = SpaceSpinorColorOrder<Float, Ns, Nc>;
       using real = typename mapper<Float>::type;
-      using complex = complex<real>;
+      using complex = quda::complex<real>;
       static const int length = 2 * Ns * Nc;
       Float *field;
       size_t offset;
@@ -1486,7 +1486,7 @@ namespace quda {
       struct PaddedSpaceSpinorColorOrder {
       using Accessor = PaddedSpaceSpinorColorOrder<Float, Ns, Nc>;
       using real = typename mapper<Float>::type;
-      using complex = complex<real>;
+      using complex = quda::complex<real>;
       static const int length = 2 * Ns * Nc;
       Float *field;
       size_t offset;
@@ -1633,7 +1633,7 @@ namespace quda {
       struct QDPJITDiracOrder {
       using Accessor = QDPJITDiracOrder<Float, Ns, Nc>;
       using real = typename mapper<Float>::type;
-      using complex = complex<real>;
+      using complex = quda::complex<real>;
       Float *field;
       int volumeCB;
       int stride;
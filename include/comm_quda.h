@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
 
 #ifdef __cplusplus
@@ -6,6 +7,7 @@ extern "C" {
 #endif
 
   typedef struct MsgHandle_s MsgHandle;
+  typedef struct ReduceHandle_s ReduceHandle;
   typedef struct Topology_s Topology;
 
   /* defined in quda.h; redefining here to avoid circular references */
@@ -155,7 +157,8 @@ extern "C" {
   const char *comm_config_string();
 
   /**
-     @brief Initialize the communications, implemented in comm_single.cpp, comm_qmp.cpp, and comm_mpi.cpp
+     @brief Initialize the communications, implemented in comm_single.cpp, comm_qmp.cpp, comm_mpi.cpp and
+     communicator_threads.cpp
   */
   void comm_init(int ndim, const int *dims, QudaCommsMap rank_from_coords, void *map_data,
                  bool user_set_comm_handle = false, void *user_comm = nullptr);
@@ -165,6 +168,16 @@ extern "C" {
   */
   void comm_init_common(int ndim, const int *dims, QudaCommsMap rank_from_coords, void *map_data);
 
+  /**
+     @brief Register a function to be called whenever the current
+     communicator is changed by a communicator split, to release
+     resources tied to the previous communicator (e.g., the ghost
+     buffers of the lattice fields).  This keeps the communicator
+     stack independent of the layers built on top of it.
+     @param[in] callback Function to call
+  */
+  void comm_register_push_callback(void (*callback)(void));
+
   /**
      @return Rank id of this process
   */
@@ -319,6 +332,28 @@ extern "C" {
   void comm_allreduce_max_array(double* data, size_t size);
   void comm_allreduce_int(int* data);
   void comm_allreduce_xor(uint64_t *data);
+
+  /**
+     Start an in-place global sum of data without waiting for it to
+     complete, so that the caller can overlap the reduction with other
+     work.  The data must not be accessed until the reduction has been
+     completed with comm_allreduce_wait().  Backends without
+     non-blocking collectives complete the reduction before returning.
+     @param[in,out] data Array of local values, replaced by the global sums
+     @param[in] size Length of the array
+     @return Handle to the reduction in flight, or nullptr if it has
+     already completed
+  */
+  ReduceHandle *comm_allreduce_array_async(double *data, size_t size);
+
+  /**
+     Complete a reduction started with comm_allreduce_array_async()
+     and free its handle.
+     @param[in,out] rh Pointer to the handle of the reduction; the
+     handle may be nullptr, and is reset to nullptr
+  */
+  void comm_allreduce_wait(ReduceHandle **rh);
+
   void comm_broadcast(void *data, size_t nbytes);
   void comm_barrier(void);
   void comm_abort(int status);
@@ -327,6 +362,15 @@ extern "C" {
   void reduceMaxDouble(double &);
   void reduceDouble(double &);
   void reduceDoubleArray(double *, const int len);
+
+  /**
+     Non-blocking variant of reduceDoubleArray(): start the global sum
+     if global reductions are enabled.  Complete with
+     comm_allreduce_wait().
+     @return Handle to the reduction in flight, or nullptr if it has
+     already completed or is not needed
+  */
+  ReduceHandle *reduceDoubleArrayAsync(double *, const int len);
   int commDim(int);
   int commCoords(int);
   int commDimPartitioned(int dir);
@@ -347,3 +391,72 @@ extern "C" {
 #ifdef __cplusplus
 }
 #endif
+
+#ifdef __cplusplus
+#include <string>
+#include <vector>
+
+/**
+   Process-grid mapping built from the placement of the ranks on
+   nodes, used in place of the default lexicographical mapping when
+   QUDA_ENABLE_TOPOLOGY_MAPPING=1.  The map is filled in by
+   comm_build_topology_map() during communicator initialization, once
+   the hostnames of all ranks are known.  Since nothing can be printed
+   before the communicator exists, the report of the mapping is kept
+   here for the caller of comm_init() to print.
+*/
+struct CommTopologyMap {
+  std::vector<int> dims;             // process grid dimensions
+  std::vector<int> ranks;            // rank at each grid coordinate (lexicographical, last dimension fastest)
+  std::vector<std::string> warnings; // reasons for falling back to the lexicographical mapping
+  std::string report;                // summary of the chosen mapping
+};
+
+/**
+   @brief QudaCommsMap callback for a CommTopologyMap
+   @param[in] coords Process grid coordinates
+   @param[in] fdata Pointer to the CommTopologyMap
+   @return Rank at coords
+*/
+int comm_topology_rank_from_coords(const int *coords, void *fdata);
+
+/**
+   @brief Build a topology-aware process-grid mapping.  The ranks are
+   grouped by hostname, and the process grid is factorized into an
+   intra-node block (one rank per node-local rank) tiled over a grid
+   of nodes.  Of the factorizations, the one minimizing the halo
+   traffic between nodes is chosen, with the relative face sizes
+   taken from the global lattice in QUDA_TOPOLOGY_MAPPING_LATTICE
+   (e.g., "32x32x32x64") if set, else assuming equal faces.  The
+   expected inter-node halo volume is reported against that of the
+   default lexicographical mapping.  If the nodes hold unequal numbers
+   of ranks, or no block of the node size tiles the grid, this falls
+   back to the lexicographical mapping.  This runs while the
+   communicator is being constructed, so rather than printing, any
+   warnings are added to map.warnings.
+   @param[in,out] map The mapping, with dims set on input
+   @param[in] hostname_recv_buf Hostnames of all ranks, 128 bytes each
+   @param[in] size Number of ranks
+   @return The report of the chosen mapping, empty on fallback
+*/
+std::string comm_build_topology_map(CommTopologyMap &map, const char *hostname_recv_buf, int size);
+#endif
+
+#ifdef THREAD_COMMS
+#include <functional>
+
+/**
+   @brief Run body on n_rank host threads of this process, each of
+   which acts as one rank of the in-process communicator.  Each thread
+   should call initCommsGridQuda() (or comm_init()) with a grid of
+   n_rank ranks before communicating.  Returns once every rank has
+   returned from body.  A thread that initializes comms without
+   having been started here forms a single-rank world.  Note that the
+   rest of QUDA's state (initQuda() and the fields) is per process,
+   so the ranks can share the communicator layer but not run
+   independent solves.
+   @param[in] n_rank Number of ranks
+   @param[in] body Function run by each rank, passed its rank
+*/
+void comm_thread_launch(int n_rank, const std::function<void(int)> &body);
+#endif
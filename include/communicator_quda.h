@@ -21,6 +21,11 @@
 #include <qmp.h>
 #endif
 
+#if defined(THREAD_COMMS)
+#include <memory>
+struct ThreadComm; // group of threads acting as ranks, defined in communicator_threads.cpp
+#endif
+
 #ifdef QUDA_BACKWARDSCPP
 #include "backward.hpp"
 namespace backward
@@ -129,8 +134,27 @@ inline int comm_rank_displaced(const Topology *topo, const int displacement[])
   return comm_rank_from_coords(topo, coords);
 }
 
+/**
+   @brief Return the number of devices visible to this process.  The
+   CPU target exposes the host as a single device.
+*/
+inline int comm_device_count()
+{
+#ifdef QUDA_TARGET_CPU
+  return 1;
+#else
+  int device_count;
+  cudaGetDeviceCount(&device_count);
+  return device_count;
+#endif
+}
+
 inline bool isHost(const void *buffer)
 {
+#ifdef QUDA_TARGET_CPU
+  // all memory is host memory on the CPU target
+  return true;
+#else
   CUmemorytype memType;
   void *attrdata[] = {(void *)&memType};
   CUpointer_attribute attributes[2] = {CU_POINTER_ATTRIBUTE_MEMORY_TYPE};
@@ -149,6 +173,7 @@ inline bool isHost(const void *buffer)
   default: // memory not allocated by CUDA allocaters will default to being host memory
     return true;
   }
+#endif
 }
 
 inline void check_displacement(const int displacement[], int ndim)
@@ -270,6 +295,7 @@ struct Communicator {
             enable_p2p_max_access_rank);
       }
 
+#ifndef QUDA_TARGET_CPU // there are no peer devices to access on the CPU target
       // first check that the local GPU supports UVA
       const int gpuid = comm_gpuid();
       cudaDeviceProp prop;
@@ -331,6 +357,9 @@ struct Communicator {
       }     // different directions - forward/backward
 
       host_free(gpuid_recv_buf);
+#else
+      (void)disable_peer_to_peer_bidir;
+#endif
     }
 
     peer2peer_init = true;
@@ -497,8 +526,7 @@ struct Communicator {
       if (blacklist_env) { // set the policies to tune for explicitly
         std::stringstream blacklist_list(blacklist_env);
 
-        int device_count;
-        cudaGetDeviceCount(&device_count);
+        int device_count = comm_device_count();
 
         int excluded_device;
         while (blacklist_list >> excluded_device) {
@@ -524,12 +552,19 @@ struct Communicator {
 
   void comm_init_common(int ndim, const int *dims, QudaCommsMap rank_from_coords, void *map_data)
   {
+    char *hostname_recv_buf = (char *)safe_malloc(128 * comm_size());
+    comm_gather_hostname(hostname_recv_buf);
+
+    // a topology-aware mapping can only be built once the placement of the ranks is known
+    if (rank_from_coords == comm_topology_rank_from_coords) {
+      auto &map = *static_cast<CommTopologyMap *>(map_data);
+      map.report = comm_build_topology_map(map, hostname_recv_buf, comm_size());
+    }
+
     Topology *topo = comm_create_topology(ndim, dims, rank_from_coords, map_data, comm_rank());
     comm_set_default_topology(topo);
 
     // determine which GPU this rank will use
-    char *hostname_recv_buf = (char *)safe_malloc(128 * comm_size());
-    comm_gather_hostname(hostname_recv_buf);
 
     // We only want one (1) gpuid for all communicators, so gpuid is static.
     // We initialize gpuid if it's still negative.
@@ -540,8 +575,7 @@ struct Communicator {
         if (!strncmp(comm_hostname(), &hostname_recv_buf[128 * i], 128)) { gpuid++; }
       }
 
-      int device_count;
-      cudaGetDeviceCount(&device_count);
+      int device_count = comm_device_count();
       if (device_count == 0) { errorQuda("No CUDA devices found"); }
       if (gpuid >= device_count) {
         char *enable_mps_env = getenv("QUDA_ENABLE_MPS");
@@ -574,8 +608,6 @@ struct Communicator {
         std::stringstream device_list;                       // formatted (no commas)
 
         int device;
-        int deviceCount;
-        cudaGetDeviceCount(&deviceCount);
         while (device_list_raw >> device) {
           // check this is a valid policy choice
           if (device < 0) { errorQuda("Invalid CUDA_VISIBLE_DEVICE ordinal %d", device); }
@@ -656,6 +688,11 @@ struct Communicator {
     if (globalReduce) comm_allreduce_array(sum, len);
   }
 
+  ReduceHandle *reduceDoubleArrayAsync(double *sum, const int len)
+  {
+    return globalReduce ? comm_allreduce_array_async(sum, len) : nullptr;
+  }
+
   int commDim(int dir) { return comm_dim(dir); }
 
   int commCoords(int dir) { return comm_coord(dir); }
@@ -682,6 +719,10 @@ struct Communicator {
   QMP_comm_t QMP_COMM_HANDLE;
 #endif
 
+#if defined(THREAD_COMMS)
+  std::shared_ptr<ThreadComm> THREAD_COMM_HANDLE;
+#endif
+
   int rank = -1;
   int size = -1;
 
@@ -770,6 +811,10 @@ struct Communicator {
 
   void comm_allreduce_xor(uint64_t *data);
 
+  ReduceHandle *comm_allreduce_array_async(double *data, size_t size);
+
+  void comm_allreduce_wait(ReduceHandle *rh);
+
   /**  broadcast from rank 0 */
   void comm_broadcast(void *data, size_t nbytes);
 
@@ -20,4 +20,79 @@ using namespace quda;
 struct __half { };
 #endif
 
+#ifndef QUDA_TARGET_CPU
 #include <cub/block/block_reduce.cuh>
+#else
+#include <vector>
+#include <quda_host_runtime.h>
+
+/**
+   Host stand-ins for the parts of cub that QUDA uses.  The threads of
+   a block that synchronizes run as fibers on one worker thread (see
+   __syncthreads), so the values are exchanged through a buffer owned
+   by that worker, and the temporary storage of the collectives is not
+   needed.
+ */
+namespace cub
+{
+  struct Sum {
+    template <typename T> inline T operator()(const T &a, const T &b) const { return a + b; }
+  };
+  struct Max {
+    template <typename T> inline T operator()(const T &a, const T &b) const { return b > a ? b : a; }
+  };
+  struct Min {
+    template <typename T> inline T operator()(const T &a, const T &b) const { return b < a ? b : a; }
+  };
+
+  enum BlockReduceAlgorithm { BLOCK_REDUCE_RAKING_COMMUTATIVE_ONLY, BLOCK_REDUCE_RAKING, BLOCK_REDUCE_WARP_REDUCTIONS };
+
+  /**
+     @brief Reduce the values of groups of width consecutive threads of
+     the block, returning the result in the first thread of each group.
+     Every live thread of the block must take part.
+   */
+  template <typename T, typename Reducer> inline T host_group_reduce(const T &in, unsigned int width, Reducer r)
+  {
+    static thread_local std::vector<T> buffer;
+    const unsigned int tid = (threadIdx.z * blockDim.y + threadIdx.y) * blockDim.x + threadIdx.x;
+    const unsigned int n = blockDim.x * blockDim.y * blockDim.z;
+    if (buffer.size() < n) buffer.resize(n); // every thread resizes before the barrier, so no data is lost
+    buffer[tid] = in;
+    __syncthreads();
+    T aggregate = in;
+    if (tid % width == 0)
+      for (unsigned int i = tid + 1; i < tid + width && i < n; i++) aggregate = r(aggregate, buffer[i]);
+    __syncthreads(); // the buffer may be reused once every group has been reduced
+    return aggregate;
+  }
+
+  template <typename T, int block_dim_x, BlockReduceAlgorithm algorithm = BLOCK_REDUCE_WARP_REDUCTIONS,
+            int block_dim_y = 1, int block_dim_z = 1>
+  class BlockReduce
+  {
+  public:
+    struct TempStorage {
+    };
+    BlockReduce(TempStorage &) { }
+    template <typename Reducer> T Reduce(const T &in, Reducer r)
+    {
+      return host_group_reduce(in, block_dim_x * block_dim_y * block_dim_z, r);
+    }
+    T Sum(const T &in) { return Reduce(in, cub::Sum()); }
+  };
+
+  template <typename T, int logical_warp_threads = 32> class WarpReduce
+  {
+  public:
+    struct TempStorage {
+    };
+    WarpReduce(TempStorage &) { }
+    template <typename Reducer> T Reduce(const T &in, Reducer r)
+    {
+      return host_group_reduce(in, logical_warp_threads, r);
+    }
+    T Sum(const T &in) { return Reduce(in, cub::Sum()); }
+  };
+} // namespace cub
+#endif
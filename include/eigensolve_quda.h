@@ -614,11 +614,43 @@ protected:
     void qrShifts(const std::vector<Complex> evals, const int num_shifts);
 
     /**
-       @brief Apply One step of the the QR algorithm
-       @param[in] Q The Q matrix
-       @param[in] R The R matrix
-    */
-    void qrIteration(Complex **Q, Complex **R);
+       The Givens rotations of one bulge-chasing sweep over the window
+       [lo, hi]: rotation k acts on rows/columns lo + k and lo + k + 1.
+    */
+    struct GivensSweep {
+      int lo;
+      int hi;
+      std::vector<double> c;
+      std::vector<Complex> s;
+    };
+
+    /** The maximum number of sweeps whose off-window updates are deferred */
+    static constexpr size_t max_deferred_sweeps = 16;
+
+    /**
+       @brief Apply one implicitly shifted QR step to the unreduced
+       window [lo, hi] of an upper Hessenberg matrix by bulge chasing.
+       Only the window is updated; the rotations are recorded in
+       sweeps, and their application to the rest of H and to Q is
+       deferred to applySweeps.
+       @param[in,out] Q The accumulated rotation matrix
+       @param[in,out] H The upper Hessenberg matrix
+       @param[in,out] sweeps The deferred sweeps
+       @param[in] lo First row of the active window
+       @param[in] hi Last row of the active window
+       @param[in] shift The shift to apply
+    */
+    void qrBulgeChase(Complex **Q, Complex **H, std::vector<GivensSweep> &sweeps, int lo, int hi, Complex shift);
+
+    /**
+       @brief Apply the deferred sweeps to Q and to the parts of H
+       outside their windows, then clear them.  Each row of Q takes all
+       the rotations in one pass while it is in cache.
+       @param[in,out] Q The accumulated rotation matrix
+       @param[in,out] H The upper Hessenberg matrix
+       @param[in,out] sweeps The deferred sweeps
+    */
+    void applySweeps(Complex **Q, Complex **H, std::vector<GivensSweep> &sweeps);
 
     /**
        @brief Reorder the Krylov space and eigenvalues
@@ -130,6 +130,7 @@
 #define QUDA_CA_CGNE_INVERTER 23
 #define QUDA_CA_CGNR_INVERTER 24
 #define QUDA_CA_GCR_INVERTER 25
+#define QUDA_PIPELINED_CG_INVERTER 26
 #define QUDA_INVALID_INVERTER QUDA_INVALID_ENUM
 
 #define QudaEigType integer(4)
@@ -632,6 +632,66 @@ namespace quda {
   private:
     void **gauge; // the actual gauge field
 
+    /**
+       Persistent state for the padded ghost exchange (exchangeGhost
+       and injectGhost): the staging buffers and the message handles
+       declared on them and on the ghost zone are created on first use
+       and reused until the field is destroyed or the communicator
+       changes.
+    */
+    struct GhostPlan {
+      int comms_generation = -1;
+      size_t bytes[QUDA_MAX_DIM] = {};
+      void *send[2 * QUDA_MAX_DIM] = {};
+      void *recv[QUDA_MAX_DIM] = {};
+      MsgHandle *mh_send_fwd[2 * QUDA_MAX_DIM] = {};
+      MsgHandle *mh_recv_fwd[2 * QUDA_MAX_DIM] = {};
+      MsgHandle *mh_send_back[QUDA_MAX_DIM] = {};
+      MsgHandle *mh_recv_back[QUDA_MAX_DIM] = {};
+    } ghost_plan;
+
+    /**
+       Persistent state for exchangeExtendedGhost, valid for the halo
+       depth R and no_comms_fill it was created with
+    */
+    struct HaloPlan {
+      int comms_generation = -1;
+      int R[QUDA_MAX_DIM] = {};
+      bool no_comms_fill = false;
+      size_t bytes[QUDA_MAX_DIM] = {};
+      void *send[QUDA_MAX_DIM] = {};
+      void *recv[QUDA_MAX_DIM] = {};
+      MsgHandle *mh_recv_back[QUDA_MAX_DIM] = {};
+      MsgHandle *mh_recv_fwd[QUDA_MAX_DIM] = {};
+      MsgHandle *mh_send_back[QUDA_MAX_DIM] = {};
+      MsgHandle *mh_send_fwd[QUDA_MAX_DIM] = {};
+    } halo_plan;
+
+    /**
+       @brief Create the ghost plan if it does not exist or was
+       declared on a different communicator
+    */
+    void createGhostPlan();
+
+    /**
+       @brief Free the buffers and message handles of the ghost plan
+    */
+    void destroyGhostPlan();
+
+    /**
+       @brief Create the extended halo plan if it does not exist or
+       does not match the requested exchange
+       @param[in] R The thickness of the extended region in each dimension
+       @param[in] no_comms_fill Whether non-partitioned dimensions are
+       filled locally
+    */
+    void createHaloPlan(const int *R, bool no_comms_fill);
+
+    /**
+       @brief Free the buffers and message handles of the halo plan
+    */
+    void destroyHaloPlan();
+
   public:
     /**
        @brief Constructor for cpuGaugeField from a GaugeFieldParam
@@ -1251,7 +1251,7 @@ namespace quda {
       template <int N, typename Float, QudaGhostExchange ghostExchange_, QudaStaggeredPhase = QUDA_STAGGERED_PHASE_NO>
       struct Reconstruct {
         using real = typename mapper<Float>::type;
-        using complex = complex<real>;
+        using complex = quda::complex<real>;
         real scale;
         real scale_inv;
         Reconstruct(const GaugeField &u) :
@@ -1361,7 +1361,7 @@ namespace quda {
       */
       template <typename Float, QudaGhostExchange ghostExchange_> struct Reconstruct<12, Float, ghostExchange_> {
         using real = typename mapper<Float>::type;
-        using complex = complex<real>;
+        using complex = quda::complex<real>;
         const real anisotropy;
         const real tBoundary;
         const int firstTimeSliceBound;
@@ -1444,7 +1444,7 @@ namespace quda {
       */
       template <typename Float, QudaGhostExchange ghostExchange_> struct Reconstruct<11, Float, ghostExchange_> {
         using real = typename mapper<Float>::type;
-        using complex = complex<real>;
+        using complex = quda::complex<real>;
 
         Reconstruct(const GaugeField &u) { ; }
         Reconstruct(const Reconstruct<11, Float, ghostExchange_> &recon) {}
@@ -1493,7 +1493,7 @@ namespace quda {
       template <typename Float, QudaGhostExchange ghostExchange_, QudaStaggeredPhase stag_phase>
       struct Reconstruct<13, Float, ghostExchange_, stag_phase> {
         using real = typename mapper<Float>::type;
-        using complex = complex<real>;
+        using complex = quda::complex<real>;
         const Reconstruct<12, Float, ghostExchange_> reconstruct_12;
         const real scale;
         const real scale_inv;
@@ -1576,7 +1576,7 @@ namespace quda {
       */
       template <typename Float, QudaGhostExchange ghostExchange_> struct Reconstruct<8, Float, ghostExchange_> {
         using real = typename mapper<Float>::type;
-        using complex = complex<real>;
+        using complex = quda::complex<real>;
         const complex anisotropy; // imaginary value stores inverse
         const complex tBoundary;  // imaginary value stores inverse
         const int firstTimeSliceBound;
@@ -1734,7 +1734,7 @@ namespace quda {
       template <typename Float, QudaGhostExchange ghostExchange_, QudaStaggeredPhase stag_phase>
       struct Reconstruct<9, Float, ghostExchange_, stag_phase> {
         using real = typename mapper<Float>::type;
-        using complex = complex<real>;
+        using complex = quda::complex<real>;
         const Reconstruct<8, Float, ghostExchange_> reconstruct_8;
         const real scale;
         const real scale_inv;
@@ -1843,7 +1843,7 @@ namespace quda {
             = FloatNOrder<Float, length, N, reconLenParam, stag_phase, huge_alloc, ghostExchange_, use_inphase>;
 
         using real = typename mapper<Float>::type;
-        using complex = complex<real>;
+        using complex = quda::complex<real>;
         typedef typename VectorType<Float, N>::type Vector;
         typedef typename AllocType<huge_alloc>::type AllocInt;
         Reconstruct<reconLenParam, Float, ghostExchange_, stag_phase> reconstruct;
@@ -2172,7 +2172,7 @@ namespace quda {
       template <typename Float, int length> struct LegacyOrder {
         using Accessor = LegacyOrder<Float, length>;
         using real = typename mapper<Float>::type;
-        using complex = complex<real>;
+        using complex = quda::complex<real>;
         Float *ghost[QUDA_MAX_DIM];
         int faceVolumeCB[QUDA_MAX_DIM];
         const int volumeCB;
@@ -2313,7 +2313,7 @@ namespace quda {
     template <typename Float, int length> struct QDPOrder : public LegacyOrder<Float,length> {
       using Accessor = QDPOrder<Float, length>;
       using real = typename mapper<Float>::type;
-      using complex = complex<real>;
+      using complex = quda::complex<real>;
       Float *gauge[QUDA_MAX_DIM];
       const int volumeCB;
     QDPOrder(const GaugeField &u, Float *gauge_=0, Float **ghost_=0)
@@ -2395,7 +2395,7 @@ namespace quda {
     template <typename Float, int length> struct QDPJITOrder : public LegacyOrder<Float,length> {
       using Accessor = QDPJITOrder<Float, length>;
       using real = typename mapper<Float>::type;
-      using complex = complex<real>;
+      using complex = quda::complex<real>;
       Float *gauge[QUDA_MAX_DIM];
       const int volumeCB;
     QDPJITOrder(const GaugeField &u, Float *gauge_=0, Float **ghost_=0)
@@ -2461,7 +2461,7 @@ namespace quda {
   template <typename Float, int length> struct MILCOrder : public LegacyOrder<Float,length> {
     using Accessor = MILCOrder<Float, length>;
     using real = typename mapper<Float>::type;
-    using complex = complex<real>;
+    using complex = quda::complex<real>;
     Float *gauge;
     const int volumeCB;
     const int geometry;
@@ -2555,7 +2555,7 @@ namespace quda {
   template <typename Float, int length> struct MILCSiteOrder : public LegacyOrder<Float,length> {
     using Accessor = MILCSiteOrder<Float, length>;
     using real = typename mapper<Float>::type;
-    using complex = complex<real>;
+    using complex = quda::complex<real>;
     Float *gauge;
     const int volumeCB;
     const int geometry;
@@ -2660,7 +2660,7 @@ namespace quda {
   template <typename Float, int length> struct CPSOrder : LegacyOrder<Float,length> {
     using Accessor = CPSOrder<Float, length>;
     using real = typename mapper<Float>::type;
-    using complex = complex<real>;
+    using complex = quda::complex<real>;
     Float *gauge;
     const int volumeCB;
     const real anisotropy;
@@ -2771,7 +2771,7 @@ namespace quda {
     template <typename Float, int length> struct BQCDOrder : LegacyOrder<Float,length> {
       using Accessor = BQCDOrder<Float, length>;
       using real = typename mapper<Float>::type;
-      using complex = complex<real>;
+      using complex = quda::complex<real>;
       Float *gauge;
       const int volumeCB;
       int exVolumeCB; // extended checkerboard volume
@@ -2873,7 +2873,7 @@ namespace quda {
     template <typename Float, int length> struct TIFROrder : LegacyOrder<Float,length> {
       using Accessor = TIFROrder<Float, length>;
       using real = typename mapper<Float>::type;
-      using complex = complex<real>;
+      using complex = quda::complex<real>;
       Float *gauge;
       const int volumeCB;
       static constexpr int Nc = 3;
@@ -2978,7 +2978,7 @@ namespace quda {
     template <typename Float, int length> struct TIFRPaddedOrder : LegacyOrder<Float,length> {
       using Accessor = TIFRPaddedOrder<Float, length>;
       using real = typename mapper<Float>::type;
-      using complex = complex<real>;
+      using complex = quda::complex<real>;
       Float *gauge;
       const int volumeCB;
       int exVolumeCB;
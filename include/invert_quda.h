@@ -476,6 +476,7 @@ namespace quda {
     bool recompute_evals;   /** If true, instruct the solver to recompute evals from an existing deflation space. */
     std::vector<ColorSpinorField *> evecs;     /** Holds the eigenvectors. */
     std::vector<Complex> evals;                /** Holds the eigenvalues. */
+    const char *timeline_name; /** Interned name of the solver's iteration events on the timeline */
 
   public:
     Solver(const DiracMatrix &mat, const DiracMatrix &matSloppy, const DiracMatrix &matPrecon,
@@ -767,6 +768,32 @@ namespace quda {
     virtual bool hermitian() { return false; } /** CG3NR is for any system */
   };
 
+  /**
+     @brief Pipelined conjugate-gradient solver (Ghysels and
+     Vanroose).  The recurrences are rearranged so that each iteration
+     needs a single fused global reduction, which is left in flight
+     while the operator is applied.  The drift of the extra
+     recurrences is controlled by residual replacement at the reliable
+     updates.
+   */
+  class PipelinedCG : public Solver
+  {
+
+  private:
+    // pointers to fields to avoid multiple creation overhead
+    ColorSpinorField *yp, *rp, *tmpp, *rSp, *xSp, *wSp, *pSp, *sSp, *zSp, *qSp, *tmpSp, *tmp2Sp;
+    bool init;
+
+  public:
+    PipelinedCG(const DiracMatrix &mat, const DiracMatrix &matSloppy, const DiracMatrix &matPrecon, SolverParam &param,
+                TimeProfile &profile);
+    virtual ~PipelinedCG();
+
+    void operator()(ColorSpinorField &out, ColorSpinorField &in);
+
+    virtual bool hermitian() { return true; } /** Pipelined CG is only for Hermitian systems */
+  };
+
   class MPCG : public Solver {
     private:
       void computeMatrixPowers(cudaColorSpinorField out[], cudaColorSpinorField &in, int nvec);
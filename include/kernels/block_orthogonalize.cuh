@@ -13,7 +13,7 @@
 namespace quda {
 
 #define MAX_MATRIX_SIZE 4096
-  __constant__ signed char B_array_d[MAX_MATRIX_SIZE];
+  static __constant__ signed char B_array_d[MAX_MATRIX_SIZE];
 
   // to avoid overflowing the parameter space we put the B array into a separate constant memory buffer
   static signed char B_array_h[MAX_MATRIX_SIZE];
@@ -160,7 +160,7 @@ namespace quda {
     constexpr int uvSpin = Arg::fineSpin * (Arg::from_coarse ? 2 : 1);
     constexpr int nFace = 1; // to do: nFace == 3 version for long links
 
-    using complex = complex<typename Arg::Float>;
+    using complex = quda::complex<typename Arg::Float>;
     using TileType = typename Arg::uvTileType;
     auto &tile = arg.uvTile;
     using Ctype = decltype(make_tile_C<complex, false>(tile));
@@ -628,7 +628,7 @@ namespace quda {
   __device__ __host__ inline void multiplyVUV(Out &vuv, const Arg &arg, const Gamma &gamma, int parity, int x_cb, int i0, int j0)
   {
     using Float = typename Arg::Float;
-    using complex = complex<Float>;
+    using complex = quda::complex<Float>;
     using TileType = typename Arg::vuvTileType;
     auto &tile = arg.vuvTile;
 
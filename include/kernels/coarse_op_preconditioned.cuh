@@ -43,7 +43,7 @@ namespace quda {
   inline __device__ __host__ auto computeYhat(Arg &arg, int d, int x_cb, int parity, int i0, int j0)
   {
     using real = typename Arg::Float;
-    using complex = complex<real>;
+    using complex = quda::complex<real>;
     constexpr int nDim = 4;
     int coord[nDim];
     getCoords(coord, x_cb, arg.dim, parity);
@@ -25,6 +25,15 @@ namespace quda {
     }
   };
 
+  /**
+     Number of checkerboard sites each host thread reorders at a time.
+     All geometry components of a block are copied before moving on,
+     so that both the site-major (MILC/CPS/BQCD/TIFR) and the
+     direction-major (QDP/QUDA) orders stream through a cache-resident
+     window rather than striding across the whole field.
+  */
+  constexpr int copy_gauge_host_block = 64;
+
   /**
      Generic CPU gauge reordering and packing
   */
@@ -33,58 +42,79 @@ namespace quda {
     typedef typename mapper<FloatIn>::type RegTypeIn;
     typedef typename mapper<FloatOut>::type RegTypeOut;
     constexpr int nColor = Ncolor(length);
+    constexpr int block = copy_gauge_host_block;
+    const int volumeCB = arg.volume / 2;
+    const int n_block = (volumeCB + block - 1) / block;
 
+#pragma omp parallel for collapse(2)
     for (int parity=0; parity<2; parity++) {
-
-      for (int d=0; d<arg.geometry; d++) {
-	for (int x=0; x<arg.volume/2; x++) {
+      for (int b = 0; b < n_block; b++) {
+        const int x_end = std::min((b + 1) * block, volumeCB);
+        for (int d=0; d<arg.geometry; d++) {
+          for (int x = b * block; x < x_end; x++) {
 #ifdef FINE_GRAINED_ACCESS
-	  for (int i=0; i<nColor; i++)
-	    for (int j=0; j<nColor; j++) {
-	      arg.out(d, parity, x, i, j) = arg.in(d, parity, x, i, j);
-	    }
+            for (int i=0; i<nColor; i++)
+              for (int j=0; j<nColor; j++) {
+                arg.out(d, parity, x, i, j) = arg.in(d, parity, x, i, j);
+              }
 #else
-	  Matrix<complex<RegTypeIn>, nColor> in;
-	  Matrix<complex<RegTypeOut>, nColor> out;
-          in = arg.in(d, x, parity);
-          out = in;
-	  arg.out(d, x, parity) = out;
+            Matrix<complex<RegTypeIn>, nColor> in;
+            Matrix<complex<RegTypeOut>, nColor> out;
+            in = arg.in(d, x, parity);
+            out = in;
+            arg.out(d, x, parity) = out;
 #endif
-	}
+          }
+        }
       }
-
     }
   }
 
   /**
-     Check whether the field contains Nans
+     Check whether the field contains Nans.  The field is scanned in
+     parallel and the first offending element (in the serial traversal
+     order) is reported once the scan completes.
   */
   template <typename Float, int length, typename Arg>
   void checkNan(Arg &arg) {
     typedef typename mapper<Float>::type RegType;
     constexpr int nColor = Ncolor(length);
+    const int volumeCB = arg.volume / 2;
+    const int geometry = arg.geometry;
 
-    for (int parity=0; parity<2; parity++) {
+    // linearized (parity, d, x, i) index of the first Nan found
+    constexpr int n_elem = 2 * nColor * nColor;
+    const long long n_site = 2ll * geometry * volumeCB;
+    long long first_nan = n_site * n_elem;
 
-      for (int d=0; d<arg.geometry; d++) {
-	for (int x=0; x<arg.volume/2; x++) {
+#pragma omp parallel for collapse(2) reduction(min:first_nan)
+    for (int parity=0; parity<2; parity++) {
+      for (int d=0; d<geometry; d++) {
+	for (int x=0; x<volumeCB; x++) {
+          const long long offset = ((long long)(parity * geometry + d) * volumeCB + x) * n_elem;
 #ifdef FINE_GRAINED_ACCESS
 	  for (int i=0; i<nColor; i++)
 	    for (int j=0; j<nColor; j++) {
               complex<Float> u = arg.in(d, parity, x, i, j);
-	      if (isnan(u.real()))
-	        errorQuda("Nan detected at parity=%d, dir=%d, x=%d, i=%d", parity, d, x, 2*(i*Ncolor(length)+j));
-	      if (isnan(u.imag()))
-		errorQuda("Nan detected at parity=%d, dir=%d, x=%d, i=%d", parity, d, x, 2*(i*Ncolor(length)+j+1));
+              if (isnan(u.real())) first_nan = std::min(first_nan, offset + 2 * (i * nColor + j));
+              if (isnan(u.imag())) first_nan = std::min(first_nan, offset + 2 * (i * nColor + j) + 1);
             }
 #else
 	  Matrix<complex<RegType>, nColor> u = arg.in(d, x, parity);
 	  for (int i=0; i<length/2; i++)
-	    if (isnan(u(i).real()) || isnan(u(i).imag())) errorQuda("Nan detected at parity=%d, dir=%d, x=%d, i=%d", parity, d, x, i);
+	    if (isnan(u(i).real()) || isnan(u(i).imag())) first_nan = std::min(first_nan, offset + i);
 #endif
 	}
       }
+    }
 
+    if (first_nan < n_site * n_elem) {
+      const int i = first_nan % n_elem;
+      const long long site = first_nan / n_elem;
+      const int x = site % volumeCB;
+      const int d = (site / volumeCB) % geometry;
+      const int parity = site / ((long long)volumeCB * geometry);
+      errorQuda("Nan detected at parity=%d, dir=%d, x=%d, i=%d", parity, d, x, i);
     }
   }
 
@@ -131,6 +161,7 @@ namespace quda {
     for (int parity=0; parity<2; parity++) {
 
       for (int d=0; d<arg.nDim; d++) {
+#pragma omp parallel for
         for (int x=0; x<arg.faceVolumeCB[d]; x++) {
 #ifdef FINE_GRAINED_ACCESS
           for (int i=0; i<nColor; i++)
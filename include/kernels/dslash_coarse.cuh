@@ -2,7 +2,10 @@
 #include <color_spinor_field_order.h>
 #include <index_helper.cuh>
 #include <float_vector.h>
+#include <shared_memory_cache_helper.cuh>
+#ifndef QUDA_TARGET_CPU
 #include <generics/shfl.h>
+#endif
 
 namespace quda {
 
@@ -88,7 +91,6 @@ namespace quda {
      @param parity The site parity
      @param x_cb The checkerboarded site index
    */
-  extern __shared__ float s[];
   template <typename Float, int nDim, int Ns, int Nc, int Mc, int color_stride, int dim_stride, int thread_dir, int thread_dim, bool dagger, DslashType type, typename Arg>
   __device__ __host__ inline void applyDslash(complex<Float> out[], Arg &arg, int x_cb, int src_idx, int parity, int s_row, int color_block, int color_offset) {
     const int their_spinor_parity = (arg.nParity == 2) ? 1-parity : 0;
@@ -98,6 +100,7 @@ namespace quda {
     coord[4] = src_idx;
 
 #ifdef __CUDA_ARCH__
+    QUDA_DYNAMIC_SHARED(float, s);
     complex<Float> *shared_sum = (complex<Float>*)s;
     if (!thread_dir) {
 #endif
@@ -340,33 +343,180 @@ namespace quda {
 
   }
 
+  /**
+     Maximum number of right-hand sides (the fifth dimension of the
+     coarse fields) the host coarse dslash applies per link load.
+  */
+  constexpr int coarse_dslash_host_src_block = 4;
+
+  /**
+     @brief Host helper that applies a coarse link (or its adjoint) to
+     a block of right-hand sides, out[src] += L * in[src] (or L^dagger
+     * in[src]).  The link is traversed in storage order one row at a
+     time, so each row is loaded and converted to the compute precision
+     once, then reused for every source.  The innermost loop runs
+     contiguously over color-spin so the compiler can vectorize it.
+
+     @param out Accumulator indexed as [src][spin*Nc+color]
+     @param link Accessor returning the (row, col) element of the link
+     @param in Input spinors indexed as [src][spin*Nc+color]
+     @param src_begin First source index in the block to apply to
+     @param src_end One past the last source index in the block to apply to
+   */
+  template <typename Float, int n, bool adjoint, typename Link>
+  inline void coarseLinkMultiply(complex<Float> out[][n], const Link &link, const complex<Float> in[][n],
+                                 int src_begin, int src_end)
+  {
+    complex<Float> L[n];
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < n; j++) L[j] = link(i, j);
+
+      for (int src = src_begin; src < src_end; src++) {
+        if (!adjoint) {
+          complex<Float> sum = 0.0;
+          for (int j = 0; j < n; j++) sum += L[j] * in[src][j];
+          out[src][i] += sum;
+        } else {
+          const complex<Float> v = in[src][i];
+          for (int j = 0; j < n; j++) out[src][j] += conj(L[j]) * v;
+        }
+      }
+    }
+  }
+
+  /**
+     @brief Applies the coarse dslash and/or clover term at a single
+     checkerboard site to a block of right-hand sides on the host.
+     This computes the same as the per-thread coarseDslash() used by
+     the GPU kernel, with the link loads hoisted out of the source loop.
+
+     @param arg Kernel argument struct
+     @param parity The site parity
+     @param x_cb The checkerboarded 4-d site index
+     @param src_offset Source index of the first right-hand side in the block
+     @param n_src Number of right-hand sides in the block
+   */
+  template <typename Float, int nDim, int Ns, int Nc, int src_block, bool dslash, bool clover, bool dagger,
+            DslashType type, typename Arg>
+  inline void coarseDslashHost(Arg &arg, int parity, int x_cb, int src_offset, int n_src)
+  {
+    constexpr int n = Ns * Nc;
+    const int their_spinor_parity = (arg.nParity == 2) ? 1 - parity : 0;
+    const int my_spinor_parity = (arg.nParity == 2) ? parity : 0;
+
+    complex<Float> out[src_block][n];
+    complex<Float> in[src_block][n];
+    for (int src = 0; src < n_src; src++)
+      for (int i = 0; i < n; i++) out[src][i] = 0.0;
+
+    int coord[5];
+    getCoordsCB(coord, x_cb, arg.dim, arg.X0h, parity);
+    coord[4] = src_offset;
+
+    if (dslash) {
+      for (int d = 0; d < nDim; d++) {
+        // forward gather: out += Y_{-mu}(x) in(x+mu)
+        auto fwd_link
+          = [&](int row, int col) -> complex<Float> { return arg.Y(dagger ? d : d + 4, parity, x_cb, row, col); };
+
+        if (arg.commDim[d] && (coord[d] + arg.nFace >= arg.dim[d])) {
+          if (doHalo<type>()) {
+            for (int src = 0; src < n_src; src++) {
+              coord[4] = src_offset + src;
+              const int ghost_idx = ghostFaceIndex<1, 5>(coord, arg.dim, d, arg.nFace);
+              for (int s = 0; s < Ns; s++)
+                for (int c = 0; c < Nc; c++)
+                  in[src][s * Nc + c] = arg.inA.Ghost(d, 1, their_spinor_parity,
+                                                      ghost_idx + (src_offset + src) * arg.volumeCB, s, c);
+            }
+            coarseLinkMultiply<Float, n, false>(out, fwd_link, in, 0, n_src);
+          }
+        } else if (doBulk<type>()) {
+          const int fwd_idx = linkIndexP1(coord, arg.dim, d);
+          for (int src = 0; src < n_src; src++)
+            for (int s = 0; s < Ns; s++)
+              for (int c = 0; c < Nc; c++)
+                in[src][s * Nc + c] = arg.inA(their_spinor_parity, fwd_idx + (src_offset + src) * arg.volumeCB, s, c);
+          coarseLinkMultiply<Float, n, false>(out, fwd_link, in, 0, n_src);
+        }
+
+        // backward gather: out += Y^\dagger_mu(x-mu) in(x-mu)
+        if (arg.commDim[d] && (coord[d] - arg.nFace < 0)) {
+          if (doHalo<type>()) {
+            // the ghost link index depends on the source index, so apply one source at a time
+            for (int src = 0; src < n_src; src++) {
+              coord[4] = src_offset + src;
+              const int ghost_idx = ghostFaceIndex<0, 5>(coord, arg.dim, d, arg.nFace);
+              for (int s = 0; s < Ns; s++)
+                for (int c = 0; c < Nc; c++)
+                  in[src][s * Nc + c] = arg.inA.Ghost(d, 0, their_spinor_parity,
+                                                      ghost_idx + (src_offset + src) * arg.volumeCB, s, c);
+              auto ghost_link = [&](int row, int col) -> complex<Float> {
+                return arg.Y.Ghost(dagger ? d + 4 : d, 1 - parity, ghost_idx, row, col);
+              };
+              coarseLinkMultiply<Float, n, true>(out, ghost_link, in, src, src + 1);
+            }
+          }
+        } else if (doBulk<type>()) {
+          const int back_idx = linkIndexM1(coord, arg.dim, d);
+          for (int src = 0; src < n_src; src++)
+            for (int s = 0; s < Ns; s++)
+              for (int c = 0; c < Nc; c++)
+                in[src][s * Nc + c] = arg.inA(their_spinor_parity, back_idx + (src_offset + src) * arg.volumeCB, s, c);
+          auto back_link = [&](int row, int col) -> complex<Float> {
+            return arg.Y(dagger ? d + 4 : d, 1 - parity, back_idx, row, col);
+          };
+          coarseLinkMultiply<Float, n, true>(out, back_link, in, 0, n_src);
+        }
+      } // nDim
+
+      for (int src = 0; src < n_src; src++)
+        for (int i = 0; i < n; i++) out[src][i] *= -arg.kappa;
+    }
+
+    if (doBulk<type>() && clover) {
+      for (int src = 0; src < n_src; src++)
+        for (int s = 0; s < Ns; s++)
+          for (int c = 0; c < Nc; c++)
+            in[src][s * Nc + c] = arg.inB(my_spinor_parity, x_cb + (src_offset + src) * arg.volumeCB, s, c);
+      // factor of kappa and diagonal addition are incorporated in X
+      auto clover_link = [&](int row, int col) -> complex<Float> { return arg.X(0, parity, x_cb, row, col); };
+      coarseLinkMultiply<Float, n, dagger>(out, clover_link, in, 0, n_src);
+    }
+
+    for (int src = 0; src < n_src; src++) {
+      for (int s = 0; s < Ns; s++) {
+        for (int c = 0; c < Nc; c++) {
+          // if not halo we just store, else we accumulate
+          if (doBulk<type>())
+            arg.out(my_spinor_parity, x_cb + (src_offset + src) * arg.volumeCB, s, c) = out[src][s * Nc + c];
+          else
+            arg.out(my_spinor_parity, x_cb + (src_offset + src) * arg.volumeCB, s, c) += out[src][s * Nc + c];
+        }
+      }
+    }
+  }
+
   // CPU kernel for applying the coarse Dslash to a vector
   template <typename Float, int nDim, int Ns, int Nc, int Mc, bool dslash, bool clover, bool dagger, DslashType type, typename Arg>
   void coarseDslash(Arg arg)
   {
-    // the fine-grain parameters mean nothing for CPU variant
-    const int color_stride = 1;
-    const int color_offset = 0;
-    const int dim_thread_split = 1;
-    const int dir = 0;
-    const int dim = 0;
-
-    for (int parity= 0; parity < arg.nParity; parity++) {
-      // for full fields then set parity from loop else use arg setting
-      parity = (arg.nParity == 2) ? parity : arg.parity;
-
-      for (int src_idx = 0; src_idx < arg.dim[4]; src_idx++) {
-	//#pragma omp parallel for
-	for(int x_cb = 0; x_cb < arg.volumeCB; x_cb++) { // 4-d volume
-	  for (int s=0; s<2; s++) {
-	    for (int color_block=0; color_block<Nc; color_block+=Mc) { // Mc=Nc means all colors in a thread
-	      coarseDslash<Float,nDim,Ns,Nc,Mc,color_stride,dim_thread_split,dslash,clover,dagger,type,dir,dim>(arg, x_cb, src_idx, parity, s, color_block, color_offset);
-	    }
-	  }
-	} // 4-d volumeCB
-      } // src index
-    } // parity
-
+    // the fine-grain parameters mean nothing for the CPU variant: we
+    // instead thread over sites and block over the right-hand sides
+    constexpr int src_block = coarse_dslash_host_src_block;
+    const int n_src = arg.dim[4];
+
+#pragma omp parallel for collapse(2)
+    for (int p = 0; p < arg.nParity; p++) {
+      for (int x_cb = 0; x_cb < arg.volumeCB; x_cb++) { // 4-d volume
+        // for full fields then set parity from loop else use arg setting
+        const int parity = (arg.nParity == 2) ? p : arg.parity;
+        for (int src_idx = 0; src_idx < n_src; src_idx += src_block) {
+          const int n = (n_src - src_idx < src_block) ? n_src - src_idx : src_block;
+          coarseDslashHost<Float, nDim, Ns, Nc, src_block, dslash, clover, dagger, type>(arg, parity, x_cb, src_idx, n);
+        }
+      } // 4-d volumeCB
+    }   // parity
   }
 
   // GPU Kernel for applying the coarse Dslash to a vector
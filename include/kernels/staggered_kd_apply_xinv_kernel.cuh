@@ -4,6 +4,7 @@
 #include <index_helper.cuh>
 #include <register_traits.h>
 #include <cub_helper.cuh>
+#include <shared_memory_cache_helper.cuh>
 
 namespace quda {
 
@@ -66,8 +67,8 @@ namespace quda {
 
     // Type for gauge/compute
     using real = typename Arg::Float;
-    using complex = complex<real>;
-    extern __shared__ complex cs_buffer[];
+    using complex = quda::complex<real>;
+    QUDA_DYNAMIC_SHARED(complex, cs_buffer);
 
     // For each "dot product" in the mat-vec
     using WarpReduce16 = cub::WarpReduce<complex,16>;
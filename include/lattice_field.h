@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <map>
 #include <quda.h>
 #include <iostream>
@@ -494,6 +495,15 @@ namespace quda {
     */
     static bool ghost_field_reset;
 
+    /**
+       Counter incremented whenever the ghost buffers are freed, e.g.,
+       when the communicator is changed.  Fields that keep persistent
+       message handles compare against this to know when they must be
+       redeclared.  Atomic since the ranks of the thread communicator
+       free the buffers and compare against it concurrently.
+    */
+    static std::atomic<int> comms_generation;
+
     /**
        @return The dimension of the lattice 
     */
@@ -136,6 +136,44 @@ namespace quda {
     */
     void flush_pinned();
 
+    /**
+       @return whether safe_malloc() allocations are served from the
+       size-class host memory pool (QUDA_ENABLE_HOST_MEMORY_POOL=1)
+    */
+    bool host_memory_pool();
+
+    /**
+       @brief Allocate host memory for safe_malloc().  With the host
+       pool enabled, requests of at least a page are rounded up to one
+       of four size classes per power of two and served from the free
+       list of that class if possible; blocks of 2 MiB and above are
+       hugepage aligned.  Otherwise this is a plain malloc().
+       @param[in] size Size of allocation
+       @param[out] base_size Size of the block actually reserved
+       @return Pointer to allocated memory (nullptr on failure)
+    */
+    void *host_acquire(size_t size, size_t &base_size);
+
+    /**
+       @brief Return a block obtained from host_acquire() to its
+       size-class free list (or to the system if it is unpooled).
+       @param[in] ptr Pointer to be (virtually) freed
+       @param[in] size Size originally requested
+       @param[in] base_size Size of the block reserved
+    */
+    void host_release(void *ptr, size_t size, size_t base_size);
+
+    /**
+       @brief Free all cached host-memory blocks.
+    */
+    void flush_host();
+
+    /**
+       @brief Print the high-water and fragmentation statistics of the
+       host memory pool.
+    */
+    void print_host_stats();
+
   } // namespace pool
 
 }
@@ -29,13 +29,13 @@ namespace quda
   template <class T> struct TensorCoreSharedMemory {
     __device__ inline operator T *()
     {
-      extern __shared__ int __smem[];
+      QUDA_DYNAMIC_SHARED(int, __smem);
       return (T *)__smem;
     }
 
     __device__ inline operator const T *() const
     {
-      extern __shared__ int __smem[];
+      QUDA_DYNAMIC_SHARED(int, __smem);
       return (T *)__smem;
     }
   };
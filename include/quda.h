@@ -836,7 +836,11 @@ extern "C" {
    *               QMP, the existing logical topology is used if it's been
    *               declared.  With MPI or as a fallback with QMP, the default
    *               ordering is lexicographical with the fourth ("t") index
-   *               varying fastest.
+   *               varying fastest, unless QUDA_ENABLE_TOPOLOGY_MAPPING=1,
+   *               in which case the ranks sharing a node are placed in a
+   *               block of the grid chosen to minimize inter-node halo
+   *               traffic (QUDA_TOPOLOGY_MAPPING_LATTICE optionally gives
+   *               the global lattice dimensions used to weight the faces).
    *
    * @param fdata  Pointer to any data required by "func" (may be NULL)
    *
@@ -1,6 +1,8 @@
 #pragma once
 
-#ifndef __CUDACC_RTC__
+#if defined(QUDA_TARGET_CPU)
+#include <quda_host_runtime.h>
+#elif !defined(__CUDACC_RTC__)
 #include <cuda.h>
 #include <cuda_runtime.h>
 #endif
@@ -31,6 +33,22 @@ namespace quda
   */
   qudaError_t qudaLaunchKernel(const void *func, const TuneParam &tp, void **args, qudaStream_t stream);
 
+#ifdef QUDA_TARGET_CPU
+  /**
+     @brief Execute a kernel on the host over the launch grid given by
+     tp.  Blocks are distributed over the OpenMP thread pool.  The
+     threads of a block are run in sequence, unless the kernel
+     synchronizes the block, in which case they are run as fibers
+     that switch at each barrier.  Whether a kernel synchronizes is
+     learned on its first launch, which always uses fibers.
+     @param[in] tp TuneParam containing the launch parameters
+     @param[in] kernel Host function invoked once per kernel thread
+     @param[in] arg Opaque argument passed to kernel
+     @param[in] func Kernel symbol, identifying the kernel
+  */
+  qudaError_t qudaLaunchKernel(const TuneParam &tp, void (*kernel)(const void *), const void *arg, const void *func);
+#endif
+
   /**
      @brief Templated wrapper around qudaLaunchKernel which can accept
      a templated kernel, and expects a kernel with a single Arg argument
@@ -42,8 +60,16 @@ namespace quda
   template <typename T, typename... Arg>
   qudaError_t qudaLaunchKernel(T *func, const TuneParam &tp, qudaStream_t stream, const Arg &...arg)
   {
+#ifdef QUDA_TARGET_CPU
+    // kernels are ordinary host functions on this target
+    auto body = [&]() { func(arg...); };
+    return qudaLaunchKernel(
+      tp, [](const void *b) { (*static_cast<const decltype(body) *>(b))(); }, &body,
+      reinterpret_cast<const void *>(func));
+#else
     const void *args[] = {&arg...};
     return qudaLaunchKernel(reinterpret_cast<const void *>(func), tp, const_cast<void **>(args), stream);
+#endif
   }
 
   /**
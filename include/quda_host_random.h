@@ -0,0 +1,202 @@
+#pragma once
+
+/**
+   @file quda_host_random.h
+
+   Host stand-in for the parts of CURAND that QUDA's kernels use: the
+   MRG32k3a generator state, its initialization with a seed and a
+   subsequence, and the uniform and normal variates drawn from it.
+   This header is used in place of <curand_kernel.h> when building
+   with QUDA_TARGET_TYPE=CPU.  The generator is L'Ecuyer's MRG32k3a
+   with subsequences 2^76 draws apart, as in CURAND, although the
+   seeding of the initial state is not bit-compatible with CURAND.
+ */
+
+#include <cmath>
+#include <cstdint>
+
+struct curandStateXORWOW;
+
+struct curandStateMRG32k3a {
+  uint64_t s1[3];
+  uint64_t s2[3];
+  int boxmuller_flag;
+  int boxmuller_flag_double;
+  float boxmuller_extra;
+  double boxmuller_extra_double;
+};
+
+namespace quda
+{
+
+  namespace mrg32k3a
+  {
+
+    constexpr uint64_t m1 = 4294967087ull;
+    constexpr uint64_t m2 = 4294944443ull;
+    constexpr uint64_t a12 = 1403580ull;
+    constexpr uint64_t a13n = 810728ull;
+    constexpr uint64_t a21 = 527612ull;
+    constexpr uint64_t a23n = 1370589ull;
+    constexpr double norm = 2.3283065498378288e-10; // 1 / (m1 + 1)
+
+    using matrix = uint64_t[3][3];
+
+    /** c = a * b mod m, where all elements are less than m < 2^32 */
+    inline void multiply(matrix &c, const matrix &a, const matrix &b, uint64_t m)
+    {
+      matrix r;
+      for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++) {
+          uint64_t sum = 0;
+          for (int k = 0; k < 3; k++) sum = (sum + a[i][k] * b[k][j] % m) % m;
+          r[i][j] = sum;
+        }
+      for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++) c[i][j] = r[i][j];
+    }
+
+    /** s = a * s mod m */
+    inline void apply(const matrix &a, uint64_t s[3], uint64_t m)
+    {
+      uint64_t r[3];
+      for (int i = 0; i < 3; i++) {
+        r[i] = 0;
+        for (int k = 0; k < 3; k++) r[i] = (r[i] + a[i][k] * s[k] % m) % m;
+      }
+      for (int i = 0; i < 3; i++) s[i] = r[i];
+    }
+
+    /** a = a^(2^e) mod m */
+    inline void square(matrix &a, int e, uint64_t m)
+    {
+      for (int i = 0; i < e; i++) multiply(a, a, a, m);
+    }
+
+    /** s = a^n * s mod m */
+    inline void skip(const matrix &t, uint64_t n, uint64_t s[3], uint64_t m)
+    {
+      matrix a;
+      for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++) a[i][j] = t[i][j];
+      for (; n; n >>= 1) {
+        if (n & 1) apply(a, s, m);
+        multiply(a, a, a, m);
+      }
+    }
+
+    /** the transition matrices of the two components, raised to the power 2^e */
+    inline void transition(matrix &a1, matrix &a2, int e)
+    {
+      const matrix t1 = {{0, 1, 0}, {0, 0, 1}, {m1 - a13n, a12, 0}};
+      const matrix t2 = {{0, 1, 0}, {0, 0, 1}, {m2 - a23n, 0, a21}};
+      for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++) {
+          a1[i][j] = t1[i][j];
+          a2[i][j] = t2[i][j];
+        }
+      square(a1, e, m1);
+      square(a2, e, m2);
+    }
+
+    /** advance the state and return the next output in [1, m1] */
+    inline uint64_t next(curandStateMRG32k3a &state)
+    {
+      uint64_t *s1 = state.s1, *s2 = state.s2;
+      uint64_t p1 = (a12 * s1[1] % m1 + m1 - a13n * s1[0] % m1) % m1;
+      uint64_t p2 = (a21 * s2[2] % m2 + m2 - a23n * s2[0] % m2) % m2;
+      s1[0] = s1[1];
+      s1[1] = s1[2];
+      s1[2] = p1;
+      s2[0] = s2[1];
+      s2[1] = s2[2];
+      s2[2] = p2;
+      return p1 > p2 ? p1 - p2 : p1 + m1 - p2;
+    }
+
+  } // namespace mrg32k3a
+
+} // namespace quda
+
+/**
+   @brief Initialize the generator state: the seed selects the
+   starting point, the subsequence advances it by 2^76 draws per unit
+   and the offset by single draws, so that each subsequence yields an
+   independent stream.
+ */
+inline void curand_init(unsigned long long seed, unsigned long long subsequence, unsigned long long offset,
+                        curandStateMRG32k3a *state)
+{
+  using namespace quda::mrg32k3a;
+  // neither component may be seeded with all zeros
+  uint64_t x1 = (seed ^ 0x55555555ull) & 0xffffffffull;
+  uint64_t x2 = ((seed >> 32) ^ 0xaaaaaaaaull) & 0xffffffffull;
+  for (int i = 0; i < 3; i++) {
+    state->s1[i] = (12345ull * (x1 % m1 + 1)) % m1;
+    state->s2[i] = (12345ull * (x2 % m2 + 1)) % m2;
+  }
+
+  matrix a1, a2;
+  if (subsequence) {
+    transition(a1, a2, 76);
+    skip(a1, subsequence, state->s1, m1);
+    skip(a2, subsequence, state->s2, m2);
+  }
+  if (offset) {
+    transition(a1, a2, 0);
+    skip(a1, offset, state->s1, m1);
+    skip(a2, offset, state->s2, m2);
+  }
+
+  state->boxmuller_flag = 0;
+  state->boxmuller_flag_double = 0;
+  state->boxmuller_extra = 0.0f;
+  state->boxmuller_extra_double = 0.0;
+}
+
+inline unsigned int curand(curandStateMRG32k3a *state)
+{
+  return static_cast<unsigned int>(quda::mrg32k3a::next(*state));
+}
+
+/** @return a uniform variate in (0, 1] */
+inline float curand_uniform(curandStateMRG32k3a *state)
+{
+  return static_cast<float>(quda::mrg32k3a::next(*state) * quda::mrg32k3a::norm);
+}
+
+/** @return a uniform variate in (0, 1] */
+inline double curand_uniform_double(curandStateMRG32k3a *state)
+{
+  return quda::mrg32k3a::next(*state) * quda::mrg32k3a::norm;
+}
+
+/** @return a normal variate, generated in pairs with the Box-Muller transform */
+inline double curand_normal_double(curandStateMRG32k3a *state)
+{
+  if (state->boxmuller_flag_double) {
+    state->boxmuller_flag_double = 0;
+    return state->boxmuller_extra_double;
+  }
+  double u = curand_uniform_double(state);
+  double v = curand_uniform_double(state);
+  double r = std::sqrt(-2.0 * std::log(u));
+  state->boxmuller_extra_double = r * std::cos(2.0 * M_PI * v);
+  state->boxmuller_flag_double = 1;
+  return r * std::sin(2.0 * M_PI * v);
+}
+
+/** @return a normal variate, generated in pairs with the Box-Muller transform */
+inline float curand_normal(curandStateMRG32k3a *state)
+{
+  if (state->boxmuller_flag) {
+    state->boxmuller_flag = 0;
+    return state->boxmuller_extra;
+  }
+  double u = curand_uniform_double(state);
+  double v = curand_uniform_double(state);
+  double r = std::sqrt(-2.0 * std::log(u));
+  state->boxmuller_extra = static_cast<float>(r * std::cos(2.0 * M_PI * v));
+  state->boxmuller_flag = 1;
+  return static_cast<float>(r * std::sin(2.0 * M_PI * v));
+}
@@ -0,0 +1,391 @@
+#pragma once
+
+/**
+   @file quda_host_runtime.h
+
+   Host stand-ins for the parts of the CUDA runtime and driver API
+   that QUDA's host code depends on: the built-in vector types, the
+   execution-space qualifiers, the stream / event handles and the
+   handful of runtime calls made outside of lib/targets.  This header
+   is used in place of <cuda.h> and <cuda_runtime.h> when building
+   with QUDA_TARGET_TYPE=CPU, so that no CUDA installation is needed.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+
+// execution space and memory qualifiers are meaningless on the host
+#define __host__
+#define __device__
+#define __global__
+// each worker of the host launcher runs one block at a time, so shared memory is per worker thread
+#define __shared__ thread_local
+#define __constant__
+#define __managed__
+#define __inline__ inline
+#define __forceinline__ inline __attribute__((always_inline))
+#define __align__(n) __attribute__((aligned(n)))
+#define __launch_bounds__(...)
+
+// the vector types are laid out and aligned as they are on the device
+// so that host and device field orders remain interchangeable
+#define QUDA_HOST_VECTOR_TYPE(type, name, align1, align2, align3, align4)                                              \
+  struct __align__(align1) name##1 { type x; };                                                                          \
+  struct __align__(align2) name##2 { type x, y; };                                                                       \
+  struct __align__(align3) name##3 { type x, y, z; };                                                                    \
+  struct __align__(align4) name##4 { type x, y, z, w; };                                                                 \
+  inline name##1 make_##name##1(type x) { return {x}; }                                                                  \
+  inline name##2 make_##name##2(type x, type y) { return {x, y}; }                                                       \
+  inline name##3 make_##name##3(type x, type y, type z) { return {x, y, z}; }                                            \
+  inline name##4 make_##name##4(type x, type y, type z, type w) { return {x, y, z, w}; }
+
+QUDA_HOST_VECTOR_TYPE(signed char, char, 1, 2, 1, 4)
+QUDA_HOST_VECTOR_TYPE(unsigned char, uchar, 1, 2, 1, 4)
+QUDA_HOST_VECTOR_TYPE(short, short, 2, 4, 2, 8)
+QUDA_HOST_VECTOR_TYPE(unsigned short, ushort, 2, 4, 2, 8)
+QUDA_HOST_VECTOR_TYPE(int, int, 4, 8, 4, 16)
+QUDA_HOST_VECTOR_TYPE(unsigned int, uint, 4, 8, 4, 16)
+QUDA_HOST_VECTOR_TYPE(long, long, 8, 16, 8, 16)
+QUDA_HOST_VECTOR_TYPE(unsigned long, ulong, 8, 16, 8, 16)
+QUDA_HOST_VECTOR_TYPE(long long, longlong, 8, 16, 8, 16)
+QUDA_HOST_VECTOR_TYPE(unsigned long long, ulonglong, 8, 16, 8, 16)
+QUDA_HOST_VECTOR_TYPE(float, float, 4, 8, 4, 16)
+QUDA_HOST_VECTOR_TYPE(double, double, 8, 16, 8, 16)
+
+#undef QUDA_HOST_VECTOR_TYPE
+
+struct dim3 {
+  unsigned int x, y, z;
+  constexpr dim3(unsigned int x = 1, unsigned int y = 1, unsigned int z = 1) : x(x), y(y), z(z) { }
+  constexpr dim3(uint3 v) : x(v.x), y(v.y), z(v.z) { }
+  constexpr operator uint3() const { return {x, y, z}; }
+};
+
+/**
+   Launch indices of the executing kernel thread, set by the host
+   kernel launcher (see qudaLaunchKernel) before each invocation
+ */
+extern thread_local uint3 threadIdx;
+extern thread_local uint3 blockIdx;
+extern thread_local dim3 blockDim;
+extern thread_local dim3 gridDim;
+
+/**
+   Block-wide barrier.  The host launcher runs the threads of a block
+   that synchronizes as fibers on one worker, and this switches to the
+   next thread of the block until all of them have reached the barrier.
+ */
+void __syncthreads();
+
+namespace quda
+{
+  /**
+     @return The dynamic shared memory of the executing block, a buffer
+     owned by the worker thread that is at least as large as the
+     shared_bytes of the launch
+   */
+  void *host_shared_memory();
+} // namespace quda
+
+/**
+   Device intrinsics used by the kernels.  Kernel threads of
+   different blocks run concurrently on the host thread pool, so the
+   atomics are real atomics, built on the compiler's __atomic builtins.
+ */
+inline unsigned int __float_as_uint(float x)
+{
+  unsigned int u;
+  memcpy(&u, &x, sizeof(u));
+  return u;
+}
+
+inline float __uint_as_float(unsigned int u)
+{
+  float x;
+  memcpy(&x, &u, sizeof(x));
+  return x;
+}
+
+inline long long __double_as_longlong(double x)
+{
+  long long u;
+  memcpy(&u, &x, sizeof(u));
+  return u;
+}
+
+inline double __longlong_as_double(long long u)
+{
+  double x;
+  memcpy(&x, &u, sizeof(x));
+  return x;
+}
+
+inline float rsqrt(float x) { return 1.0f / std::sqrt(x); }
+inline double rsqrt(double x) { return 1.0 / std::sqrt(x); }
+inline float __fdividef(float x, float y) { return x / y; }
+inline float __sinf(float x) { return std::sin(x); }
+inline float __cosf(float x) { return std::cos(x); }
+inline void sincos(double x, double *s, double *c) { *s = std::sin(x), *c = std::cos(x); }
+inline void sincos(float x, float *s, float *c) { *s = std::sin(x), *c = std::cos(x); }
+inline void sincosf(float x, float *s, float *c) { *s = std::sin(x), *c = std::cos(x); }
+
+inline int atomicCAS(int *address, int compare, int val)
+{
+  __atomic_compare_exchange_n(address, &compare, val, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+  return compare;
+}
+inline unsigned int atomicCAS(unsigned int *address, unsigned int compare, unsigned int val)
+{
+  __atomic_compare_exchange_n(address, &compare, val, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+  return compare;
+}
+inline unsigned long long atomicCAS(unsigned long long *address, unsigned long long compare, unsigned long long val)
+{
+  __atomic_compare_exchange_n(address, &compare, val, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+  return compare;
+}
+
+template <typename T> inline T atomicMax(T *address, T val)
+{
+  T old = __atomic_load_n(address, __ATOMIC_RELAXED);
+  while (old < val && !__atomic_compare_exchange_n(address, &old, val, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) { }
+  return old;
+}
+
+inline int atomicAdd(int *address, int val) { return __atomic_fetch_add(address, val, __ATOMIC_RELAXED); }
+inline unsigned int atomicAdd(unsigned int *address, unsigned int val)
+{
+  return __atomic_fetch_add(address, val, __ATOMIC_RELAXED);
+}
+inline unsigned long long atomicAdd(unsigned long long *address, unsigned long long val)
+{
+  return __atomic_fetch_add(address, val, __ATOMIC_RELAXED);
+}
+
+namespace quda
+{
+  /** floating-point atomic addition as a compare-and-swap loop */
+  template <typename T> inline T host_atomic_add(T *address, T val)
+  {
+    T old, sum;
+    __atomic_load(address, &old, __ATOMIC_RELAXED);
+    do { sum = old + val; } while (!__atomic_compare_exchange(address, &old, &sum, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    return old;
+  }
+} // namespace quda
+
+inline float atomicAdd(float *address, float val) { return quda::host_atomic_add(address, val); }
+inline double atomicAdd(double *address, double val) { return quda::host_atomic_add(address, val); }
+
+// error handling
+typedef int CUresult;
+enum { CUDA_SUCCESS = 0, CUDA_ERROR_INVALID_VALUE = 1 };
+
+enum cudaError_t {
+  cudaSuccess = 0,
+  cudaErrorInvalidValue = 1,
+  cudaErrorNotReady = 600,
+  cudaErrorNotSupported = 801
+};
+
+inline cudaError_t cudaGetLastError() { return cudaSuccess; }
+inline cudaError_t cudaPeekAtLastError() { return cudaSuccess; }
+inline const char *cudaGetErrorString(cudaError_t error)
+{
+  switch (error) {
+  case cudaSuccess: return "no error";
+  case cudaErrorInvalidValue: return "invalid argument";
+  case cudaErrorNotReady: return "device not ready";
+  case cudaErrorNotSupported: return "operation not supported on the host target";
+  default: return "unknown error";
+  }
+}
+
+/**
+   Device description, filled in by the CPU target from the host
+   (see lib/targets/cpu/device.cpp)
+ */
+struct cudaDeviceProp {
+  char name[256];
+  size_t totalGlobalMem;
+  size_t sharedMemPerBlock;
+  size_t sharedMemPerBlockOptin;
+  size_t sharedMemPerMultiprocessor;
+  size_t totalConstMem;
+  size_t memPitch;
+  size_t surfaceAlignment;
+  int regsPerBlock;
+  int warpSize;
+  int maxThreadsPerBlock;
+  int maxThreadsDim[3];
+  int maxGridSize[3];
+  int maxThreadsPerMultiProcessor;
+  int clockRate;
+  int major;
+  int minor;
+  int multiProcessorCount;
+  int deviceOverlap;
+  int kernelExecTimeoutEnabled;
+  int integrated;
+  int canMapHostMemory;
+  int computeMode;
+  int concurrentKernels;
+  int ECCEnabled;
+  int pciBusID;
+  int pciDeviceID;
+  int pciDomainID;
+  int tccDriver;
+  int asyncEngineCount;
+  int unifiedAddressing;
+  int memoryClockRate;
+  int memoryBusWidth;
+  int l2CacheSize;
+  int managedMemory;
+  int concurrentManagedAccess;
+  int pageableMemoryAccess;
+  int directManagedMemAccessFromHost;
+};
+
+enum cudaDeviceP2PAttr { cudaDevP2PAttrPerformanceRank = 1, cudaDevP2PAttrAccessSupported = 2 };
+
+inline cudaError_t cudaDeviceGetP2PAttribute(int *value, cudaDeviceP2PAttr, int, int)
+{
+  *value = 0;
+  return cudaSuccess;
+}
+
+inline cudaError_t cudaDeviceSynchronize() { return cudaSuccess; }
+
+// all work is issued synchronously, so streams are opaque tokens
+typedef struct CUstream_st *cudaStream_t;
+
+inline cudaError_t cudaStreamCreate(cudaStream_t *stream)
+{
+  *stream = nullptr;
+  return cudaSuccess;
+}
+
+inline cudaError_t cudaStreamDestroy(cudaStream_t) { return cudaSuccess; }
+
+/**
+   Events record the host time at which they are issued, which is
+   when the preceding work has completed on this target
+ */
+struct CUevent_st {
+  std::chrono::steady_clock::time_point time;
+};
+typedef CUevent_st *cudaEvent_t;
+
+enum { cudaEventDefault = 0, cudaEventBlockingSync = 1, cudaEventDisableTiming = 2, cudaEventInterprocess = 4 };
+
+inline cudaError_t cudaEventCreate(cudaEvent_t *event)
+{
+  *event = new CUevent_st {std::chrono::steady_clock::now()};
+  return cudaSuccess;
+}
+
+inline cudaError_t cudaEventCreate(cudaEvent_t *event, unsigned int) { return cudaEventCreate(event); }
+
+inline cudaError_t cudaEventCreateWithFlags(cudaEvent_t *event, unsigned int) { return cudaEventCreate(event); }
+
+inline cudaError_t cudaEventDestroy(cudaEvent_t event)
+{
+  delete event;
+  return cudaSuccess;
+}
+
+inline cudaError_t cudaEventRecord(cudaEvent_t event, cudaStream_t = nullptr)
+{
+  event->time = std::chrono::steady_clock::now();
+  return cudaSuccess;
+}
+
+inline cudaError_t cudaEventQuery(cudaEvent_t) { return cudaSuccess; }
+
+inline cudaError_t cudaEventSynchronize(cudaEvent_t) { return cudaSuccess; }
+
+inline cudaError_t cudaEventElapsedTime(float *ms, cudaEvent_t start, cudaEvent_t end)
+{
+  *ms = std::chrono::duration<float, std::milli>(end->time - start->time).count();
+  return cudaSuccess;
+}
+
+// memory transfers are plain host copies
+enum cudaMemcpyKind {
+  cudaMemcpyHostToHost = 0,
+  cudaMemcpyHostToDevice = 1,
+  cudaMemcpyDeviceToHost = 2,
+  cudaMemcpyDeviceToDevice = 3,
+  cudaMemcpyDefault = 4
+};
+
+inline cudaError_t cudaMemcpy(void *dst, const void *src, size_t count, cudaMemcpyKind)
+{
+  if (count) memcpy(dst, src, count);
+  return cudaSuccess;
+}
+
+inline cudaError_t cudaMemcpyAsync(void *dst, const void *src, size_t count, cudaMemcpyKind kind, cudaStream_t = nullptr)
+{
+  return cudaMemcpy(dst, src, count, kind);
+}
+
+inline cudaError_t cudaMemcpy2DAsync(void *dst, size_t dpitch, const void *src, size_t spitch, size_t width,
+                                     size_t height, cudaMemcpyKind, cudaStream_t = nullptr)
+{
+  for (size_t i = 0; i < height; i++)
+    memcpy(static_cast<char *>(dst) + i * dpitch, static_cast<const char *>(src) + i * spitch, width);
+  return cudaSuccess;
+}
+
+template <typename T>
+inline cudaError_t cudaMemcpyToSymbolAsync(T &symbol, const void *src, size_t count, size_t offset = 0,
+                                           cudaMemcpyKind = cudaMemcpyHostToDevice, cudaStream_t = nullptr)
+{
+  if (count) memcpy(reinterpret_cast<char *>(&symbol) + offset, src, count);
+  return cudaSuccess;
+}
+
+template <typename T>
+inline cudaError_t cudaMemcpyToSymbol(T &symbol, const void *src, size_t count, size_t offset = 0,
+                                      cudaMemcpyKind kind = cudaMemcpyHostToDevice)
+{
+  return cudaMemcpyToSymbolAsync(symbol, src, count, offset, kind);
+}
+
+inline cudaError_t cudaMemsetAsync(void *ptr, int value, size_t count, cudaStream_t = nullptr)
+{
+  if (count) memset(ptr, value, count);
+  return cudaSuccess;
+}
+
+// host memory is always accessible, so registration is a no-op
+enum { cudaHostRegisterDefault = 0, cudaHostRegisterPortable = 1, cudaHostRegisterMapped = 2 };
+
+inline cudaError_t cudaHostRegister(void *, size_t, unsigned int) { return cudaSuccess; }
+
+inline cudaError_t cudaHostUnregister(void *) { return cudaSuccess; }
+
+// there is no peer-to-peer transport between processes on this target
+struct cudaIpcMemHandle_t {
+  char reserved[64];
+};
+
+struct cudaIpcEventHandle_t {
+  char reserved[64];
+};
+
+enum { cudaIpcMemLazyEnablePeerAccess = 1 };
+
+inline cudaError_t cudaIpcGetMemHandle(cudaIpcMemHandle_t *, void *) { return cudaErrorNotSupported; }
+
+inline cudaError_t cudaIpcOpenMemHandle(void **, cudaIpcMemHandle_t, unsigned int) { return cudaErrorNotSupported; }
+
+inline cudaError_t cudaIpcCloseMemHandle(void *) { return cudaErrorNotSupported; }
+
+inline cudaError_t cudaIpcGetEventHandle(cudaIpcEventHandle_t *, cudaEvent_t) { return cudaErrorNotSupported; }
+
+inline cudaError_t cudaIpcOpenEventHandle(cudaEvent_t *, cudaIpcEventHandle_t) { return cudaErrorNotSupported; }
@@ -5,7 +5,11 @@
 #ifdef __CUDACC_RTC__
 #define RNG int
 #else
+#ifdef QUDA_TARGET_CPU
+#include <quda_host_random.h>
+#else
 #include <curand_kernel.h>
+#endif
 
 namespace quda {
 
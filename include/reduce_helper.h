@@ -241,6 +241,42 @@ namespace quda
       }
     }
 
+#elif defined(QUDA_TARGET_CPU)
+    /**
+       @brief Host variant of the block reduction.  The host kernel
+       launcher runs the threads of a block in sequence on a single
+       worker, so each thread folds its value into the partial of its
+       block, and the last block to complete reduces the partials.
+
+       @param in The input per-thread data to be reduced
+       @param idx In the case of multiple reductions, idx identifies
+       which reduction this thread block corresponds to.
+    */
+    template <int block_size_x, int block_size_y, bool do_sum = true, typename Reducer = cub::Sum>
+    inline void reduce2d(const T &in, const int idx = 0)
+    {
+      Reducer r;
+      T &aggregate = partial[idx * gridDim.x + blockIdx.x];
+      if (threadIdx.x == 0 && threadIdx.y == 0 && threadIdx.z == 0)
+        aggregate = in;
+      else
+        aggregate = do_sum ? aggregate + in : r(aggregate, in);
+
+      if (threadIdx.x == blockDim.x - 1 && threadIdx.y == blockDim.y - 1 && threadIdx.z == blockDim.z - 1) {
+        // increment global block counter, publishing this block's partial
+        auto value = __atomic_fetch_add(&count[idx], 1u, __ATOMIC_ACQ_REL);
+
+        // finish the reduction if last block
+        if (value == gridDim.x - 1) {
+          T sum = partial[idx * gridDim.x];
+          for (unsigned int i = 1; i < gridDim.x; i++)
+            sum = do_sum ? sum + partial[idx * gridDim.x + i] : r(sum, partial[idx * gridDim.x + i]);
+          result_d[idx] = sum;
+          count[idx] = 0; // set to zero for next time
+        }
+      }
+    }
+
 #else
     /**
        @brief Generic reduction function that reduces block-distributed
@@ -7,6 +7,17 @@
    sharing data between threads in a thread block.
  */
 
+/**
+   @brief Declare name as a pointer to the dynamic shared memory of
+   the thread block, with element type type.  On the CPU target this is
+   a buffer of the worker thread that is executing the block.
+ */
+#ifdef QUDA_TARGET_CPU
+#define QUDA_DYNAMIC_SHARED(type, name) type *name = reinterpret_cast<type *>(quda::host_shared_memory())
+#else
+#define QUDA_DYNAMIC_SHARED(type, name) extern __shared__ type name[]
+#endif
+
 namespace quda
 {
 
@@ -27,7 +38,7 @@ namespace quda
      */
     __device__ inline real *cache()
     {
-      extern __shared__ int cache_[];
+      QUDA_DYNAMIC_SHARED(int, cache_);
       return reinterpret_cast<real *>(cache_);
     }
 
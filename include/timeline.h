@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+
+namespace quda
+{
+
+  /**
+     A host-side timeline of QUDA events (profile intervals, kernel
+     launches and tuning, halo communication and solver iterations),
+     recorded when QUDA_ENABLE_TIMELINE=1 and written out at endQuda
+     as a Chrome trace that can be viewed with chrome://tracing or
+     ui.perfetto.dev.  Events are stamped with steady_clock and
+     appended to a ring buffer owned by the recording thread, so
+     recording takes no locks; once a ring is full the oldest events
+     are overwritten.  The ring size is set with QUDA_TIMELINE_EVENTS
+     (default 262144 events per thread).
+
+     Names, categories and details are stored by pointer, so they must
+     outlive the timeline: use string literals or intern().
+  */
+  namespace timeline
+  {
+
+    bool init_enabled();
+
+    /**
+       @return Whether the timeline is being recorded
+    */
+    inline bool enabled()
+    {
+      static const bool enabled = init_enabled();
+      return enabled;
+    }
+
+    /**
+       @return The steady_clock time in nanoseconds
+    */
+    int64_t now();
+
+    /**
+       @brief Return a copy of str that lives as long as the process.
+       Repeated calls with the same string return the same pointer.
+    */
+    const char *intern(const char *str);
+
+    /**
+       @brief Record an interval that started at start and ends now
+       @param[in] name Event name
+       @param[in] category Event category
+       @param[in] start Start time from now()
+       @param[in] detail Optional string shown with the event
+       @param[in] arg Optional integer shown with the event (ignored if negative)
+    */
+    void complete(const char *name, const char *category, int64_t start, const char *detail = nullptr,
+                  int64_t arg = -1);
+
+    /**
+       @brief Record an instantaneous event
+       @param[in] name Event name
+       @param[in] category Event category
+       @param[in] detail Optional string shown with the event
+       @param[in] arg Optional integer shown with the event (ignored if negative)
+    */
+    void instant(const char *name, const char *category, const char *detail = nullptr, int64_t arg = -1);
+
+    /**
+       @brief Write the events recorded by every thread to
+       timeline_<rank>.json in QUDA_RESOURCE_PATH (or the working
+       directory if unset).  Timestamps are offset to the system clock
+       and each rank is written as its own process, so the per-rank
+       files can be merged by concatenating their traceEvents arrays.
+       With thread comms, whose ranks share the process, only the
+       threads created by this rank are written.
+    */
+    void save();
+
+  } // namespace timeline
+
+} // namespace quda
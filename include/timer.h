@@ -23,6 +23,7 @@ namespace quda {
 #else
 
 #include <sys/time.h>
+#include <timeline.h>
 
 #ifdef INTERFACE_NVTX
 #if QUDA_NVTX_VERSION == 3
@@ -183,6 +184,16 @@ namespace quda {
     bool switchOff;
     bool use_global;
 
+    // timeline recording (see timeline.h)
+    const char *trace_name;                  /**< interned copy of fname */
+    int64_t trace_start[QUDA_PROFILE_COUNT]; /**< steady_clock time at which each timer was started */
+
+    void traceStop(QudaProfileType idx)
+    {
+      if (!trace_name) trace_name = timeline::intern(fname.c_str());
+      timeline::complete(trace_name, pname[idx].c_str(), trace_start[idx]);
+    }
+
     // global timer
     static Timer global_profile[QUDA_PROFILE_COUNT];
     static bool global_switchOff[QUDA_PROFILE_COUNT];
@@ -214,9 +225,13 @@ namespace quda {
     }
 
   public:
-    TimeProfile(std::string fname) : fname(fname), switchOff(false), use_global(true) { ; }
+    TimeProfile(std::string fname) : fname(fname), switchOff(false), use_global(true), trace_name(nullptr) { ; }
 
-    TimeProfile(std::string fname, bool use_global) : fname(fname), switchOff(false), use_global(use_global) { ; }
+    TimeProfile(std::string fname, bool use_global) :
+      fname(fname), switchOff(false), use_global(use_global), trace_name(nullptr)
+    {
+      ;
+    }
 
     /**< Print out the profile information */
     void Print();
@@ -226,9 +241,11 @@ namespace quda {
       if (!profile[QUDA_PROFILE_TOTAL].running && idx != QUDA_PROFILE_TOTAL) {
 	profile[QUDA_PROFILE_TOTAL].Start(func,file,line);
         switchOff = true;
+        if (timeline::enabled()) trace_start[QUDA_PROFILE_TOTAL] = timeline::now();
       }
 
       profile[idx].Start(func, file, line); 
+      if (timeline::enabled()) trace_start[idx] = timeline::now();
       PUSH_RANGE(fname.c_str(),idx)
 	if (use_global) StartGlobal(func,file,line,idx);
     }
@@ -237,11 +254,13 @@ namespace quda {
     void Stop_(const char *func, const char *file, int line, QudaProfileType idx) {
       profile[idx].Stop(func, file, line); 
       POP_RANGE
+      if (timeline::enabled()) traceStop(idx);
 
       // switch off total timer if we need to
       if (switchOff && idx != QUDA_PROFILE_TOTAL) {
         profile[QUDA_PROFILE_TOTAL].Stop(func,file,line);
         switchOff = false;
+        if (timeline::enabled()) traceStop(QUDA_PROFILE_TOTAL);
       }
       if (use_global) StopGlobal(func,file,line,idx);
     }
@@ -3,8 +3,9 @@
 // ensure that we include the quda_define.h file to ensure that __COMPUTE_CAPABILITY__ is set
 #include <quda_define.h>
 
-// trove requires the warp shuffle instructions introduced with Kepler and has issues with device debug
-#if __COMPUTE_CAPABILITY__ >= 300 && !defined(DEVICE_DEBUG)
+// trove requires the warp shuffle instructions introduced with Kepler and has issues with device debug, and there
+// are no warps on the CPU target
+#if __COMPUTE_CAPABILITY__ >= 300 && !defined(DEVICE_DEBUG) && !defined(QUDA_TARGET_CPU)
 #include <trove/ptr.h>
 #else
 #define DISABLE_TROVE
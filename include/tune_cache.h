@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <tune_quda.h>
+
+/**
+   @file tune_cache.h
+
+   Interface between the tunecache (lib/tune_cache.cpp), which is
+   shared by all targets, and the target-specific autotuner in
+   lib/targets/<target>/tune.cpp.
+ */
+
+namespace quda
+{
+
+  /**
+     @return The tunecache of this process
+  */
+  TuneCache &tuneCache();
+
+  /**
+     @return The directory set by QUDA_RESOURCE_PATH, or an empty
+     string if the tuned parameters are not cached to disk
+  */
+  const std::string &tuneResourcePath();
+
+  /**
+     @brief Look up key in the tunecache, falling back to the mapped
+     binary tunecache.  Entries found in the latter are copied into
+     the tunecache, so only the kernels that a job actually launches
+     are ever materialized.
+     @param[in] key The key to look up
+     @return The entry, or tuneCache().end() if there is none
+  */
+  TuneCache::iterator findTuneCache(const TuneKey &key);
+
+  /**
+     @brief Record that an entry has been tuned since the last save,
+     so that the next saveTuneCache() appends it to the journal
+     @param[in] entry The newly tuned entry
+  */
+  void markTuneCacheUnsaved(TuneCache::iterator entry);
+
+  /**
+     @brief Distribute the tunecache from global rank 0 to all other
+     ranks
+  */
+  void broadcastTuneCache();
+
+  /**
+     @return Whether the autotuner is warm started from entries tuned
+     at other volumes, which is set with QUDA_TUNE_WARM_START=1
+  */
+  bool warmStart();
+
+  /**
+     @brief Find the tunecache entry with the same name and aux as key
+     at the nearest volume, which is used to seed the autotuner when
+     warm starting
+     @param[in] key The key being tuned
+     @param[out] seed The parameters of the seed entry, if found
+     @return The key of the seed entry, or nullptr if there is none
+  */
+  const TuneKey *findWarmStartSeed(const TuneKey &key, TuneParam &seed);
+
+} // namespace quda
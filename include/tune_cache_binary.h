@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <tune_quda.h>
+
+namespace quda
+{
+
+  /**
+     @brief Read-only, memory-mapped view of a binary tunecache
+     (tunecache.bin).  The file holds a versioned header, the entries as
+     fixed-size records in the same order as tunecache.tsv, and an index
+     of (digest, record) pairs sorted by TuneKey::digest.  Opening the
+     file parses nothing, a lookup is a binary search over the index
+     followed by a string comparison of the candidate records, and
+     every process on a node shares the same pages.
+  */
+  class TuneCacheBinary
+  {
+    const char *data = nullptr;
+    size_t bytes = 0;
+
+  public:
+    TuneCacheBinary() = default;
+    TuneCacheBinary(const TuneCacheBinary &) = delete;
+    TuneCacheBinary &operator=(const TuneCacheBinary &) = delete;
+    ~TuneCacheBinary() { close(); }
+
+    /**
+       @brief Map a binary tunecache
+       @param[in] path The file to map
+       @param[in] build Build string the file must have been written
+       with, or an empty string to skip the check
+       @return False if the file does not exist
+    */
+    bool open(const std::string &path, const std::string &build);
+
+    /**
+       @brief Unmap the file
+    */
+    void close();
+
+    /**
+       @return Whether a file is mapped
+    */
+    bool isOpen() const { return data; }
+
+    /**
+       @return The number of entries in the file
+    */
+    size_t size() const;
+
+    /**
+       @brief Look up an entry
+       @param[in] key The key to look up
+       @param[out] param The entry, if found
+       @return Whether the key is present
+    */
+    bool find(const TuneKey &key, TuneParam &param) const;
+
+    /**
+       @brief Merge every entry into cache, keeping the faster of any
+       duplicates
+       @param[in,out] cache The cache we are merging into
+    */
+    void read(TuneCache &cache) const;
+  };
+
+  /**
+     @brief Write a binary tunecache.  The file is written under a
+     temporary name and renamed into place, so a process that has the
+     previous file mapped is unaffected.
+     @param[in] path The file to write
+     @param[in] cache The entries to write
+     @param[in] build The build string to stamp the file with
+     @return Whether the file was written
+  */
+  bool writeTuneCacheBinary(const std::string &path, const TuneCache &cache, const std::string &build);
+
+} // namespace quda
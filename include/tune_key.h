@@ -2,6 +2,7 @@
 #define _TUNE_KEY_H
 
 #include <cstring>
+#include <cstdint>
 
 namespace quda {
 
@@ -14,16 +15,57 @@ namespace quda {
     char name[name_n];
     char aux[aux_n];
 
+    /**
+       64-bit FNV-1a digest of volume, name and aux (each including
+       its terminator), used to index the tunecache.  It is computed
+       when the key is constructed; any code that edits the strings
+       afterwards (e.g., appending to aux) must call rehash().
+    */
+    uint64_t digest;
+
+    static constexpr uint64_t digest_basis = 14695981039346656037ull;
+    static constexpr uint64_t digest_prime = 1099511628211ull;
+
+    /**
+       @brief Copy a null-terminated string while folding it into the digest
+       @return The updated digest
+    */
+    static inline uint64_t copy_hash(char *dst, const char *src, uint64_t h)
+    {
+      char c;
+      do {
+        c = *src++;
+        *dst++ = c;
+        h = (h ^ static_cast<unsigned char>(c)) * digest_prime;
+      } while (c);
+      return h;
+    }
+
+    /**
+       @brief Fold a null-terminated string into the digest
+       @return The updated digest
+    */
+    static inline uint64_t hash(const char *src, uint64_t h)
+    {
+      char c;
+      do {
+        c = *src++;
+        h = (h ^ static_cast<unsigned char>(c)) * digest_prime;
+      } while (c);
+      return h;
+    }
+
     TuneKey() { }
     TuneKey(const char v[], const char n[], const char a[]="type=default") {
-      strcpy(volume, v);
-      strcpy(name, n);
-      strcpy(aux, a);
-    } 
+      digest = copy_hash(volume, v, digest_basis);
+      digest = copy_hash(name, n, digest);
+      digest = copy_hash(aux, a, digest);
+    }
     TuneKey(const TuneKey &key) {
       strcpy(volume,key.volume);
       strcpy(name,key.name);
       strcpy(aux,key.aux);
+      digest = key.digest;
     }
 
     TuneKey& operator=(const TuneKey &key) {
@@ -31,10 +73,26 @@ namespace quda {
 	strcpy(volume,key.volume);
 	strcpy(name,key.name);
 	strcpy(aux,key.aux);
+        digest = key.digest;
       }
       return *this;
     }
 
+    /**
+       @brief Recompute the digest after the strings have been modified in place
+    */
+    void rehash() { digest = hash(aux, hash(name, hash(volume, digest_basis))); }
+
+    /**
+       Equality test: the strings are only compared when the digests
+       agree, so a mismatch is normally decided by a single integer
+       comparison.
+    */
+    bool operator==(const TuneKey &other) const {
+      return digest == other.digest && std::strcmp(aux, other.aux) == 0 && std::strcmp(name, other.name) == 0
+        && std::strcmp(volume, other.volume) == 0;
+    }
+
     bool operator<(const TuneKey &other) const {
       int vc = std::strcmp(volume, other.volume);
       if (vc < 0) {
@@ -7,6 +7,7 @@
 #include <cfloat>
 #include <stdarg.h>
 #include <map>
+#include <vector>
 #include <algorithm>
 #include <typeinfo>
 
@@ -80,10 +81,113 @@ namespace quda {
 
 #ifndef __CUDACC_RTC__
   /**
-   * @brief Returns a reference to the tunecache map
+     @brief The tunecache.  Entries are stored in a std::map, which
+     keeps them in the sorted order used when serializing the cache,
+     and are looked up through an open-addressing hash index keyed by
+     TuneKey::digest.  A lookup hence costs a probe over a few 64-bit
+     digests and a single string comparison on a digest match, rather
+     than O(log n) rounds of strcmp.  Entries are never erased, so the
+     map iterators held by the index remain valid.
+  */
+  class TuneCache
+  {
+
+  public:
+    typedef std::map<TuneKey, TuneParam> map;
+    typedef map::iterator iterator;
+    typedef map::const_iterator const_iterator;
+
+  private:
+    struct Slot {
+      uint64_t digest;
+      iterator entry;
+      bool used;
+      Slot() : digest(0), used(false) { }
+    };
+
+    map cache;
+    std::vector<Slot> index; // power-of-two size, kept at most half full
+
+    /**
+       @brief Return the slot holding key, or the empty slot where it would go
+    */
+    size_t probe(const TuneKey &key) const
+    {
+      const size_t mask = index.size() - 1;
+      size_t i = key.digest & mask;
+      while (index[i].used && !(index[i].digest == key.digest && index[i].entry->first == key)) i = (i + 1) & mask;
+      return i;
+    }
+
+    void insertIndex(iterator entry)
+    {
+      if (2 * (cache.size() + 1) > index.size()) {
+        // grow and rebuild the index from the map
+        index.assign(std::max(static_cast<size_t>(1024), 2 * index.size()), Slot());
+        for (auto it = cache.begin(); it != cache.end(); it++) {
+          if (it == entry) continue;
+          Slot &slot = index[probe(it->first)];
+          slot.digest = it->first.digest;
+          slot.entry = it;
+          slot.used = true;
+        }
+      }
+      Slot &slot = index[probe(entry->first)];
+      slot.digest = entry->first.digest;
+      slot.entry = entry;
+      slot.used = true;
+    }
+
+  public:
+    TuneCache() = default;
+
+    // a copy of the index would hold iterators into the original's map
+    TuneCache(const TuneCache &) = delete;
+    TuneCache &operator=(const TuneCache &) = delete;
+
+    iterator find(const TuneKey &key)
+    {
+      if (index.empty()) return cache.end();
+      const Slot &slot = index[probe(key)];
+      return slot.used ? slot.entry : cache.end();
+    }
+
+    const_iterator find(const TuneKey &key) const
+    {
+      if (index.empty()) return cache.end();
+      const Slot &slot = index[probe(key)];
+      return slot.used ? const_iterator(slot.entry) : cache.end();
+    }
+
+    TuneParam &operator[](const TuneKey &key)
+    {
+      iterator it = find(key);
+      if (it != cache.end()) return it->second;
+      it = cache.emplace(key, TuneParam()).first;
+      insertIndex(it);
+      return it->second;
+    }
+
+    iterator begin() { return cache.begin(); }
+    iterator end() { return cache.end(); }
+    const_iterator begin() const { return cache.begin(); }
+    const_iterator end() const { return cache.end(); }
+    size_t size() const { return cache.size(); }
+  };
+
+  /**
+   * @brief Returns a reference to the tunecache
    * @return tunecache reference
    */
-  const std::map<TuneKey, TuneParam> &getTuneCache();
+  const TuneCache &getTuneCache();
+
+  /**
+   * @brief Returns whether the tunecache holds an entry for key.
+   * Unlike getTuneCache().find(), this also consults the binary
+   * tunecache if it has been mapped.
+   * @param[in] key The key to look up
+   */
+  bool inTuneCache(const TuneKey &key);
 #endif
 
   class Tunable {
@@ -179,7 +283,10 @@ namespace quda {
      */
     unsigned int maxBlocksPerSM() const
     {
-#if CUDA_VERSION >= 11000
+#if defined(QUDA_TARGET_CPU)
+      // the host thread pool has no residency limit, so we report the CUDA 11 default
+      return 32;
+#elif CUDA_VERSION >= 11000
       static int max_blocks_per_sm = 0;
       if (!max_blocks_per_sm) cudaDeviceGetAttribute(&max_blocks_per_sm, cudaDevAttrMaxBlocksPerMultiprocessor, comm_gpuid());
       return max_blocks_per_sm;
@@ -286,9 +393,12 @@ namespace quda {
       if (!getTuning()) return true;
 
       TuneKey key = tuneKey();
-      if (use_managed_memory()) strcat(key.aux, ",managed");
+      if (use_managed_memory()) {
+        strcat(key.aux, ",managed");
+        key.rehash();
+      }
       // if key is present in cache then already tuned
-      return getTuneCache().find(key) != getTuneCache().end();
+      return inTuneCache(key);
 #else
       return true;
 #endif
@@ -358,6 +468,30 @@ namespace quda {
       return advanceSharedBytes(param) || advanceBlockDim(param) || advanceGridDim(param) || advanceAux(param);
     }
 
+    /**
+       @brief Whether param lies in the neighbourhood of seed that is
+       explored when the autotuner is warm started from an entry tuned
+       at a different volume (QUDA_TUNE_WARM_START=1).  By default the
+       block dimensions must be within a factor of two of the seed, the
+       grid dimension within 25% of it if it is being tuned, and the
+       aux dimension must match; the shared memory is unconstrained.
+       @param[in] param The candidate launch parameters
+       @param[in] seed The launch parameters we are starting from
+       @return Whether param should be timed
+    */
+    virtual bool warmStartNeighbour(const TuneParam &param, const TuneParam &seed) const
+    {
+      auto near_block = [](unsigned int x, unsigned int x0) { return 2 * x >= x0 && x <= 2 * x0; };
+      auto near_grid = [](unsigned int x, unsigned int x0) { return 4 * x >= 3 * x0 && 4 * x <= 5 * x0; };
+
+      if (!near_block(param.block.x, seed.block.x) || !near_block(param.block.y, seed.block.y)
+          || !near_block(param.block.z, seed.block.z))
+        return false;
+      if (tuneGridDim() && !near_grid(param.grid.x, seed.grid.x)) return false;
+      return param.aux.x == seed.aux.x && param.aux.y == seed.aux.y && param.aux.z == seed.aux.z
+        && param.aux.w == seed.aux.w;
+    }
+
     /**
      * Check the launch parameters of the kernel to ensure that they are
      * valid for the current device.
@@ -418,7 +552,8 @@ namespace quda {
     */
     bool tuneGridDim() const final { return true; }
 
-    unsigned int minGridSize() const { return maxGridSize() / 8; }
+    // at least one block, so that the grid step is nonzero on devices (and hosts) with few multiprocessors
+    unsigned int minGridSize() const { return std::max(maxGridSize() / 8, 1u); }
     int gridStep() const { return minGridSize(); }
 
     /**
@@ -578,6 +713,17 @@ namespace quda {
   void loadTuneCache();
   void saveTuneCache(bool error = false);
 
+  /**
+   * @brief Convert a tunecache between the human-readable text format
+   * (tunecache.tsv) and the memory-mapped binary format
+   * (tunecache.bin) used when QUDA_TUNECACHE_BINARY=1.  The direction
+   * is set by the file extensions (".bin" for binary).  The
+   * tune_cache_convert utility built with the tests wraps this.
+   * @param[in] in_path The file to read
+   * @param[in] out_path The file to write
+   */
+  void convertTuneCache(const std::string &in_path, const std::string &out_path);
+
   /**
    * @brief Save profile to disk.
    */
@@ -590,6 +736,19 @@ namespace quda {
 
   TuneParam& tuneLaunch(Tunable &tunable, QudaTune enabled, QudaVerbosity verbosity);
 
+  /**
+   * @brief Report the performance of a Tunable that was executed on
+   * the host (e.g., a CPU-location field reorder) and so was not timed
+   * by the autotuner.  The report uses the same form as the tuning
+   * output, and is printed once per TuneKey at QUDA_VERBOSE and on
+   * every call at QUDA_DEBUG_VERBOSE.  Nothing is reported while
+   * tuning is in progress.
+   * @param[in] tunable The Tunable instance that was executed
+   * @param[in] time The host wall-clock time of the execution in seconds
+   * @param[in] verbosity The verbosity level
+   */
+  void reportHostLaunch(const Tunable &tunable, double time, QudaVerbosity verbosity);
+
   /**
    * @brief Post an event in the trace, recording where it was posted
    */
@@ -141,6 +141,13 @@ namespace quda {
 #endif // MULTI_GPU
 
 
+#ifdef QUDA_TARGET_CPU
+
+// no device runtime is present on the CPU target so there is no error state to query
+#define checkCudaErrorNoSync() do { } while (0)
+
+#else
+
 #define checkCudaErrorNoSync() do {                    \
   cudaError_t error = cudaGetLastError();              \
   if (error != cudaSuccess)                            \
@@ -148,6 +155,8 @@ namespace quda {
     ;\
 } while (0)
 
+#endif // QUDA_TARGET_CPU
+
 
 #ifdef HOST_DEBUG
 
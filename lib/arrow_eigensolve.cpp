@@ -0,0 +1,339 @@
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <algorithm>
+
+#include <quda_internal.h>
+#include <arrow_eigensolve.h>
+#include <eigen_helper.h>
+
+namespace quda
+{
+
+  // Tridiagonal blocks at or below this size are solved directly with QR iteration
+  constexpr int arrow_base_size = 32;
+
+  /**
+     @brief Eigendecomposition of the real symmetric arrowhead matrix
+     H = [diag(d) z; z^T a], with the head in the last row.
+
+     Entries of z that are negligible, and diagonal entries that are
+     indistinguishable, are deflated first (the latter by a Givens
+     rotation that concentrates their z weight in one entry).  Each of
+     the remaining eigenvalues is the unique root of the secular
+     equation in an interval between consecutive poles, and is found
+     relative to the nearest pole so that its distance to that pole is
+     known to full relative precision.  The z vector is then recomputed
+     from the eigenvalues (Lowner's formula), which keeps the
+     eigenvectors numerically orthogonal.
+
+     @param[out] lambda Eigenvalues in ascending order
+     @param[out] V Eigenvectors, rows ordered as H
+     @param[in] d Diagonal of the arrowhead (excluding the head)
+     @param[in] z Arrow vector
+     @param[in] a Head of the arrow
+  */
+  static void arrowheadEigensolve(VectorXd &lambda, MatrixXd &V, const VectorXd &d, const VectorXd &z, double a)
+  {
+    const int m = d.size();
+    const int n = m + 1;
+    const double eps = std::numeric_limits<double>::epsilon();
+
+    const double z_norm = z.norm();
+    double scale = std::max(std::abs(a), z_norm);
+    if (m > 0) scale = std::max(scale, d.cwiseAbs().maxCoeff());
+    const double tol = 8.0 * eps * scale;
+
+    // sort the poles and deflate
+    std::vector<int> order(m);
+    for (int i = 0; i < m; i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](int i, int j) { return d[i] < d[j]; });
+
+    struct Rotation {
+      int p;
+      int j;
+      double c;
+      double s;
+    };
+    std::vector<Rotation> rotations;
+    std::vector<int> secular;
+    std::vector<int> deflated;
+    VectorXd w = z;
+
+    for (auto i : order) {
+      if (std::abs(w[i]) <= tol) {
+        deflated.push_back(i);
+      } else if (!secular.empty() && d[i] - d[secular.back()] <= tol) {
+        int p = secular.back();
+        double r = std::hypot(w[p], w[i]);
+        rotations.push_back({p, i, w[p] / r, w[i] / r});
+        w[p] = r;
+        w[i] = 0.0;
+        deflated.push_back(i);
+      } else {
+        secular.push_back(i);
+      }
+    }
+
+    const int r = secular.size();
+    std::vector<double> ds(r), zs(r);
+    for (int i = 0; i < r; i++) {
+      ds[i] = d[secular[i]];
+      zs[i] = w[secular[i]];
+    }
+
+    // the secular roots, each stored as a pole index and an offset from that pole
+    std::vector<int> sigma(r + 1);
+    std::vector<double> tau(r + 1);
+
+    auto secular_fn = [&](int s, double t, double &df) {
+      double f = (a - ds[s]) - t;
+      df = -1.0;
+      for (int j = 0; j < r; j++) {
+        double inv = 1.0 / (t - (ds[j] - ds[s]));
+        double zinv = zs[j] * inv;
+        f += zs[j] * zinv;
+        df -= zinv * zinv;
+      }
+      return f;
+    };
+
+    if (r > 0) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+      for (int k = 0; k <= r; k++) {
+        // bracket the root in the shifted variable; f decreases from +inf to -inf across the interval
+        int s;
+        double lo, hi;
+        double df;
+        if (k == 0) {
+          s = 0;
+          lo = std::min(ds[0], a) - z_norm - tol - ds[0];
+          hi = 0.0;
+        } else if (k == r) {
+          s = r - 1;
+          lo = 0.0;
+          hi = std::max(ds[r - 1], a) + z_norm + tol - ds[r - 1];
+        } else {
+          double gap = ds[k] - ds[k - 1];
+          if (secular_fn(k - 1, 0.5 * gap, df) >= 0.0) {
+            s = k;
+            lo = -0.5 * gap;
+            hi = 0.0;
+          } else {
+            s = k - 1;
+            lo = 0.0;
+            hi = 0.5 * gap;
+          }
+        }
+
+        // safeguarded Newton iteration
+        double t = 0.5 * (lo + hi);
+        for (int iter = 0; iter < 200; iter++) {
+          double f = secular_fn(s, t, df);
+          if (f > 0.0)
+            lo = t;
+          else if (f < 0.0)
+            hi = t;
+          else
+            break;
+
+          double t_new = t - f / df;
+          if (!(t_new > lo && t_new < hi)) t_new = 0.5 * (lo + hi);
+          bool converged = std::abs(t_new - t) <= 2.0 * eps * std::abs(t_new)
+            || hi - lo <= 2.0 * eps * std::max(std::abs(lo), std::abs(hi));
+          t = t_new;
+          if (converged) break;
+        }
+
+        sigma[k] = s;
+        tau[k] = t;
+      }
+    }
+
+    // d_i - lambda_k, evaluated relative to the pole that lambda_k is anchored to
+    auto diff = [&](int i, int k) { return (ds[i] - ds[sigma[k]]) - tau[k]; };
+
+    // Lowner's formula: the arrow vector for which the computed roots are exact
+    std::vector<double> zhat(r);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int i = 0; i < r; i++) {
+      double p = -diff(i, i) * diff(i, i + 1);
+      for (int j = 0; j < i; j++) p *= diff(i, j) / (ds[i] - ds[j]);
+      for (int j = i + 1; j < r; j++) p *= diff(i, j + 1) / (ds[i] - ds[j]);
+      zhat[i] = std::copysign(std::sqrt(std::abs(p)), zs[i]);
+    }
+
+    // gather the eigenpairs, then order them by eigenvalue
+    std::vector<std::pair<double, int>> pairs;
+    pairs.reserve(n);
+    if (r > 0)
+      for (int k = 0; k <= r; k++) pairs.push_back({ds[sigma[k]] + tau[k], k});
+    else
+      pairs.push_back({a, 0});
+    for (auto i : deflated) pairs.push_back({d[i], -1 - i});
+    std::sort(pairs.begin(), pairs.end(), [](const auto &x, const auto &y) { return x.first < y.first; });
+
+    lambda.resize(n);
+    V = MatrixXd::Zero(n, n);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int col = 0; col < n; col++) {
+      lambda[col] = pairs[col].first;
+      int k = pairs[col].second;
+      if (k < 0) {
+        V(-1 - k, col) = 1.0;
+      } else if (r == 0) {
+        V(m, col) = 1.0;
+      } else {
+        double norm2 = 1.0;
+        for (int i = 0; i < r; i++) {
+          double u = -zhat[i] / diff(i, k);
+          V(secular[i], col) = u;
+          norm2 += u * u;
+        }
+        V(m, col) = 1.0;
+        V.col(col) /= std::sqrt(norm2);
+      }
+    }
+
+    // undo the deflation rotations, last first
+    for (auto rot = rotations.rbegin(); rot != rotations.rend(); rot++) {
+      for (int col = 0; col < n; col++) {
+        double yp = V(rot->p, col);
+        double yj = V(rot->j, col);
+        V(rot->p, col) = rot->c * yp - rot->s * yj;
+        V(rot->j, col) = rot->s * yp + rot->c * yj;
+      }
+    }
+  }
+
+  /**
+     @brief Divide-and-conquer eigendecomposition of a real symmetric
+     tridiagonal matrix.  Removing the middle row splits the matrix
+     into two independent tridiagonal halves; in the basis of their
+     eigenvectors the full matrix is an arrowhead with the middle row
+     as its head.
+     @param[out] lambda Eigenvalues in ascending order
+     @param[out] Q Eigenvectors
+     @param[in] d Diagonal
+     @param[in] e Sub-diagonal
+  */
+  static void tridiagonalEigensolve(VectorXd &lambda, MatrixXd &Q, const VectorXd &d, const VectorXd &e)
+  {
+    const int n = d.size();
+    if (n == 0) {
+      lambda.resize(0);
+      Q.resize(0, 0);
+      return;
+    }
+
+    if (n <= arrow_base_size) {
+      SelfAdjointEigenSolver<MatrixXd> eigensolver;
+      eigensolver.computeFromTridiagonal(d, e, ComputeEigenvectors);
+      lambda = eigensolver.eigenvalues();
+      Q = eigensolver.eigenvectors();
+      return;
+    }
+
+    const int mid = n / 2;
+    const int n2 = n - mid - 1;
+    VectorXd lambda1, lambda2;
+    MatrixXd Q1, Q2;
+    tridiagonalEigensolve(lambda1, Q1, d.head(mid), e.head(mid - 1));
+    tridiagonalEigensolve(lambda2, Q2, d.tail(n2), e.tail(n2 - 1));
+
+    VectorXd dh(n - 1), zh(n - 1);
+    dh << lambda1, lambda2;
+    zh << e[mid - 1] * Q1.row(mid - 1).transpose(), e[mid] * Q2.row(0).transpose();
+
+    MatrixXd V;
+    arrowheadEigensolve(lambda, V, dh, zh, d[mid]);
+
+    Q.resize(n, n);
+    Q.topRows(mid).noalias() = Q1 * V.topRows(mid);
+    Q.row(mid) = V.row(n - 1);
+    Q.bottomRows(n2).noalias() = Q2 * V.middleRows(mid, n2);
+  }
+
+  /**
+     @brief The phase that rotates x onto the non-negative real axis
+  */
+  static inline double phase(double x) { return x < 0.0 ? -1.0 : 1.0; }
+  static inline Complex phase(const Complex &x) { return std::abs(x) > 0.0 ? x / std::abs(x) : Complex(1.0); }
+
+  static inline double conjugate(double x) { return x; }
+  static inline Complex conjugate(const Complex &x) { return std::conj(x); }
+
+  template <typename T>
+  void arrowEigensolve(std::vector<double> &evals, std::vector<T> &evecs, const std::vector<double> &diag,
+                       const std::vector<T> &off, int arrow_pos)
+  {
+    const int dim = diag.size();
+    if (arrow_pos < 0 || (dim > 0 && arrow_pos >= dim))
+      errorQuda("arrow_pos = %d out of range for dim = %d", arrow_pos, dim);
+    if (static_cast<int>(off.size()) < dim - 1) errorQuda("off-diagonal length %lu < %d", off.size(), dim - 1);
+
+    // The sparsity graph of the arrow matrix is a tree, so a diagonal
+    // unitary gauge makes every off-diagonal entry real and
+    // non-negative.  With phi the phases, A = P Ar P^dagger.
+    std::vector<T> phi(dim, 1.0);
+    VectorXd a(dim), b(std::max(dim - 1, 0));
+    for (int i = 0; i < dim; i++) a[i] = diag[i];
+    for (int i = 0; i < arrow_pos; i++) {
+      phi[i] = conjugate(phase(off[i]));
+      b[i] = std::abs(off[i]);
+    }
+    for (int i = arrow_pos; i < dim - 1; i++) {
+      phi[i + 1] = phi[i] * phase(off[i]);
+      b[i] = std::abs(off[i]);
+    }
+
+    VectorXd lambda;
+    MatrixXd X(dim, dim);
+
+    if (arrow_pos == 0) {
+      tridiagonalEigensolve(lambda, X, a, b);
+    } else {
+      // decompose the tridiagonal tail below the arrow...
+      const int k = arrow_pos;
+      const int m = dim - k - 1;
+      VectorXd lambda_t;
+      MatrixXd Q;
+      tridiagonalEigensolve(lambda_t, Q, a.tail(m), b.tail(std::max(m - 1, 0)));
+
+      // ...which leaves an arrowhead with the arrow row as its head
+      VectorXd dh(dim - 1), zh(dim - 1);
+      dh << a.head(k), lambda_t;
+      zh.head(k) = b.head(k);
+      if (m > 0) zh.tail(m) = b[k] * Q.row(0).transpose();
+
+      MatrixXd V;
+      arrowheadEigensolve(lambda, V, dh, zh, a[k]);
+
+      X.topRows(k) = V.topRows(k);
+      X.row(k) = V.row(dim - 1);
+      if (m > 0) X.bottomRows(m).noalias() = Q * V.middleRows(k, m);
+    }
+
+    evals.resize(dim);
+    evecs.resize(dim * dim);
+    for (int i = 0; i < dim; i++) evals[i] = lambda[i];
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int i = 0; i < dim; i++)
+      for (int j = 0; j < dim; j++) evecs[dim * i + j] = phi[j] * X(j, i);
+  }
+
+  template void arrowEigensolve<double>(std::vector<double> &, std::vector<double> &, const std::vector<double> &,
+                                        const std::vector<double> &, int);
+  template void arrowEigensolve<Complex>(std::vector<double> &, std::vector<Complex> &, const std::vector<double> &,
+                                         const std::vector<Complex> &, int);
+
+} // namespace quda
@@ -1,6 +1,11 @@
 #include <unistd.h> // for gethostname()
 #include <assert.h>
 #include <limits>
+#include <map>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
 
 #include <quda_internal.h>
 #include <communicator_quda.h>
@@ -17,14 +22,13 @@ namespace backward
 
 char *comm_hostname(void)
 {
-  static bool cached = false;
   static char hostname[128];
-
-  if (!cached) {
+  static bool cached = []() { // initialized once, also when ranks are threads
     gethostname(hostname, 128);
     hostname[127] = '\0';
-    cached = true;
-  }
+    return true;
+  }();
+  (void)cached;
 
   return hostname;
 }
@@ -213,6 +217,179 @@ Topology *comm_create_topology(int ndim, const int *dims, QudaCommsMap rank_from
   return topo;
 }
 
+int comm_topology_rank_from_coords(const int *coords, void *fdata)
+{
+  auto *map = static_cast<CommTopologyMap *>(fdata);
+  return map->ranks[index(map->dims.size(), map->dims.data(), coords)];
+}
+
+/**
+   @brief Compute the halo volume each rank exchanges, on average, in
+   the partitioned dimensions, and how much of it goes off node
+   @param[in] dims Process grid dimensions
+   @param[in] ranks Rank at each grid coordinate
+   @param[in] node Node index of each rank
+   @param[in] face Relative face size of each dimension
+   @return Pair of the inter-node and the total halo volume per rank
+*/
+static std::pair<double, double> comm_halo_volume(const std::vector<int> &dims, const std::vector<int> &ranks,
+                                                  const std::vector<int> &node, const std::vector<double> &face)
+{
+  const int ndim = dims.size();
+  double inter = 0.0, total = 0.0;
+
+  int x[QUDA_MAX_DIM] = {};
+  do {
+    int rank = ranks[index(ndim, dims.data(), x)];
+    for (int d = 0; d < ndim; d++) {
+      if (dims[d] == 1) continue;
+      for (int dir = -1; dir <= 1; dir += 2) {
+        int y[QUDA_MAX_DIM];
+        for (int i = 0; i < ndim; i++) y[i] = x[i];
+        y[d] = mod(x[d] + dir, dims[d]);
+        total += face[d];
+        if (node[ranks[index(ndim, dims.data(), y)]] != node[rank]) inter += face[d];
+      }
+    }
+  } while (advance_coords(ndim, dims.data(), x));
+
+  return std::make_pair(inter / ranks.size(), total / ranks.size());
+}
+
+/**
+   @brief Enumerate the blocks of the process grid with the given
+   volume whose extents divide the grid dimensions
+*/
+static void comm_grid_blocks(const std::vector<int> &dims, size_t d, int volume, std::vector<int> &block,
+                             std::vector<std::vector<int>> &blocks)
+{
+  if (d == dims.size()) {
+    if (volume == 1) blocks.push_back(block);
+    return;
+  }
+  for (int b = 1; b <= dims[d]; b++) {
+    if (dims[d] % b != 0 || volume % b != 0) continue;
+    block[d] = b;
+    comm_grid_blocks(dims, d + 1, volume / b, block, blocks);
+  }
+}
+
+std::string comm_build_topology_map(CommTopologyMap &map, const char *hostname_recv_buf, int size)
+{
+  const std::vector<int> &dims = map.dims;
+  const int ndim = dims.size();
+
+  // the lexicographical mapping is the identity on the grid index
+  map.ranks.resize(size);
+  std::iota(map.ranks.begin(), map.ranks.end(), 0);
+
+  // group the ranks by node, in order of first appearance
+  std::vector<int> node(size);
+  std::vector<std::vector<int>> node_ranks;
+  std::map<std::string, int> node_id;
+  for (int r = 0; r < size; r++) {
+    const char *hostname = &hostname_recv_buf[128 * r];
+    auto it = node_id.emplace(std::string(hostname, strnlen(hostname, 128)), node_ranks.size());
+    if (it.second) node_ranks.emplace_back();
+    node[r] = it.first->second;
+    node_ranks[node[r]].push_back(r);
+  }
+
+  // relative face sizes: the local face in dimension d is the local volume over the local extent in d
+  std::vector<double> face(ndim, 1.0);
+  bool face_sites = false;
+  char *lattice_env = getenv("QUDA_TOPOLOGY_MAPPING_LATTICE");
+  if (lattice_env) {
+    std::vector<int> X;
+    for (char *p = lattice_env; *p;) {
+      char *end;
+      long x = strtol(p, &end, 10);
+      if (end == p) {
+        p++;
+      } else {
+        X.push_back(x);
+        p = end;
+      }
+    }
+    bool valid = X.size() == dims.size();
+    for (int d = 0; valid && d < ndim; d++) valid = X[d] > 0 && X[d] % dims[d] == 0;
+    if (valid) {
+      double volume = 1.0;
+      for (int d = 0; d < ndim; d++) volume *= X[d] / dims[d];
+      for (int d = 0; d < ndim; d++) face[d] = volume / (X[d] / dims[d]);
+      face_sites = true;
+    } else {
+      map.warnings.push_back(std::string("Ignoring QUDA_TOPOLOGY_MAPPING_LATTICE=") + lattice_env
+                             + ", which does not tile the process grid");
+    }
+  }
+
+  const int node_size = size / node_ranks.size();
+  bool uniform = true;
+  for (auto &ranks : node_ranks) uniform = uniform && static_cast<int>(ranks.size()) == node_size;
+
+  std::vector<std::vector<int>> blocks;
+  std::vector<int> block(ndim);
+  if (uniform) comm_grid_blocks(dims, 0, node_size, block, blocks);
+
+  if (blocks.empty()) {
+    map.warnings.push_back("Cannot tile the process grid with the " + std::to_string(node_ranks.size())
+                           + " nodes of this job; using lexicographical ordering");
+    return "";
+  }
+
+  // Ranks on the block boundary in a partitioned dimension have an
+  // off-node neighbor in each direction, so each rank sends an
+  // average 2 * face / block off node per dimension the block does
+  // not span.  Ties go to the block extending furthest in the last
+  // dimensions, as the lexicographical mapping would.
+  auto cost = [&](const std::vector<int> &b) {
+    double c = 0.0;
+    for (int d = 0; d < ndim; d++)
+      if (b[d] < dims[d]) c += 2.0 * face[d] / b[d];
+    return c;
+  };
+
+  const std::vector<int> *best = &blocks[0];
+  for (auto &b : blocks) {
+    double c = cost(b), c_best = cost(*best);
+    if (c < c_best || (c == c_best && std::lexicographical_compare(best->rbegin(), best->rend(), b.rbegin(), b.rend())))
+      best = &b;
+  }
+  block = *best;
+
+  // the block at each node coordinate holds the ranks of one node
+  std::vector<int> node_grid(ndim);
+  for (int d = 0; d < ndim; d++) node_grid[d] = dims[d] / block[d];
+
+  std::vector<int> lex = map.ranks;
+  int x[QUDA_MAX_DIM] = {};
+  do {
+    int n[QUDA_MAX_DIM], l[QUDA_MAX_DIM];
+    for (int d = 0; d < ndim; d++) {
+      n[d] = x[d] / block[d];
+      l[d] = x[d] % block[d];
+    }
+    map.ranks[index(ndim, dims.data(), x)] = node_ranks[index(ndim, node_grid.data(), n)][index(ndim, block.data(), l)];
+  } while (advance_coords(ndim, dims.data(), x));
+
+  auto halo = comm_halo_volume(dims, map.ranks, node, face);
+  auto halo_lex = comm_halo_volume(dims, lex, node, face);
+
+  std::stringstream report;
+  const char *unit = face_sites ? "sites" : "faces";
+  report << "Topology-aware rank mapping: " << node_ranks.size() << " nodes of " << node_size << " ranks, node block ";
+  for (int d = 0; d < ndim; d++) report << (d ? "x" : "") << block[d];
+  report << "\n";
+  char line[256];
+  snprintf(line, sizeof(line),
+           "Inter-node halo per rank = %g of %g %s (%.1f%%), lexicographical mapping = %g %s (%.1f%%)\n", halo.first,
+           halo.second, unit, halo.second > 0 ? 100.0 * halo.first / halo.second : 0.0, halo_lex.first, unit,
+           halo_lex.second > 0 ? 100.0 * halo_lex.first / halo_lex.second : 0.0);
+  report << line;
+  return report.str();
+}
+
 void comm_abort(int status)
 {
 #ifdef HOST_DEBUG
@@ -32,6 +32,25 @@ struct MsgHandle_s {
   bool custom;
 };
 
+struct ReduceHandle_s {
+  /**
+     The request of the non-blocking collective
+   */
+  MPI_Request request;
+
+  /**
+     The array being reduced, and its length
+   */
+  double *data;
+  size_t size;
+
+  /**
+     For deterministic reductions, the gathered contributions of all
+     ranks, which are summed in a fixed order on completion
+   */
+  double *recv_buf;
+};
+
 Communicator::Communicator(int nDim, const int *commDims, QudaCommsMap rank_from_coords, void *map_data,
                            bool user_set_comm_handle_, void *user_comm)
 {
@@ -344,6 +363,43 @@ void Communicator::comm_allreduce_xor(uint64_t *data)
   *data = recvbuf;
 }
 
+ReduceHandle *Communicator::comm_allreduce_array_async(double *data, size_t size)
+{
+  ReduceHandle *rh = (ReduceHandle *)safe_malloc(sizeof(ReduceHandle));
+  rh->data = data;
+  rh->size = size;
+  rh->recv_buf = nullptr;
+
+  if (!comm_deterministic_reduce()) {
+    MPI_CHECK(MPI_Iallreduce(MPI_IN_PLACE, data, size, MPI_DOUBLE, MPI_SUM, MPI_COMM_HANDLE, &(rh->request)));
+  } else {
+    rh->recv_buf = (double *)safe_malloc(size * comm_size() * sizeof(double));
+    MPI_CHECK(MPI_Iallgather(data, size, MPI_DOUBLE, rh->recv_buf, size, MPI_DOUBLE, MPI_COMM_HANDLE, &(rh->request)));
+  }
+
+  return rh;
+}
+
+void Communicator::comm_allreduce_wait(ReduceHandle *rh)
+{
+  MPI_CHECK(MPI_Wait(&(rh->request), MPI_STATUS_IGNORE));
+
+  if (rh->recv_buf) {
+    size_t n = comm_size();
+    double *recv_trans = new double[rh->size * n];
+    for (size_t i = 0; i < n; i++) {
+      for (size_t j = 0; j < rh->size; j++) { recv_trans[j * n + i] = rh->recv_buf[i * rh->size + j]; }
+    }
+
+    for (size_t i = 0; i < rh->size; i++) { rh->data[i] = deterministic_reduce(recv_trans + i * n, n); }
+
+    delete[] recv_trans;
+    host_free(rh->recv_buf);
+  }
+
+  host_free(rh);
+}
+
 /**  broadcast from rank 0 */
 void Communicator::comm_broadcast(void *data, size_t nbytes)
 {
@@ -343,6 +343,15 @@ void Communicator::comm_allreduce_xor(uint64_t *data)
   QMP_CHECK(QMP_comm_xor_ulong(QMP_COMM_HANDLE, reinterpret_cast<unsigned long *>(data)));
 }
 
+// QMP has no non-blocking collectives, so the reduction completes immediately
+ReduceHandle *Communicator::comm_allreduce_array_async(double *data, size_t size)
+{
+  comm_allreduce_array(data, size);
+  return nullptr;
+}
+
+void Communicator::comm_allreduce_wait(ReduceHandle *rh) { }
+
 void Communicator::comm_broadcast(void *data, size_t nbytes)
 {
   QMP_CHECK(QMP_comm_broadcast(QMP_COMM_HANDLE, data, nbytes));
@@ -98,6 +98,10 @@ void Communicator::comm_allreduce_int(int *data) { }
 
 void Communicator::comm_allreduce_xor(uint64_t *data) { }
 
+ReduceHandle *Communicator::comm_allreduce_array_async(double *data, size_t size) { return nullptr; }
+
+void Communicator::comm_allreduce_wait(ReduceHandle *rh) { }
+
 void Communicator::comm_broadcast(void *data, size_t nbytes) { }
 
 void Communicator::comm_barrier(void) { }
@@ -1,13 +1,21 @@
 #include <communicator_quda.h>
 #include <map>
 #include <array>
-#include <lattice_field.h>
+#include <vector>
+#include <timeline.h>
 
 int Communicator::gpuid = -1;
 
-static std::map<quda::CommKey, Communicator> communicator_stack;
+#ifdef THREAD_COMMS
+// each rank is a thread, with its own stack of communicators
+#define COMM_STACK_LOCAL thread_local
+#else
+#define COMM_STACK_LOCAL
+#endif
 
-static quda::CommKey current_key = {-1, -1, -1, -1};
+static COMM_STACK_LOCAL std::map<quda::CommKey, Communicator> communicator_stack;
+
+static COMM_STACK_LOCAL quda::CommKey current_key = {-1, -1, -1, -1};
 
 void init_communicator_stack(int ndim, const int *dims, QudaCommsMap rank_from_coords, void *map_data,
                              bool user_set_comm_handle, void *user_comm)
@@ -35,6 +43,14 @@ Communicator &get_current_communicator()
   return search->second;
 }
 
+static std::vector<void (*)()> &push_callbacks()
+{
+  static std::vector<void (*)()> callbacks;
+  return callbacks;
+}
+
+void comm_register_push_callback(void (*callback)()) { push_callbacks().push_back(callback); }
+
 void push_communicator(const quda::CommKey &split_key)
 {
   auto search = communicator_stack.find(split_key);
@@ -43,7 +59,7 @@ void push_communicator(const quda::CommKey &split_key)
                                std::forward_as_tuple(get_default_communicator(), split_key.data()));
   }
 
-  quda::LatticeField::freeGhostBuffer(); // Destroy the (IPC) Comm buffers with the old communicator.
+  for (auto callback : push_callbacks()) callback(); // e.g., destroy the (IPC) Comm buffers with the old communicator
 
   current_key = split_key;
 }
@@ -157,9 +173,19 @@ MsgHandle *comm_declare_strided_receive_displaced(void *buffer, const int displa
 
 void comm_free(MsgHandle *&mh) { get_current_communicator().comm_free(mh); }
 
-void comm_start(MsgHandle *mh) { get_current_communicator().comm_start(mh); }
+void comm_start(MsgHandle *mh)
+{
+  const int64_t start = quda::timeline::enabled() ? quda::timeline::now() : 0;
+  get_current_communicator().comm_start(mh);
+  if (quda::timeline::enabled()) quda::timeline::complete("comm_start", "comms", start);
+}
 
-void comm_wait(MsgHandle *mh) { get_current_communicator().comm_wait(mh); }
+void comm_wait(MsgHandle *mh)
+{
+  const int64_t start = quda::timeline::enabled() ? quda::timeline::now() : 0;
+  get_current_communicator().comm_wait(mh);
+  if (quda::timeline::enabled()) quda::timeline::complete("comm_wait", "comms", start);
+}
 
 int comm_query(MsgHandle *mh) { return get_current_communicator().comm_query(mh); }
 
@@ -180,6 +206,20 @@ void comm_allreduce_int(int *data) { get_current_communicator().comm_allreduce_i
 
 void comm_allreduce_xor(uint64_t *data) { get_current_communicator().comm_allreduce_xor(data); }
 
+ReduceHandle *comm_allreduce_array_async(double *data, size_t size)
+{
+  return get_current_communicator().comm_allreduce_array_async(data, size);
+}
+
+void comm_allreduce_wait(ReduceHandle **rh)
+{
+  if (!*rh) return;
+  const int64_t start = quda::timeline::enabled() ? quda::timeline::now() : 0;
+  get_current_communicator().comm_allreduce_wait(*rh);
+  if (quda::timeline::enabled()) quda::timeline::complete("comm_allreduce_wait", "comms", start);
+  *rh = nullptr;
+}
+
 void comm_broadcast(void *data, size_t nbytes) { get_current_communicator().comm_broadcast(data, nbytes); }
 
 void comm_broadcast_global(void *data, size_t nbytes) { get_default_communicator().comm_broadcast(data, nbytes); }
@@ -194,6 +234,11 @@ void reduceDouble(double &sum) { get_current_communicator().reduceDouble(sum); }
 
 void reduceDoubleArray(double *max, const int len) { get_current_communicator().reduceDoubleArray(max, len); }
 
+ReduceHandle *reduceDoubleArrayAsync(double *sum, const int len)
+{
+  return get_current_communicator().reduceDoubleArrayAsync(sum, len);
+}
+
 int commDim(int dim) { return get_current_communicator().commDim(dim); }
 
 int commCoords(int dim) { return get_current_communicator().commCoords(dim); }
@@ -0,0 +1,502 @@
+/**
+ * In-process communications layer: every rank is a host thread of a
+ * single process, launched with comm_thread_launch().  Point-to-point
+ * messages are handed over directly from the send buffer to the
+ * receive buffer through shared memory, and reductions are tree
+ * reductions over the threads.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <communicator_quda.h>
+
+/**
+   Meeting point of a persistent send and the persistent receive that
+   matches it (same source, destination and tag).  Whichever of the
+   two is started second copies the message straight from the send
+   buffer into the receive buffer and completes both.
+ */
+struct Channel {
+  std::mutex mutex;
+  std::condition_variable cv;
+  MsgHandle *send = nullptr; // started send waiting for its receive
+  MsgHandle *recv = nullptr; // started receive waiting for its send
+};
+
+struct MsgHandle_s {
+  Channel *channel;
+  bool is_send;
+  char *buffer;
+  size_t blksize;
+  int nblocks;
+  size_t stride;
+  /** whether the handle has been started and not yet completed */
+  std::atomic<bool> active;
+};
+
+/**
+   A group of threads acting as the ranks of one communicator.  The
+   collectives use the per-rank slots to publish pointers to each
+   rank's data, separated by barriers.
+ */
+struct ThreadComm {
+  const int size;
+
+  std::atomic<int> arrived;
+  std::atomic<unsigned long> generation;
+
+  std::vector<const void *> slot;
+
+  /** scratch for comm_split */
+  struct SplitEntry {
+    int color;
+    int key;
+    std::shared_ptr<ThreadComm> comm;
+  };
+  std::vector<SplitEntry> split_entry;
+
+  std::mutex channel_mutex;
+  std::map<std::tuple<int, int, int>, Channel> channels;
+
+  ThreadComm(int size) : size(size), arrived(0), generation(0), slot(size), split_entry(size) { }
+
+  /**
+     @brief Sense-reversing barrier.  The waiting threads yield rather
+     than block, since ranks are usually oversubscribed on the cores.
+   */
+  void barrier()
+  {
+    unsigned long gen = generation.load(std::memory_order_acquire);
+    if (arrived.fetch_add(1, std::memory_order_acq_rel) == size - 1) {
+      arrived.store(0, std::memory_order_relaxed);
+      generation.fetch_add(1, std::memory_order_release);
+    } else {
+      while (generation.load(std::memory_order_acquire) == gen) std::this_thread::yield();
+    }
+  }
+
+  Channel &channel(int src, int dst, int tag)
+  {
+    std::lock_guard<std::mutex> lock(channel_mutex);
+    return channels[std::make_tuple(src, dst, tag)];
+  }
+
+  /**
+     @brief In-place all-reduce of n elements over the ranks.  The
+     ranks are combined pairwise in log2(size) stages, always in the
+     same order, so the result is identical on every rank and
+     reproducible from run to run.
+   */
+  template <typename T, typename Op> void allreduce(int rank, T *data, size_t n, Op op)
+  {
+    slot[rank] = data;
+    barrier();
+    for (int s = 1; s < size; s *= 2) {
+      if (rank % (2 * s) == 0 && rank + s < size) {
+        const T *other = static_cast<const T *>(slot[rank + s]);
+        for (size_t i = 0; i < n; i++) data[i] = op(data[i], other[i]);
+      }
+      barrier();
+    }
+    if (rank != 0) memcpy(data, slot[0], n * sizeof(T));
+    barrier(); // rank 0's data must stay in place until all have read it
+  }
+
+  void allgather(int rank, const void *send, void *recv, size_t nbytes)
+  {
+    slot[rank] = send;
+    barrier();
+    for (int r = 0; r < size; r++) memcpy(static_cast<char *>(recv) + r * nbytes, slot[r], nbytes);
+    barrier();
+  }
+
+  void broadcast(int rank, void *data, size_t nbytes)
+  {
+    slot[rank] = data;
+    barrier();
+    if (rank != 0) memcpy(data, slot[0], nbytes);
+    barrier();
+  }
+
+  /**
+     @brief Partition the ranks by color, ordering each partition by
+     key (then by rank).  The lowest rank of each color creates the
+     new group.
+     @param[in] rank Rank in this group
+     @param[in] color Color of the partition to join
+     @param[in] key Ordering key within the partition
+     @param[out] new_rank Rank in the new group
+     @return The new group
+   */
+  std::shared_ptr<ThreadComm> split(int rank, int color, int key, int &new_rank)
+  {
+    split_entry[rank] = {color, key, nullptr};
+    barrier();
+
+    int leader = rank;
+    int n = 0;
+    new_rank = 0;
+    for (int r = 0; r < size; r++) {
+      if (split_entry[r].color != color) continue;
+      n++;
+      leader = std::min(leader, r);
+      if (std::make_pair(split_entry[r].key, r) < std::make_pair(key, rank)) new_rank++;
+    }
+    if (leader == rank) split_entry[rank].comm = std::make_shared<ThreadComm>(n);
+    barrier();
+
+    auto comm = split_entry[leader].comm;
+    barrier();
+    split_entry[rank].comm.reset();
+    return comm;
+  }
+};
+
+/** the communicator spanning all threads, and this thread's rank in it, set by comm_thread_launch */
+static thread_local std::shared_ptr<ThreadComm> world;
+static thread_local int world_rank = 0;
+
+void comm_thread_launch(int n_rank, const std::function<void(int)> &body)
+{
+  if (n_rank < 1) errorQuda("Invalid number of ranks %d", n_rank);
+  auto comm = std::make_shared<ThreadComm>(n_rank);
+
+  std::vector<std::thread> threads;
+  for (int r = 0; r < n_rank; r++) {
+    threads.emplace_back([&comm, &body, r]() {
+      world = comm;
+      world_rank = r;
+      body(r);
+      world.reset();
+    });
+  }
+  for (auto &t : threads) t.join();
+}
+
+Communicator::Communicator(int nDim, const int *commDims, QudaCommsMap rank_from_coords, void *map_data,
+                           bool user_set_comm_handle_, void *user_comm)
+{
+  user_set_comm_handle = false;
+  // a thread that was not started by comm_thread_launch() is a world
+  // of its own, as an MPI process run without a launcher is
+  if (!world) {
+    world = std::make_shared<ThreadComm>(1);
+    world_rank = 0;
+  }
+  THREAD_COMM_HANDLE = world;
+  rank = world_rank;
+
+  comm_init(nDim, commDims, rank_from_coords, map_data);
+}
+
+Communicator::Communicator(Communicator &other, const int *comm_split)
+{
+  user_set_comm_handle = false;
+
+  constexpr int nDim = 4;
+
+  quda::CommKey comm_dims_split;
+
+  quda::CommKey comm_key_split;
+  quda::CommKey comm_color_split;
+
+  for (int d = 0; d < nDim; d++) {
+    assert(other.comm_dim(d) % comm_split[d] == 0);
+    comm_dims_split[d] = other.comm_dim(d) / comm_split[d];
+    comm_key_split[d] = other.comm_coord(d) % comm_dims_split[d];
+    comm_color_split[d] = other.comm_coord(d) / comm_dims_split[d];
+  }
+
+  int key = index(nDim, comm_dims_split.data(), comm_key_split.data());
+  int color = index(nDim, comm_split, comm_color_split.data());
+
+  THREAD_COMM_HANDLE = other.THREAD_COMM_HANDLE->split(other.rank, color, key, rank);
+
+  QudaCommsMap func = lex_rank_from_coords_dim_t;
+  comm_init(nDim, comm_dims_split.data(), func, comm_dims_split.data());
+}
+
+Communicator::~Communicator() { comm_finalize(); }
+
+void Communicator::comm_gather_hostname(char *hostname_recv_buf)
+{
+  THREAD_COMM_HANDLE->allgather(rank, comm_hostname(), hostname_recv_buf, 128);
+}
+
+void Communicator::comm_gather_gpuid(int *gpuid_recv_buf)
+{
+  int gpuid = comm_gpuid();
+  THREAD_COMM_HANDLE->allgather(rank, &gpuid, gpuid_recv_buf, sizeof(int));
+}
+
+void Communicator::comm_init(int ndim, const int *dims, QudaCommsMap rank_from_coords, void *map_data)
+{
+  size = THREAD_COMM_HANDLE->size;
+
+  int grid_size = 1;
+  for (int i = 0; i < ndim; i++) { grid_size *= dims[i]; }
+  if (grid_size != size) {
+    errorQuda("Communication grid size declared via initCommsGridQuda() does not match"
+              " total number of thread ranks (%d != %d)",
+              grid_size, size);
+  }
+
+  // all ranks share this process's device
+  static std::once_flag gpuid_once;
+  std::call_once(gpuid_once, []() {
+    if (gpuid < 0) gpuid = 0;
+  });
+
+  comm_init_common(ndim, dims, rank_from_coords, map_data);
+
+  // memory handles cannot be exchanged by IPC within a process, so
+  // all halos go through the message handles
+  for (int dir = 0; dir < 2; dir++) {
+    for (int dim = 0; dim < 4; dim++) {
+      peer2peer_enabled[dir][dim] = false;
+      intranode_enabled[dir][dim] = false;
+    }
+  }
+  peer2peer_present = false;
+  p2p_global = false;
+  init = true;
+}
+
+int Communicator::comm_rank(void) { return rank; }
+
+int Communicator::comm_size(void) { return size; }
+
+static MsgHandle *declare(Channel &channel, bool is_send, void *buffer, size_t blksize, int nblocks, size_t stride)
+{
+  MsgHandle *mh = new MsgHandle;
+  mh->channel = &channel;
+  mh->is_send = is_send;
+  mh->buffer = static_cast<char *>(buffer);
+  mh->blksize = blksize;
+  mh->nblocks = nblocks;
+  mh->stride = stride;
+  mh->active = false;
+  return mh;
+}
+
+static int displaced_tag(const int displacement[], int ndim, int sign)
+{
+  int tag = 0;
+  for (int i = ndim - 1; i >= 0; i--) tag = tag * 4 * max_displacement + sign * displacement[i] + max_displacement;
+  return tag;
+}
+
+/**
+ * Declare a message handle for sending `nbytes` to the `rank` with `tag`.
+ */
+MsgHandle *Communicator::comm_declare_send_rank(void *buffer, int rank, int tag, size_t nbytes)
+{
+  return declare(THREAD_COMM_HANDLE->channel(comm_rank(), rank, tag), true, buffer, nbytes, 1, nbytes);
+}
+
+/**
+ * Declare a message handle for receiving `nbytes` from the `rank` with `tag`.
+ */
+MsgHandle *Communicator::comm_declare_recv_rank(void *buffer, int rank, int tag, size_t nbytes)
+{
+  return declare(THREAD_COMM_HANDLE->channel(rank, comm_rank(), tag), false, buffer, nbytes, 1, nbytes);
+}
+
+/**
+ * Declare a message handle for sending to a node displaced in (x,y,z,t) according to "displacement"
+ */
+MsgHandle *Communicator::comm_declare_send_displaced(void *buffer, const int displacement[], size_t nbytes)
+{
+  return comm_declare_strided_send_displaced(buffer, displacement, nbytes, 1, nbytes);
+}
+
+/**
+ * Declare a message handle for receiving from a node displaced in (x,y,z,t) according to "displacement"
+ */
+MsgHandle *Communicator::comm_declare_receive_displaced(void *buffer, const int displacement[], size_t nbytes)
+{
+  return comm_declare_strided_receive_displaced(buffer, displacement, nbytes, 1, nbytes);
+}
+
+/**
+ * Declare a message handle for sending to a node displaced in (x,y,z,t) according to "displacement"
+ */
+MsgHandle *Communicator::comm_declare_strided_send_displaced(void *buffer, const int displacement[], size_t blksize,
+                                                             int nblocks, size_t stride)
+{
+  Topology *topo = comm_default_topology();
+  int ndim = comm_ndim(topo);
+  check_displacement(displacement, ndim);
+
+  int rank = comm_rank_displaced(topo, displacement);
+  int tag = displaced_tag(displacement, ndim, +1);
+
+  return declare(THREAD_COMM_HANDLE->channel(comm_rank(), rank, tag), true, buffer, blksize, nblocks, stride);
+}
+
+/**
+ * Declare a message handle for receiving from a node displaced in (x,y,z,t) according to "displacement"
+ */
+MsgHandle *Communicator::comm_declare_strided_receive_displaced(void *buffer, const int displacement[], size_t blksize,
+                                                                int nblocks, size_t stride)
+{
+  Topology *topo = comm_default_topology();
+  int ndim = comm_ndim(topo);
+  check_displacement(displacement, ndim);
+
+  int rank = comm_rank_displaced(topo, displacement);
+  int tag = displaced_tag(displacement, ndim, -1);
+
+  return declare(THREAD_COMM_HANDLE->channel(rank, comm_rank(), tag), false, buffer, blksize, nblocks, stride);
+}
+
+void Communicator::comm_free(MsgHandle *&mh)
+{
+  if (mh->active) errorQuda("Attempt to free an active message handle");
+  delete mh;
+  mh = nullptr;
+}
+
+/**
+   @brief Copy a message between two (possibly strided) buffers
+ */
+static void copy_message(const MsgHandle &dst, const MsgHandle &src)
+{
+  const size_t nbytes = src.blksize * src.nblocks;
+  if (nbytes != dst.blksize * dst.nblocks)
+    errorQuda("Message size mismatch: sending %zu bytes but receiving %zu", nbytes, dst.blksize * dst.nblocks);
+
+  if (src.nblocks == 1 && dst.nblocks == 1) {
+    memcpy(dst.buffer, src.buffer, nbytes);
+    return;
+  }
+
+  size_t s_block = 0, s_offset = 0, d_block = 0, d_offset = 0;
+  for (size_t done = 0; done < nbytes;) {
+    size_t n = std::min(src.blksize - s_offset, dst.blksize - d_offset);
+    memcpy(dst.buffer + d_block * dst.stride + d_offset, src.buffer + s_block * src.stride + s_offset, n);
+    done += n;
+    if ((s_offset += n) == src.blksize) {
+      s_block++;
+      s_offset = 0;
+    }
+    if ((d_offset += n) == dst.blksize) {
+      d_block++;
+      d_offset = 0;
+    }
+  }
+}
+
+void Communicator::comm_start(MsgHandle *mh)
+{
+  Channel &channel = *mh->channel;
+  std::lock_guard<std::mutex> lock(channel.mutex);
+  mh->active = true;
+
+  MsgHandle *&partner = mh->is_send ? channel.recv : channel.send;
+  if (partner) {
+    if (mh->is_send)
+      copy_message(*partner, *mh);
+    else
+      copy_message(*mh, *partner);
+    partner->active.store(false, std::memory_order_release);
+    mh->active.store(false, std::memory_order_release);
+    partner = nullptr;
+    channel.cv.notify_all();
+  } else {
+    (mh->is_send ? channel.send : channel.recv) = mh;
+  }
+}
+
+void Communicator::comm_wait(MsgHandle *mh)
+{
+  // the partner is typically only moments behind, so spin briefly before blocking
+  for (int i = 0; i < 1000 && mh->active.load(std::memory_order_acquire); i++) std::this_thread::yield();
+  if (!mh->active.load(std::memory_order_acquire)) return;
+
+  std::unique_lock<std::mutex> lock(mh->channel->mutex);
+  mh->channel->cv.wait(lock, [mh]() { return !mh->active.load(std::memory_order_acquire); });
+}
+
+int Communicator::comm_query(MsgHandle *mh) { return !mh->active.load(std::memory_order_acquire); }
+
+void Communicator::comm_allreduce(double *data)
+{
+  if (!comm_deterministic_reduce()) {
+    THREAD_COMM_HANDLE->allreduce(rank, data, 1, [](double a, double b) { return a + b; });
+  } else {
+    std::vector<double> recv_buf(size);
+    THREAD_COMM_HANDLE->allgather(rank, data, recv_buf.data(), sizeof(double));
+    *data = deterministic_reduce(recv_buf.data(), size);
+  }
+}
+
+void Communicator::comm_allreduce_max(double *data)
+{
+  THREAD_COMM_HANDLE->allreduce(rank, data, 1, [](double a, double b) { return std::max(a, b); });
+}
+
+void Communicator::comm_allreduce_min(double *data)
+{
+  THREAD_COMM_HANDLE->allreduce(rank, data, 1, [](double a, double b) { return std::min(a, b); });
+}
+
+void Communicator::comm_allreduce_array(double *data, size_t size)
+{
+  if (!comm_deterministic_reduce()) {
+    THREAD_COMM_HANDLE->allreduce(rank, data, size, [](double a, double b) { return a + b; });
+  } else {
+    size_t n = comm_size();
+    std::vector<double> recv_buf(size * n);
+    THREAD_COMM_HANDLE->allgather(rank, data, recv_buf.data(), size * sizeof(double));
+
+    std::vector<double> recv_trans(size * n);
+    for (size_t i = 0; i < n; i++) {
+      for (size_t j = 0; j < size; j++) { recv_trans[j * n + i] = recv_buf[i * size + j]; }
+    }
+
+    for (size_t i = 0; i < size; i++) { data[i] = deterministic_reduce(recv_trans.data() + i * n, n); }
+  }
+}
+
+void Communicator::comm_allreduce_max_array(double *data, size_t size)
+{
+  THREAD_COMM_HANDLE->allreduce(rank, data, size, [](double a, double b) { return std::max(a, b); });
+}
+
+void Communicator::comm_allreduce_int(int *data)
+{
+  THREAD_COMM_HANDLE->allreduce(rank, data, 1, [](int a, int b) { return a + b; });
+}
+
+void Communicator::comm_allreduce_xor(uint64_t *data)
+{
+  THREAD_COMM_HANDLE->allreduce(rank, data, 1, [](uint64_t a, uint64_t b) { return a ^ b; });
+}
+
+// the ranks share memory, so the reduction is cheap enough to complete immediately
+ReduceHandle *Communicator::comm_allreduce_array_async(double *data, size_t size)
+{
+  comm_allreduce_array(data, size);
+  return nullptr;
+}
+
+void Communicator::comm_allreduce_wait(ReduceHandle *rh) { }
+
+/**  broadcast from rank 0 */
+void Communicator::comm_broadcast(void *data, size_t nbytes) { THREAD_COMM_HANDLE->broadcast(rank, data, nbytes); }
+
+void Communicator::comm_barrier(void) { THREAD_COMM_HANDLE->barrier(); }
+
+void Communicator::comm_abort_(int status) { exit(status); }
+
+int Communicator::comm_rank_global() { return world_rank; }
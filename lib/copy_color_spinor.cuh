@@ -132,16 +132,32 @@ namespace quda {
     }
   };
 
+  /**
+     Number of checkerboard sites each host thread reorders at a time.
+     Each block touches a contiguous window of sites in both the input
+     and output orders, so that for the site-major host orders
+     (QDP/QDPJIT/CPS/MILC) and the strided QUDA orders alike a block's
+     worth of both fields stays resident in cache.
+  */
+  constexpr int copy_color_spinor_host_block = 64;
+
   /** CPU function to reorder spinor fields.  */
   template <typename Arg, template <typename> class Basis> void copyColorSpinor(Arg &arg)
   {
+    constexpr int block = copy_color_spinor_host_block;
+    const int n_block = (arg.volumeCB + block - 1) / block;
+
+#pragma omp parallel for collapse(2)
     for (int parity = 0; parity<arg.nParity; parity++) {
-      for (int x=0; x<arg.volumeCB; x++) {
-        ColorSpinor<typename Arg::realIn, Arg::nColor, Arg::nSpin> in = arg.in(x, (parity+arg.inParity)&1);
-        ColorSpinor<typename Arg::realOut, Arg::nColor, Arg::nSpin> out;
-        Basis<Arg> basis;
-	basis(out.data, in.data);
-	arg.out(x, (parity+arg.outParity)&1) = out;
+      for (int b = 0; b < n_block; b++) {
+        const int x_end = std::min((b + 1) * block, arg.volumeCB);
+        for (int x = b * block; x < x_end; x++) {
+          ColorSpinor<typename Arg::realIn, Arg::nColor, Arg::nSpin> in = arg.in(x, (parity+arg.inParity)&1);
+          ColorSpinor<typename Arg::realOut, Arg::nColor, Arg::nSpin> out;
+          Basis<Arg> basis;
+          basis(out.data, in.data);
+          arg.out(x, (parity+arg.outParity)&1) = out;
+        }
       }
     }
   }
@@ -183,7 +199,11 @@ namespace quda {
 
     void apply(const qudaStream_t &stream) {
       if (location == QUDA_CPU_FIELD_LOCATION) {
-	copyColorSpinor<Arg, PreserveBasis>(arg);
+        Timer timer;
+        timer.Start(__func__, __FILE__, __LINE__);
+        copyColorSpinor<Arg, PreserveBasis>(arg);
+        timer.Stop(__func__, __FILE__, __LINE__);
+        reportHostLaunch(*this, timer.Last(), getVerbosity());
       } else {
 	TuneParam tp = tuneLaunch(*this, getTuning(), getVerbosity());
 	qudaLaunchKernel(copyColorSpinorKernel<Arg, PreserveBasis>, tp, stream, arg);
@@ -232,6 +252,8 @@ namespace quda {
 
     void apply(const qudaStream_t &stream) {
       if (location == QUDA_CPU_FIELD_LOCATION) {
+        Timer timer;
+        timer.Start(__func__, __FILE__, __LINE__);
 	if (out.GammaBasis()==in.GammaBasis()) {
           copyColorSpinor<Arg, PreserveBasis>(arg);
 	} else if (out.GammaBasis() == QUDA_UKQCD_GAMMA_BASIS && in.GammaBasis() == QUDA_DEGRAND_ROSSI_GAMMA_BASIS) {
@@ -243,6 +265,8 @@ namespace quda {
 	} else if (in.GammaBasis() == QUDA_UKQCD_GAMMA_BASIS && out.GammaBasis() == QUDA_CHIRAL_GAMMA_BASIS) {
 	  copyColorSpinor<Arg, NonRelToChiralBasis>(arg);
 	}
+        timer.Stop(__func__, __FILE__, __LINE__);
+        reportHostLaunch(*this, timer.Last(), getVerbosity());
       } else {
 	TuneParam tp = tuneLaunch(*this, getTuning(), getVerbosity());
 	if (out.GammaBasis()==in.GammaBasis()) {
@@ -82,11 +82,15 @@ public:
     void apply(const qudaStream_t &stream) {
       TuneParam tp = tuneLaunch(*this, getTuning(), getVerbosity());
       if (location == QUDA_CPU_FIELD_LOCATION) {
+        Timer timer;
+        timer.Start(__func__, __FILE__, __LINE__);
         if (!is_ghost) {
           copyGauge<FloatOut, FloatIn, length>(arg);
         } else {
           copyGhost<FloatOut, FloatIn, length>(arg);
         }
+        timer.Stop(__func__, __FILE__, __LINE__);
+        reportHostLaunch(*this, timer.Last(), getVerbosity());
       } else if (location == QUDA_CUDA_FIELD_LOCATION) {
 #ifdef JITIFY
         using namespace jitify::reflection;
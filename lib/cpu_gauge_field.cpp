@@ -123,6 +123,10 @@ namespace quda {
       }
     }
   
+    // the ghost plan holds message handles declared on the ghost zone
+    destroyGhostPlan();
+    destroyHaloPlan();
+
     if (link_type != QUDA_ASQTAD_MOM_LINKS) {
       for (int i=0; i<nDim; i++) {
 	if (ghost[i]) host_free(ghost[i]);
@@ -131,6 +135,51 @@ namespace quda {
     }
   }
 
+  void cpuGaugeField::createGhostPlan()
+  {
+    if (ghost_plan.comms_generation == comms_generation) return;
+    destroyGhostPlan();
+
+    auto &p = ghost_plan;
+    const int n_link = geometry == QUDA_COARSE_GEOMETRY ? 2 : 1;
+    for (int d = 0; d < nDim; d++) {
+      p.bytes[d] = nFace * surface[d] * nInternal * precision;
+      for (int l = 0; l < n_link; l++) p.send[d + l * nDim] = safe_malloc(p.bytes[d]);
+      p.recv[d] = safe_malloc(p.bytes[d]);
+    }
+
+    for (int d = 0; d < nDimComms; d++) {
+      if (!comm_dim_partitioned(d)) continue;
+      for (int l = 0; l < n_link; l++) {
+        const int i = d + l * nDim;
+        p.mh_send_fwd[i] = comm_declare_send_relative(p.send[i], d, +1, p.bytes[d]);
+        p.mh_recv_fwd[i] = comm_declare_receive_relative(ghost[i], d, -1, p.bytes[d]);
+      }
+      p.mh_send_back[d] = comm_declare_send_relative(ghost[d], d, -1, p.bytes[d]);
+      p.mh_recv_back[d] = comm_declare_receive_relative(p.recv[d], d, +1, p.bytes[d]);
+    }
+
+    p.comms_generation = comms_generation;
+  }
+
+  void cpuGaugeField::destroyGhostPlan()
+  {
+    auto &p = ghost_plan;
+    for (int i = 0; i < 2 * QUDA_MAX_DIM; i++) {
+      if (p.mh_send_fwd[i]) comm_free(p.mh_send_fwd[i]);
+      if (p.mh_recv_fwd[i]) comm_free(p.mh_recv_fwd[i]);
+      if (p.send[i]) host_free(p.send[i]);
+      p.send[i] = nullptr;
+    }
+    for (int d = 0; d < QUDA_MAX_DIM; d++) {
+      if (p.mh_send_back[d]) comm_free(p.mh_send_back[d]);
+      if (p.mh_recv_back[d]) comm_free(p.mh_recv_back[d]);
+      if (p.recv[d]) host_free(p.recv[d]);
+      p.recv[d] = nullptr;
+    }
+    p.comms_generation = -1;
+  }
+
   // This does the exchange of the gauge field ghost zone and places it
   // into the ghost array.
   void cpuGaugeField::exchangeGhost(QudaLinkDirection link_direction) {
@@ -140,27 +189,48 @@ namespace quda {
     if ( (link_direction == QUDA_LINK_BIDIRECTIONAL || link_direction == QUDA_LINK_FORWARDS) && geometry != QUDA_COARSE_GEOMETRY)
       errorQuda("Cannot request exchange of forward links on non-coarse geometry");
 
-    void *send[2*QUDA_MAX_DIM];
-    for (int d=0; d<nDim; d++) {
-      send[d] = safe_malloc(nFace*surface[d]*nInternal*precision);
-      if (geometry == QUDA_COARSE_GEOMETRY) send[d+4] = safe_malloc(nFace*surface[d]*nInternal*precision);
-    }
+    createGhostPlan();
+    auto &p = ghost_plan;
+
+    // post the exchange of the links starting at offset, filling the
+    // ghost zone locally in dimensions that are not partitioned
+    auto start = [&](int offset) {
+      for (int d = 0; d < nDimComms; d++) {
+        if (comm_dim_partitioned(d)) {
+          comm_start(p.mh_recv_fwd[offset + d]);
+          comm_start(p.mh_send_fwd[offset + d]);
+        } else {
+          memcpy(ghost[offset + d], p.send[offset + d], p.bytes[d]);
+        }
+      }
+    };
+
+    auto wait = [&](int offset) {
+      for (int d = 0; d < nDimComms; d++) {
+        if (!comm_dim_partitioned(d)) continue;
+        comm_wait(p.mh_send_fwd[offset + d]);
+        comm_wait(p.mh_recv_fwd[offset + d]);
+      }
+    };
 
-    if (link_direction == QUDA_LINK_BACKWARDS || link_direction == QUDA_LINK_BIDIRECTIONAL) {
-      // get the links into contiguous buffers
-      extractGaugeGhost(*this, send, true);
+    const bool backwards = link_direction == QUDA_LINK_BACKWARDS || link_direction == QUDA_LINK_BIDIRECTIONAL;
+    const bool forwards = link_direction == QUDA_LINK_FORWARDS || link_direction == QUDA_LINK_BIDIRECTIONAL;
 
-      // communicate between nodes
-      exchange(ghost, send, QUDA_FORWARDS);
+    if (backwards) {
+      // get the links into contiguous buffers and communicate between nodes
+      extractGaugeGhost(*this, p.send, true);
+      start(0);
     }
 
-    // repeat if requested and links are bi-directional
-    if (link_direction == QUDA_LINK_FORWARDS || link_direction == QUDA_LINK_BIDIRECTIONAL) {
-      extractGaugeGhost(*this, send, true, nDim);
-      exchange(ghost+nDim, send+nDim, QUDA_FORWARDS);
+    // the forward links go to their own buffers, so they are
+    // extracted while the backward links are in flight
+    if (forwards) {
+      extractGaugeGhost(*this, p.send, true, nDim);
+      start(nDim);
     }
 
-    for (int d=0; d<geometry; d++) host_free(send[d]);
+    if (backwards) wait(0);
+    if (forwards) wait(nDim);
   }
 
   // This does the opposite of exchangeGhost and sends back the ghost
@@ -173,77 +243,113 @@ namespace quda {
     if (link_direction != QUDA_LINK_BACKWARDS)
       errorQuda("link_direction = %d not supported", link_direction);
 
-    void *recv[2*QUDA_MAX_DIM];
-    for (int d=0; d<nDim; d++) recv[d] = safe_malloc(nFace*surface[d]*nInternal*precision);
+    createGhostPlan();
+    auto &p = ghost_plan;
 
     // communicate between nodes
-    exchange(recv, ghost, QUDA_BACKWARDS);
+    for (int d = 0; d < nDimComms; d++) {
+      if (!comm_dim_partitioned(d)) continue;
+      comm_start(p.mh_recv_back[d]);
+      comm_start(p.mh_send_back[d]);
+    }
+
+    for (int d = 0; d < nDimComms; d++) {
+      if (!comm_dim_partitioned(d)) continue;
+      comm_wait(p.mh_send_back[d]);
+      comm_wait(p.mh_recv_back[d]);
+    }
 
     // get the links into contiguous buffers
-    extractGaugeGhost(*this, recv, false);
+    extractGaugeGhost(*this, p.recv, false);
+  }
+
+  void cpuGaugeField::createHaloPlan(const int *R, bool no_comms_fill)
+  {
+    auto &p = halo_plan;
+    bool match = p.comms_generation == comms_generation && p.no_comms_fill == no_comms_fill;
+    for (int d = 0; d < nDim; d++) match = match && p.R[d] == R[d];
+    if (match) return;
+    destroyHaloPlan();
+
+    // store both parities and directions in each
+    for (int d = 0; d < nDim; d++) {
+      p.R[d] = R[d];
+      if (!(comm_dim_partitioned(d) || (no_comms_fill && R[d]))) continue;
+      p.bytes[d] = surface[d] * R[d] * geometry * nInternal * precision;
+      p.send[d] = safe_malloc(2 * p.bytes[d]);
+      p.recv[d] = safe_malloc(2 * p.bytes[d]);
+
+      if (comm_dim_partitioned(d)) {
+        p.mh_recv_back[d] = comm_declare_receive_relative(p.recv[d], d, -1, p.bytes[d]);
+        p.mh_recv_fwd[d] = comm_declare_receive_relative(static_cast<char *>(p.recv[d]) + p.bytes[d], d, +1, p.bytes[d]);
+        p.mh_send_back[d] = comm_declare_send_relative(p.send[d], d, -1, p.bytes[d]);
+        p.mh_send_fwd[d] = comm_declare_send_relative(static_cast<char *>(p.send[d]) + p.bytes[d], d, +1, p.bytes[d]);
+      }
+    }
 
-    for (int d=0; d<nDim; d++) host_free(recv[d]);
+    p.no_comms_fill = no_comms_fill;
+    p.comms_generation = comms_generation;
+  }
+
+  void cpuGaugeField::destroyHaloPlan()
+  {
+    auto &p = halo_plan;
+    for (int d = 0; d < QUDA_MAX_DIM; d++) {
+      if (p.mh_recv_back[d]) comm_free(p.mh_recv_back[d]);
+      if (p.mh_recv_fwd[d]) comm_free(p.mh_recv_fwd[d]);
+      if (p.mh_send_back[d]) comm_free(p.mh_send_back[d]);
+      if (p.mh_send_fwd[d]) comm_free(p.mh_send_fwd[d]);
+      if (p.send[d]) host_free(p.send[d]);
+      if (p.recv[d]) host_free(p.recv[d]);
+      p.send[d] = nullptr;
+      p.recv[d] = nullptr;
+    }
+    p.comms_generation = -1;
   }
 
   void cpuGaugeField::exchangeExtendedGhost(const int *R, bool no_comms_fill) {
-    
-    void *send[QUDA_MAX_DIM];
-    void *recv[QUDA_MAX_DIM];
-    size_t bytes[QUDA_MAX_DIM];
-    // store both parities and directions in each
-    for (int d=0; d<nDim; d++) {
-      if (!(comm_dim_partitioned(d) || (no_comms_fill && R[d])) ) continue;
-      bytes[d] = surface[d] * R[d] * geometry * nInternal * precision;
-      send[d] = safe_malloc(2 * bytes[d]);
-      recv[d] = safe_malloc(2 * bytes[d]);
+
+    createHaloPlan(R, no_comms_fill);
+    auto &p = halo_plan;
+
+    // post every receive up front, so that halos which arrive ahead
+    // of our own progress land directly in their final buffers
+    for (int d = 0; d < nDim; d++) {
+      if (!comm_dim_partitioned(d)) continue;
+      comm_start(p.mh_recv_back[d]);
+      comm_start(p.mh_recv_fwd[d]);
     }
 
+    // The dimensions must be processed in order: the slab extracted
+    // for dimension d spans the halos of the preceding dimensions, so
+    // it is only complete (corners included) once those have been
+    // injected.  The sends are not waited on until the end, so
+    // extraction of the next dimension overlaps their completion.
     for (int d=0; d<nDim; d++) {
       if (!(comm_dim_partitioned(d) || (no_comms_fill && R[d])) ) continue;
       //extract into a contiguous buffer
-      extractExtendedGaugeGhost(*this, d, R, send, true);
+      extractExtendedGaugeGhost(*this, d, R, p.send, true);
 
       if (comm_dim_partitioned(d)) {
-	// do the exchange
-	MsgHandle *mh_recv_back;
-	MsgHandle *mh_recv_fwd;
-	MsgHandle *mh_send_fwd;
-	MsgHandle *mh_send_back;
-	
-	mh_recv_back = comm_declare_receive_relative(recv[d], d, -1, bytes[d]);
-	mh_recv_fwd  = comm_declare_receive_relative(((char*)recv[d])+bytes[d], d, +1, bytes[d]);
-	mh_send_back = comm_declare_send_relative(send[d], d, -1, bytes[d]);
-	mh_send_fwd  = comm_declare_send_relative(((char*)send[d])+bytes[d], d, +1, bytes[d]);
-	
-	comm_start(mh_recv_back);
-	comm_start(mh_recv_fwd);
-	comm_start(mh_send_fwd);
-	comm_start(mh_send_back);
-	
-	comm_wait(mh_send_fwd);
-	comm_wait(mh_send_back);
-	comm_wait(mh_recv_back);
-	comm_wait(mh_recv_fwd);
-	
-	comm_free(mh_send_fwd);
-	comm_free(mh_send_back);
-	comm_free(mh_recv_back);
-	comm_free(mh_recv_fwd);
+        comm_start(p.mh_send_fwd[d]);
+        comm_start(p.mh_send_back[d]);
+
+        comm_wait(p.mh_recv_back[d]);
+        comm_wait(p.mh_recv_fwd[d]);
       } else {
-	memcpy(static_cast<char*>(recv[d])+bytes[d], send[d], bytes[d]);
-	memcpy(recv[d], static_cast<char*>(send[d])+bytes[d], bytes[d]);
-      }      
+        memcpy(static_cast<char *>(p.recv[d]) + p.bytes[d], p.send[d], p.bytes[d]);
+        memcpy(p.recv[d], static_cast<char *>(p.send[d]) + p.bytes[d], p.bytes[d]);
+      }
 
       // inject back into the gauge field
-      extractExtendedGaugeGhost(*this, d, R, recv, false);
+      extractExtendedGaugeGhost(*this, d, R, p.recv, false);
     }
 
-    for (int d=0; d<nDim; d++) {
-      if (!(comm_dim_partitioned(d) || (no_comms_fill && R[d])) ) continue;
-      host_free(send[d]);
-      host_free(recv[d]);
+    for (int d = 0; d < nDim; d++) {
+      if (!comm_dim_partitioned(d)) continue;
+      comm_wait(p.mh_send_fwd[d]);
+      comm_wait(p.mh_send_back[d]);
     }
-
   }
 
   void cpuGaugeField::exchangeExtendedGhost(const int *R, TimeProfile &profile, bool no_comms_fill) {
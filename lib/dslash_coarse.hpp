@@ -217,7 +217,11 @@ namespace quda {
           errorQuda("Unsupported field order colorspinor=%d gauge=%d combination\n", inA.FieldOrder(), Y.FieldOrder());
 
         DslashCoarseArg<Float,yFloat,ghostFloat,Ns,Nc,QUDA_SPACE_SPIN_COLOR_FIELD_ORDER,QUDA_QDP_GAUGE_ORDER> arg(out, inA, inB, Y, X, (Float)kappa, parity);
+        Timer timer;
+        timer.Start(__func__, __FILE__, __LINE__);
         coarseDslash<Float,nDim,Ns,Nc,Mc,dslash,clover,dagger,type>(arg);
+        timer.Stop(__func__, __FILE__, __LINE__);
+        reportHostLaunch(*this, timer.Last(), getVerbosity());
       } else {
 
         const TuneParam &tp = tuneLaunch(*this, getTuning(), getVerbosity());
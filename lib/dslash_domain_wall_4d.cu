@@ -18,7 +18,7 @@ namespace quda
 
   template <typename Arg> class DomainWall4D : public Dslash<domainWall4D, Arg>
   {
-    using Dslash = Dslash<domainWall4D, Arg>;
+    using Dslash = quda::Dslash<domainWall4D, Arg>;
     using Dslash::arg;
     using Dslash::in;
 
@@ -1989,6 +1989,7 @@ public:
      strcat(key.aux, comm_dim_topology_string());
      strcat(key.aux, comm_config_string()); // any change in P2P/GDR will be stored as a separate tunecache entry
      strcat(key.aux, policy_string);        // any change in policies enabled will be stored as a separate entry
+     key.rehash();
      dslashParam.kernel_type = kernel_type;
      return key;
    }
@@ -16,7 +16,7 @@ namespace quda
 
   template <typename Arg> class TwistedClover : public Dslash<wilsonClover, Arg>
   {
-    using Dslash = Dslash<wilsonClover, Arg>;
+    using Dslash = quda::Dslash<wilsonClover, Arg>;
     using Dslash::arg;
     using Dslash::in;
 
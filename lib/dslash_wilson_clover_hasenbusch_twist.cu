@@ -18,7 +18,7 @@ namespace quda
 
   template <typename Arg> class WilsonCloverHasenbuschTwist : public Dslash<cloverHasenbusch, Arg>
   {
-    using Dslash = Dslash<cloverHasenbusch, Arg>;
+    using Dslash = quda::Dslash<cloverHasenbusch, Arg>;
     using Dslash::arg;
     using Dslash::in;
 
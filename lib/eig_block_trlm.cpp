@@ -12,6 +12,7 @@
 #include <blas_quda.h>
 #include <util_quda.h>
 #include <eigen_helper.h>
+#include <arrow_eigensolve.h>
 
 namespace quda
 {
@@ -390,71 +391,95 @@ namespace quda
     int block_arrow_pos = arrow_pos / block_size;
     int num_locked_offset = (num_locked / block_size) * block_data_length;
 
-    // Eigen objects
-    MatrixXcd T = MatrixXcd::Zero(dim, dim);
     block_ritz_mat.resize(dim * dim);
     int idx = 0;
 
-    // Populate the r and eblocks
-    for (int i = 0; i < block_arrow_pos; i++) {
-      for (int b = 0; b < block_size; b++) {
-        // E block
-        idx = i * block_size + b;
-        T(idx, idx) = alpha[idx + num_locked];
+    if (block_size == 1) {
+      // With unit blocks this is the scalar arrow matrix of TRLM, with
+      // complex off-diagonal entries, so use the structured solver
+      std::vector<double> diag(dim);
+      std::vector<Complex> off(dim - 1);
+      for (int i = 0; i < arrow_pos; i++) diag[i] = alpha[i + num_locked];
+      for (int i = arrow_pos; i < dim; i++) diag[i] = block_alpha[i + num_locked].real();
+      for (int i = 0; i < dim - 1; i++) off[i] = block_beta[i + num_locked];
+
+      // Invert the spectrum due to Chebyshev (except the arrow diagonal)
+      if (reverse) {
+        for (int i = 0; i < dim; i++)
+          if (!(restart_iter > 0 && i < arrow_pos)) diag[i] *= -1.0;
+        for (int i = 0; i < dim - 1; i++) off[i] *= -1.0;
+      }
 
-        for (int c = 0; c < block_size; c++) {
-          // r blocks
-          idx = num_locked_offset + b * block_size + c;
-          T(arrow_pos + c, i * block_size + b) = block_beta[i * block_data_length + idx];
-          T(i * block_size + b, arrow_pos + c) = conj(block_beta[i * block_data_length + idx]);
+      std::vector<double> evals;
+      arrowEigensolve(evals, block_ritz_mat, diag, off, arrow_pos);
+
+      // Populate the alpha array with eigenvalues
+      for (int i = 0; i < dim; i++) alpha[i + num_locked] = evals[i];
+    } else {
+      // Eigen objects
+      MatrixXcd T = MatrixXcd::Zero(dim, dim);
+
+      // Populate the r and eblocks
+      for (int i = 0; i < block_arrow_pos; i++) {
+        for (int b = 0; b < block_size; b++) {
+          // E block
+          idx = i * block_size + b;
+          T(idx, idx) = alpha[idx + num_locked];
+
+          for (int c = 0; c < block_size; c++) {
+            // r blocks
+            idx = num_locked_offset + b * block_size + c;
+            T(arrow_pos + c, i * block_size + b) = block_beta[i * block_data_length + idx];
+            T(i * block_size + b, arrow_pos + c) = conj(block_beta[i * block_data_length + idx]);
+          }
         }
       }
-    }
 
-    // Add the alpha blocks
-    for (int i = block_arrow_pos; i < blocks; i++) {
-      for (int b = 0; b < block_size; b++) {
-        for (int c = 0; c < block_size; c++) {
-          idx = num_locked_offset + b * block_size + c;
-          T(i * block_size + b, i * block_size + c) = block_alpha[i * block_data_length + idx];
+      // Add the alpha blocks
+      for (int i = block_arrow_pos; i < blocks; i++) {
+        for (int b = 0; b < block_size; b++) {
+          for (int c = 0; c < block_size; c++) {
+            idx = num_locked_offset + b * block_size + c;
+            T(i * block_size + b, i * block_size + c) = block_alpha[i * block_data_length + idx];
+          }
         }
       }
-    }
 
-    // Add the beta blocks
-    for (int i = block_arrow_pos; i < blocks - 1; i++) {
-      for (int b = 0; b < block_size; b++) {
-        for (int c = 0; c < b + 1; c++) {
-          idx = num_locked_offset + b * block_size + c;
-          // Sub diag
-          T((i + 1) * block_size + c, i * block_size + b) = block_beta[i * block_data_length + idx];
-          // Super diag
-          T(i * block_size + b, (i + 1) * block_size + c) = conj(block_beta[i * block_data_length + idx]);
+      // Add the beta blocks
+      for (int i = block_arrow_pos; i < blocks - 1; i++) {
+        for (int b = 0; b < block_size; b++) {
+          for (int c = 0; c < b + 1; c++) {
+            idx = num_locked_offset + b * block_size + c;
+            // Sub diag
+            T((i + 1) * block_size + c, i * block_size + b) = block_beta[i * block_data_length + idx];
+            // Super diag
+            T(i * block_size + b, (i + 1) * block_size + c) = conj(block_beta[i * block_data_length + idx]);
+          }
         }
       }
-    }
 
-    // Invert the spectrum due to Chebyshev (except the arrow diagonal)
-    if (reverse) {
-      for (int b = 0; b < dim; b++) {
-        for (int c = 0; c < dim; c++) {
-          T(c, b) *= -1.0;
-          if (restart_iter > 0)
-            if (b == c && b < arrow_pos && c < arrow_pos) T(c, b) *= -1.0;
+      // Invert the spectrum due to Chebyshev (except the arrow diagonal)
+      if (reverse) {
+        for (int b = 0; b < dim; b++) {
+          for (int c = 0; c < dim; c++) {
+            T(c, b) *= -1.0;
+            if (restart_iter > 0)
+              if (b == c && b < arrow_pos && c < arrow_pos) T(c, b) *= -1.0;
+          }
         }
       }
-    }
 
-    // Eigensolve the arrow matrix
-    SelfAdjointEigenSolver<MatrixXcd> eigensolver;
-    eigensolver.compute(T);
+      // Eigensolve the arrow matrix
+      SelfAdjointEigenSolver<MatrixXcd> eigensolver;
+      eigensolver.compute(T);
 
-    // Populate the alpha array with eigenvalues
-    for (int i = 0; i < dim; i++) alpha[i + num_locked] = eigensolver.eigenvalues()[i];
+      // Populate the alpha array with eigenvalues
+      for (int i = 0; i < dim; i++) alpha[i + num_locked] = eigensolver.eigenvalues()[i];
 
-    // Repopulate ritz matrix: COLUMN major
-    for (int i = 0; i < dim; i++)
-      for (int j = 0; j < dim; j++) block_ritz_mat[dim * i + j] = eigensolver.eigenvectors().col(i)[j];
+      // Repopulate ritz matrix: COLUMN major
+      for (int i = 0; i < dim; i++)
+        for (int j = 0; j < dim; j++) block_ritz_mat[dim * i + j] = eigensolver.eigenvectors().col(i)[j];
+    }
 
     for (int i = 0; i < blocks; i++) {
       for (int b = 0; b < block_size; b++) {
@@ -4,6 +4,7 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <limits>
 
 #include <quda_internal.h>
 #include <eigensolve_quda.h>
@@ -194,127 +195,202 @@ namespace quda
     }
   }
 
+  /**
+     @brief Apply a Givens rotation to the pair (a, b) from the right,
+     (a, b) <- (c a + conj(s) b, c b - s a).  This is spelled out in
+     real arithmetic since std::complex multiplication carries inf/nan
+     recovery that dominates these short loops.  The left rotation
+     G [a; b] is the same with s replaced by conj(s).
+  */
+  static inline void givensRotate(Complex &a, Complex &b, double c, const Complex &s)
+  {
+    const double ar = a.real(), ai = a.imag();
+    const double br = b.real(), bi = b.imag();
+    const double sr = s.real(), si = s.imag();
+    a = Complex(c * ar + sr * br + si * bi, c * ai + sr * bi - si * br);
+    b = Complex(c * br - sr * ar + si * ai, c * bi - sr * ai - si * ar);
+  }
+
   void IRAM::qrShifts(const std::vector<Complex> evals, const int num_shifts)
   {
     // This isn't really Eigen, but it's morally equivalent
     profile.TPSTART(QUDA_PROFILE_HOST_COMPUTE);
 
-    // Reset Q to the identity, copy upper Hessenberg
-    MatrixXcd UHcopy = MatrixXcd::Zero(n_kr, n_kr);
-    for (int i = 0; i < n_kr; i++) {
-      for (int j = 0; j < n_kr; j++) {
-        if (i == j)
-          Qmat[i][j] = 1.0;
-        else
-          Qmat[i][j] = 0.0;
-        UHcopy(i, j) = upperHess[i][j];
-      }
-    }
-
-    for (int shift = 0; shift < num_shifts; shift++) {
-
-      // Shift the eigenvalue
-      for (int i = 0; i < n_kr; i++) upperHess[i][i] -= evals[shift];
+    // Reset Q to the identity
+    for (int i = 0; i < n_kr; i++)
+      for (int j = 0; j < n_kr; j++) Qmat[i][j] = (i == j) ? 1.0 : 0.0;
 
-      qrIteration(Qmat, upperHess);
+    double tol = eig_param->qr_tol;
+    std::vector<GivensSweep> sweeps;
 
-      for (int i = 0; i < n_kr; i++) upperHess[i][i] += evals[shift];
+    for (int shift = 0; shift < num_shifts; shift++) {
+      // Apply the shift to each unreduced block of the upper Hessenberg
+      int lo = 0;
+      for (int i = 0; i < n_kr; i++) {
+        if (i < n_kr - 1 && abs(upperHess[i + 1][i]) >= tol) continue;
+        if (i < n_kr - 1) upperHess[i + 1][i] = 0.0;
+        if (i > lo) qrBulgeChase(Qmat, upperHess, sweeps, lo, i, evals[shift]);
+        lo = i + 1;
+      }
     }
+    applySweeps(Qmat, upperHess, sweeps);
 
     profile.TPSTOP(QUDA_PROFILE_HOST_COMPUTE);
   }
 
-  void IRAM::qrIteration(Complex **Q, Complex **R)
+  void IRAM::qrBulgeChase(Complex **Q, Complex **H, std::vector<GivensSweep> &sweeps, int lo, int hi, Complex shift)
   {
-    Complex T11, T12, T21, T22, U1, U2;
-    double dV;
-
-    double tol = eig_param->qr_tol;
-
-    // Allocate the rotation matrices.
-    std::vector<Complex> R11(n_kr - 1, 0.0);
-    std::vector<Complex> R12(n_kr - 1, 0.0);
-    std::vector<Complex> R21(n_kr - 1, 0.0);
-    std::vector<Complex> R22(n_kr - 1, 0.0);
-
-    for (int i = 0; i < n_kr - 1; i++) {
-
-      // If the sub-diagonal element is numerically
-      // small enough, floor it to 0;
-      if (abs(R[i + 1][i]) < tol) {
-        R[i + 1][i] = 0.0;
-        continue;
+    // The deferred rotations must be applied before the window grows
+    // into the region they cover, and the batch is bounded in size
+    if (!sweeps.empty() && (lo < sweeps.back().lo || hi > sweeps.back().hi || sweeps.size() == max_deferred_sweeps))
+      applySweeps(Q, H, sweeps);
+
+    sweeps.push_back({lo, hi, std::vector<double>(hi - lo), std::vector<Complex>(hi - lo)});
+    auto &c = sweeps.back().c;
+    auto &s = sweeps.back().s;
+
+    // Chase the bulge down the active window
+    for (int k = lo; k < hi; k++) {
+      Complex x = (k == lo) ? H[lo][lo] - shift : H[k][k - 1];
+      Complex y = (k == lo) ? H[lo + 1][lo] : H[k + 1][k - 1];
+
+      // Rotation G = [c s; -conj(s) c] with G [x; y] = [r; 0]
+      double nrm = sqrt(norm(x) + norm(y));
+      double ck = 1.0;
+      Complex sk = 0.0;
+      Complex r = x;
+      if (nrm > 0.0) {
+        double ax = abs(x);
+        Complex phase = ax > 0.0 ? x / ax : Complex(1.0);
+        ck = ax / nrm;
+        sk = phase * conj(y) / nrm;
+        r = phase * nrm;
       }
+      c[k - lo] = ck;
+      s[k - lo] = sk;
 
-      U1 = R[i][i];
-      dV = sqrt(norm(R[i][i]) + norm(R[i + 1][i]));
-      dV = (U1.real() > 0) ? dV : -dV;
-      U1 += dV;
-      U2 = R[i + 1][i];
-
-      T11 = conj(U1) / dV;
-      R11[i] = conj(T11);
+      // H <- G H on rows k, k+1
+      if (k > lo) {
+        H[k][k - 1] = r;
+        H[k + 1][k - 1] = 0.0;
+      }
+      for (int j = k; j <= hi; j++) givensRotate(H[k][j], H[k + 1][j], ck, conj(sk));
 
-      T12 = conj(U2) / dV;
-      R12[i] = conj(T12);
+      // H <- H G^dagger on columns k, k+1
+      for (int i = lo; i <= std::min(k + 2, hi); i++) givensRotate(H[i][k], H[i][k + 1], ck, sk);
+    }
+  }
 
-      T21 = conj(T12) * conj(U1) / U1;
-      R21[i] = conj(T21);
+  void IRAM::applySweeps(Complex **Q, Complex **H, std::vector<GivensSweep> &sweeps)
+  {
+    if (sweeps.empty()) return;
+
+    // Apply the sweeps' rotations from the right to rows [i0, i1) of
+    // A, skipping the rows that are at or below each sweep's window
+    // (none of them for Q).  The rows of a block are interleaved so
+    // that their dependent chains of rotations overlap.
+    constexpr int row_block = 4;
+    auto rotate_rows = [&](Complex **A, int i0, int i1, bool all) {
+      for (auto &sweep : sweeps) {
+        const int n_rows = (all ? i1 : std::min(i1, sweep.lo)) - i0;
+        if (n_rows <= 0) continue;
+        const int n_rot = sweep.hi - sweep.lo;
+        const double *c = sweep.c.data();
+        const Complex *s = sweep.s.data();
+        Complex *x[row_block];
+        for (int r = 0; r < n_rows; r++) x[r] = A[i0 + r] + sweep.lo;
+        for (int k = 0; k < n_rot; k++)
+          for (int r = 0; r < n_rows; r++) givensRotate(x[r][k], x[r][k + 1], c[k], s[k]);
+      }
+    };
 
-      T22 = T12 * U2 / U1;
-      R22[i] = conj(T22);
+    int lo_max = 0;
+    int hi_min = n_kr - 1;
+    for (auto &sweep : sweeps) {
+      lo_max = std::max(lo_max, sweep.lo);
+      hi_min = std::min(hi_min, sweep.hi);
+    }
 
-      // Do the H_kk and set the H_k+1k to zero
-      R[i][i] -= (T11 * R[i][i] + T12 * R[i + 1][i]);
-      R[i + 1][i] = 0;
+    // Columns right of the windows are done in blocks, so that each
+    // rotation streams along contiguous rows of the block
+    constexpr int col_block = 64;
+    const int n_col_blocks = (n_kr - hi_min - 1 + col_block - 1) / col_block;
 
-      // Continue for the other columns
 #ifdef _OPENMP
-#pragma omp parallel for schedule(static, 32)
+#pragma omp parallel
+    {
+#pragma omp for schedule(static) nowait
 #endif
-      for (int j = i + 1; j < n_kr; j++) {
-        Complex temp = R[i][j];
-        R[i][j] -= (T11 * temp + T12 * R[i + 1][j]);
-        R[i + 1][j] -= (T21 * temp + T22 * R[i + 1][j]);
-      }
-    }
-
-    // Rotate R and V, i.e. H->RQ. V->VQ
-    // Loop over columns of upper Hessenberg
-    for (int j = 0; j < n_kr - 1; j++) {
-      if (abs(R11[j]) > tol) {
-        // Loop over the rows, up to the sub diagonal element i=j+1
+      for (int i = 0; i < n_kr; i += row_block) rotate_rows(Q, i, std::min(i + row_block, n_kr), true);
 #ifdef _OPENMP
-#pragma omp parallel
-        {
-#pragma omp for schedule(static, 32) nowait
+#pragma omp for schedule(static) nowait
 #endif
-          for (int i = 0; i < j + 2; i++) {
-            Complex temp = R[i][j];
-            R[i][j] -= (R11[j] * temp + R12[j] * R[i][j + 1]);
-            R[i][j + 1] -= (R21[j] * temp + R22[j] * R[i][j + 1]);
-          }
+      for (int i = 0; i < lo_max; i += row_block) rotate_rows(H, i, std::min(i + row_block, lo_max), false);
 #ifdef _OPENMP
-#pragma omp for schedule(static, 32) nowait
+#pragma omp for schedule(static) nowait
 #endif
-          for (int i = 0; i < n_kr; i++) {
-            Complex temp = Q[i][j];
-            Q[i][j] -= (R11[j] * temp + R12[j] * Q[i][j + 1]);
-            Q[i][j + 1] -= (R21[j] * temp + R22[j] * Q[i][j + 1]);
+      for (int b = 0; b < n_col_blocks; b++) {
+        const int j1 = std::min(hi_min + 1 + (b + 1) * col_block, n_kr);
+        for (auto &sweep : sweeps) {
+          const int j0 = std::max(hi_min + 1 + b * col_block, sweep.hi + 1);
+          for (int k = 0; k < sweep.hi - sweep.lo; k++) {
+            const double c = sweep.c[k];
+            const Complex s = conj(sweep.s[k]);
+            Complex *row0 = H[sweep.lo + k];
+            Complex *row1 = H[sweep.lo + k + 1];
+            for (int j = j0; j < j1; j++) givensRotate(row0[j], row1[j], c, s);
           }
-#ifdef _OPENMP
         }
+      }
+#ifdef _OPENMP
+    }
 #endif
+
+    sweeps.clear();
+  }
+
+  /**
+     @brief Compute the eigenvectors of a matrix from its complex Schur
+     decomposition H = U T U^dagger.  The eigenvectors X of the upper
+     triangular T are found by back substitution, which is independent
+     for each eigenvector, and then rotated back by U.
+     @param[in,out] U On input the Schur vectors, on output the
+     normalized eigenvectors of H
+     @param[in] T The upper triangular Schur form
+  */
+  static void schurEigenvectors(MatrixXcd &U, const MatrixXcd &T)
+  {
+    const int n = T.rows();
+    const double small = std::max(T.norm(), 1.0) * std::numeric_limits<double>::epsilon();
+
+    MatrixXcd X = MatrixXcd::Zero(n, n);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 8)
+#endif
+    for (int k = 0; k < n; k++) {
+      X(k, k) = 1.0;
+      for (int i = k - 1; i >= 0; i--) {
+        Complex sum = 0.0;
+        for (int j = i + 1; j <= k; j++) sum += T(i, j) * X(j, k);
+        Complex denom = T(i, i) - T(k, k);
+        if (abs(denom) < small) denom = small;
+        X(i, k) = -sum / denom;
       }
     }
+
+    U = U * X.triangularView<Eigen::Upper>();
+    for (int k = 0; k < n; k++) U.col(k).normalize();
   }
 
   void IRAM::eigensolveFromUpperHess(std::vector<Complex> &evals, const double beta)
   {
+    MatrixXcd Q;
+    MatrixXcd T;
+
     if (eig_param->use_eigen_qr) {
       profile.TPSTART(QUDA_PROFILE_EIGENQR);
       // Construct the upper Hessenberg matrix
-      MatrixXcd Q = MatrixXcd::Identity(n_kr, n_kr);
+      Q = MatrixXcd::Identity(n_kr, n_kr);
       MatrixXcd R = MatrixXcd::Zero(n_kr, n_kr);
       for (int i = 0; i < n_kr; i++) {
         for (int j = 0; j < n_kr; j++) { R(i, j) = upperHess[i][j]; }
@@ -323,24 +399,9 @@ namespace quda
       // QR the upper Hessenberg matrix
       Eigen::ComplexSchur<MatrixXcd> schurUH;
       schurUH.computeFromHessenberg(R, Q);
+      Q = schurUH.matrixU();
+      T = schurUH.matrixT().triangularView<Eigen::Upper>();
       profile.TPSTOP(QUDA_PROFILE_EIGENQR);
-
-      profile.TPSTART(QUDA_PROFILE_EIGENEV);
-      // Extract the upper triangular matrix, eigensolve, then
-      // get the eigenvectors of the upper Hessenberg
-      MatrixXcd matUpper = MatrixXcd::Zero(n_kr, n_kr);
-      matUpper = schurUH.matrixT().triangularView<Eigen::Upper>();
-      matUpper.conservativeResize(n_kr, n_kr);
-      Eigen::ComplexEigenSolver<MatrixXcd> eigenSolver(matUpper);
-      Q = schurUH.matrixU() * eigenSolver.eigenvectors();
-
-      // Update eigenvalues, residuia, and the Q matrix
-      for (int i = 0; i < n_kr; i++) {
-        evals[i] = eigenSolver.eigenvalues()[i];
-        residua[i] = abs(beta * Q.col(i)[n_kr - 1]);
-        for (int j = 0; j < n_kr; j++) Qmat[i][j] = Q(i, j);
-      }
-      profile.TPSTOP(QUDA_PROFILE_EIGENEV);
     } else {
       profile.TPSTART(QUDA_PROFILE_HOST_COMPUTE);
       // Copy the upper Hessenberg matrix into Rmat, and set Qmat to the identity
@@ -359,74 +420,79 @@ namespace quda
       double tol = eig_param->qr_tol;
       int max_iter = 100000;
       int iter = 0;
+      int iter_block = 0;
 
+      // Reduce to Schur form, deflating from the bottom and only
+      // iterating on the active unreduced window [lo, hi]
       Complex temp, discriminant, sol1, sol2, eval;
-      for (int i = n_kr - 2; i >= 0; i--) {
-        while (iter < max_iter) {
-          if (abs(Rmat[i + 1][i]) < tol) {
-            Rmat[i + 1][i] = 0.0;
-            break;
-          } else {
-
-            // Compute the 2 eigenvalues via the quadratic formula
-            //----------------------------------------------------
-            // The discriminant
-            temp = (Rmat[i][i] - Rmat[i + 1][i + 1]) * (Rmat[i][i] - Rmat[i + 1][i + 1]) / 4.0;
-            discriminant = sqrt(Rmat[i + 1][i] * Rmat[i][i + 1] + temp);
-
-            // Reuse temp
-            temp = (Rmat[i][i] + Rmat[i + 1][i + 1]) / 2.0;
-
-            sol1 = temp - Rmat[i + 1][i + 1] + discriminant;
-            sol2 = temp - Rmat[i + 1][i + 1] - discriminant;
-            //----------------------------------------------------
-
-            // Deduce the better eval to shift
-            eval = Rmat[i + 1][i + 1] + (norm(sol1) < norm(sol2) ? sol1 : sol2);
-
-            // Shift the eigenvalue
-            for (int j = 0; j < n_kr; j++) Rmat[j][j] -= eval;
-
-            // Do the QR iteration
-            qrIteration(Qmat, Rmat);
+      std::vector<GivensSweep> sweeps;
+      int hi = n_kr - 1;
+      while (hi > 0 && iter < max_iter) {
+        int lo = hi;
+        while (lo > 0 && abs(Rmat[lo][lo - 1]) >= tol) lo--;
+        if (lo > 0) Rmat[lo][lo - 1] = 0.0;
+
+        if (lo == hi) {
+          hi--;
+          iter_block = 0;
+          continue;
+        }
 
-            // Shift back
-            for (int j = 0; j < n_kr; j++) Rmat[j][j] += eval;
-          }
-          iter++;
+        if (iter_block > 0 && iter_block % 10 == 0) {
+          // Exceptional shift to break a stagnating iteration
+          eval = Rmat[hi][hi] + 0.75 * abs(Rmat[hi][hi - 1]);
+        } else {
+          // Compute the 2 eigenvalues of the trailing 2x2 via the quadratic formula
+          //----------------------------------------------------
+          int i = hi - 1;
+          // The discriminant
+          temp = (Rmat[i][i] - Rmat[i + 1][i + 1]) * (Rmat[i][i] - Rmat[i + 1][i + 1]) / 4.0;
+          discriminant = sqrt(Rmat[i + 1][i] * Rmat[i][i + 1] + temp);
+
+          // Reuse temp
+          temp = (Rmat[i][i] + Rmat[i + 1][i + 1]) / 2.0;
+
+          sol1 = temp - Rmat[i + 1][i + 1] + discriminant;
+          sol2 = temp - Rmat[i + 1][i + 1] - discriminant;
+          //----------------------------------------------------
+
+          // Deduce the better eval to shift
+          eval = Rmat[i + 1][i + 1] + (norm(sol1) < norm(sol2) ? sol1 : sol2);
         }
+
+        qrBulgeChase(Qmat, Rmat, sweeps, lo, hi, eval);
+        iter++;
+        iter_block++;
       }
-      profile.TPSTOP(QUDA_PROFILE_HOST_COMPUTE);
+      applySweeps(Qmat, Rmat, sweeps);
 
-      profile.TPSTART(QUDA_PROFILE_EIGENEV);
-      // Compute the eigevectors of the origial upper Hessenberg
-      // This is now very cheap because the input matrix to Eigen
-      // is upper triangular.
-      MatrixXcd Q = MatrixXcd::Zero(n_kr, n_kr);
-      MatrixXcd R = MatrixXcd::Zero(n_kr, n_kr);
+      if (iter == max_iter) warningQuda("QR iterations did not converge after %d iterations", max_iter);
+
+      Q.resize(n_kr, n_kr);
+      T = MatrixXcd::Zero(n_kr, n_kr);
       for (int i = 0; i < n_kr; i++) {
         for (int j = 0; j < n_kr; j++) {
           Q(i, j) = Qmat[i][j];
-          R(i, j) = Rmat[i][j];
+          if (j >= i) T(i, j) = Rmat[i][j];
         }
       }
+      profile.TPSTOP(QUDA_PROFILE_HOST_COMPUTE);
 
-      MatrixXcd matUpper = MatrixXcd::Zero(n_kr, n_kr);
-      matUpper = R.triangularView<Eigen::Upper>();
-      matUpper.conservativeResize(n_kr, n_kr);
-      Eigen::ComplexEigenSolver<MatrixXcd> eigenSolver(matUpper);
-      Q *= eigenSolver.eigenvectors();
+      if (getVerbosity() >= QUDA_VERBOSE) printfQuda("QR iterations = %d\n", iter);
+    }
 
-      // Update eigenvalues, residuia, and the Q matrix
-      for (int i = 0; i < n_kr; i++) {
-        evals[i] = eigenSolver.eigenvalues()[i];
-        residua[i] = abs(beta * Q.col(i)[n_kr - 1]);
-        for (int j = 0; j < n_kr; j++) Qmat[i][j] = Q(i, j);
-      }
+    profile.TPSTART(QUDA_PROFILE_EIGENEV);
+    // Compute the eigenvectors of the original upper Hessenberg from
+    // the Schur form.  This is cheap because T is upper triangular.
+    schurEigenvectors(Q, T);
 
-      if (getVerbosity() >= QUDA_VERBOSE) printfQuda("QR iterations = %d\n", iter);
-      profile.TPSTOP(QUDA_PROFILE_EIGENEV);
+    // Update eigenvalues, residuia, and the Q matrix
+    for (int i = 0; i < n_kr; i++) {
+      evals[i] = T(i, i);
+      residua[i] = abs(beta * Q.col(i)[n_kr - 1]);
+      for (int j = 0; j < n_kr; j++) Qmat[i][j] = Q(i, j);
     }
+    profile.TPSTOP(QUDA_PROFILE_EIGENEV);
   }
 
   void IRAM::operator()(std::vector<ColorSpinorField *> &kSpace, std::vector<Complex> &evals)
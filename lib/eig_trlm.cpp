@@ -11,7 +11,7 @@
 #include <color_spinor_field.h>
 #include <blas_quda.h>
 #include <util_quda.h>
-#include <eigen_helper.h>
+#include <arrow_eigensolve.h>
 
 namespace quda
 {
@@ -279,11 +279,6 @@ namespace quda
     int dim = n_kr - num_locked;
     int arrow_pos = num_keep - num_locked;
 
-    // Eigen objects
-    MatrixXd A = MatrixXd::Zero(dim, dim);
-    ritz_mat.resize(dim * dim);
-    for (int i = 0; i < dim * dim; i++) ritz_mat[i] = 0.0;
-
     // Invert the spectrum due to chebyshev
     if (reverse) {
       for (int i = num_locked; i < n_kr - 1; i++) {
@@ -293,39 +288,18 @@ namespace quda
       alpha[n_kr - 1] *= -1.0;
     }
 
-    // Construct arrow mat A_{dim,dim}
-    for (int i = 0; i < dim; i++) {
-
-      // alpha populates the diagonal
-      A(i, i) = alpha[i + num_locked];
-    }
-
-    for (int i = 0; i < arrow_pos; i++) {
-
-      // beta populates the arrow
-      A(i, arrow_pos) = beta[i + num_locked];
-      A(arrow_pos, i) = beta[i + num_locked];
-    }
-
-    for (int i = arrow_pos; i < dim - 1; i++) {
-
-      // beta populates the sub-diagonal
-      A(i, i + 1) = beta[i + num_locked];
-      A(i + 1, i) = beta[i + num_locked];
-    }
+    // alpha populates the diagonal, beta the arrow and then the sub-diagonal
+    std::vector<double> diag(alpha + num_locked, alpha + n_kr);
+    std::vector<double> off(beta + num_locked, beta + n_kr - 1);
 
     // Eigensolve the arrow matrix
-    SelfAdjointEigenSolver<MatrixXd> eigensolver;
-    eigensolver.compute(A);
-
-    // repopulate ritz matrix
-    for (int i = 0; i < dim; i++)
-      for (int j = 0; j < dim; j++) ritz_mat[dim * i + j] = eigensolver.eigenvectors().col(i)[j];
+    std::vector<double> evals;
+    arrowEigensolve(evals, ritz_mat, diag, off, arrow_pos);
 
     for (int i = 0; i < dim; i++) {
-      residua[i + num_locked] = fabs(beta[n_kr - 1] * eigensolver.eigenvectors().col(i)[dim - 1]);
+      residua[i + num_locked] = fabs(beta[n_kr - 1] * ritz_mat[dim * i + dim - 1]);
       // Update the alpha array
-      alpha[i + num_locked] = eigensolver.eigenvalues()[i];
+      alpha[i + num_locked] = evals[i];
     }
 
     // Put spectrum back in order
@@ -9,12 +9,17 @@
 #include <reduce_helper.h>
 #include <index_helper.cuh>
 
+// cuFFT is not available on the CPU target, where this method is not built
+#ifndef QUDA_TARGET_CPU
 #include <cufft.h>
 #include <CUFFT_Plans.h>
+#endif
 #include <instantiate.h>
 
 namespace quda {
 
+#ifndef QUDA_TARGET_CPU
+
 //UNCOMMENT THIS IF YOU WAN'T TO USE LESS MEMORY
 #define GAUGEFIXING_DONT_USE_GX
 //Without using the precalculation of g(x),
@@ -840,6 +845,7 @@ namespace quda {
       }
     }
   };
+#endif // QUDA_TARGET_CPU
 
   /**
    * @brief Gauge fixing with Steepest descent method with FFTs with support for single GPU only.
@@ -855,7 +861,9 @@ namespace quda {
   void gaugeFixingFFT(GaugeField& data, const int gauge_dir, const int Nsteps, const int verbose_interval, const double alpha,
                       const int autotune, const double tolerance, const int stopWtheta)
   {
-#ifdef GPU_GAUGE_ALG
+#if defined(QUDA_TARGET_CPU)
+    errorQuda("Gauge fixing with FFTs is not supported on the CPU target");
+#elif defined(GPU_GAUGE_ALG)
 #ifdef MULTI_GPU
     if (comm_dim_partitioned(0) || comm_dim_partitioned(1) || comm_dim_partitioned(2) || comm_dim_partitioned(3))
       errorQuda("Gauge Fixing with FFTs in multi-GPU support NOT implemented yet!\n");
@@ -1,7 +1,11 @@
 #include <comm_quda.h>
 #include <gauge_fix_ovr_extra.h>
-#include <thrust_helper.cuh>
 #include <tune_quda.h>
+#ifdef QUDA_TARGET_CPU
+#include <algorithm>
+#else
+#include <thrust_helper.cuh>
+#endif
 
 namespace quda {
 
@@ -77,12 +81,16 @@ namespace quda {
     int nlinksfaces = 0;
     for ( int dir = 0; dir < 4; ++dir )
       if ( comm_dim_partitioned(dir)) nlinksfaces += faceVolume[dir];
+#ifndef QUDA_TARGET_CPU
     thrust::device_ptr<int> array_faceT[2];
     thrust::device_ptr<int> array_interiorT[2];
+#endif
     for ( int i = 0; i < 2; i++ ) { //even and odd ids
       borderpoints[i] = static_cast<int*>(pool_device_malloc(nlinksfaces * sizeof(int) ));
       qudaMemset(borderpoints[i], 0, nlinksfaces * sizeof(int) );
+#ifndef QUDA_TARGET_CPU
       array_faceT[i] = thrust::device_pointer_cast(borderpoints[i]);
+#endif
     }
     TuneParam tp;
     tp.block = dim3(128, 1, 1);
@@ -100,10 +108,16 @@ namespace quda {
     int size[2];
     for ( int i = 0; i < 2; i++ ) {
       //sort and remove duplicated lattice indices
+#ifdef QUDA_TARGET_CPU
+      // the device allocations are host memory on the CPU target
+      std::sort(borderpoints[i], borderpoints[i] + nlinksfaces);
+      size[i] = std::unique(borderpoints[i], borderpoints[i] + nlinksfaces) - borderpoints[i];
+#else
       thrust_allocator alloc;
       thrust::sort(thrust::cuda::par(alloc), array_faceT[i], array_faceT[i] + nlinksfaces);
       thrust::device_ptr<int> new_end = thrust::unique(array_faceT[i], array_faceT[i] + nlinksfaces);
       size[i] = thrust::raw_pointer_cast(new_end) - thrust::raw_pointer_cast(array_faceT[i]);
+#endif
     }
     if ( size[0] == size[1] ) threads = size[0];
     else errorQuda("BORDER: Even and Odd sizes does not match, not supported!!!!, %d:%d",size[0],size[1]);
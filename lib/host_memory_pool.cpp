@@ -0,0 +1,156 @@
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <vector>
+#include <unistd.h>   // for getpagesize()
+#include <sys/mman.h> // for madvise()
+#include <quda_internal.h>
+
+namespace quda
+{
+
+  namespace pool
+  {
+
+    /** Blocks at least this large are aligned to (and advised as)
+        transparent hugepages */
+    static constexpr size_t huge_page_size = 2 * 1024 * 1024;
+
+    /** Free lists of inactive host-memory blocks, keyed by size class */
+    static std::map<size_t, std::vector<void *>> hostCache;
+
+    /** Guards hostCache and the statistics below, since host
+        temporaries are allocated from within threaded regions */
+    static std::mutex host_mutex;
+
+    static long host_active_bytes = 0;   // bytes in blocks handed out
+    static long host_active_request = 0; // bytes requested for those blocks
+    static long host_cached_bytes = 0;   // bytes in blocks on the free lists
+    static long host_max_footprint = 0;  // high water of active + cached bytes
+    static long host_peak_active = 0;    // active bytes at the high water
+    static long host_peak_request = 0;   // requested bytes at the high water
+    static size_t host_hits = 0;
+    static size_t host_misses = 0;
+
+    bool host_memory_pool()
+    {
+      // the first call may come from any thread, so use a thread-safe
+      // static, and it may precede comms initialization (e.g., from
+      // comm_init() itself), so it is announced by pool::init() instead
+      static const bool pool = []() {
+        char *enable_host_pool = getenv("QUDA_ENABLE_HOST_MEMORY_POOL");
+        return enable_host_pool && strcmp(enable_host_pool, "1") == 0;
+      }();
+
+      return pool;
+    }
+
+    /**
+       @brief Round a request up to its size class: multiples of the
+       page size up to eight pages, and four classes per power of two
+       beyond that, so at most a quarter of a block is wasted.
+    */
+    static size_t host_class_size(size_t size)
+    {
+      static const size_t page_size = getpagesize();
+      size_t step = page_size;
+      while (8 * step < size) step *= 2;
+      return ((size + step - 1) / step) * step;
+    }
+
+    static void *host_block_alloc(size_t base_size)
+    {
+      static const size_t page_size = getpagesize();
+      const size_t align = base_size >= huge_page_size ? huge_page_size : page_size;
+      void *ptr = nullptr;
+      if (posix_memalign(&ptr, align, base_size) != 0) return nullptr;
+#ifdef MADV_HUGEPAGE
+      if (align == huge_page_size) madvise(ptr, base_size, MADV_HUGEPAGE); // advisory only
+#endif
+      return ptr;
+    }
+
+    void *host_acquire(size_t size, size_t &base_size)
+    {
+      static const size_t page_size = getpagesize();
+      if (!host_memory_pool() || size < page_size) {
+        base_size = size;
+        return malloc(size);
+      }
+
+      base_size = host_class_size(size);
+      void *ptr = nullptr;
+      {
+        std::lock_guard<std::mutex> lock(host_mutex);
+        auto it = hostCache.find(base_size);
+        if (it != hostCache.end() && !it->second.empty()) {
+          ptr = it->second.back();
+          it->second.pop_back();
+          host_cached_bytes -= base_size;
+          host_hits++;
+        } else {
+          host_misses++;
+        }
+      }
+
+      if (!ptr) {
+        ptr = host_block_alloc(base_size);
+        if (!ptr) { // give the cached blocks back to the system and retry
+          flush_host();
+          ptr = host_block_alloc(base_size);
+          if (!ptr) return nullptr;
+        }
+      }
+
+      std::lock_guard<std::mutex> lock(host_mutex);
+      host_active_bytes += base_size;
+      host_active_request += size;
+      if (host_active_bytes + host_cached_bytes > host_max_footprint) {
+        host_max_footprint = host_active_bytes + host_cached_bytes;
+        host_peak_active = host_active_bytes;
+        host_peak_request = host_active_request;
+      }
+      return ptr;
+    }
+
+    void host_release(void *ptr, size_t size, size_t base_size)
+    {
+      static const size_t page_size = getpagesize();
+      if (!host_memory_pool() || base_size < page_size) {
+        free(ptr);
+        return;
+      }
+
+      std::lock_guard<std::mutex> lock(host_mutex);
+      hostCache[base_size].push_back(ptr);
+      host_active_bytes -= base_size;
+      host_active_request -= size;
+      host_cached_bytes += base_size;
+    }
+
+    void flush_host()
+    {
+      std::lock_guard<std::mutex> lock(host_mutex);
+      for (auto &entry : hostCache) {
+        for (auto ptr : entry.second) free(ptr);
+      }
+      hostCache.clear();
+      host_cached_bytes = 0;
+    }
+
+    void print_host_stats()
+    {
+      std::lock_guard<std::mutex> lock(host_mutex);
+      const double MB = 1 << 20;
+      printfQuda("Host memory pool high water = %.1f MB (%.1f MB active, %.1f MB cached)\n", host_max_footprint / MB,
+                 host_peak_active / MB, (host_max_footprint - host_peak_active) / MB);
+      printfQuda("Host memory pool size-class overhead at high water = %.1f%%\n",
+                 host_peak_active > 0 ? 100.0 * (host_peak_active - host_peak_request) / host_peak_active : 0.0);
+      printfQuda("Host memory pool reused %lu of %lu allocations\n", (unsigned long)host_hits,
+                 (unsigned long)(host_hits + host_misses));
+    }
+
+  } // namespace pool
+
+} // namespace quda
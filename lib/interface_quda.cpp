@@ -366,7 +366,11 @@ void setMPICommHandleQuda(void *mycomm)
 #endif
 }
 
+#ifdef THREAD_COMMS
+static thread_local bool comms_initialized = false; // each rank is a thread
+#else
 static bool comms_initialized = false;
+#endif
 
 void initCommsGridQuda(int nDim, const int *dims, QudaCommsMap func, void *fdata)
 {
@@ -377,6 +381,7 @@ void initCommsGridQuda(int nDim, const int *dims, QudaCommsMap func, void *fdata
   }
 
   LexMapData map_data;
+  CommTopologyMap topology_map;
   if (!func) {
 
 #if QMP_COMMS
@@ -396,12 +401,18 @@ void initCommsGridQuda(int nDim, const int *dims, QudaCommsMap func, void *fdata
       warningQuda("QMP logical topology is undeclared; using default lexicographical ordering");
 #endif
 
-      map_data.ndim = nDim;
-      for (int i=0; i<nDim; i++) {
-        map_data.dims[i] = dims[i];
+      char *topology_env = getenv("QUDA_ENABLE_TOPOLOGY_MAPPING");
+      if (topology_env && strcmp(topology_env, "1") == 0) {
+        // the mapping is filled in once the communicator knows where each rank runs
+        topology_map.dims.assign(dims, dims + nDim);
+        fdata = (void *)&topology_map;
+        func = comm_topology_rank_from_coords;
+      } else {
+        map_data.ndim = nDim;
+        for (int i = 0; i < nDim; i++) { map_data.dims[i] = dims[i]; }
+        fdata = (void *)&map_data;
+        func = lex_rank_from_coords;
       }
-      fdata = (void *) &map_data;
-      func = lex_rank_from_coords;
 
 #if QMP_COMMS
     }
@@ -415,6 +426,12 @@ void initCommsGridQuda(int nDim, const int *dims, QudaCommsMap func, void *fdata
   comm_init(nDim, dims, func, fdata);
 #endif
 
+  // the topology mapping is built before the communicator exists, so it is reported here
+  if (func == comm_topology_rank_from_coords && fdata == &topology_map) {
+    for (auto &warning : topology_map.warnings) warningQuda("%s", warning.c_str());
+    if (!topology_map.report.empty()) printfQuda("%s", topology_map.report.c_str());
+  }
+
   comms_initialized = true;
 }
 
@@ -432,6 +449,8 @@ static void init_default_comms()
   }
 #elif defined(MPI_COMMS)
   errorQuda("When using MPI for communications, initCommsGridQuda() must be called before initQuda()");
+#elif defined(THREAD_COMMS)
+  errorQuda("When using threads for communications, initCommsGridQuda() must be called before initQuda()");
 #else // single-GPU
   const int dims[4] = {1, 1, 1, 1};
   initCommsGridQuda(4, dims, nullptr, nullptr);
@@ -484,6 +503,13 @@ void initQudaDevice(int dev)
   { // determine if we will do CPU or GPU data reordering (default is GPU)
     char *reorder_str = getenv("QUDA_REORDER_LOCATION");
 
+#ifdef QUDA_TARGET_CPU
+    // there is no device to reorder on with the CPU target
+    if (reorder_str && (!strcmp(reorder_str, "GPU") || !strcmp(reorder_str, "gpu")))
+      warningQuda("Ignoring QUDA_REORDER_LOCATION=%s with the CPU target", reorder_str);
+    reorder_str = const_cast<char *>("CPU");
+#endif
+
     if (!reorder_str || (strcmp(reorder_str,"CPU") && strcmp(reorder_str,"cpu")) ) {
       warningQuda("Data reordering done on GPU (set with QUDA_REORDER_LOCATION=GPU/CPU)");
       reorder_location_set(QUDA_CUDA_FIELD_LOCATION);
@@ -1493,6 +1519,7 @@ void endQuda(void)
 
   saveTuneCache();
   saveProfile();
+  timeline::save();
 
   // flush any outstanding force monitoring (if enabled)
   flushForceMonitor();
@@ -1547,6 +1574,7 @@ void endQuda(void)
     printfQuda("\n");
   }
 
+  pool::flush_host();
   assertAllMemFree();
 
   device::destroy();
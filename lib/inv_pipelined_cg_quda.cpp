@@ -0,0 +1,388 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <quda_internal.h>
+#include <blas_quda.h>
+#include <invert_quda.h>
+#include <util_quda.h>
+
+/**
+   @file inv_pipelined_cg_quda.cpp
+
+   Implementation of the pipelined conjugate-gradient algorithm of
+   Ghysels and Vanroose (Parallel Computing 40, 224 (2014)).  Besides
+   the residual r, the auxiliary vectors w = A r, s = A p, z = A s
+   are carried by recurrence, so that the two inner products of an
+   iteration, (r,r) and (r,w), can be computed as one fused reduction
+   whose global sum overlaps the application of the operator q = A w.
+
+   The additional recurrences amplify rounding errors, so at each
+   reliable update we replace r with the true residual and recompute
+   w, s and z from their definitions (residual replacement, Cools et
+   al, SIAM J. Sci. Comput. 40, A2541 (2018)).
+*/
+
+namespace quda {
+
+  PipelinedCG::PipelinedCG(const DiracMatrix &mat, const DiracMatrix &matSloppy, const DiracMatrix &matPrecon,
+                           SolverParam &param, TimeProfile &profile) :
+    Solver(mat, matSloppy, matPrecon, matPrecon, param, profile), init(false)
+  {
+  }
+
+  PipelinedCG::~PipelinedCG()
+  {
+    if (init) {
+      delete rp;
+      delete yp;
+      delete tmpp;
+      delete wSp;
+      delete pSp;
+      delete sSp;
+      delete zSp;
+      delete qSp;
+      if (param.precision != param.precision_sloppy) {
+        delete rSp;
+        delete xSp;
+        delete tmpSp;
+      }
+      if (!mat.isStaggered()) delete tmp2Sp;
+
+      init = false;
+    }
+  }
+
+  void PipelinedCG::operator()(ColorSpinorField &x, ColorSpinorField &b)
+  {
+    if (checkLocation(x, b) != QUDA_CUDA_FIELD_LOCATION)
+      errorQuda("Not supported");
+    if (x.Precision() != param.precision || b.Precision() != param.precision)
+      errorQuda("Precision mismatch");
+
+    profile.TPSTART(QUDA_PROFILE_INIT);
+
+    // Check to see that we're not trying to invert on a zero-field source
+    double b2 = blas::norm2(b);
+    if (b2 == 0 &&
+        (param.compute_null_vector == QUDA_COMPUTE_NULL_VECTOR_NO || param.use_init_guess == QUDA_USE_INIT_GUESS_NO)) {
+      profile.TPSTOP(QUDA_PROFILE_INIT);
+      printfQuda("Warning: inverting on zero-field source\n");
+      x = b;
+      param.true_res = 0.0;
+      param.true_res_hq = 0.0;
+      return;
+    }
+
+    const bool mixed_precision = (param.precision != param.precision_sloppy);
+    ColorSpinorParam csParam(x);
+    if (!init) {
+      csParam.create = QUDA_ZERO_FIELD_CREATE;
+      rp = ColorSpinorField::Create(csParam);
+      tmpp = ColorSpinorField::Create(csParam);
+      yp = ColorSpinorField::Create(csParam);
+
+      // Sloppy fields
+      csParam.setPrecision(param.precision_sloppy);
+      wSp = ColorSpinorField::Create(csParam);
+      pSp = ColorSpinorField::Create(csParam);
+      sSp = ColorSpinorField::Create(csParam);
+      zSp = ColorSpinorField::Create(csParam);
+      qSp = ColorSpinorField::Create(csParam);
+      if (mixed_precision) {
+        rSp = ColorSpinorField::Create(csParam);
+        xSp = ColorSpinorField::Create(csParam);
+        tmpSp = ColorSpinorField::Create(csParam);
+      } else {
+        tmpSp = tmpp;
+      }
+      if (!mat.isStaggered()) {
+        tmp2Sp = ColorSpinorField::Create(csParam);
+      } else {
+        tmp2Sp = tmpSp;
+      }
+
+      init = true;
+    }
+
+    ColorSpinorField &r = *rp;
+    ColorSpinorField &y = *yp;
+    ColorSpinorField &rS = mixed_precision ? *rSp : r;
+    ColorSpinorField &xS = mixed_precision ? *xSp : x;
+    ColorSpinorField &wS = *wSp;
+    ColorSpinorField &pS = *pSp;
+    ColorSpinorField &sS = *sSp;
+    ColorSpinorField &zS = *zSp;
+    ColorSpinorField &qS = *qSp;
+    ColorSpinorField &tmp = *tmpp;
+    ColorSpinorField &tmpS = *tmpSp;
+    ColorSpinorField &tmp2S = *tmp2Sp;
+
+    double stop = stopping(param.tol, b2, param.residual_type); // stopping condition of solver
+
+    const bool use_heavy_quark_res =
+      (param.residual_type & QUDA_HEAVY_QUARK_RESIDUAL) ? true : false;
+
+    // this parameter determines how many consecutive reliable update
+    // residual increases we tolerate before terminating the solver,
+    // i.e., how long do we want to keep trying to converge
+    const int maxResIncrease = param.max_res_increase; // check if we reached the limit of our tolerance
+    const int maxResIncreaseTotal = param.max_res_increase_total;
+    int resIncrease = 0;
+    int resIncreaseTotal = 0;
+
+    // these are only used if we use the heavy_quark_res
+    const int hqmaxresIncrease = maxResIncrease + 1;
+    int heavy_quark_check = param.heavy_quark_check; // how often to check the heavy quark residual
+    double heavy_quark_res = 0.0; // heavy quark residual
+    double heavy_quark_res_old = 0.0;  // heavy quark residual
+    int hqresIncrease = 0;
+    bool L2breakdown = false;
+
+    profile.TPSTOP(QUDA_PROFILE_INIT);
+    profile.TPSTART(QUDA_PROFILE_PREAMBLE);
+
+    blas::flops = 0;
+
+    // compute initial residual depending on whether we have an initial guess or not
+    double r2;
+    if (param.use_init_guess == QUDA_USE_INIT_GUESS_YES) {
+      mat(r, x, y, tmp);
+      r2 = blas::xmyNorm(b, r);
+      if (b2 == 0) b2 = r2;
+      if (mixed_precision) {
+        blas::copy(y, x);
+        blas::zero(xS);
+      }
+    } else {
+      blas::copy(r, b);
+      r2 = b2;
+      blas::zero(x);
+      if (mixed_precision) {
+        blas::zero(y);
+        blas::zero(xS);
+      }
+    }
+    blas::copy(rS, r);
+
+    if (use_heavy_quark_res) {
+      heavy_quark_res = sqrt(blas::HeavyQuarkResidualNorm(x, r).z);
+      heavy_quark_res_old = heavy_quark_res;
+    }
+
+    profile.TPSTOP(QUDA_PROFILE_PREAMBLE);
+    if (convergence(r2, heavy_quark_res, stop, param.tol_hq)) {
+      if (param.preserve_source == QUDA_PRESERVE_SOURCE_NO) {
+        blas::copy(b, r);
+      }
+      return;
+    }
+    profile.TPSTART(QUDA_PROFILE_COMPUTE);
+
+    double rNorm = sqrt(r2);
+    double r0Norm = rNorm;
+    double maxrx = rNorm;
+    double maxrr = rNorm;
+    double delta = param.delta;
+
+    matSloppy(wS, rS, tmpS, tmp2S);
+
+    double gamma = r2, gamma_old = r2;
+    double alpha = 0.0, alpha_old = 0.0, beta = 0.0;
+    bool restart = true; // the first iteration starts the direction recurrences
+
+    int k = 0;
+    PrintStats("PipelinedCG", k, r2, b2, heavy_quark_res);
+
+    while (true) {
+
+      // start the global sum of gamma = (r,r) and (r,w) = (r,Ar), and
+      // apply the operator q = A w while it is in flight
+      blas::AsyncReduction<double3> reduction([&]() { return blas::cDotProductNormA(rS, wS); });
+      matSloppy(qS, wS, tmpS, tmp2S);
+      double3 rr = reduction.wait();
+      gamma = rr.z;
+      double rAr = rr.x;
+
+      if (k > 0) {
+        r2 = gamma;
+
+        if (use_heavy_quark_res && k % heavy_quark_check == 0) {
+          heavy_quark_res_old = heavy_quark_res;
+          if (mixed_precision) {
+            blas::copy(tmpS, y);
+            heavy_quark_res = sqrt(blas::xpyHeavyQuarkResidualNorm(xS, tmpS, rS).z);
+          } else {
+            heavy_quark_res = sqrt(blas::HeavyQuarkResidualNorm(xS, rS).z);
+          }
+        }
+
+        // reliable update conditions
+        rNorm = sqrt(r2);
+        if (rNorm > maxrx) maxrx = rNorm;
+        if (rNorm > maxrr) maxrr = rNorm;
+        bool update = (rNorm < delta * r0Norm && r0Norm <= maxrx);        // condition for x
+        update = (update || (rNorm < delta * maxrr && r0Norm <= maxrr)); // condition for r
+
+        // force a reliable update if we are within target tolerance (only if doing reliable updates when mixed)
+        if (convergence(r2, heavy_quark_res, stop, param.tol_hq) && (!mixed_precision || param.delta >= param.tol))
+          update = true;
+
+        // For heavy-quark inversion force a reliable update if we continue after
+        if (use_heavy_quark_res and L2breakdown and convergenceHQ(r2, heavy_quark_res, stop, param.tol_hq)
+            and param.delta >= param.tol) {
+          update = true;
+        }
+
+        if (update) {
+          // compute the true residual from the accumulated solution
+          if (mixed_precision) {
+            blas::copy(x, xS);
+            blas::xpy(x, y);
+            mat(r, y, x, tmp); //  here we can use x as tmp
+          } else {
+            mat(r, x, y, tmp);
+          }
+          r2 = blas::xmyNorm(b, r);
+          param.true_res = sqrt(r2 / b2);
+          if (use_heavy_quark_res) {
+            heavy_quark_res = sqrt(blas::HeavyQuarkResidualNorm(mixed_precision ? y : x, r).z);
+            param.true_res_hq = heavy_quark_res;
+          }
+
+          // break-out check if we have reached the limit of the precision
+          if (sqrt(r2) > r0Norm) {
+            resIncrease++;
+            resIncreaseTotal++;
+            warningQuda("PipelinedCG: new reliable residual norm %e is greater than previous reliable residual norm %e "
+                        "(total #inc %i)",
+                        sqrt(r2), r0Norm, resIncreaseTotal);
+            if (resIncrease > maxResIncrease or resIncreaseTotal > maxResIncreaseTotal) {
+              if (use_heavy_quark_res) {
+                L2breakdown = true;
+              } else {
+                warningQuda("PipelinedCG: solver exiting due to too many true residual norm increases");
+                break;
+              }
+            }
+          } else {
+            resIncrease = 0;
+          }
+
+          rNorm = sqrt(r2);
+          r0Norm = rNorm;
+          maxrr = rNorm;
+          maxrx = rNorm;
+
+          // residual replacement: restart the auxiliary recurrences from their definitions
+          if (!convergence(r2, heavy_quark_res, stop, param.tol_hq)) {
+            if (mixed_precision) {
+              blas::copy(rS, r);
+              blas::zero(xS);
+            }
+            matSloppy(wS, rS, tmpS, tmp2S);
+            if (!restart) {
+              matSloppy(sS, pS, tmpS, tmp2S);
+              matSloppy(zS, sS, tmpS, tmp2S);
+            }
+            matSloppy(qS, wS, tmpS, tmp2S);
+            rr = blas::cDotProductNormA(rS, wS);
+            gamma = rr.z;
+            rAr = rr.x;
+          }
+        }
+
+        // if L2 broke down we turn off reliable updates and restart the CG
+        if (use_heavy_quark_res and L2breakdown) {
+          delta = 0;
+          heavy_quark_check = 1;
+          warningQuda("PipelinedCG: Restarting without reliable updates for heavy-quark residual");
+          restart = true;
+          L2breakdown = false;
+          if (heavy_quark_res > heavy_quark_res_old) {
+            hqresIncrease++;
+            warningQuda("PipelinedCG: new reliable HQ residual norm %e is greater than previous reliable residual norm %e",
+                        heavy_quark_res, heavy_quark_res_old);
+            // break out if we do not improve here anymore
+            if (hqresIncrease > hqmaxresIncrease) {
+              warningQuda("PipelinedCG: solver exiting due to too many heavy quark residual norm increases");
+              break;
+            }
+          }
+        }
+
+        PrintStats("PipelinedCG", k, r2, b2, heavy_quark_res);
+      }
+
+      // the residual norm of the last iteration is only known here,
+      // so the final operator application is unused
+      if (convergence(r2, heavy_quark_res, stop, param.tol_hq) || k >= param.maxiter) break;
+
+      if (!restart) {
+        beta = gamma / gamma_old;
+        double pAp = rAr - beta * gamma / alpha_old; // (p,Ap) from the recurrences
+        // rounding can cost the recurrences the positivity of (p,Ap), in which case we restart
+        if (pAp > 0.0) {
+          alpha = gamma / pAp;
+        } else {
+          if (getVerbosity() >= QUDA_VERBOSE) printfQuda("PipelinedCG: (p,Ap) = %e, restarting\n", pAp);
+          restart = true;
+        }
+      }
+
+      if (restart) {
+        beta = 0.0;
+        alpha = gamma / rAr;
+        blas::copy(zS, qS);
+        blas::copy(sS, wS);
+        blas::copy(pS, rS);
+        restart = false;
+      } else {
+        blas::xpay(qS, beta, zS); // z = q + beta * z
+        blas::xpay(wS, beta, sS); // s = w + beta * s
+        blas::xpay(rS, beta, pS); // p = r + beta * p
+      }
+
+      blas::axpy(alpha, pS, xS);  // x += alpha * p
+      blas::axpy(-alpha, sS, rS); // r -= alpha * s
+      blas::axpy(-alpha, zS, wS); // w -= alpha * z
+
+      gamma_old = gamma;
+      alpha_old = alpha;
+      k++;
+    }
+
+    if (mixed_precision) blas::copy(x, y);
+    profile.TPSTOP(QUDA_PROFILE_COMPUTE);
+    profile.TPSTART(QUDA_PROFILE_EPILOGUE);
+
+    param.secs = profile.Last(QUDA_PROFILE_COMPUTE);
+    double gflops = (blas::flops + mat.flops() + matSloppy.flops())*1e-9;
+    param.gflops = gflops;
+    param.iter += k;
+
+    if (k == param.maxiter)
+      warningQuda("Exceeded maximum iterations %d", param.maxiter);
+
+    // compute the true residuals
+    if (!mixed_precision && param.compute_true_res) {
+      mat(r, x, y, tmp);
+      param.true_res = sqrt(blas::xmyNorm(b, r) / b2);
+      if (use_heavy_quark_res) param.true_res_hq = sqrt(blas::HeavyQuarkResidualNorm(x, r).z);
+    }
+
+    if (param.preserve_source == QUDA_PRESERVE_SOURCE_NO) {
+      blas::copy(b, r);
+    }
+
+    PrintSummary("PipelinedCG", k, r2, b2, stop, param.tol_hq);
+
+    // reset the flops counters
+    blas::flops = 0;
+    mat.flops();
+    matSloppy.flops();
+
+    profile.TPSTOP(QUDA_PROFILE_EPILOGUE);
+  }
+
+} // namespace quda
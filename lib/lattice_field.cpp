@@ -36,6 +36,8 @@ namespace quda {
 
   bool LatticeField::ghost_field_reset = false;
 
+  std::atomic<int> LatticeField::comms_generation {0};
+
   void* LatticeField::ghost_remote_send_buffer_d[2][QUDA_MAX_DIM][2];
 
   bool LatticeField::initGhostFaceBuffer = false;
@@ -44,6 +46,9 @@ namespace quda {
 
   int LatticeField::bufferIndex = 0;
 
+  // the ghost buffers and IPC handles are tied to the communicator they were created with
+  static const bool ghost_buffer_push_callback = (comm_register_push_callback(LatticeField::freeGhostBuffer), true);
+
   LatticeFieldParam::LatticeFieldParam(const LatticeField &field)
     : precision(field.Precision()), ghost_precision(field.Precision()),
       nDim(field.Ndim()), pad(field.Pad()),
@@ -277,6 +282,7 @@ namespace quda {
   void LatticeField::freeGhostBuffer(void)
   {
     destroyIPCComms();
+    comms_generation++;
 
     if (!initGhostFaceBuffer) return;
 
@@ -2,7 +2,9 @@
 #include <invert_quda.h>
 #include <multigrid.h>
 #include <eigensolve_quda.h>
+#include <timeline.h>
 #include <cmath>
+#include <cstring>
 
 namespace quda {
 
@@ -22,7 +24,8 @@ namespace quda {
     eig_solve(nullptr),
     deflate_init(false),
     deflate_compute(true),
-    recompute_evals(!param.eig_param.preserve_evals)
+    recompute_evals(!param.eig_param.preserve_evals),
+    timeline_name(nullptr)
   {
     // compute parity of the node
     for (int i=0; i<4; i++) node_parity += commCoords(i);
@@ -156,6 +159,10 @@ namespace quda {
       report("CG3NR");
       solver = new CG3NR(mat, matSloppy, matPrecon, param, profile);
       break;
+    case QUDA_PIPELINED_CG_INVERTER:
+      report("PIPELINED-CG");
+      solver = new PipelinedCG(mat, matSloppy, matPrecon, param, profile);
+      break;
     default:
       errorQuda("Invalid solver type %d", param.inv_type);
     }
@@ -369,6 +376,12 @@ namespace quda {
   }
 
   void Solver::PrintStats(const char* name, int k, double r2, double b2, double hq2) {
+    if (timeline::enabled()) {
+      // the name is fixed for the duration of a solve, so it is only interned when it changes
+      if (!timeline_name || strcmp(timeline_name, name)) timeline_name = timeline::intern(name);
+      timeline::instant(timeline_name, "solver", "iteration", k);
+    }
+
     if (getVerbosity() >= QUDA_VERBOSE) {
       if (param.residual_type & QUDA_HEAVY_QUARK_RESIDUAL) {
         printfQuda("%s: %5d iterations, <r,r> = %9.6e, |r|/|b| = %9.6e, heavy-quark residual = %9.6e\n", name, k, r2,
@@ -1,3 +1,5 @@
+#include <memory>
+
 #include <tune_quda.h>
 #include <transfer.h>
 #include <color_spinor_field.h>
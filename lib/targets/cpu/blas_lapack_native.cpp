@@ -0,0 +1,33 @@
+#include <blas_lapack.h>
+
+namespace quda
+{
+
+  namespace blas_lapack
+  {
+
+    /**
+       On the CPU target the host is the native device, so the native
+       blas/lapack operations are simply the Eigen-based generic ones.
+     */
+    namespace native
+    {
+
+      void init() { }
+
+      void destroy() { }
+
+      long long BatchInvertMatrix(void *Ainv, void *A, const int n, const uint64_t batch, QudaPrecision prec,
+                                  QudaFieldLocation location)
+      {
+        return generic::BatchInvertMatrix(Ainv, A, n, batch, prec, location);
+      }
+
+      long long stridedBatchGEMM(void *A, void *B, void *C, QudaBLASParam blas_param, QudaFieldLocation location)
+      {
+        return generic::stridedBatchGEMM(A, B, C, blas_param, location);
+      }
+
+    } // namespace native
+  }   // namespace blas_lapack
+} // namespace quda
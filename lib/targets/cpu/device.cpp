@@ -0,0 +1,151 @@
+#include <unistd.h> // for sysconf()
+#include <limits>
+#include <fstream>
+#include <util_quda.h>
+#include <quda_internal.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+cudaDeviceProp deviceProp;
+qudaStream_t *streams;
+
+namespace quda
+{
+
+  namespace device
+  {
+
+    static bool initialized = false;
+
+    /**
+       @brief Return the host processor model name as reported by
+       /proc/cpuinfo, falling back to a generic name if unavailable.
+     */
+    static std::string host_name()
+    {
+      std::ifstream cpuinfo("/proc/cpuinfo");
+      std::string line;
+      while (cpuinfo && std::getline(cpuinfo, line)) {
+        if (line.compare(0, 10, "model name") == 0) {
+          auto pos = line.find(':');
+          if (pos != std::string::npos && pos + 2 < line.size()) return line.substr(pos + 2);
+        }
+      }
+      return "Host CPU";
+    }
+
+    /**
+       @brief Number of threads in the host thread pool.  This is set
+       from QUDA_ENABLE_CPU_THREADS if set, else defaults to the
+       OpenMP runtime setting (e.g., OMP_NUM_THREADS).
+     */
+    static int host_threads()
+    {
+      int threads = 1;
+#ifdef _OPENMP
+      threads = omp_get_max_threads();
+      char *threads_env = getenv("QUDA_ENABLE_CPU_THREADS");
+      if (threads_env) {
+        int n = atoi(threads_env);
+        if (n > 0) {
+          omp_set_num_threads(n);
+          threads = n;
+        } else {
+          warningQuda("Ignoring invalid QUDA_ENABLE_CPU_THREADS=%s", threads_env);
+        }
+      }
+#endif
+      return threads;
+    }
+
+    void init(int dev)
+    {
+      if (initialized) return;
+      initialized = true;
+      printfQuda("*** CPU BACKEND ***\n");
+
+      if (dev != 0) warningQuda("CPU target only supports a single device, ignoring device ordinal %d", dev);
+
+      // synthesize a device description of the host so that the
+      // launch-parameter logic in the autotuner remains valid
+      memset(&deviceProp, 0, sizeof(deviceProp));
+      snprintf(deviceProp.name, sizeof(deviceProp.name), "%s", host_name().c_str());
+      deviceProp.major = __COMPUTE_CAPABILITY__ / 100;
+      deviceProp.minor = (__COMPUTE_CAPABILITY__ - deviceProp.major * 100) / 10;
+      deviceProp.totalGlobalMem = static_cast<size_t>(sysconf(_SC_PHYS_PAGES)) * sysconf(_SC_PAGESIZE);
+      deviceProp.sharedMemPerBlock = 48 * 1024;
+      deviceProp.sharedMemPerMultiprocessor = 96 * 1024;
+      deviceProp.regsPerBlock = 65536;
+      deviceProp.warpSize = 32;
+      deviceProp.memPitch = std::numeric_limits<int>::max();
+      deviceProp.maxThreadsPerBlock = 1024;
+      deviceProp.maxThreadsPerMultiProcessor = 2048;
+      deviceProp.maxThreadsDim[0] = 1024;
+      deviceProp.maxThreadsDim[1] = 1024;
+      deviceProp.maxThreadsDim[2] = 64;
+      deviceProp.maxGridSize[0] = std::numeric_limits<int>::max();
+      deviceProp.maxGridSize[1] = 65535;
+      deviceProp.maxGridSize[2] = 65535;
+      deviceProp.multiProcessorCount = host_threads();
+      deviceProp.canMapHostMemory = 1;
+      deviceProp.unifiedAddressing = 1;
+      deviceProp.managedMemory = 1;
+      deviceProp.concurrentKernels = 0;
+      deviceProp.l2CacheSize = sysconf(_SC_LEVEL2_CACHE_SIZE) > 0 ? sysconf(_SC_LEVEL2_CACHE_SIZE) : 0;
+
+      if (getVerbosity() >= QUDA_SUMMARIZE) {
+        printfQuda("Using host %s with %d threads\n", deviceProp.name, deviceProp.multiProcessorCount);
+      }
+    }
+
+    void print_device_properties()
+    {
+      const int device = 0;
+      printfQuda("%d - name:                    %s\n", device, deviceProp.name);
+      printfQuda("%d - totalGlobalMem:          %lu bytes ( %.2f Gbytes)\n", device, deviceProp.totalGlobalMem,
+                 deviceProp.totalGlobalMem / (float)(1024 * 1024 * 1024));
+      printfQuda("%d - sharedMemPerBlock:       %lu bytes ( %.2f Kbytes)\n", device, deviceProp.sharedMemPerBlock,
+                 deviceProp.sharedMemPerBlock / (float)1024);
+      printfQuda("%d - warpSize:                %d\n", device, deviceProp.warpSize);
+      printfQuda("%d - maxThreadsPerBlock:      %d\n", device, deviceProp.maxThreadsPerBlock);
+      printfQuda("%d - maxThreadsDim[0]:        %d\n", device, deviceProp.maxThreadsDim[0]);
+      printfQuda("%d - maxThreadsDim[1]:        %d\n", device, deviceProp.maxThreadsDim[1]);
+      printfQuda("%d - maxThreadsDim[2]:        %d\n", device, deviceProp.maxThreadsDim[2]);
+      printfQuda("%d - maxGridSize[0]:          %d\n", device, deviceProp.maxGridSize[0]);
+      printfQuda("%d - maxGridSize[1]:          %d\n", device, deviceProp.maxGridSize[1]);
+      printfQuda("%d - maxGridSize[2]:          %d\n", device, deviceProp.maxGridSize[2]);
+      printfQuda("%d - host threads             %d\n", device, deviceProp.multiProcessorCount);
+      printfQuda("%d - l2CacheSize              %d bytes\n\n", device, deviceProp.l2CacheSize);
+    }
+
+    void create_context()
+    {
+      // all work is issued synchronously on the host thread pool so
+      // streams are only placeholders
+      streams = new qudaStream_t[Nstream];
+      for (int i = 0; i < Nstream; i++) streams[i] = nullptr;
+    }
+
+    void destroy()
+    {
+      if (streams) {
+        delete[] streams;
+        streams = nullptr;
+      }
+    }
+
+    size_t max_dynamic_shared_memory() { return deviceProp.sharedMemPerBlock; }
+
+    namespace profile
+    {
+
+      void start() { }
+
+      void stop() { }
+
+    } // namespace profile
+
+  } // namespace device
+} // namespace quda
@@ -0,0 +1,502 @@
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <map>
+#include <unistd.h>   // for getpagesize()
+#include <execinfo.h> // for backtrace
+#include <quda_internal.h>
+
+#ifdef QUDA_BACKWARDSCPP
+#include "backward.hpp"
+#endif
+#include <alloc_tracker.h>
+
+namespace quda
+{
+
+  // never destroyed, since the communicators free their buffers from
+  // static destructors when the process exits without comm_finalize()
+  static AllocTracker &alloc = *new AllocTracker;
+
+  long device_allocated_peak() { return alloc.peak(DEVICE); }
+
+  long pinned_allocated_peak() { return alloc.peak(PINNED); }
+
+  long mapped_allocated_peak() { return alloc.peak(MAPPED); }
+
+  long managed_allocated_peak() { return alloc.peak(MANAGED); }
+
+  long host_allocated_peak() { return alloc.peak(HOST); }
+
+  static void print_trace(void)
+  {
+    void *array[10];
+    size_t size;
+    char **strings;
+    size = backtrace(array, 10);
+    strings = backtrace_symbols(array, size);
+    printfQuda("Obtained %zd stack frames.\n", size);
+    for (size_t i = 0; i < size; i++) printfQuda("%s\n", strings[i]);
+    free(strings);
+  }
+
+  static void print_alloc_header()
+  {
+    printfQuda("Type    Pointer          Size             Location\n");
+    printfQuda("----------------------------------------------------------\n");
+  }
+
+  static void print_alloc(AllocType type)
+  {
+    const char *type_str[] = {"Device", "Device Pinned", "Host  ", "Pinned", "Mapped", "Managed"};
+
+    for (auto &entry : alloc.entries(type)) {
+      void *ptr = entry.first;
+      const MemAlloc &a = entry.second;
+      printfQuda("%s  %15p  %15lu  %s(), %s:%d\n", type_str[type], ptr, (unsigned long)a.base_size, a.func, a.file,
+                 a.line);
+#ifdef QUDA_BACKWARDSCPP
+      if (getRankVerbosity()) {
+        backward::Printer p;
+        p.print(a.st);
+      }
+#endif
+    }
+  }
+
+  static void track_malloc(const AllocType &type, const MemAlloc &a, void *ptr) { alloc.insert(type, ptr, a); }
+
+  static bool track_free(const AllocType &type, void *ptr, MemAlloc *a = nullptr) { return alloc.erase(type, ptr, a); }
+
+  /**
+   * On the CPU target all "device", pinned and mapped allocations are
+   * plain host memory.  We align these to page boundaries so that
+   * each thread in the pool touches whole pages, and so that the
+   * allocations are suitable for vectorized access.
+   */
+  static void *aligned_malloc(MemAlloc &a, size_t size)
+  {
+    void *ptr = nullptr;
+
+    a.size = size;
+
+    static int page_size = 2 * getpagesize();
+    a.base_size = ((size + page_size - 1) / page_size) * page_size; // round up to the nearest multiple of page_size
+    int align = posix_memalign(&ptr, page_size, a.base_size);
+    if (!ptr || align != 0) {
+      errorQuda("Failed to allocate aligned host memory of size %zu (%s:%d in %s())\n", size, a.file, a.line, a.func);
+    }
+    return ptr;
+  }
+
+  bool use_managed_memory()
+  {
+    static bool managed = false;
+    static bool init = false;
+
+    if (!init) {
+      char *enable_managed_memory = getenv("QUDA_ENABLE_MANAGED_MEMORY");
+      if (enable_managed_memory && strcmp(enable_managed_memory, "1") == 0) {
+        warningQuda("Using managed memory for CPU allocations");
+        managed = true;
+      }
+
+      init = true;
+    }
+
+    return managed;
+  }
+
+  bool is_prefetch_enabled()
+  {
+    static bool prefetch = false;
+    static bool init = false;
+
+    if (!init) {
+      if (use_managed_memory()) {
+        char *enable_managed_prefetch = getenv("QUDA_ENABLE_MANAGED_PREFETCH");
+        if (enable_managed_prefetch && strcmp(enable_managed_prefetch, "1") == 0) {
+          warningQuda("Enabling prefetch support for managed memory");
+          prefetch = true;
+        }
+      }
+
+      init = true;
+    }
+
+    return prefetch;
+  }
+
+  /**
+   * Allocate "device" memory, which on the CPU target is aligned host
+   * memory.  This function should only be called via the
+   * device_malloc() macro, defined in malloc_quda.h
+   */
+  void *device_malloc_(const char *func, const char *file, int line, size_t size)
+  {
+    if (use_managed_memory()) return managed_malloc_(func, file, line, size);
+
+    MemAlloc a(func, file, line);
+    void *ptr = aligned_malloc(a, size);
+    track_malloc(DEVICE, a, ptr);
+#ifdef HOST_DEBUG
+    memset(ptr, 0xff, a.base_size);
+#endif
+    return ptr;
+  }
+
+  /**
+   * On the CPU target there is no peer-to-peer communication so this
+   * is equivalent to device_malloc_().  This should only be called
+   * via the device_pinned_malloc() macro, defined in malloc_quda.h.
+   */
+  void *device_pinned_malloc_(const char *func, const char *file, int line, size_t size)
+  {
+    return device_malloc_(func, file, line, size);
+  }
+
+  /**
+   * Perform a standard malloc() with error-checking.  This function
+   * should only be called via the safe_malloc() macro, defined in
+   * malloc_quda.h
+   */
+  void *safe_malloc_(const char *func, const char *file, int line, size_t size)
+  {
+    MemAlloc a(func, file, line);
+    a.size = size;
+
+    void *ptr = pool::host_acquire(size, a.base_size);
+    if (!ptr) { errorQuda("Failed to allocate host memory of size %zu (%s:%d in %s())\n", size, file, line, func); }
+    track_malloc(HOST, a, ptr);
+#ifdef HOST_DEBUG
+    memset(ptr, 0xff, size);
+#endif
+    return ptr;
+  }
+
+  /**
+   * Allocate page-locked ("pinned") host memory.  On the CPU target
+   * there is no device to register the memory with so this is an
+   * aligned host allocation.  This function should only be called
+   * via the pinned_malloc() macro, defined in malloc_quda.h
+   */
+  void *pinned_malloc_(const char *func, const char *file, int line, size_t size)
+  {
+    MemAlloc a(func, file, line);
+    void *ptr = aligned_malloc(a, size);
+    track_malloc(PINNED, a, ptr);
+#ifdef HOST_DEBUG
+    memset(ptr, 0xff, a.base_size);
+#endif
+    return ptr;
+  }
+
+  /**
+   * Allocate host memory that is "mapped" into the device address
+   * space.  On the CPU target the host and device address spaces are
+   * one and the same.  This function should only be called via the
+   * mapped_malloc() macro, defined in malloc_quda.h
+   */
+  void *mapped_malloc_(const char *func, const char *file, int line, size_t size)
+  {
+    MemAlloc a(func, file, line);
+    void *ptr = aligned_malloc(a, size);
+    track_malloc(MAPPED, a, ptr);
+#ifdef HOST_DEBUG
+    memset(ptr, 0xff, a.base_size);
+#endif
+    return ptr;
+  }
+
+  /**
+   * Allocate managed memory, which on the CPU target is aligned host
+   * memory.  This function should only be called via the
+   * managed_malloc() macro, defined in malloc_quda.h
+   */
+  void *managed_malloc_(const char *func, const char *file, int line, size_t size)
+  {
+    MemAlloc a(func, file, line);
+    void *ptr = aligned_malloc(a, size);
+    track_malloc(MANAGED, a, ptr);
+#ifdef HOST_DEBUG
+    memset(ptr, 0xff, a.base_size);
+#endif
+    return ptr;
+  }
+
+  /**
+   * Free device memory allocated with device_malloc().  This function
+   * should only be called via the device_free() macro, defined in
+   * malloc_quda.h
+   */
+  void device_free_(const char *func, const char *file, int line, void *ptr)
+  {
+    if (use_managed_memory()) {
+      managed_free_(func, file, line, ptr);
+      return;
+    }
+
+    if (!ptr) { errorQuda("Attempt to free NULL device pointer (%s:%d in %s())\n", file, line, func); }
+    if (!track_free(DEVICE, ptr)) {
+      errorQuda("Attempt to free invalid device pointer (%s:%d in %s())\n", file, line, func);
+    }
+    free(ptr);
+  }
+
+  /**
+   * Free device memory allocated with device_pinned malloc().  This
+   * function should only be called via the device_pinned_free()
+   * macro, defined in malloc_quda.h
+   */
+  void device_pinned_free_(const char *func, const char *file, int line, void *ptr)
+  {
+    device_free_(func, file, line, ptr);
+  }
+
+  /**
+   * Free managed memory allocated with managed_malloc().  This
+   * function should only be called via the managed_free() macro,
+   * defined in malloc_quda.h
+   */
+  void managed_free_(const char *func, const char *file, int line, void *ptr)
+  {
+    if (!ptr) { errorQuda("Attempt to free NULL managed pointer (%s:%d in %s())\n", file, line, func); }
+    if (!track_free(MANAGED, ptr)) {
+      errorQuda("Attempt to free invalid managed pointer (%s:%d in %s())\n", file, line, func);
+    }
+    free(ptr);
+  }
+
+  /**
+   * Free host memory allocated with safe_malloc(), pinned_malloc(),
+   * or mapped_malloc().  This function should only be called via the
+   * host_free() macro, defined in malloc_quda.h
+   */
+  void host_free_(const char *func, const char *file, int line, void *ptr)
+  {
+    if (!ptr) { errorQuda("Attempt to free NULL host pointer (%s:%d in %s())\n", file, line, func); }
+    MemAlloc a;
+    if (track_free(HOST, ptr, &a)) {
+      pool::host_release(ptr, a.size, a.base_size);
+    } else if (track_free(PINNED, ptr)) {
+      free(ptr);
+    } else if (track_free(MAPPED, ptr)) {
+      free(ptr);
+    } else {
+      printfQuda("ERROR: Attempt to free invalid host pointer (%s:%d in %s())\n", file, line, func);
+      print_trace();
+      errorQuda("Aborting");
+    }
+  }
+
+  void printPeakMemUsage()
+  {
+    printfQuda("Device memory used = %.1f MB\n", alloc.peak(DEVICE) / (double)(1 << 20));
+    printfQuda("Pinned device memory used = %.1f MB\n", alloc.peak(DEVICE_PINNED) / (double)(1 << 20));
+    printfQuda("Managed memory used = %.1f MB\n", alloc.peak(MANAGED) / (double)(1 << 20));
+    printfQuda("Page-locked host memory used = %.1f MB\n", alloc.peak_pinned() / (double)(1 << 20));
+    printfQuda("Total host memory used >= %.1f MB\n", alloc.peak_host() / (double)(1 << 20));
+    if (pool::host_memory_pool()) pool::print_host_stats();
+  }
+
+  void assertAllMemFree()
+  {
+    if (!alloc.empty(DEVICE) || !alloc.empty(DEVICE_PINNED) || !alloc.empty(HOST) || !alloc.empty(PINNED)
+        || !alloc.empty(MAPPED)) {
+      warningQuda("The following internal memory allocations were not freed.");
+      printfQuda("\n");
+      print_alloc_header();
+      print_alloc(DEVICE);
+      print_alloc(DEVICE_PINNED);
+      print_alloc(HOST);
+      print_alloc(PINNED);
+      print_alloc(MAPPED);
+      printfQuda("\n");
+    }
+  }
+
+  QudaFieldLocation get_pointer_location(const void *ptr)
+  {
+    // every allocation is a host allocation, but we report those made
+    // through the device allocators as device memory so that callers
+    // that dispatch on location see a consistent view
+    AllocType type = alloc.find(ptr);
+    if (type == DEVICE || type == DEVICE_PINNED || type == MANAGED) return QUDA_CUDA_FIELD_LOCATION;
+    return QUDA_CPU_FIELD_LOCATION;
+  }
+
+  void *get_mapped_device_pointer_(const char *func, const char *file, int line, const void *host)
+  {
+    if (alloc.find(host) != MAPPED)
+      errorQuda("Attempt to get device pointer of non-mapped allocation %p (%s:%d in %s())", host, file, line, func);
+    return const_cast<void *>(host);
+  }
+
+
+  namespace pool
+  {
+
+    /** Cache of inactive pinned-memory allocations.  We cache pinned
+        memory allocations so that fields can reuse these with minimal
+        overhead.*/
+    static std::multimap<size_t, void *> pinnedCache;
+
+    /** Sizes of active pinned-memory allocations.  For convenience,
+        we keep track of the sizes of active allocations (i.e., those not
+        in the cache). */
+    static std::map<void *, size_t> pinnedSize;
+
+    /** Cache of inactive device-memory allocations.  We cache pinned
+        memory allocations so that fields can reuse these with minimal
+        overhead.*/
+    static std::multimap<size_t, void *> deviceCache;
+
+    /** Sizes of active device-memory allocations.  For convenience,
+        we keep track of the sizes of active allocations (i.e., those not
+        in the cache). */
+    static std::map<void *, size_t> deviceSize;
+
+    static bool pool_init = false;
+
+    /** whether to use a memory pool allocator for device memory */
+    static bool device_memory_pool = true;
+
+    /** whether to use a memory pool allocator for pinned memory */
+    static bool pinned_memory_pool = true;
+
+    void init()
+    {
+      if (!pool_init) {
+        // device memory pool
+        char *enable_device_pool = getenv("QUDA_ENABLE_DEVICE_MEMORY_POOL");
+        if (!enable_device_pool || strcmp(enable_device_pool, "0") != 0) {
+          warningQuda("Using device memory pool allocator");
+          device_memory_pool = true;
+        } else {
+          warningQuda("Not using device memory pool allocator");
+          device_memory_pool = false;
+        }
+
+        // pinned memory pool
+        char *enable_pinned_pool = getenv("QUDA_ENABLE_PINNED_MEMORY_POOL");
+        if (!enable_pinned_pool || strcmp(enable_pinned_pool, "0") != 0) {
+          warningQuda("Using pinned memory pool allocator");
+          pinned_memory_pool = true;
+        } else {
+          warningQuda("Not using pinned memory pool allocator");
+          pinned_memory_pool = false;
+        }
+
+        // host memory pool, which is set up on first use since safe_malloc() may precede initQuda()
+        if (host_memory_pool()) warningQuda("Using host memory pool allocator");
+        pool_init = true;
+      }
+    }
+
+    void *pinned_malloc_(const char *func, const char *file, int line, size_t nbytes)
+    {
+      void *ptr = nullptr;
+      if (pinned_memory_pool) {
+        std::multimap<size_t, void *>::iterator it;
+
+        if (pinnedCache.empty()) {
+          ptr = quda::pinned_malloc_(func, file, line, nbytes);
+        } else {
+          it = pinnedCache.lower_bound(nbytes);
+          if (it != pinnedCache.end()) { // sufficiently large allocation found
+            nbytes = it->first;
+            ptr = it->second;
+            pinnedCache.erase(it);
+          } else { // sacrifice the smallest cached allocation
+            it = pinnedCache.begin();
+            ptr = it->second;
+            pinnedCache.erase(it);
+            host_free(ptr);
+            ptr = quda::pinned_malloc_(func, file, line, nbytes);
+          }
+        }
+        pinnedSize[ptr] = nbytes;
+      } else {
+        ptr = quda::pinned_malloc_(func, file, line, nbytes);
+      }
+      return ptr;
+    }
+
+    void pinned_free_(const char *func, const char *file, int line, void *ptr)
+    {
+      if (pinned_memory_pool) {
+        if (!pinnedSize.count(ptr)) { errorQuda("Attempt to free invalid pointer"); }
+        pinnedCache.insert(std::make_pair(pinnedSize[ptr], ptr));
+        pinnedSize.erase(ptr);
+      } else {
+        quda::host_free_(func, file, line, ptr);
+      }
+    }
+
+    void *device_malloc_(const char *func, const char *file, int line, size_t nbytes)
+    {
+      void *ptr = nullptr;
+      if (device_memory_pool) {
+        std::multimap<size_t, void *>::iterator it;
+
+        if (deviceCache.empty()) {
+          ptr = quda::device_malloc_(func, file, line, nbytes);
+        } else {
+          it = deviceCache.lower_bound(nbytes);
+          if (it != deviceCache.end()) { // sufficiently large allocation found
+            nbytes = it->first;
+            ptr = it->second;
+            deviceCache.erase(it);
+          } else { // sacrifice the smallest cached allocation
+            it = deviceCache.begin();
+            ptr = it->second;
+            deviceCache.erase(it);
+            quda::device_free_(func, file, line, ptr);
+            ptr = quda::device_malloc_(func, file, line, nbytes);
+          }
+        }
+        deviceSize[ptr] = nbytes;
+      } else {
+        ptr = quda::device_malloc_(func, file, line, nbytes);
+      }
+      return ptr;
+    }
+
+    void device_free_(const char *func, const char *file, int line, void *ptr)
+    {
+      if (device_memory_pool) {
+        if (!deviceSize.count(ptr)) { errorQuda("Attempt to free invalid pointer"); }
+        deviceCache.insert(std::make_pair(deviceSize[ptr], ptr));
+        deviceSize.erase(ptr);
+      } else {
+        quda::device_free_(func, file, line, ptr);
+      }
+    }
+
+    void flush_pinned()
+    {
+      if (pinned_memory_pool) {
+        std::multimap<size_t, void *>::iterator it;
+        for (it = pinnedCache.begin(); it != pinnedCache.end(); it++) {
+          void *ptr = it->second;
+          host_free(ptr);
+        }
+        pinnedCache.clear();
+      }
+    }
+
+    void flush_device()
+    {
+      if (device_memory_pool) {
+        std::multimap<size_t, void *>::iterator it;
+        for (it = deviceCache.begin(); it != deviceCache.end(); it++) {
+          void *ptr = it->second;
+          device_free(ptr);
+        }
+        deviceCache.clear();
+      }
+    }
+
+  } // namespace pool
+
+} // namespace quda
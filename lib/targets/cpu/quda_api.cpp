@@ -0,0 +1,374 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <tune_quda.h>
+#include <uint_to_char.h>
+#include <quda_internal.h>
+#include <device.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// if this macro is defined then we profile the host API calls
+//#define API_PROFILE
+
+#ifdef API_PROFILE
+#define PROFILE(f, idx)                                 \
+  apiTimer.TPSTART(idx);				\
+  f;                                                    \
+  apiTimer.TPSTOP(idx);
+#else
+#define PROFILE(f, idx) f;
+#endif
+
+thread_local uint3 threadIdx;
+thread_local uint3 blockIdx;
+thread_local dim3 blockDim;
+thread_local dim3 gridDim;
+
+namespace quda {
+
+  static TimeProfile apiTimer("CPU API calls");
+
+  /**
+     Below this size we do not bother spinning up the thread pool for
+     memory copies and sets, since the fork/join overhead dominates.
+   */
+  static constexpr size_t parallel_threshold = 1 << 20;
+
+  /**
+     @brief Copy count bytes from src to dst using the host thread
+     pool.  Each thread is assigned a contiguous, page-aligned chunk
+     of the buffer.
+   */
+  static void host_memcpy(void *dst, const void *src, size_t count)
+  {
+#ifdef _OPENMP
+    if (count >= parallel_threshold && omp_get_max_threads() > 1) {
+#pragma omp parallel
+      {
+        const size_t nthreads = omp_get_num_threads();
+        const size_t page = 4096;
+        const size_t chunk = ((count / nthreads + page - 1) / page) * page;
+        const size_t begin = std::min(count, omp_get_thread_num() * chunk);
+        const size_t end = std::min(count, begin + chunk);
+        if (end > begin)
+          memcpy(static_cast<char *>(dst) + begin, static_cast<const char *>(src) + begin, end - begin);
+      }
+      return;
+    }
+#endif
+    memcpy(dst, src, count);
+  }
+
+  /**
+     @brief Set count bytes of ptr to value using the host thread
+     pool.
+   */
+  static void host_memset(void *ptr, int value, size_t count)
+  {
+#ifdef _OPENMP
+    if (count >= parallel_threshold && omp_get_max_threads() > 1) {
+#pragma omp parallel
+      {
+        const size_t nthreads = omp_get_num_threads();
+        const size_t page = 4096;
+        const size_t chunk = ((count / nthreads + page - 1) / page) * page;
+        const size_t begin = std::min(count, omp_get_thread_num() * chunk);
+        const size_t end = std::min(count, begin + chunk);
+        if (end > begin) memset(static_cast<char *>(ptr) + begin, value, end - begin);
+      }
+      return;
+    }
+#endif
+    memset(ptr, value, count);
+  }
+
+  qudaError_t qudaLaunchKernel(const void *, const TuneParam &, void **, qudaStream_t)
+  {
+    // a type-erased kernel symbol cannot be invoked on the host: kernels
+    // must be launched through the templated qudaLaunchKernel
+    errorQuda("(CPU) Untyped kernel launch is not supported by the CPU target");
+    return QUDA_ERROR;
+  }
+
+  /**
+     The threads of a block that synchronizes are run as fibers on the
+     worker that executes the block, each with its own stack.  A thread
+     that reaches __syncthreads() switches back to the scheduler, which
+     runs the next live thread of the block, so the barrier opens once
+     every thread that has not exited has reached it.
+   */
+  class BlockScheduler
+  {
+    static constexpr size_t stack_size = 256 * 1024;
+
+    struct Fiber {
+      ucontext_t context;
+      bool done;
+    };
+
+    ucontext_t scheduler;
+    ucontext_t initial;
+    std::vector<Fiber> fibers;
+    char *stacks = nullptr;
+    size_t n_stacks = 0;
+    size_t stride = 0; // stack size plus a guard page
+    unsigned int current = 0;
+    void (*kernel)(const void *) = nullptr;
+    const void *arg = nullptr;
+
+    static void entry();
+
+    void reserve(unsigned int n)
+    {
+      if (n <= n_stacks) return;
+      if (stacks) munmap(stacks, n_stacks * stride);
+      const size_t page = sysconf(_SC_PAGESIZE);
+      stride = stack_size + page;
+      stacks = static_cast<char *>(
+        mmap(nullptr, n * stride, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0));
+      if (stacks == MAP_FAILED) errorQuda("(CPU) Failed to map the stacks of %u kernel threads", n);
+      // a stack overflow faults on the guard page rather than corrupting the neighbouring stack
+      for (unsigned int i = 0; i < n; i++) mprotect(stacks + i * stride, page, PROT_NONE);
+      n_stacks = n;
+      fibers.resize(n);
+      getcontext(&initial);
+    }
+
+  public:
+    bool active = false;  // whether the current block is run as fibers
+    bool barrier = false; // whether a thread of this worker has reached a barrier
+
+    ~BlockScheduler()
+    {
+      if (stacks) munmap(stacks, n_stacks * stride);
+    }
+
+    void run(const dim3 &block, void (*kernel)(const void *), const void *arg)
+    {
+      const unsigned int n = block.x * block.y * block.z;
+      reserve(n);
+      this->kernel = kernel;
+      this->arg = arg;
+      const size_t page = sysconf(_SC_PAGESIZE);
+      for (unsigned int t = 0; t < n; t++) {
+        auto &f = fibers[t];
+        f.context = initial;
+        f.context.uc_stack.ss_sp = stacks + t * stride + page;
+        f.context.uc_stack.ss_size = stack_size;
+        f.context.uc_link = &scheduler;
+        makecontext(&f.context, entry, 0);
+        f.done = false;
+      }
+
+      // each pass runs every live thread up to its next barrier, or to its exit
+      active = true;
+      for (unsigned int live = n; live > 0;) {
+        live = 0;
+        for (unsigned int t = 0; t < n; t++) {
+          if (fibers[t].done) continue;
+          current = t;
+          threadIdx = make_uint3(t % block.x, (t / block.x) % block.y, t / (block.x * block.y));
+          swapcontext(&scheduler, &fibers[t].context);
+          if (!fibers[t].done) live++;
+        }
+      }
+      active = false;
+    }
+
+    void sync()
+    {
+      barrier = true;
+      swapcontext(&fibers[current].context, &scheduler);
+    }
+  };
+
+  static thread_local BlockScheduler block_scheduler;
+
+  void BlockScheduler::entry()
+  {
+    auto &s = block_scheduler;
+    s.kernel(s.arg);
+    s.fibers[s.current].done = true;
+    // returning resumes the scheduler through uc_link
+  }
+
+  /** the dynamic shared memory of the block being executed by this worker */
+  static thread_local std::vector<char> shared_memory;
+
+  void *host_shared_memory() { return shared_memory.data(); }
+
+  /**
+     Whether each kernel synchronizes its blocks, as learned on its
+     first launch
+   */
+  static std::unordered_map<const void *, bool> &kernel_syncs()
+  {
+    static std::unordered_map<const void *, bool> syncs;
+    return syncs;
+  }
+
+  static std::mutex kernel_syncs_mutex;
+
+  qudaError_t qudaLaunchKernel(const TuneParam &tp, void (*kernel)(const void *), const void *arg, const void *func)
+  {
+    const dim3 grid = tp.grid;
+    const dim3 block = tp.block;
+    const long n_blocks = static_cast<long>(grid.x) * grid.y * grid.z;
+    const size_t shared_bytes = std::max<size_t>(tp.shared_bytes, 1);
+
+    bool known, cooperative;
+    {
+      std::lock_guard<std::mutex> lock(kernel_syncs_mutex);
+      auto it = kernel_syncs().find(func);
+      known = it != kernel_syncs().end();
+      cooperative = known ? it->second : true;
+    }
+    std::atomic<bool> synced(false);
+
+    // blocks are independent so are distributed over the thread pool
+#pragma omp parallel for schedule(dynamic)
+    for (long b = 0; b < n_blocks; b++) {
+      gridDim = grid;
+      blockDim = block;
+      blockIdx = make_uint3(b % grid.x, (b / grid.x) % grid.y, b / (static_cast<long>(grid.x) * grid.y));
+      if (shared_memory.size() < shared_bytes) shared_memory.resize(shared_bytes);
+
+      if (cooperative) {
+        block_scheduler.barrier = false;
+        block_scheduler.run(block, kernel, arg);
+        if (block_scheduler.barrier) synced = true;
+      } else {
+        for (unsigned int z = 0; z < block.z; z++) {
+          for (unsigned int y = 0; y < block.y; y++) {
+            for (unsigned int x = 0; x < block.x; x++) {
+              threadIdx = make_uint3(x, y, z);
+              kernel(arg);
+            }
+          }
+        }
+      }
+    }
+
+    if (!known) {
+      std::lock_guard<std::mutex> lock(kernel_syncs_mutex);
+      kernel_syncs()[func] = synced;
+    }
+
+    return QUDA_SUCCESS;
+  }
+
+  void qudaMemcpy_(void *dst, const void *src, size_t count, cudaMemcpyKind kind, const char *func, const char *file,
+                   const char *line)
+  {
+    if (count == 0) return;
+    PROFILE(host_memcpy(dst, src, count), QUDA_PROFILE_MEMCPY_DEFAULT_ASYNC);
+  }
+
+  void qudaMemcpyAsync_(void *dst, const void *src, size_t count, cudaMemcpyKind kind, const qudaStream_t &stream,
+                        const char *func, const char *file, const char *line)
+  {
+    if (count == 0) return;
+    PROFILE(host_memcpy(dst, src, count), QUDA_PROFILE_MEMCPY_DEFAULT_ASYNC);
+  }
+
+  void qudaMemcpy2D_(void *dst, size_t dpitch, const void *src, size_t spitch, size_t width, size_t height,
+                     cudaMemcpyKind kind, const char *func, const char *file, const char *line)
+  {
+    if (width > dpitch || width > spitch)
+      errorQuda("(CPU) Invalid pitch dpitch=%lu spitch=%lu width=%lu (%s:%s in %s())", dpitch, spitch, width, file,
+                line, func);
+#ifdef _OPENMP
+#pragma omp parallel for if (width * height >= parallel_threshold)
+#endif
+    for (size_t i = 0; i < height; i++) {
+      memcpy(static_cast<char *>(dst) + i * dpitch, static_cast<const char *>(src) + i * spitch, width);
+    }
+  }
+
+  void qudaMemcpy2DAsync_(void *dst, size_t dpitch, const void *src, size_t spitch, size_t width, size_t height,
+                          cudaMemcpyKind kind, const qudaStream_t &stream, const char *func, const char *file,
+                          const char *line)
+  {
+    qudaMemcpy2D_(dst, dpitch, src, spitch, width, height, kind, func, file, line);
+  }
+
+  void qudaMemset_(void *ptr, int value, size_t count, const char *func, const char *file, const char *line)
+  {
+    if (count == 0) return;
+    host_memset(ptr, value, count);
+  }
+
+  void qudaMemsetAsync_(void *ptr, int value, size_t count, const qudaStream_t &stream, const char *func,
+                        const char *file, const char *line)
+  {
+    if (count == 0) return;
+    host_memset(ptr, value, count);
+  }
+
+  void qudaMemset2D_(void *ptr, size_t pitch, int value, size_t width, size_t height, const char *func,
+                     const char *file, const char *line)
+  {
+    if (width > pitch)
+      errorQuda("(CPU) Invalid pitch %lu for width %lu (%s:%s in %s())", pitch, width, file, line, func);
+#ifdef _OPENMP
+#pragma omp parallel for if (width * height >= parallel_threshold)
+#endif
+    for (size_t i = 0; i < height; i++) memset(static_cast<char *>(ptr) + i * pitch, value, width);
+  }
+
+  void qudaMemset2DAsync_(void *ptr, size_t pitch, int value, size_t width, size_t height, const qudaStream_t &stream,
+                          const char *func, const char *file, const char *line)
+  {
+    qudaMemset2D_(ptr, pitch, value, width, height, func, file, line);
+  }
+
+  void qudaMemPrefetchAsync_(void *, size_t, QudaFieldLocation mem_space, const qudaStream_t &, const char *func,
+                             const char *file, const char *line)
+  {
+    // all memory is host memory so prefetching is a no-op
+    if (mem_space != QUDA_CUDA_FIELD_LOCATION && mem_space != QUDA_CPU_FIELD_LOCATION)
+      errorQuda("Invalid QudaFieldLocation (%s:%s in %s())", file, line, func);
+  }
+
+  // All work on the CPU target completes synchronously with respect
+  // to the calling thread, so events are always reached and stream
+  // and device synchronization are no-ops.
+
+  bool qudaEventQuery_(cudaEvent_t &, const char *, const char *, const char *) { return true; }
+
+  void qudaEventRecord_(cudaEvent_t &, qudaStream_t, const char *, const char *, const char *) { }
+
+  void qudaStreamWaitEvent_(qudaStream_t, cudaEvent_t, unsigned int, const char *, const char *, const char *) { }
+
+  void qudaEventSynchronize_(cudaEvent_t &, const char *, const char *, const char *) { }
+
+  void qudaStreamSynchronize_(qudaStream_t &, const char *, const char *, const char *) { }
+
+  void qudaDeviceSynchronize_(const char *, const char *, const char *) { }
+
+  void printAPIProfile() {
+#ifdef API_PROFILE
+    apiTimer.Print();
+#endif
+  }
+
+} // namespace quda
+
+void __syncthreads()
+{
+  auto &s = quda::block_scheduler;
+  if (s.active)
+    s.sync();
+  else if (blockDim.x * blockDim.y * blockDim.z > 1)
+    // the kernel did not synchronize on its first launch, so its blocks are run in sequence
+    errorQuda("(CPU) A kernel synchronized its block after it was found not to on its first launch");
+}
@@ -1,5 +1,9 @@
 #include <blas_lapack.h>
 #include <eigen_helper.h>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 //#define _DEBUG
 
@@ -45,6 +49,112 @@ namespace quda
         printfQuda("Eigen: Norm of (A * Ainv - I) batch %lu = %e\n", batch, L2norm);
 #endif
       }
+
+      /**
+         @brief In-place Gauss-Jordan inversion with partial pivoting of
+         a single n x n column-major matrix, specialized at compile time
+         on the matrix size.  The input is copied straight into the
+         output buffer and inverted there, so no temporary matrices are
+         needed, and for the sizes used by the coarse-grid and
+         Kahler-Dirac clover inverses the matrix stays cache resident
+         for the whole inversion.  The elimination is organized by
+         column so that all inner loops are unit stride.
+         @param[in] A Input matrix for this batch entry
+         @param[out] Ainv Output inverse for this batch entry
+      */
+      template <int n, typename Float> void invertFixed(const std::complex<Float> *A, std::complex<Float> *Ainv)
+      {
+        using complex_t = std::complex<Float>;
+        auto a = [=](int row, int col) -> complex_t & { return Ainv[col * n + row]; };
+
+        for (int i = 0; i < n * n; i++) Ainv[i] = A[i];
+
+        int pivot[n];
+        complex_t f[n];
+
+        for (int k = 0; k < n; k++) {
+          // find the pivot row and swap it into place
+          int p = k;
+          Float max = std::norm(a(k, k));
+          for (int i = k + 1; i < n; i++) {
+            Float v = std::norm(a(i, k));
+            if (v > max) {
+              max = v;
+              p = i;
+            }
+          }
+          pivot[k] = p;
+          if (p != k)
+            for (int j = 0; j < n; j++) std::swap(a(k, j), a(p, j));
+
+          // scale the pivot row, with the pivot element replaced by its inverse
+          const complex_t pinv = static_cast<Float>(1.0) / a(k, k);
+          a(k, k) = 1.0;
+          for (int j = 0; j < n; j++) a(k, j) *= pinv;
+
+          // eliminate column k from every other row
+          for (int i = 0; i < n; i++) {
+            f[i] = a(i, k);
+            a(i, k) = 0.0;
+          }
+          f[k] = 0.0;
+          a(k, k) = pinv;
+
+          // the update is spelled out in real arithmetic, since std::complex
+          // multiplication carries inf/nan recovery that blocks vectorization
+          const Float *f_ = reinterpret_cast<const Float *>(f);
+          for (int j = 0; j < n; j++) {
+            const Float re = a(k, j).real();
+            const Float im = a(k, j).imag();
+            Float *col = reinterpret_cast<Float *>(&a(0, j));
+            for (int i = 0; i < n; i++) {
+              col[2 * i + 0] -= f_[2 * i + 0] * re - f_[2 * i + 1] * im;
+              col[2 * i + 1] -= f_[2 * i + 0] * im + f_[2 * i + 1] * re;
+            }
+          }
+        }
+
+        // undo the row interchanges by swapping the corresponding columns in reverse order
+        for (int k = n - 1; k >= 0; k--) {
+          if (pivot[k] != k)
+            for (int i = 0; i < n; i++) std::swap(a(i, k), a(i, pivot[k]));
+        }
+      }
+
+      /**
+         @brief Invert a batch of matrices, using the size-specialized
+         in-place kernel for the matrix sizes used by the coarse-grid
+         and Kahler-Dirac clover inverses, and falling back to Eigen
+         for any other size.  The batch is statically partitioned so
+         each thread works through a contiguous tile of the batch.
+      */
+      template <typename EigenMatrix, typename Float>
+      void invertBatch(std::complex<Float> *A_eig, std::complex<Float> *Ainv_eig, int n, uint64_t batch)
+      {
+        auto invert = [&](auto size) {
+          constexpr int N = decltype(size)::value;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+          for (uint64_t i = 0; i < batch; i++) invertFixed<N>(A_eig + i * N * N, Ainv_eig + i * N * N);
+        };
+
+        switch (n) {
+        case 12: invert(std::integral_constant<int, 12>()); break;
+        case 24: invert(std::integral_constant<int, 24>()); break;
+        case 32: invert(std::integral_constant<int, 32>()); break;
+        case 48: invert(std::integral_constant<int, 48>()); break;
+        case 64: invert(std::integral_constant<int, 64>()); break;
+        case 96: invert(std::integral_constant<int, 96>()); break;
+        case 128: invert(std::integral_constant<int, 128>()); break;
+        case 192: invert(std::integral_constant<int, 192>()); break;
+        default:
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+          for (uint64_t i = 0; i < batch; i++) { invertEigen<EigenMatrix, Float>(A_eig, Ainv_eig, n, i); }
+        }
+      }
       //---------------------------------------------------
 
       // Batched Inversions
@@ -67,20 +177,12 @@ namespace quda
         if (prec == QUDA_SINGLE_PRECISION) {
           std::complex<float> *A_eig = (std::complex<float> *)A_h;
           std::complex<float> *Ainv_eig = (std::complex<float> *)Ainv_h;
-
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
-          for (uint64_t i = 0; i < batch; i++) { invertEigen<MatrixXcf, float>(A_eig, Ainv_eig, n, i); }
+          invertBatch<MatrixXcf, float>(A_eig, Ainv_eig, n, batch);
           flops += batch * FLOPS_CGETRF(n, n);
         } else if (prec == QUDA_DOUBLE_PRECISION) {
           std::complex<double> *A_eig = (std::complex<double> *)A_h;
           std::complex<double> *Ainv_eig = (std::complex<double> *)Ainv_h;
-
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
-          for (uint64_t i = 0; i < batch; i++) { invertEigen<MatrixXcd, double>(A_eig, Ainv_eig, n, i); }
+          invertBatch<MatrixXcd, double>(A_eig, Ainv_eig, n, batch);
           flops += batch * FLOPS_ZGETRF(n, n);
         } else {
           errorQuda("%s not implemented for precision = %d", __func__, prec);
@@ -94,107 +196,238 @@ namespace quda
         if (getVerbosity() >= QUDA_VERBOSE) {
           int threads = 1;
 #ifdef _OPENMP
-          threads = omp_get_num_threads();
+          threads = omp_get_max_threads();
 #endif
           printfQuda("CPU: Batched matrix inversion completed in %f seconds using %d threads with GFLOPS = %f\n", timeh,
                      threads, 1e-9 * flops / timeh);
         }
 
         if (location == QUDA_CUDA_FIELD_LOCATION) {
+          qudaMemcpy((void *)Ainv, Ainv_h, size, cudaMemcpyHostToDevice);
           pool_pinned_free(Ainv_h);
           pool_pinned_free(A_h);
-          qudaMemcpy((void *)Ainv, Ainv_h, size, cudaMemcpyHostToDevice);
         }
 
         return flops;
       }
 
-      // Srided Batched GEMM helpers
+      // Strided Batched GEMM helpers
       //--------------------------------------------------------------------------
-      template <typename EigenMat, typename T>
-      void fillArray(EigenMat &EigenArr, T *arr, int rows, int cols, int ld, int offset, bool fill_eigen)
+
+      // Cache blocking for the GEMM engine: an mc x kc panel of op(A)
+      // stays in L1/L2 while it is swept against a kc x nc panel of op(B)
+      constexpr int gemm_mc = 64;
+      constexpr int gemm_kc = 256;
+      constexpr int gemm_nc = 512;
+
+      // GEMMs with fewer multiply-adds than this are never split across threads
+      constexpr double gemm_split_min = 64.0 * 64.0 * 64.0;
+
+      template <typename T> inline T conjugate(const T &x) { return x; }
+      template <typename T> inline std::complex<T> conjugate(const std::complex<T> &x) { return std::conj(x); }
+
+      /**
+         @brief Parameters of a single row-major GEMM C = alpha op(A) op(B) + beta C,
+         with the pointers already advanced to this batch entry.
+      */
+      template <typename T> struct GemmArg {
+        const T *A;
+        const T *B;
+        T *C;
+        int m;
+        int n;
+        int k;
+        int lda;
+        int ldb;
+        int ldc;
+        QudaBLASOperation trans_a;
+        QudaBLASOperation trans_b;
+        T alpha;
+        T beta;
+      };
+
+      /**
+         @brief Pack the rows x cols block of op(X) starting at (row0,
+         col0) into a contiguous row-major panel.  The transpose or
+         conjugation is applied while packing, so the kernel only ever
+         sees unit-stride data and the input is read in place, whatever
+         its leading dimension.
+         @param[out] panel Packed panel, with leading dimension cols
+         @param[in] X Row-major matrix as stored, with leading dimension ld
+         @param[in] op Operation applied to X
+      */
+      template <typename T>
+      void packPanel(T *panel, const T *X, int ld, QudaBLASOperation op, int row0, int col0, int rows, int cols)
       {
-        int counter = offset;
-        for (int i = 0; i < rows; i++) {
+        switch (op) {
+        case QUDA_BLAS_OP_N:
+          for (int i = 0; i < rows; i++) {
+            const T *x = X + static_cast<size_t>(row0 + i) * ld + col0;
+            for (int j = 0; j < cols; j++) panel[i * cols + j] = x[j];
+          }
+          break;
+        case QUDA_BLAS_OP_T:
+          for (int j = 0; j < cols; j++) {
+            const T *x = X + static_cast<size_t>(col0 + j) * ld + row0;
+            for (int i = 0; i < rows; i++) panel[i * cols + j] = x[i];
+          }
+          break;
+        case QUDA_BLAS_OP_C:
           for (int j = 0; j < cols; j++) {
-            if (fill_eigen)
-              EigenArr(i, j) = arr[counter];
-            else
-              arr[counter] = EigenArr(i, j);
-            counter++;
+            const T *x = X + static_cast<size_t>(col0 + j) * ld + row0;
+            for (int i = 0; i < rows; i++) panel[i * cols + j] = conjugate(x[i]);
           }
-          counter += (ld - cols);
+          break;
+        default: errorQuda("Unknown blas op type %d", op);
         }
       }
 
-      template <typename EigenMat, typename T>
+      /**
+         @brief y += a * x over a row of n elements
+      */
+      template <typename T> inline void axpyRow(T a, const T *x, T *y, int n)
+      {
+        for (int j = 0; j < n; j++) y[j] += a * x[j];
+      }
+
+      // complex variant spelled out in real arithmetic so that it vectorizes
+      template <typename T> inline void axpyRow(std::complex<T> a, const std::complex<T> *x, std::complex<T> *y, int n)
+      {
+        const T re = a.real();
+        const T im = a.imag();
+        const T *x_ = reinterpret_cast<const T *>(x);
+        T *y_ = reinterpret_cast<T *>(y);
+        for (int j = 0; j < n; j++) {
+          y_[2 * j + 0] += re * x_[2 * j + 0] - im * x_[2 * j + 1];
+          y_[2 * j + 1] += re * x_[2 * j + 1] + im * x_[2 * j + 0];
+        }
+      }
+
+      /**
+         @brief Compute one mc x nc tile of C for a single GEMM,
+         accumulating over k in kc-sized packed panels.
+         @param[in] ti Tile row index
+         @param[in] tj Tile column index
+         @param[in] Ap Scratch for the packed op(A) panel (mc * kc elements)
+         @param[in] Bp Scratch for the packed op(B) panel (kc * nc elements)
+      */
+      template <typename T> void gemmTile(const GemmArg<T> &g, int ti, int tj, T *Ap, T *Bp)
+      {
+        const int i0 = ti * gemm_mc;
+        const int j0 = tj * gemm_nc;
+        const int mb = std::min(gemm_mc, g.m - i0);
+        const int nb = std::min(gemm_nc, g.n - j0);
+        T *C = g.C + static_cast<size_t>(i0) * g.ldc + j0;
+
+        for (int i = 0; i < mb; i++) {
+          T *c = C + static_cast<size_t>(i) * g.ldc;
+          if (g.beta == static_cast<T>(0.0))
+            for (int j = 0; j < nb; j++) c[j] = 0.0;
+          else if (g.beta != static_cast<T>(1.0))
+            for (int j = 0; j < nb; j++) c[j] *= g.beta;
+        }
+
+        for (int p0 = 0; p0 < g.k; p0 += gemm_kc) {
+          const int kb = std::min(gemm_kc, g.k - p0);
+          packPanel(Ap, g.A, g.lda, g.trans_a, i0, p0, mb, kb);
+          packPanel(Bp, g.B, g.ldb, g.trans_b, p0, j0, kb, nb);
+
+          for (int i = 0; i < mb; i++) {
+            T *c = C + static_cast<size_t>(i) * g.ldc;
+            const T *a = Ap + i * kb;
+            for (int p = 0; p < kb; p++) axpyRow(g.alpha * a[p], Bp + p * nb, c, nb);
+          }
+        }
+      }
+
+      /**
+         @brief Strided batched GEMM on row-major host data.  Each GEMM
+         is cut into mc x nc tiles of C.  When the batch alone can keep
+         every thread busy, or the individual GEMMs are too small to be
+         worth splitting, whole GEMMs are distributed over the threads;
+         otherwise the batch is walked in order and the tiles of each
+         GEMM are distributed, which is what keeps the tall-skinny
+         products in the eigensolvers parallel.
+      */
+      template <typename T>
       void GEMM(void *A_h, void *B_h, void *C_h, T alpha, T beta, int max_stride, QudaBLASParam &blas_param)
       {
         // Problem parameters
         int m = blas_param.m;
         int n = blas_param.n;
         int k = blas_param.k;
-        int lda = blas_param.lda;
-        int ldb = blas_param.ldb;
-        int ldc = blas_param.ldc;
 
         // If the user did not set any stride values, we default them to 1
         // as batch size 0 is an option.
-        int a_stride = blas_param.a_stride == 0 ? 1 : blas_param.a_stride;
-        int b_stride = blas_param.b_stride == 0 ? 1 : blas_param.b_stride;
-        int c_stride = blas_param.c_stride == 0 ? 1 : blas_param.c_stride;
-        int a_offset = blas_param.a_offset;
-        int b_offset = blas_param.b_offset;
-        int c_offset = blas_param.c_offset;
-        int batches = blas_param.batch_count;
-
-        // Number of data between batches
-        unsigned int A_batch_size = blas_param.lda * blas_param.k;
-        if (blas_param.trans_a != QUDA_BLAS_OP_N) A_batch_size = blas_param.lda * blas_param.m;
-        unsigned int B_batch_size = blas_param.ldb * blas_param.n;
-        if (blas_param.trans_b != QUDA_BLAS_OP_N) B_batch_size = blas_param.ldb * blas_param.k;
-        unsigned int C_batch_size = blas_param.ldc * blas_param.n;
-
-        T *A_ptr = (T *)(&A_h)[0];
-        T *B_ptr = (T *)(&B_h)[0];
-        T *C_ptr = (T *)(&C_h)[0];
-
-        // Eigen objects to store data
-        EigenMat Amat = EigenMat::Zero(m, k);
-        EigenMat Bmat = EigenMat::Zero(k, n);
-        EigenMat Cmat = EigenMat::Zero(m, n);
-
-        for (int batch = 0; batch < batches; batch += max_stride) {
-
-          // Populate Eigen objects
-          fillArray<EigenMat, T>(Amat, A_ptr, m, k, lda, a_offset, true);
-          fillArray<EigenMat, T>(Bmat, B_ptr, k, n, ldb, b_offset, true);
-          fillArray<EigenMat, T>(Cmat, C_ptr, m, n, ldc, c_offset, true);
-
-          // Apply op(A) and op(B)
-          switch (blas_param.trans_a) {
-          case QUDA_BLAS_OP_T: Amat.transposeInPlace(); break;
-          case QUDA_BLAS_OP_C: Amat.adjointInPlace(); break;
-          case QUDA_BLAS_OP_N: break;
-          default: errorQuda("Unknown blas op type %d", blas_param.trans_a);
-          }
-
-          switch (blas_param.trans_b) {
-          case QUDA_BLAS_OP_T: Bmat.transposeInPlace(); break;
-          case QUDA_BLAS_OP_C: Bmat.adjointInPlace(); break;
-          case QUDA_BLAS_OP_N: break;
-          default: errorQuda("Unknown blas op type %d", blas_param.trans_b);
-          }
+        size_t a_stride = blas_param.a_stride == 0 ? 1 : blas_param.a_stride;
+        size_t b_stride = blas_param.b_stride == 0 ? 1 : blas_param.b_stride;
+        size_t c_stride = blas_param.c_stride == 0 ? 1 : blas_param.c_stride;
+        int n_gemm = (blas_param.batch_count + max_stride - 1) / max_stride;
+
+        // Number of data between batches, for the row-major operands
+        size_t A_batch_size = static_cast<size_t>(blas_param.lda) * blas_param.m;
+        if (blas_param.trans_a != QUDA_BLAS_OP_N) A_batch_size = static_cast<size_t>(blas_param.lda) * blas_param.k;
+        size_t B_batch_size = static_cast<size_t>(blas_param.ldb) * blas_param.k;
+        if (blas_param.trans_b != QUDA_BLAS_OP_N) B_batch_size = static_cast<size_t>(blas_param.ldb) * blas_param.n;
+        size_t C_batch_size = static_cast<size_t>(blas_param.ldc) * blas_param.m;
+
+        auto arg = [&](int batch) {
+          GemmArg<T> g;
+          g.A = static_cast<const T *>(A_h) + blas_param.a_offset + batch * A_batch_size * a_stride;
+          g.B = static_cast<const T *>(B_h) + blas_param.b_offset + batch * B_batch_size * b_stride;
+          g.C = static_cast<T *>(C_h) + blas_param.c_offset + batch * C_batch_size * c_stride;
+          g.m = m;
+          g.n = n;
+          g.k = k;
+          g.lda = blas_param.lda;
+          g.ldb = blas_param.ldb;
+          g.ldc = blas_param.ldc;
+          g.trans_a = blas_param.trans_a;
+          g.trans_b = blas_param.trans_b;
+          g.alpha = alpha;
+          g.beta = beta;
+          return g;
+        };
+
+        const int m_tiles = (m + gemm_mc - 1) / gemm_mc;
+        const int n_tiles = (n + gemm_nc - 1) / gemm_nc;
+        const int tiles = m_tiles * n_tiles;
+
+        int threads = 1;
+#ifdef _OPENMP
+        threads = omp_get_max_threads();
+#endif
+        const bool batch_parallel
+          = n_gemm >= threads || tiles == 1 || static_cast<double>(m) * n * k < gemm_split_min;
 
-          // Perform GEMM using Eigen
-          Cmat = alpha * Amat * Bmat + beta * Cmat;
+        if (getVerbosity() >= QUDA_DEBUG_VERBOSE)
+          printfQuda("GEMM (generic): %d GEMMs of %dx%dx%d, %d tiles each, parallel over %s\n", n_gemm, m, n, k, tiles,
+                     batch_parallel ? "batch" : "tiles");
 
-          // Write back to the C array
-          fillArray<EigenMat, T>(Cmat, C_ptr, m, n, ldc, c_offset, false);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+          std::vector<T> Ap(gemm_mc * gemm_kc);
+          std::vector<T> Bp(gemm_kc * gemm_nc);
 
-          a_offset += A_batch_size * a_stride;
-          b_offset += B_batch_size * b_stride;
-          c_offset += C_batch_size * c_stride;
+          if (batch_parallel) {
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+            for (int batch = 0; batch < n_gemm; batch++) {
+              auto g = arg(batch);
+              for (int t = 0; t < tiles; t++) gemmTile(g, t / n_tiles, t % n_tiles, Ap.data(), Bp.data());
+            }
+          } else {
+            for (int batch = 0; batch < n_gemm; batch++) {
+              auto g = arg(batch);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+              for (int t = 0; t < tiles; t++) gemmTile(g, t / n_tiles, t % n_tiles, Ap.data(), Bp.data());
+            }
+          }
         }
       }
       //---------------------------------------------------
@@ -297,6 +530,9 @@ namespace quda
         // Then number of GEMMs to compute
         const uint64_t batch = blas_param.batch_count / max_stride;
 
+        // The number of GEMMs actually computed, including a partial last stride
+        const uint64_t n_gemm = (blas_param.batch_count + max_stride - 1) / max_stride;
+
         uint64_t data_size
           = (blas_param.data_type == QUDA_BLAS_DATATYPE_S || blas_param.data_type == QUDA_BLAS_DATATYPE_C) ? 4 : 8;
 
@@ -304,12 +540,12 @@ namespace quda
           data_size *= 2;
         }
 
-        // Number of data between batches
-        unsigned int A_batch_size = blas_param.lda * blas_param.k;
-        if (blas_param.trans_a != QUDA_BLAS_OP_N) A_batch_size = blas_param.lda * blas_param.m;
-        unsigned int B_batch_size = blas_param.ldb * blas_param.n;
-        if (blas_param.trans_b != QUDA_BLAS_OP_N) B_batch_size = blas_param.ldb * blas_param.k;
-        unsigned int C_batch_size = blas_param.ldc * blas_param.n;
+        // Number of data between batches, for the row-major operands
+        unsigned int A_batch_size = blas_param.lda * blas_param.m;
+        if (blas_param.trans_a != QUDA_BLAS_OP_N) A_batch_size = blas_param.lda * blas_param.k;
+        unsigned int B_batch_size = blas_param.ldb * blas_param.k;
+        if (blas_param.trans_b != QUDA_BLAS_OP_N) B_batch_size = blas_param.ldb * blas_param.n;
+        unsigned int C_batch_size = blas_param.ldc * blas_param.m;
 
         // Data size of the entire array
         size_t sizeAarr = A_batch_size * data_size * batch;
@@ -332,28 +568,32 @@ namespace quda
           typedef std::complex<double> Z;
           const Z alpha = blas_param.alpha;
           const Z beta = blas_param.beta;
-          GEMM<MatrixXcd, Z>(A_h, B_h, C_h, alpha, beta, max_stride, blas_param);
+          GEMM<Z>(A_h, B_h, C_h, alpha, beta, max_stride, blas_param);
+          flops += n_gemm * FLOPS_ZGEMM(blas_param.m, blas_param.n, blas_param.k);
 
         } else if (blas_param.data_type == QUDA_BLAS_DATATYPE_C) {
 
           typedef std::complex<float> C;
           const C alpha = blas_param.alpha;
           const C beta = blas_param.beta;
-          GEMM<MatrixXcf, C>(A_h, B_h, C_h, alpha, beta, max_stride, blas_param);
+          GEMM<C>(A_h, B_h, C_h, alpha, beta, max_stride, blas_param);
+          flops += n_gemm * FLOPS_CGEMM(blas_param.m, blas_param.n, blas_param.k);
 
         } else if (blas_param.data_type == QUDA_BLAS_DATATYPE_D) {
 
           typedef double D;
           const D alpha = (D)(static_cast<std::complex<double>>(blas_param.alpha).real());
           const D beta = (D)(static_cast<std::complex<double>>(blas_param.beta).real());
-          GEMM<MatrixXd, D>(A_h, B_h, C_h, alpha, beta, max_stride, blas_param);
+          GEMM<D>(A_h, B_h, C_h, alpha, beta, max_stride, blas_param);
+          flops += n_gemm * FLOPS_DGEMM(blas_param.m, blas_param.n, blas_param.k);
 
         } else if (blas_param.data_type == QUDA_BLAS_DATATYPE_S) {
 
           typedef float S;
           const S alpha = (S)(static_cast<std::complex<float>>(blas_param.alpha).real());
           const S beta = (S)(static_cast<std::complex<float>>(blas_param.beta).real());
-          GEMM<MatrixXf, S>(A_h, B_h, C_h, alpha, beta, max_stride, blas_param);
+          GEMM<S>(A_h, B_h, C_h, alpha, beta, max_stride, blas_param);
+          flops += n_gemm * FLOPS_SGEMM(blas_param.m, blas_param.n, blas_param.k);
 
         } else {
           errorQuda("blasGEMM type %d not implemented\n", blas_param.data_type);
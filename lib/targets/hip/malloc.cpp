@@ -14,65 +14,24 @@
 #ifdef QUDA_BACKWARDSCPP
 #include "backward.hpp"
 #endif
+#include <alloc_tracker.h>
+
 namespace quda
 {
 
-  enum AllocType { DEVICE, DEVICE_PINNED, HOST, PINNED, MAPPED, MANAGED, N_ALLOC_TYPE };
-
-  class MemAlloc
-  {
-
-  public:
-    std::string func;
-    std::string file;
-    int line;
-    size_t size;
-    size_t base_size;
-#ifdef QUDA_BACKWARDSCPP
-    backward::StackTrace st;
-#endif
-
-    MemAlloc() : line(-1), size(0), base_size(0) {}
-
-    MemAlloc(std::string func, std::string file, int line) : func(func), file(file), line(line), size(0), base_size(0)
-    {
-#ifdef QUDA_BACKWARDSCPP
-      st.load_here(32);
-      st.skip_n_firsts(1);
-#endif
-    }
-
-    MemAlloc &operator=(const MemAlloc &a)
-    {
-      if (&a != this) {
-        func = a.func;
-        file = a.file;
-        line = a.line;
-        size = a.size;
-        base_size = a.base_size;
-#ifdef QUDA_BACKWARDSCPP
-        st = a.st;
-#endif
-      }
-      return *this;
-    }
-  };
-
-  static std::map<void *, MemAlloc> alloc[N_ALLOC_TYPE];
-  static long total_bytes[N_ALLOC_TYPE] = {0};
-  static long max_total_bytes[N_ALLOC_TYPE] = {0};
-  static long total_host_bytes, max_total_host_bytes;
-  static long total_pinned_bytes, max_total_pinned_bytes;
+  // never destroyed, since the communicators free their buffers from
+  // static destructors when the process exits without comm_finalize()
+  static AllocTracker &alloc = *new AllocTracker;
 
-  long device_allocated_peak() { return max_total_bytes[DEVICE]; }
+  long device_allocated_peak() { return alloc.peak(DEVICE); }
 
-  long pinned_allocated_peak() { return max_total_bytes[PINNED]; }
+  long pinned_allocated_peak() { return alloc.peak(PINNED); }
 
-  long mapped_allocated_peak() { return max_total_bytes[MAPPED]; }
+  long mapped_allocated_peak() { return alloc.peak(MAPPED); }
 
-  long managed_allocated_peak() { return max_total_bytes[MANAGED]; }
+  long managed_allocated_peak() { return alloc.peak(MANAGED); }
 
-  long host_allocated_peak() { return max_total_bytes[HOST]; }
+  long host_allocated_peak() { return alloc.peak(HOST); }
 
   static void print_trace(void)
   {
@@ -95,13 +54,12 @@ namespace quda
   static void print_alloc(AllocType type)
   {
     const char *type_str[] = {"Device", "Device Pinned", "Host  ", "Pinned", "Mapped", "Managed"};
-    std::map<void *, MemAlloc>::iterator entry;
 
-    for (entry = alloc[type].begin(); entry != alloc[type].end(); entry++) {
-      void *ptr = entry->first;
-      MemAlloc a = entry->second;
-      printfQuda("%s  %15p  %15lu  %s(), %s:%d\n", type_str[type], ptr, (unsigned long)a.base_size, a.func.c_str(),
-                 a.file.c_str(), a.line);
+    for (auto &entry : alloc.entries(type)) {
+      void *ptr = entry.first;
+      const MemAlloc &a = entry.second;
+      printfQuda("%s  %15p  %15lu  %s(), %s:%d\n", type_str[type], ptr, (unsigned long)a.base_size, a.func, a.file,
+                 a.line);
 #ifdef QUDA_BACKWARDSCPP
       if (getRankVerbosity()) {
         backward::Printer p;
@@ -111,29 +69,9 @@ namespace quda
     }
   }
 
-  static void track_malloc(const AllocType &type, const MemAlloc &a, void *ptr)
-  {
-    total_bytes[type] += a.base_size;
-    if (total_bytes[type] > max_total_bytes[type]) { max_total_bytes[type] = total_bytes[type]; }
-    if (type != DEVICE && type != DEVICE_PINNED) {
-      total_host_bytes += a.base_size;
-      if (total_host_bytes > max_total_host_bytes) { max_total_host_bytes = total_host_bytes; }
-    }
-    if (type == PINNED || type == MAPPED) {
-      total_pinned_bytes += a.base_size;
-      if (total_pinned_bytes > max_total_pinned_bytes) { max_total_pinned_bytes = total_pinned_bytes; }
-    }
-    alloc[type][ptr] = a;
-  }
+  static void track_malloc(const AllocType &type, const MemAlloc &a, void *ptr) { alloc.insert(type, ptr, a); }
 
-  static void track_free(const AllocType &type, void *ptr)
-  {
-    size_t size = alloc[type][ptr].base_size;
-    total_bytes[type] -= size;
-    if (type != DEVICE && type != DEVICE_PINNED) { total_host_bytes -= size; }
-    if (type == PINNED || type == MAPPED) { total_pinned_bytes -= size; }
-    alloc[type].erase(ptr);
-  }
+  static bool track_free(const AllocType &type, void *ptr, MemAlloc *a = nullptr) { return alloc.erase(type, ptr, a); }
 
   /**
    * Under CUDA 4.0, cudaHostRegister seems to require that both the
@@ -151,8 +89,7 @@ namespace quda
     a.base_size = ((size + page_size - 1) / page_size) * page_size; // round up to the nearest multiple of page_size
     int align = posix_memalign(&ptr, page_size, a.base_size);
     if (!ptr || align != 0) {
-      errorQuda("Failed to allocate aligned host memory of size %zu (%s:%d in %s())\n", size, a.file.c_str(), a.line,
-                a.func.c_str());
+      errorQuda("Failed to allocate aligned host memory of size %zu (%s:%d in %s())\n", size, a.file, a.line, a.func);
     }
     return ptr;
   }
@@ -262,9 +199,9 @@ namespace quda
   void *safe_malloc_(const char *func, const char *file, int line, size_t size)
   {
     MemAlloc a(func, file, line);
-    a.size = a.base_size = size;
+    a.size = size;
 
-    void *ptr = malloc(size);
+    void *ptr = pool::host_acquire(size, a.base_size);
     if (!ptr) { errorQuda("Failed to allocate host memory of size %zu (%s:%d in %s())\n", size, file, line, func); }
     track_malloc(HOST, a, ptr);
 #ifdef HOST_DEBUG
@@ -357,12 +294,11 @@ namespace quda
 
 #ifndef QDP_USE_CUDA_MANAGED_MEMORY
     if (!ptr) { errorQuda("Attempt to free NULL device pointer (%s:%d in %s())\n", file, line, func); }
-    if (!alloc[DEVICE].count(ptr)) {
+    if (!track_free(DEVICE, ptr)) {
       errorQuda("Attempt to free invalid device pointer (%s:%d in %s())\n", file, line, func);
     }
     hipError_t err = hipFree(ptr);
     if (err != hipSuccess) { errorQuda("Failed to free device memory (%s:%d in %s())\n", file, line, func); }
-    track_free(DEVICE, ptr);
 #else
     device_pinned_free_(func, file, line, ptr);
 #endif
@@ -381,12 +317,11 @@ namespace quda
     }
 
     if (!ptr) { errorQuda("Attempt to free NULL device pointer (%s:%d in %s())\n", file, line, func); }
-    if (!alloc[DEVICE_PINNED].count(ptr)) {
+    if (!track_free(DEVICE_PINNED, ptr)) {
       errorQuda("Attempt to free invalid device pointer (%s:%d in %s())\n", file, line, func);
     }
     hipError_t err = hipMemFree((hipDeviceptr_t)ptr);
     if (err != HIP_SUCCESS) { printfQuda("Failed to free device memory (%s:%d in %s())\n", file, line, func); }
-    track_free(DEVICE_PINNED, ptr);
   }
 
   /**
@@ -397,12 +332,11 @@ namespace quda
   void managed_free_(const char *func, const char *file, int line, void *ptr)
   {
     if (!ptr) { errorQuda("Attempt to free NULL managed pointer (%s:%d in %s())\n", file, line, func); }
-    if (!alloc[MANAGED].count(ptr)) {
+    if (!track_free(MANAGED, ptr)) {
       errorQuda("Attempt to free invalid managed pointer (%s:%d in %s())\n", file, line, func);
     }
     hipError_t err = hipFree(ptr);
     if (err != hipSuccess) { errorQuda("Failed to free device memory (%s:%d in %s())\n", file, line, func); }
-    track_free(MANAGED, ptr);
   }
 
   /**
@@ -413,15 +347,14 @@ namespace quda
   void host_free_(const char *func, const char *file, int line, void *ptr)
   {
     if (!ptr) { errorQuda("Attempt to free NULL host pointer (%s:%d in %s())\n", file, line, func); }
-    if (alloc[HOST].count(ptr)) {
-      track_free(HOST, ptr);
-      free(ptr);
-    } else if (alloc[PINNED].count(ptr)) {
+    MemAlloc a;
+    if (track_free(HOST, ptr, &a)) {
+      pool::host_release(ptr, a.size, a.base_size);
+    } else if (track_free(PINNED, ptr)) {
       hipError_t err = hipHostUnregister(ptr);
       if (err != hipSuccess) { errorQuda("Failed to unregister pinned memory (%s:%d in %s())\n", file, line, func); }
-      track_free(PINNED, ptr);
       free(ptr);
-    } else if (alloc[MAPPED].count(ptr)) {
+    } else if (track_free(MAPPED, ptr)) {
 #ifdef HOST_ALLOC
       hipError_t err = hipFreeHost(ptr);
       if (err != hipSuccess) { errorQuda("Failed to free host memory (%s:%d in %s())\n", file, line, func); }
@@ -432,7 +365,6 @@ namespace quda
       }
       free(ptr);
 #endif
-      track_free(MAPPED, ptr);
     } else {
       printfQuda("ERROR: Attempt to free invalid host pointer (%s:%d in %s())\n", file, line, func);
       print_trace();
@@ -442,17 +374,18 @@ namespace quda
 
   void printPeakMemUsage()
   {
-    printfQuda("Device memory used = %.1f MB\n", max_total_bytes[DEVICE] / (double)(1 << 20));
-    printfQuda("Pinned device memory used = %.1f MB\n", max_total_bytes[DEVICE_PINNED] / (double)(1 << 20));
-    printfQuda("Managed memory used = %.1f MB\n", max_total_bytes[MANAGED] / (double)(1 << 20));
-    printfQuda("Page-locked host memory used = %.1f MB\n", max_total_pinned_bytes / (double)(1 << 20));
-    printfQuda("Total host memory used >= %.1f MB\n", max_total_host_bytes / (double)(1 << 20));
+    printfQuda("Device memory used = %.1f MB\n", alloc.peak(DEVICE) / (double)(1 << 20));
+    printfQuda("Pinned device memory used = %.1f MB\n", alloc.peak(DEVICE_PINNED) / (double)(1 << 20));
+    printfQuda("Managed memory used = %.1f MB\n", alloc.peak(MANAGED) / (double)(1 << 20));
+    printfQuda("Page-locked host memory used = %.1f MB\n", alloc.peak_pinned() / (double)(1 << 20));
+    printfQuda("Total host memory used >= %.1f MB\n", alloc.peak_host() / (double)(1 << 20));
+    if (pool::host_memory_pool()) pool::print_host_stats();
   }
 
   void assertAllMemFree()
   {
-    if (!alloc[DEVICE].empty() || !alloc[DEVICE_PINNED].empty() || !alloc[HOST].empty() || !alloc[PINNED].empty()
-        || !alloc[MAPPED].empty()) {
+    if (!alloc.empty(DEVICE) || !alloc.empty(DEVICE_PINNED) || !alloc.empty(HOST) || !alloc.empty(PINNED)
+        || !alloc.empty(MAPPED)) {
       warningQuda("The following internal memory allocations were not freed.");
       printfQuda("\n");
       print_alloc_header();
@@ -556,6 +489,9 @@ namespace quda
           warningQuda("Not using pinned memory pool allocator");
           pinned_memory_pool = false;
         }
+
+        // host memory pool, which is set up on first use since safe_malloc() may precede initQuda()
+        if (host_memory_pool()) warningQuda("Using host memory pool allocator");
         pool_init = true;
       }
     }
@@ -1,9 +1,12 @@
 #include <tune_quda.h>
+#include <tune_cache.h>
+#include <timeline.h>
 #include <comm_quda.h>
 #include <quda.h>     // for QUDA_VERSION_STRING
-#include <sys/stat.h> // for stat()
 #include <fcntl.h>
 #include <cfloat> // for FLT_MAX
+#include <cmath>
+#include <cctype>
 #include <ctime>
 #include <fstream>
 #include <typeinfo>
@@ -21,16 +24,15 @@ extern char *gitversion;
 
 namespace quda
 {
-  static TuneKey last_key;
+  static TuneKey last_key;                        // copy of the last key that missed the tunecache
+  static const TuneKey *last_key_ptr = &last_key; // the last key (points into the tunecache on a hit)
 }
 
 // intentionally leave this outside of the namespace for now
-quda::TuneKey getLastTuneKey() { return quda::last_key; }
+quda::TuneKey getLastTuneKey() { return *quda::last_key_ptr; }
 
 namespace quda
 {
-  typedef std::map<TuneKey, TuneParam> map;
-
   struct TraceKey {
 
     TuneKey key;
@@ -117,10 +119,7 @@ namespace quda
   }
 
   static const std::string quda_hash = QUDA_HASH; // defined in lib/Makefile
-  static std::string resource_path;
-  static map tunecache;
-  static map::iterator it;
-  static size_t initial_cache_size = 0;
+  static TuneCache::iterator it;
 
 #define STR_(x) #x
 #define STR(x) STR_(x)
@@ -139,66 +138,6 @@ namespace quda
   void disableProfileCount() { profile_count = false; }
   void enableProfileCount() { profile_count = true; }
 
-  const map &getTuneCache() { return tunecache; }
-
-  /**
-   * Deserialize tunecache from an istream, useful for reading a file or receiving from other nodes.
-   */
-  static void deserializeTuneCache(std::istream &in)
-  {
-    std::string line;
-    std::stringstream ls;
-
-    TuneKey key;
-    TuneParam param;
-
-    std::string v;
-    std::string n;
-    std::string a;
-
-    int check;
-
-    while (in.good()) {
-      getline(in, line);
-      if (!line.length()) continue; // skip blank lines (e.g., at end of file)
-      ls.clear();
-      ls.str(line);
-      ls >> v >> n >> a >> param.block.x >> param.block.y >> param.block.z;
-      check = snprintf(key.volume, key.volume_n, "%s", v.c_str());
-      if (check < 0 || check >= key.volume_n) errorQuda("Error writing volume string (check = %d)", check);
-      check = snprintf(key.name, key.name_n, "%s", n.c_str());
-      if (check < 0 || check >= key.name_n) errorQuda("Error writing name string (check=%d)", check);
-      check = snprintf(key.aux, key.aux_n, "%s", a.c_str());
-      if (check < 0 || check >= key.aux_n) errorQuda("Error writing aux string (check=%d)", check);
-      ls >> param.grid.x >> param.grid.y >> param.grid.z >> param.shared_bytes >> param.aux.x >> param.aux.y
-        >> param.aux.z >> param.aux.w >> param.time;
-      ls.ignore(1);               // throw away tab before comment
-      getline(ls, param.comment); // assume anything remaining on the line is a comment
-      param.comment += "\n";      // our convention is to include the newline, since ctime() likes to do this
-      tunecache[key] = param;
-    }
-  }
-
-  /**
-   * Serialize tunecache to an ostream, useful for writing to a file or sending to other nodes.
-   */
-  static void serializeTuneCache(std::ostream &out)
-  {
-    map::iterator entry;
-
-    for (entry = tunecache.begin(); entry != tunecache.end(); entry++) {
-      TuneKey key = entry->first;
-      TuneParam param = entry->second;
-
-      out << std::setw(16) << key.volume << "\t" << key.name << "\t" << key.aux << "\t";
-      out << param.block.x << "\t" << param.block.y << "\t" << param.block.z << "\t";
-      out << param.grid.x << "\t" << param.grid.y << "\t" << param.grid.z << "\t";
-      out << param.shared_bytes << "\t" << param.aux.x << "\t" << param.aux.y << "\t" << param.aux.z << "\t"
-          << param.aux.w << "\t";
-      out << param.time << "\t" << param.comment; // param.comment ends with a newline
-    }
-  }
-
   template <class T> struct less_significant : std::binary_function<T, T, bool> {
     inline bool operator()(const T &lhs, const T &rhs)
     {
@@ -211,17 +150,17 @@ namespace quda
    */
   static void serializeProfile(std::ostream &out, std::ostream &async_out)
   {
-    map::iterator entry;
+    TuneCache::iterator entry;
     double total_time = 0.0;
     double async_total_time = 0.0;
 
     // first let's sort the entries in decreasing order of significance
     typedef std::pair<TuneKey, TuneParam> profile_t;
     typedef std::priority_queue<profile_t, std::deque<profile_t>, less_significant<profile_t>> queue_t;
-    queue_t q(tunecache.begin(), tunecache.end());
+    queue_t q(tuneCache().begin(), tuneCache().end());
 
     // now compute total time spent in kernels so we can give each kernel a significance
-    for (entry = tunecache.begin(); entry != tunecache.end(); entry++) {
+    for (entry = tuneCache().begin(); entry != tuneCache().end(); entry++) {
       TuneKey key = entry->first;
       TuneParam param = entry->second;
 
@@ -299,213 +238,6 @@ namespace quda
     }
   }
 
-  /**
-   * Distribute the tunecache from node 0 to all other nodes.
-   */
-  static void broadcastTuneCache()
-  {
-#ifdef MULTI_GPU
-    std::stringstream serialized;
-    size_t size;
-
-    if (comm_rank() == 0) {
-      serializeTuneCache(serialized);
-      size = serialized.str().length();
-    }
-    comm_broadcast(&size, sizeof(size_t));
-
-    if (size > 0) {
-      if (comm_rank() == 0) {
-        comm_broadcast(const_cast<char *>(serialized.str().c_str()), size);
-      } else {
-        char *serstr = new char[size + 1];
-        comm_broadcast(serstr, size);
-        serstr[size] = '\0'; // null-terminate
-        serialized.str(serstr);
-        deserializeTuneCache(serialized);
-        delete[] serstr;
-      }
-    }
-#endif
-  }
-
-  /*
-   * Read tunecache from disk.
-   */
-  void loadTuneCache()
-  {
-    if (getTuning() == QUDA_TUNE_NO) {
-      warningQuda("Autotuning disabled");
-      return;
-    }
-
-    char *path;
-    struct stat pstat;
-    std::string cache_path, line, token;
-    std::ifstream cache_file;
-    std::stringstream ls;
-
-    path = getenv("QUDA_RESOURCE_PATH");
-
-    if (!path) {
-      warningQuda("Environment variable QUDA_RESOURCE_PATH is not set.");
-      warningQuda("Caching of tuned parameters will be disabled.");
-      return;
-    } else if (stat(path, &pstat) || !S_ISDIR(pstat.st_mode)) {
-      warningQuda("The path \"%s\" specified by QUDA_RESOURCE_PATH does not exist or is not a directory.", path);
-      warningQuda("Caching of tuned parameters will be disabled.");
-      return;
-    } else {
-      resource_path = path;
-    }
-
-    bool version_check = true;
-    char *override_version_env = getenv("QUDA_TUNE_VERSION_CHECK");
-    if (override_version_env && strcmp(override_version_env, "0") == 0) {
-      version_check = false;
-      warningQuda("Disabling QUDA tunecache version check");
-    }
-
-#ifdef MULTI_GPU
-    if (comm_rank() == 0) {
-#endif
-
-      cache_path = resource_path;
-      cache_path += "/tunecache.tsv";
-      cache_file.open(cache_path.c_str());
-
-      if (cache_file) {
-
-        if (!cache_file.good()) errorQuda("Bad format in %s", cache_path.c_str());
-        getline(cache_file, line);
-        ls.str(line);
-        ls >> token;
-        if (token.compare("tunecache")) errorQuda("Bad format in %s", cache_path.c_str());
-        ls >> token;
-        if (version_check && token.compare(quda_version))
-          errorQuda("Cache file %s does not match current QUDA version. \nPlease delete this file or set the "
-                    "QUDA_RESOURCE_PATH environment variable to point to a new path.",
-                    cache_path.c_str());
-        ls >> token;
-#ifdef GITVERSION
-        if (version_check && token.compare(gitversion))
-          errorQuda("Cache file %s does not match current QUDA version. \nPlease delete this file or set the "
-                    "QUDA_RESOURCE_PATH environment variable to point to a new path.",
-                    cache_path.c_str());
-#else
-      if (version_check && token.compare(quda_version))
-        errorQuda("Cache file %s does not match current QUDA version. \nPlease delete this file or set the "
-                  "QUDA_RESOURCE_PATH environment variable to point to a new path.",
-                  cache_path.c_str());
-#endif
-        ls >> token;
-        if (version_check && token.compare(quda_hash))
-          errorQuda("Cache file %s does not match current QUDA build. \nPlease delete this file or set the "
-                    "QUDA_RESOURCE_PATH environment variable to point to a new path.",
-                    cache_path.c_str());
-
-        if (!cache_file.good()) errorQuda("Bad format in %s", cache_path.c_str());
-        getline(cache_file, line); // eat the blank line
-
-        if (!cache_file.good()) errorQuda("Bad format in %s", cache_path.c_str());
-        getline(cache_file, line); // eat the description line
-
-        deserializeTuneCache(cache_file);
-
-        cache_file.close();
-        initial_cache_size = tunecache.size();
-
-        if (getVerbosity() >= QUDA_SUMMARIZE) {
-          printfQuda("Loaded %d sets of cached parameters from %s\n", static_cast<int>(initial_cache_size),
-                     cache_path.c_str());
-        }
-
-      } else {
-        warningQuda("Cache file not found.  All kernels will be re-tuned (if tuning is enabled).");
-      }
-
-#ifdef MULTI_GPU
-    }
-#endif
-
-    broadcastTuneCache();
-  }
-
-  /**
-   * Write tunecache to disk.
-   */
-  void saveTuneCache(bool error)
-  {
-    time_t now;
-    int lock_handle;
-    std::string lock_path, cache_path;
-    std::ofstream cache_file;
-
-    if (resource_path.empty()) return;
-
-      // FIXME: We should really check to see if any nodes have tuned a kernel that was not also tuned on node 0, since as things
-      //       stand, the corresponding launch parameters would never get cached to disk in this situation.  This will come up if we
-      //       ever support different subvolumes per GPU (as might be convenient for lattice volumes that don't divide evenly).
-
-#ifdef MULTI_GPU
-    if (comm_rank() == 0) {
-#endif
-
-      if (tunecache.size() == initial_cache_size && !error) return;
-
-      // Acquire lock.  Note that this is only robust if the filesystem supports flock() semantics, which is true for
-      // NFS on recent versions of linux but not Lustre by default (unless the filesystem was mounted with "-o flock").
-      lock_path = resource_path + "/tunecache.lock";
-      lock_handle = open(lock_path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666);
-      if (lock_handle == -1) {
-        warningQuda("Unable to lock cache file.  Tuned launch parameters will not be cached to disk.  "
-                    "If you are certain that no other instances of QUDA are accessing this filesystem, "
-                    "please manually remove %s",
-                    lock_path.c_str());
-        return;
-      }
-      char msg[] = "If no instances of applications using QUDA are running,\n"
-                   "this lock file shouldn't be here and is safe to delete.";
-      int stat = write(lock_handle, msg, sizeof(msg)); // check status to avoid compiler warning
-      if (stat == -1) warningQuda("Unable to write to lock file for some bizarre reason");
-
-      cache_path = resource_path + (error ? "/tunecache_error.tsv" : "/tunecache.tsv");
-      cache_file.open(cache_path.c_str());
-
-      if (getVerbosity() >= QUDA_SUMMARIZE) {
-        printfQuda("Saving %d sets of cached parameters to %s\n", static_cast<int>(tunecache.size()), cache_path.c_str());
-      }
-
-      time(&now);
-      cache_file << "tunecache\t" << quda_version;
-#ifdef GITVERSION
-      cache_file << "\t" << gitversion;
-#else
-    cache_file << "\t" << quda_version;
-#endif
-      cache_file << "\t" << quda_hash << "\t# Last updated " << ctime(&now) << std::endl;
-      cache_file << std::setw(16) << "volume"
-                 << "\tname\taux\tblock.x\tblock.y\tblock.z\tgrid.x\tgrid.y\tgrid.z\tshared_bytes\taux.x\taux.y\taux."
-                    "z\taux.w\ttime\tcomment"
-                 << std::endl;
-      serializeTuneCache(cache_file);
-      cache_file.close();
-
-      // Release lock.
-      close(lock_handle);
-      remove(lock_path.c_str());
-
-      initial_cache_size = tunecache.size();
-
-#ifdef MULTI_GPU
-    } else {
-      // give process 0 time to write out its tunecache if needed, but
-      // doesn't cause a hang if error is not triggered on process 0
-      if (error) sleep(10);
-    }
-#endif
-  }
-
   static bool policy_tuning = false;
   bool policyTuning() { return policy_tuning; }
 
@@ -514,7 +246,7 @@ namespace quda
   // flush profile, setting counts to zero
   void flushProfile()
   {
-    for (map::iterator entry = tunecache.begin(); entry != tunecache.end(); entry++) {
+    for (TuneCache::iterator entry = tuneCache().begin(); entry != tuneCache().end(); entry++) {
       // set all n_calls = 0
       TuneParam &param = entry->second;
       param.n_calls = 0;
@@ -529,10 +261,11 @@ namespace quda
     std::string lock_path, profile_path, async_profile_path, trace_path;
     std::ofstream profile_file, async_profile_file, trace_file;
 
+    const std::string &resource_path = tuneResourcePath();
     if (resource_path.empty()) return;
 
 #ifdef MULTI_GPU
-    if (comm_rank() == 0) {
+    if (comm_rank_global() == 0) {
 #endif
 
       // Acquire lock.  Note that this is only robust if the filesystem supports flock() semantics, which is true for
@@ -579,7 +312,7 @@ namespace quda
         // compute number of non-zero entries that will be output in the profile
         int n_entry = 0;
         int n_policy = 0;
-        for (map::iterator entry = tunecache.begin(); entry != tunecache.end(); entry++) {
+        for (TuneCache::iterator entry = tuneCache().begin(); entry != tuneCache().end(); entry++) {
           // if a policy entry, then we can ignore
           char tmp[TuneKey::aux_n] = {};
           strncpy(tmp, entry->first.aux, TuneKey::aux_n);
@@ -676,8 +409,10 @@ namespace quda
 #endif
 
     TuneKey key = tunable.tuneKey();
-    if (use_managed_memory()) strcat(key.aux, ",managed");
-    last_key = key;
+    if (use_managed_memory()) {
+      strcat(key.aux, ",managed");
+      key.rehash();
+    }
     static TuneParam param;
 
 #ifdef LAUNCH_TIMER
@@ -686,10 +421,18 @@ namespace quda
 #endif
 
     static const Tunable *active_tunable; // for error checking
-    it = tunecache.find(key);
+    it = findTuneCache(key);
+
+    // on a hit we can refer to the cached key rather than copying it
+    if (it != tuneCache().end()) {
+      last_key_ptr = &it->first;
+    } else {
+      last_key = key;
+      last_key_ptr = &last_key;
+    }
 
     // first check if we have the tuned value and return if we have it
-    if (enabled == QUDA_TUNE_YES && it != tunecache.end()) {
+    if (enabled == QUDA_TUNE_YES && it != tuneCache().end()) {
 
 #ifdef LAUNCH_TIMER
       launchTimer.TPSTOP(QUDA_PROFILE_PREAMBLE);
@@ -697,6 +440,7 @@ namespace quda
 #endif
 
       TuneParam &param = it->second;
+      if (timeline::enabled()) timeline::instant(it->first.name, "launch", it->first.aux);
 
       if (verbosity >= QUDA_DEBUG_VERBOSE) {
         printfQuda("Launching %s with %s at vol=%s with %s\n", key.name, key.aux, key.volume,
@@ -743,7 +487,7 @@ namespace quda
       /* As long as global reductions are not disabled, only do the
          tuning on node 0, else do the tuning on all nodes since we
          can't guarantee that all nodes are partaking */
-      if (comm_rank() == 0 || !commGlobalReduction() || policyTuning()) {
+      if (comm_rank_global() == 0 || !commGlobalReduction() || policyTuning()) {
         TuneParam best_param;
         cudaError_t error = cudaSuccess;
         cudaEvent_t start, end;
@@ -765,9 +509,33 @@ namespace quda
         }
 
         Timer tune_timer;
+        const int64_t tune_start = timeline::enabled() ? timeline::now() : 0;
         tune_timer.Start(__func__, __FILE__, __LINE__);
 
+        // when warm starting, only the neighbourhood of the entry tuned at the nearest volume is explored
+        TuneParam seed;
+        const TuneKey *seed_key = warmStart() ? findWarmStartSeed(key, seed) : nullptr;
+        bool warm = seed_key;
+        if (warm && verbosity >= QUDA_VERBOSE) {
+          printfQuda("Warm starting %s with %s at vol=%s from vol=%s\n", key.name, key.aux, key.volume,
+                     seed_key->volume);
+        }
+
+        // advance to the next candidate, skipping those outside the neighbourhood of the seed when warm starting
+        auto next_param = [&](bool advance) {
+          bool more = !advance || tunable.advanceTuneParam(param);
+          while (more && warm && !tunable.warmStartNeighbour(param, seed)) more = tunable.advanceTuneParam(param);
+          if (!more && warm && best_time == FLT_MAX) {
+            // nothing valid in the neighbourhood so fall back to a full sweep
+            warm = false;
+            tunable.initTuneParam(param);
+            more = true;
+          }
+          return more;
+        };
+
         tunable.initTuneParam(param);
+        tuning = next_param(false);
         while (tuning) {
           cudaDeviceSynchronize();
           cudaGetLastError(); // clear error counter
@@ -816,7 +584,7 @@ namespace quda
               }
             }
           }
-          tuning = tunable.advanceTuneParam(param);
+          tuning = next_param(true);
           tunable.jitifyError() = CUDA_SUCCESS;
         }
 
@@ -841,15 +609,18 @@ namespace quda
         if (verbosity >= QUDA_DEBUG_VERBOSE) printfQuda("PostTune %s\n", key.name);
         tunable.postTune();
         param = best_param;
-        tunecache[key] = best_param;
+        tuneCache()[key] = best_param;
+        TuneCache::iterator entry = tuneCache().find(key);
+        markTuneCacheUnsaved(entry);
+        if (timeline::enabled()) timeline::complete(entry->first.name, "tune", tune_start, entry->first.aux);
       }
       if (commGlobalReduction() || policyTuning()) broadcastTuneCache();
 
       // check this process is getting the key that is expected
-      if (tunecache.find(key) == tunecache.end()) {
+      if (tuneCache().find(key) == tuneCache().end()) {
         errorQuda("Failed to find key entry (%s:%s:%s)", key.name, key.volume, key.aux);
       }
-      param = tunecache[key]; // read this now for all processes
+      param = tuneCache()[key]; // read this now for all processes
 
       if (traceEnabled() >= 2) {
         TraceKey trace_entry(key, param.time);
@@ -0,0 +1,197 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <quda_internal.h>
+#include <comm_quda.h>
+#include <timeline.h>
+
+namespace quda
+{
+
+  namespace timeline
+  {
+
+    struct Event {
+      int64_t start;
+      int64_t duration; // negative for an instantaneous event
+      const char *name;
+      const char *category;
+      const char *detail;
+      int64_t arg;
+    };
+
+    struct Ring {
+      std::vector<Event> events;
+      size_t count = 0; // number of events ever recorded
+      int tid;
+#ifdef THREAD_COMMS
+      int rank; // global rank of the thread that created the ring, as the ranks of thread comms share the rings
+#endif
+    };
+
+    // construct on first use, since TimeProfile instances may record during static initialization
+    static std::mutex &registryMutex()
+    {
+      static std::mutex mutex;
+      return mutex;
+    }
+
+    static std::vector<std::unique_ptr<Ring>> &rings()
+    {
+      static std::vector<std::unique_ptr<Ring>> rings; // never freed, so events outlive their threads
+      return rings;
+    }
+
+    // steady_clock time at which the system clock was sampled, used to align ranks
+    static const int64_t epoch_steady = now();
+    static const int64_t epoch_system
+      = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+          .count();
+
+    bool init_enabled()
+    {
+      char *enable_timeline_env = getenv("QUDA_ENABLE_TIMELINE");
+      return enable_timeline_env && strcmp(enable_timeline_env, "1") == 0;
+    }
+
+    int64_t now()
+    {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+    }
+
+    const char *intern(const char *str)
+    {
+      static std::unordered_set<std::string> strings;
+      std::lock_guard<std::mutex> lock(registryMutex());
+      return strings.insert(str).first->c_str();
+    }
+
+    static Ring &ring()
+    {
+      thread_local Ring *ring = nullptr;
+      if (!ring) {
+        static size_t ring_size = 0;
+        std::lock_guard<std::mutex> lock(registryMutex());
+        if (!ring_size) {
+          char *events_env = getenv("QUDA_TIMELINE_EVENTS");
+          ring_size = events_env ? std::max(atol(events_env), 1l) : 262144;
+        }
+        rings().emplace_back(new Ring);
+        ring = rings().back().get();
+        ring->events.resize(ring_size);
+        ring->tid = rings().size() - 1;
+#ifdef THREAD_COMMS
+        ring->rank = comm_rank_global(); // a thread_local, so safe before comms are initialized
+#endif
+      }
+      return *ring;
+    }
+
+    static inline void record(const Event &event)
+    {
+      Ring &r = ring();
+      r.events[r.count++ % r.events.size()] = event;
+    }
+
+    void complete(const char *name, const char *category, int64_t start, const char *detail, int64_t arg)
+    {
+      record({start, now() - start, name, category, detail, arg});
+    }
+
+    void instant(const char *name, const char *category, const char *detail, int64_t arg)
+    {
+      record({now(), -1, name, category, detail, arg});
+    }
+
+    static void writeString(std::ostream &out, const char *str)
+    {
+      out << '"';
+      for (; *str; str++) {
+        if (*str == '"' || *str == '\\')
+          out << '\\' << *str;
+        else if (static_cast<unsigned char>(*str) >= 0x20)
+          out << *str;
+      }
+      out << '"';
+    }
+
+    void save()
+    {
+      if (!enabled()) return;
+
+      char *path = getenv("QUDA_RESOURCE_PATH");
+      const int rank = comm_rank_global();
+      std::string timeline_path = std::string(path ? path : ".") + "/timeline_" + std::to_string(rank) + ".json";
+
+      std::ofstream out(timeline_path.c_str());
+      if (!out) {
+        warningQuda("Unable to open %s", timeline_path.c_str());
+        return;
+      }
+
+      std::lock_guard<std::mutex> lock(registryMutex());
+      size_t n_events = 0;
+
+      // times are written in microseconds, with timestamps moved onto the system clock
+      auto writeTime = [&out](int64_t ns) {
+        out << ns / 1000 << '.' << std::setw(3) << std::setfill('0') << ns % 1000;
+      };
+
+      out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+      out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << rank << ",\"args\":{\"name\":\"rank " << rank
+          << "\"}}";
+      for (auto &r : rings()) {
+#ifdef THREAD_COMMS
+        if (r->rank != rank) continue;
+#endif
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << rank << ",\"tid\":" << r->tid
+            << ",\"args\":{\"name\":\"thread " << r->tid << "\"}}";
+
+        const size_t size = r->events.size();
+        const size_t begin = r->count > size ? r->count - size : 0;
+        for (size_t i = begin; i < r->count; i++) {
+          const Event &e = r->events[i % size];
+          out << ",\n{\"name\":";
+          writeString(out, e.name);
+          out << ",\"cat\":";
+          writeString(out, e.category);
+          out << (e.duration >= 0 ? ",\"ph\":\"X\",\"ts\":" : ",\"ph\":\"i\",\"s\":\"t\",\"ts\":");
+          writeTime(e.start - epoch_steady + epoch_system);
+          if (e.duration >= 0) {
+            out << ",\"dur\":";
+            writeTime(e.duration);
+          }
+          out << ",\"pid\":" << rank << ",\"tid\":" << r->tid;
+          if (e.detail || e.arg >= 0) {
+            out << ",\"args\":{";
+            if (e.detail) {
+              out << "\"detail\":";
+              writeString(out, e.detail);
+            }
+            if (e.arg >= 0) out << (e.detail ? "," : "") << "\"arg\":" << e.arg;
+            out << "}";
+          }
+          out << "}";
+        }
+        n_events += r->count - begin;
+      }
+      out << "\n]}\n";
+      out.close();
+
+      if (getVerbosity() >= QUDA_SUMMARIZE)
+        printfQuda("Saving timeline with %lu events to %s\n", n_events, timeline_path.c_str());
+    }
+
+  } // namespace timeline
+
+} // namespace quda
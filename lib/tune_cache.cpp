@@ -0,0 +1,611 @@
+/**
+ * The tunecache shared by the autotuners of all targets: lookup,
+ * the text, journal and binary formats on disk, and the distribution
+ * of the cache between ranks.  The target-specific autotuning loop
+ * lives in lib/targets/<target>/tune.cpp.
+ */
+
+#include <tune_quda.h>
+#include <tune_cache.h>
+#include <tune_cache_binary.h>
+#include <comm_quda.h>
+#include <communicator_quda.h> // for comm_broadcast_global
+#include <quda.h>     // for QUDA_VERSION_STRING
+#include <sys/stat.h> // for stat()
+#include <fcntl.h>
+#include <cfloat> // for DBL_MAX
+#include <cmath>
+#include <cctype>
+#include <ctime>
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <map>
+#include <vector>
+#include <unistd.h>
+#include <dirent.h>
+
+extern char *gitversion;
+
+namespace quda
+{
+
+  static const std::string quda_hash = QUDA_HASH; // defined in lib/Makefile
+  static std::string resource_path;
+  static TuneCache tunecache;
+  static std::vector<TuneCache::iterator> unsaved_entries; // entries tuned since the last save
+  static bool version_check = true;
+  static TuneCacheBinary tunecache_binary; // mapped tunecache.bin, if enabled
+
+#define STR_(x) #x
+#define STR(x) STR_(x)
+  static const std::string quda_version
+    = STR(QUDA_VERSION_MAJOR) "." STR(QUDA_VERSION_MINOR) "." STR(QUDA_VERSION_SUBMINOR);
+#undef STR
+#undef STR_
+
+
+  TuneCache &tuneCache() { return tunecache; }
+
+  const TuneCache &getTuneCache() { return tunecache; }
+
+  const std::string &tuneResourcePath() { return resource_path; }
+
+  void markTuneCacheUnsaved(TuneCache::iterator entry) { unsaved_entries.push_back(entry); }
+
+  TuneCache::iterator findTuneCache(const TuneKey &key)
+  {
+    TuneCache::iterator entry = tunecache.find(key);
+    if (entry == tunecache.end() && tunecache_binary.isOpen()) {
+      TuneParam param;
+      if (tunecache_binary.find(key, param)) {
+        tunecache[key] = param;
+        entry = tunecache.find(key);
+      }
+    }
+    return entry;
+  }
+
+  bool inTuneCache(const TuneKey &key) { return findTuneCache(key) != tunecache.end(); }
+
+  /**
+   * Deserialize tunecache from an istream, useful for reading a file or receiving from other nodes.  When merging,
+   * an entry that is already present is only replaced if the incoming one is faster.
+   */
+  static void deserializeTuneCache(std::istream &in, TuneCache &cache = tunecache, bool merge = false)
+  {
+    std::string line;
+    std::stringstream ls;
+
+    TuneKey key;
+    TuneParam param;
+
+    std::string v;
+    std::string n;
+    std::string a;
+
+    int check;
+
+    while (in.good()) {
+      getline(in, line);
+      if (!line.length()) continue; // skip blank lines (e.g., at end of file)
+      ls.clear();
+      ls.str(line);
+      ls >> v >> n >> a >> param.block.x >> param.block.y >> param.block.z;
+      check = snprintf(key.volume, key.volume_n, "%s", v.c_str());
+      if (check < 0 || check >= key.volume_n) errorQuda("Error writing volume string (check = %d)", check);
+      check = snprintf(key.name, key.name_n, "%s", n.c_str());
+      if (check < 0 || check >= key.name_n) errorQuda("Error writing name string (check=%d)", check);
+      check = snprintf(key.aux, key.aux_n, "%s", a.c_str());
+      if (check < 0 || check >= key.aux_n) errorQuda("Error writing aux string (check=%d)", check);
+      ls >> param.grid.x >> param.grid.y >> param.grid.z >> param.shared_bytes >> param.aux.x >> param.aux.y
+        >> param.aux.z >> param.aux.w >> param.time;
+      ls.ignore(1);               // throw away tab before comment
+      getline(ls, param.comment); // assume anything remaining on the line is a comment
+      param.comment += "\n";      // our convention is to include the newline, since ctime() likes to do this
+      key.rehash();
+      if (merge) {
+        auto entry = cache.find(key);
+        if (entry != cache.end() && entry->second.time <= param.time) continue;
+      }
+      cache[key] = param;
+    }
+  }
+
+  /**
+   * Serialize tunecache to an ostream, useful for writing to a file or sending to other nodes.
+   */
+  static void serializeTuneCache(std::ostream &out, const TuneCache &cache = tunecache)
+  {
+    TuneCache::const_iterator entry;
+
+    for (entry = cache.begin(); entry != cache.end(); entry++) {
+      TuneKey key = entry->first;
+      TuneParam param = entry->second;
+
+      out << std::setw(16) << key.volume << "\t" << key.name << "\t" << key.aux << "\t";
+      out << param.block.x << "\t" << param.block.y << "\t" << param.block.z << "\t";
+      out << param.grid.x << "\t" << param.grid.y << "\t" << param.grid.z << "\t";
+      out << param.shared_bytes << "\t" << param.aux.x << "\t" << param.aux.y << "\t" << param.aux.z << "\t"
+          << param.aux.w << "\t";
+      out << param.time << "\t" << param.comment; // param.comment ends with a newline
+    }
+  }
+
+
+  void broadcastTuneCache()
+  {
+#ifdef MULTI_GPU
+    std::stringstream serialized;
+    size_t size;
+
+    if (comm_rank_global() == 0) {
+      serializeTuneCache(serialized);
+      size = serialized.str().length();
+    }
+    comm_broadcast_global(&size, sizeof(size_t));
+
+    if (size > 0) {
+      if (comm_rank_global() == 0) {
+        comm_broadcast_global(const_cast<char *>(serialized.str().c_str()), size);
+      } else {
+        char *serstr = new char[size + 1];
+        comm_broadcast_global(serstr, size);
+        serstr[size] = '\0'; // null-terminate
+        serialized.str(serstr);
+        deserializeTuneCache(serialized);
+        delete[] serstr;
+      }
+    }
+#endif
+  }
+
+  /**
+   * Returns whether the binary tunecache (tunecache.bin) is enabled, which is set with QUDA_TUNECACHE_BINARY=1.
+   * When enabled, tunecache.bin is read in place of tunecache.tsv and compaction keeps the two in step; a
+   * tunecache.tsv updated without it should be converted with convertTuneCache().
+   */
+  static bool useBinaryTuneCache()
+  {
+    static bool init = false;
+    static bool binary = false;
+    if (!init) {
+      char *binary_env = getenv("QUDA_TUNECACHE_BINARY");
+      binary = binary_env && strcmp(binary_env, "1") == 0;
+      init = true;
+    }
+    return binary;
+  }
+
+  bool warmStart()
+  {
+    static bool init = false;
+    static bool warm_start = false;
+    if (!init) {
+      char *warm_start_env = getenv("QUDA_TUNE_WARM_START");
+      warm_start = warm_start_env && strcmp(warm_start_env, "1") == 0;
+      init = true;
+    }
+    return warm_start;
+  }
+
+  /**
+   * Returns the product of the extents in a volume string (e.g., 16x16x16x32), or zero if there are none.
+   */
+  static double keyVolume(const char *volume)
+  {
+    double product = 0.0;
+    while (*volume) {
+      if (isdigit(*volume)) {
+        char *end;
+        double extent = strtol(volume, &end, 10);
+        product = (product == 0.0 ? extent : product * extent);
+        volume = end;
+      } else {
+        volume++;
+      }
+    }
+    return product;
+  }
+
+  const TuneKey *findWarmStartSeed(const TuneKey &key, TuneParam &seed)
+  {
+    const TuneKey *seed_key = nullptr;
+    const double volume = keyVolume(key.volume);
+    if (volume == 0.0) return seed_key;
+
+    double best_distance = DBL_MAX;
+    for (TuneCache::iterator entry = tunecache.begin(); entry != tunecache.end(); entry++) {
+      if (strcmp(entry->first.name, key.name) || strcmp(entry->first.aux, key.aux)) continue;
+      const double entry_volume = keyVolume(entry->first.volume);
+      if (entry_volume == 0.0) continue;
+      const double distance = std::abs(std::log(entry_volume / volume));
+      if (distance < best_distance) {
+        best_distance = distance;
+        seed = entry->second;
+        seed_key = &entry->first;
+      }
+    }
+    return seed_key;
+  }
+
+  /**
+   * Returns the build string stamped into binary tunecache files, the counterpart of the version fields in the
+   * header of tunecache.tsv.
+   */
+  static std::string tuneCacheBuild()
+  {
+#ifdef GITVERSION
+    return quda_version + "\t" + gitversion + "\t" + quda_hash;
+#else
+    return quda_version + "\t" + quda_version + "\t" + quda_hash;
+#endif
+  }
+
+  /**
+   * Returns the directory holding the tunecache journal.  Every save appends a segment to this directory containing
+   * the entries tuned since the previous save, and compaction folds the segments back into tunecache.tsv.
+   */
+  static std::string journalPath() { return resource_path + "/tunecache.journal"; }
+
+  /**
+   * Returns the sorted list of journal segments currently on disk.  Segments are written under a temporary name and
+   * renamed into place, so only complete segments carry the ".tsv" suffix.
+   */
+  static std::vector<std::string> journalSegments()
+  {
+    std::vector<std::string> segments;
+    std::string journal_path = journalPath();
+    DIR *dir = opendir(journal_path.c_str());
+    if (!dir) return segments;
+
+    while (struct dirent *entry = readdir(dir)) {
+      std::string name(entry->d_name);
+      if (name.size() > 4 && name[0] != '.' && name.compare(name.size() - 4, 4, ".tsv") == 0)
+        segments.push_back(journal_path + "/" + name);
+    }
+    closedir(dir);
+
+    std::sort(segments.begin(), segments.end());
+    return segments;
+  }
+
+  /**
+   * Read a tunecache file (either tunecache.tsv or a journal segment) into cache, merging with any entries already
+   * present.  Returns false if the file does not exist.
+   */
+  static bool readTuneCacheFile(const std::string &cache_path, TuneCache &cache)
+  {
+    std::string line, token;
+    std::ifstream cache_file;
+    std::stringstream ls;
+
+    cache_file.open(cache_path.c_str());
+    if (!cache_file) return false;
+
+    if (!cache_file.good()) errorQuda("Bad format in %s", cache_path.c_str());
+    getline(cache_file, line);
+    ls.str(line);
+    ls >> token;
+    if (token.compare("tunecache")) errorQuda("Bad format in %s", cache_path.c_str());
+    ls >> token;
+    if (version_check && token.compare(quda_version))
+      errorQuda("Cache file %s does not match current QUDA version. \nPlease delete this file or set the "
+                "QUDA_RESOURCE_PATH environment variable to point to a new path.",
+                cache_path.c_str());
+    ls >> token;
+#ifdef GITVERSION
+    if (version_check && token.compare(gitversion))
+      errorQuda("Cache file %s does not match current QUDA version. \nPlease delete this file or set the "
+                "QUDA_RESOURCE_PATH environment variable to point to a new path.",
+                cache_path.c_str());
+#else
+    if (version_check && token.compare(quda_version))
+      errorQuda("Cache file %s does not match current QUDA version. \nPlease delete this file or set the "
+                "QUDA_RESOURCE_PATH environment variable to point to a new path.",
+                cache_path.c_str());
+#endif
+    ls >> token;
+    if (version_check && token.compare(quda_hash))
+      errorQuda("Cache file %s does not match current QUDA build. \nPlease delete this file or set the "
+                "QUDA_RESOURCE_PATH environment variable to point to a new path.",
+                cache_path.c_str());
+
+    if (!cache_file.good()) errorQuda("Bad format in %s", cache_path.c_str());
+    getline(cache_file, line); // eat the blank line
+
+    if (!cache_file.good()) errorQuda("Bad format in %s", cache_path.c_str());
+    getline(cache_file, line); // eat the description line
+
+    deserializeTuneCache(cache_file, cache, true);
+
+    cache_file.close();
+    return true;
+  }
+
+  /**
+   * Write cache to cache_path.  The file is written under a temporary name in the same directory and then renamed,
+   * so concurrent readers see either the old or the new file but never a partial one.  Returns false on failure.
+   */
+  static bool writeTuneCacheFile(const std::string &cache_path, const TuneCache &cache)
+  {
+    time_t now;
+    std::ofstream cache_file;
+    char host[64] = {};
+    gethostname(host, sizeof(host) - 1);
+    std::string tmp_path = cache_path + ".tmp." + host + "." + std::to_string(getpid());
+
+    cache_file.open(tmp_path.c_str());
+    if (!cache_file) return false;
+
+    time(&now);
+    cache_file << "tunecache\t" << quda_version;
+#ifdef GITVERSION
+    cache_file << "\t" << gitversion;
+#else
+    cache_file << "\t" << quda_version;
+#endif
+    cache_file << "\t" << quda_hash << "\t# Last updated " << ctime(&now) << std::endl;
+    cache_file << std::setw(16) << "volume"
+               << "\tname\taux\tblock.x\tblock.y\tblock.z\tgrid.x\tgrid.y\tgrid.z\tshared_bytes\taux.x\taux.y\taux."
+                  "z\taux.w\ttime\tcomment"
+               << std::endl;
+    serializeTuneCache(cache_file, cache);
+    cache_file.close();
+
+    if (cache_file.fail() || rename(tmp_path.c_str(), cache_path.c_str())) {
+      remove(tmp_path.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Fold the journal segments into tunecache.tsv (and tunecache.bin if enabled), keeping the fastest of any duplicate entries.  This is the only
+   * step that takes a lock, and only opportunistically: if another process holds the lock we leave the segments
+   * for it (or a later save) to compact, and since the segments are loaded alongside tunecache.tsv no entries are
+   * lost in the meantime.  The new tunecache.tsv is renamed into place before the segments it absorbed are removed.
+   */
+  static void compactTuneCache()
+  {
+    std::string lock_path = resource_path + "/tunecache.lock";
+    int lock_handle = open(lock_path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666);
+    if (lock_handle == -1) {
+      // a lock held across this many saves was most likely left behind by a process that died while compacting
+      constexpr size_t stale_lock_segments = 8;
+      size_t n_segments = journalSegments().size();
+      if (n_segments > stale_lock_segments)
+        warningQuda("%s has been held while %lu tunecache journal segments accumulated: if no instances of "
+                    "applications using QUDA are running, it is stale and safe to delete",
+                    lock_path.c_str(), n_segments);
+      else if (getVerbosity() >= QUDA_VERBOSE)
+        printfQuda("Skipping tunecache compaction since %s is held by another process\n", lock_path.c_str());
+      return;
+    }
+    char msg[] = "If no instances of applications using QUDA are running,\n"
+                 "this lock file shouldn't be here and is safe to delete.";
+    int stat = write(lock_handle, msg, sizeof(msg)); // check status to avoid compiler warning
+    if (stat == -1) warningQuda("Unable to write to lock file for some bizarre reason");
+
+    std::string cache_path = resource_path + "/tunecache.tsv";
+    std::string binary_path = resource_path + "/tunecache.bin";
+    std::vector<std::string> segments = journalSegments();
+
+    TuneCache merged;
+    readTuneCacheFile(cache_path, merged);
+    if (useBinaryTuneCache()) {
+      TuneCacheBinary binary;
+      if (binary.open(binary_path, version_check ? tuneCacheBuild() : "")) binary.read(merged);
+    }
+    for (auto &segment : segments) readTuneCacheFile(segment, merged);
+
+    bool written = writeTuneCacheFile(cache_path, merged);
+    if (written && useBinaryTuneCache()) written = writeTuneCacheBinary(binary_path, merged, tuneCacheBuild());
+
+    if (written) {
+      for (auto &segment : segments) remove(segment.c_str());
+      if (getVerbosity() >= QUDA_SUMMARIZE)
+        printfQuda("Compacted %d journal segments into %d sets of cached parameters in %s\n",
+                   static_cast<int>(segments.size()), static_cast<int>(merged.size()), cache_path.c_str());
+    } else {
+      warningQuda("Unable to write %s; the tunecache journal will be compacted later", cache_path.c_str());
+    }
+
+    // Release lock.
+    close(lock_handle);
+    remove(lock_path.c_str());
+  }
+
+  /*
+   * Read tunecache from disk.
+   */
+  void loadTuneCache()
+  {
+    if (getTuning() == QUDA_TUNE_NO) {
+      warningQuda("Autotuning disabled");
+      return;
+    }
+
+    char *path;
+    struct stat pstat;
+    std::string cache_path;
+
+    path = getenv("QUDA_RESOURCE_PATH");
+
+    if (!path) {
+      warningQuda("Environment variable QUDA_RESOURCE_PATH is not set.");
+      warningQuda("Caching of tuned parameters will be disabled.");
+      return;
+    } else if (stat(path, &pstat) || !S_ISDIR(pstat.st_mode)) {
+      warningQuda("The path \"%s\" specified by QUDA_RESOURCE_PATH does not exist or is not a directory.", path);
+      warningQuda("Caching of tuned parameters will be disabled.");
+      return;
+    } else {
+      resource_path = path;
+    }
+
+    char *override_version_env = getenv("QUDA_TUNE_VERSION_CHECK");
+    if (override_version_env && strcmp(override_version_env, "0") == 0) {
+      version_check = false;
+      warningQuda("Disabling QUDA tunecache version check");
+    }
+
+    // with the binary tunecache every rank maps tunecache.bin, and rank 0 only has to parse and distribute the
+    // journal rather than the whole cache
+    std::string binary_path = resource_path + "/tunecache.bin";
+    bool binary = false;
+
+#ifdef MULTI_GPU
+    if (comm_rank_global() == 0) {
+#endif
+
+      if (useBinaryTuneCache()) binary = tunecache_binary.open(binary_path, version_check ? tuneCacheBuild() : "");
+
+      cache_path = resource_path;
+      cache_path += "/tunecache.tsv";
+
+      // list the journal before reading tunecache.tsv: a segment that is compacted away in between will have been
+      // folded into a tunecache.tsv that we then re-read
+      std::vector<std::string> segments = journalSegments();
+      bool found = binary || readTuneCacheFile(cache_path, tunecache);
+      bool compacted = false;
+      int n_segments = 0;
+      for (auto &segment : segments) {
+        if (readTuneCacheFile(segment, tunecache))
+          n_segments++;
+        else
+          compacted = true;
+      }
+      if (compacted) found = readTuneCacheFile(cache_path, tunecache) || found;
+
+      if (found || n_segments > 0) {
+        if (getVerbosity() >= QUDA_SUMMARIZE) {
+          if (binary)
+            printfQuda("Mapped %d sets of cached parameters from %s and loaded %d journal segments\n",
+                       static_cast<int>(tunecache_binary.size()), binary_path.c_str(), n_segments);
+          else
+            printfQuda("Loaded %d sets of cached parameters from %s and %d journal segments\n",
+                       static_cast<int>(tunecache.size()), cache_path.c_str(), n_segments);
+        }
+      } else {
+        warningQuda("Cache file not found.  All kernels will be re-tuned (if tuning is enabled).");
+      }
+
+#ifdef MULTI_GPU
+    }
+
+    comm_broadcast_global(&binary, sizeof(bool));
+    if (binary && comm_rank_global() != 0 && !tunecache_binary.open(binary_path, version_check ? tuneCacheBuild() : ""))
+      errorQuda("Unable to map %s", binary_path.c_str());
+#endif
+
+    broadcastTuneCache();
+  }
+
+  /**
+   * Write tunecache to disk.
+   */
+  void saveTuneCache(bool error)
+  {
+    if (resource_path.empty()) return;
+
+      // FIXME: We should really check to see if any nodes have tuned a kernel that was not also tuned on node 0, since as things
+      //       stand, the corresponding launch parameters would never get cached to disk in this situation.  This will come up if we
+      //       ever support different subvolumes per GPU (as might be convenient for lattice volumes that don't divide evenly).
+
+#ifdef MULTI_GPU
+    if (comm_rank_global() == 0) {
+#endif
+
+      if (error) {
+        // dump everything we have for post-mortem inspection
+        std::string cache_path = resource_path + "/tunecache_error.tsv";
+        if (getVerbosity() >= QUDA_SUMMARIZE) {
+          printfQuda("Saving %d sets of cached parameters to %s\n", static_cast<int>(tunecache.size()),
+                     cache_path.c_str());
+        }
+        if (!writeTuneCacheFile(cache_path, tunecache)) warningQuda("Unable to write %s", cache_path.c_str());
+      }
+
+      if (unsaved_entries.empty()) return;
+
+      // append the entries tuned since the last save to the journal as a new segment, which is lock free since
+      // every process writes its own uniquely named segment
+      std::string journal_path = journalPath();
+      if (mkdir(journal_path.c_str(), 0777) && errno != EEXIST) {
+        warningQuda("Unable to create %s.  Tuned launch parameters will not be cached to disk.", journal_path.c_str());
+        return;
+      }
+
+      static int segment_count = 0;
+      char host[64] = {};
+      gethostname(host, sizeof(host) - 1);
+      std::string segment_path = journal_path + "/" + host + "." + std::to_string(getpid()) + "."
+        + std::to_string(segment_count++) + ".tsv";
+
+      TuneCache segment;
+      for (auto &entry : unsaved_entries) segment[entry->first] = entry->second;
+
+      if (getVerbosity() >= QUDA_SUMMARIZE) {
+        printfQuda("Saving %d sets of cached parameters to %s\n", static_cast<int>(segment.size()), segment_path.c_str());
+      }
+
+      if (!writeTuneCacheFile(segment_path, segment)) {
+        warningQuda("Unable to write %s.  Tuned launch parameters will not be cached to disk.", segment_path.c_str());
+        return;
+      }
+      unsaved_entries.clear();
+
+      compactTuneCache();
+
+#ifdef MULTI_GPU
+    } else {
+      // give process 0 time to write out its tunecache if needed, but
+      // doesn't cause a hang if error is not triggered on process 0
+      if (error) sleep(10);
+    }
+#endif
+  }
+
+  void convertTuneCache(const std::string &in_path, const std::string &out_path)
+  {
+    auto is_binary = [](const std::string &path) {
+      return path.size() > 4 && path.compare(path.size() - 4, 4, ".bin") == 0;
+    };
+
+    TuneCache cache;
+    bool found;
+    if (is_binary(in_path)) {
+      TuneCacheBinary binary;
+      found = binary.open(in_path, version_check ? tuneCacheBuild() : "");
+      if (found) binary.read(cache);
+    } else {
+      found = readTuneCacheFile(in_path, cache);
+    }
+    if (!found) errorQuda("Unable to read %s", in_path.c_str());
+
+    bool written = is_binary(out_path) ? writeTuneCacheBinary(out_path, cache, tuneCacheBuild()) :
+                                         writeTuneCacheFile(out_path, cache);
+    if (!written) errorQuda("Unable to write %s", out_path.c_str());
+
+    if (getVerbosity() >= QUDA_SUMMARIZE)
+      printfQuda("Converted %d sets of cached parameters from %s to %s\n", static_cast<int>(cache.size()),
+                 in_path.c_str(), out_path.c_str());
+  }
+
+  static std::map<TuneKey, bool> host_launch_reported;
+
+  void reportHostLaunch(const Tunable &tunable, double time, QudaVerbosity verbosity)
+  {
+    if (verbosity < QUDA_VERBOSE || activeTuning() || time <= 0.0) return;
+
+    const TuneKey key = tunable.tuneKey();
+    if (verbosity < QUDA_DEBUG_VERBOSE && host_launch_reported.find(key) != host_launch_reported.end()) return;
+    host_launch_reported[key] = true;
+
+    printfQuda("Host launch giving %s for %s with %s\n", tunable.perfString(time).c_str(), key.name, key.aux);
+  }
+
+} // namespace quda
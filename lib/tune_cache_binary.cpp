@@ -0,0 +1,214 @@
+#include <tune_cache_binary.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace quda
+{
+
+  // bump this whenever the layout below or the TuneKey digest changes
+  static constexpr uint32_t binary_format = 1;
+  static constexpr char binary_magic[8] = {'Q', 'U', 'D', 'A', 'T', 'U', 'N', 'E'};
+
+  struct BinaryHeader {
+    char magic[8];
+    uint32_t format;
+    uint32_t record_bytes;
+    uint64_t n_records;
+    uint64_t record_offset;
+    uint64_t index_offset;
+    char build[1024];
+  };
+
+  struct BinaryRecord {
+    static constexpr int comment_n = 256;
+    char volume[TuneKey::volume_n];
+    char name[TuneKey::name_n];
+    char aux[TuneKey::aux_n];
+    uint64_t digest;
+    int32_t block[3];
+    int32_t grid[3];
+    int32_t shared_bytes;
+    int32_t param_aux[4];
+    float time;
+    char comment[comment_n]; // truncated if need be, always ending in a newline
+  };
+
+  struct BinaryIndex {
+    uint64_t digest;
+    uint64_t record;
+    bool operator<(const BinaryIndex &other) const
+    {
+      return digest < other.digest || (digest == other.digest && record < other.record);
+    }
+  };
+
+  static_assert(sizeof(BinaryHeader) % 8 == 0, "BinaryHeader must be 8-byte padded");
+  static_assert(sizeof(BinaryRecord) % 8 == 0, "BinaryRecord must be 8-byte padded");
+
+  static const BinaryHeader &header(const char *data) { return *reinterpret_cast<const BinaryHeader *>(data); }
+
+  static const BinaryRecord *records(const char *data)
+  {
+    return reinterpret_cast<const BinaryRecord *>(data + header(data).record_offset);
+  }
+
+  static const BinaryIndex *index(const char *data)
+  {
+    return reinterpret_cast<const BinaryIndex *>(data + header(data).index_offset);
+  }
+
+  static void recordToParam(const BinaryRecord &record, TuneParam &param)
+  {
+    param.block = dim3(record.block[0], record.block[1], record.block[2]);
+    param.grid = dim3(record.grid[0], record.grid[1], record.grid[2]);
+    param.shared_bytes = record.shared_bytes;
+    param.aux = make_int4(record.param_aux[0], record.param_aux[1], record.param_aux[2], record.param_aux[3]);
+    param.time = record.time;
+    param.comment = record.comment;
+    param.n_calls = 0;
+  }
+
+  bool TuneCacheBinary::open(const std::string &path, const std::string &build)
+  {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) return false;
+
+    struct stat pstat;
+    if (fstat(fd, &pstat) || static_cast<size_t>(pstat.st_size) < sizeof(BinaryHeader)) {
+      ::close(fd);
+      errorQuda("Bad format in %s", path.c_str());
+    }
+    bytes = pstat.st_size;
+
+    void *map = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping persists after closing the descriptor
+    if (map == MAP_FAILED) errorQuda("Unable to map %s", path.c_str());
+    data = static_cast<const char *>(map);
+
+    const BinaryHeader &h = header(data);
+    if (memcmp(h.magic, binary_magic, sizeof(binary_magic)) || h.format != binary_format
+        || h.record_bytes != sizeof(BinaryRecord) || h.record_offset + h.n_records * sizeof(BinaryRecord) > bytes
+        || h.index_offset + h.n_records * sizeof(BinaryIndex) > bytes)
+      errorQuda("Bad format in %s", path.c_str());
+
+    if (!build.empty() && strncmp(h.build, build.c_str(), sizeof(h.build)))
+      errorQuda("Cache file %s does not match current QUDA build. \nPlease delete this file or set the "
+                "QUDA_RESOURCE_PATH environment variable to point to a new path.",
+                path.c_str());
+
+    return true;
+  }
+
+  void TuneCacheBinary::close()
+  {
+    if (data) munmap(const_cast<char *>(data), bytes);
+    data = nullptr;
+    bytes = 0;
+  }
+
+  size_t TuneCacheBinary::size() const { return data ? header(data).n_records : 0; }
+
+  bool TuneCacheBinary::find(const TuneKey &key, TuneParam &param) const
+  {
+    if (!data) return false;
+
+    const BinaryIndex *begin = index(data);
+    const BinaryIndex *end = begin + header(data).n_records;
+    const BinaryIndex *entry = std::lower_bound(begin, end, BinaryIndex {key.digest, 0});
+
+    for (; entry != end && entry->digest == key.digest; entry++) {
+      const BinaryRecord &record = records(data)[entry->record];
+      if (strcmp(record.aux, key.aux) == 0 && strcmp(record.name, key.name) == 0
+          && strcmp(record.volume, key.volume) == 0) {
+        recordToParam(record, param);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void TuneCacheBinary::read(TuneCache &cache) const
+  {
+    TuneParam param;
+    for (size_t i = 0; i < size(); i++) {
+      const BinaryRecord &record = records(data)[i];
+      TuneKey key(record.volume, record.name, record.aux);
+      auto entry = cache.find(key);
+      if (entry != cache.end() && entry->second.time <= record.time) continue;
+      recordToParam(record, param);
+      cache[key] = param;
+    }
+  }
+
+  bool writeTuneCacheBinary(const std::string &path, const TuneCache &cache, const std::string &build)
+  {
+    BinaryHeader h = {};
+    memcpy(h.magic, binary_magic, sizeof(binary_magic));
+    h.format = binary_format;
+    h.record_bytes = sizeof(BinaryRecord);
+    h.n_records = cache.size();
+    h.record_offset = sizeof(BinaryHeader);
+    h.index_offset = h.record_offset + h.n_records * sizeof(BinaryRecord);
+    if (build.size() >= sizeof(h.build)) {
+      warningQuda("Build string too long for the binary tunecache");
+      return false;
+    }
+    strcpy(h.build, build.c_str());
+
+    std::vector<BinaryRecord> record(cache.size());
+    std::vector<BinaryIndex> idx(cache.size());
+    size_t i = 0;
+    for (auto entry = cache.begin(); entry != cache.end(); entry++, i++) {
+      const TuneKey &key = entry->first;
+      const TuneParam &param = entry->second;
+      BinaryRecord &r = record[i];
+      memset(&r, 0, sizeof(r));
+      strcpy(r.volume, key.volume);
+      strcpy(r.name, key.name);
+      strcpy(r.aux, key.aux);
+      r.digest = key.digest;
+      r.block[0] = param.block.x;
+      r.block[1] = param.block.y;
+      r.block[2] = param.block.z;
+      r.grid[0] = param.grid.x;
+      r.grid[1] = param.grid.y;
+      r.grid[2] = param.grid.z;
+      r.shared_bytes = param.shared_bytes;
+      r.param_aux[0] = param.aux.x;
+      r.param_aux[1] = param.aux.y;
+      r.param_aux[2] = param.aux.z;
+      r.param_aux[3] = param.aux.w;
+      r.time = param.time;
+      strncpy(r.comment, param.comment.c_str(), BinaryRecord::comment_n - 1);
+      if (param.comment.size() >= BinaryRecord::comment_n - 1) r.comment[BinaryRecord::comment_n - 2] = '\n';
+      idx[i] = {key.digest, i};
+    }
+    std::sort(idx.begin(), idx.end());
+
+    char host[64] = {};
+    gethostname(host, sizeof(host) - 1);
+    std::string tmp_path = path + ".tmp." + host + "." + std::to_string(getpid());
+
+    std::ofstream file(tmp_path.c_str(), std::ios::binary);
+    if (!file) return false;
+    file.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    file.write(reinterpret_cast<const char *>(record.data()), record.size() * sizeof(BinaryRecord));
+    file.write(reinterpret_cast<const char *>(idx.data()), idx.size() * sizeof(BinaryIndex));
+    file.close();
+
+    if (file.fail() || rename(tmp_path.c_str(), path.c_str())) {
+      remove(tmp_path.c_str());
+      return false;
+    }
+    return true;
+  }
+
+} // namespace quda
@@ -0,0 +1,146 @@
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <alloc_tracker.h>
+
+#include <gtest/gtest.h>
+
+/**
+   @file alloc_tracker_test.cpp
+
+   Tests of the registry of live allocations shared by the target
+   allocators: insertion and erasure (including the backward shift
+   of the probe chains), the type checks, and the byte counters and
+   their high-water marks under concurrent threads.
+ */
+
+using namespace quda;
+
+/** fake page-aligned addresses, which is the worst case for the hash */
+static void *address(int thread, int i)
+{
+  return reinterpret_cast<void *>((static_cast<uintptr_t>(thread + 1) << 40) + (static_cast<uintptr_t>(i) << 12));
+}
+
+static MemAlloc record(size_t size, int line)
+{
+  MemAlloc a(__func__, __FILE__, line);
+  a.size = size;
+  a.base_size = size;
+  return a;
+}
+
+TEST(alloc_tracker, insert_erase)
+{
+  AllocTracker alloc;
+  const int n = 20000;
+  EXPECT_TRUE(alloc.empty(HOST));
+  EXPECT_EQ(alloc.find(address(0, 0)), N_ALLOC_TYPE);
+  EXPECT_FALSE(alloc.erase(HOST, address(0, 0)));
+
+  for (int i = 0; i < n; i++) alloc.insert(i % 2 ? HOST : PINNED, address(0, i), record(100 + i, i));
+  EXPECT_FALSE(alloc.empty(HOST));
+  EXPECT_FALSE(alloc.empty(PINNED));
+  EXPECT_TRUE(alloc.empty(DEVICE));
+
+  // an allocation is only erased as the type it was made with
+  EXPECT_FALSE(alloc.erase(HOST, address(0, 0)));
+  EXPECT_FALSE(alloc.erase(DEVICE, address(0, 1)));
+
+  // erase every third entry, which exercises the backward shift of the probe chains
+  for (int i = 0; i < n; i += 3) {
+    MemAlloc a;
+    ASSERT_TRUE(alloc.erase(i % 2 ? HOST : PINNED, address(0, i), &a)) << "entry " << i;
+    EXPECT_EQ(a.size, 100u + i);
+    EXPECT_EQ(a.line, i);
+  }
+  for (int i = 0; i < n; i++) {
+    AllocType type = i % 3 == 0 ? N_ALLOC_TYPE : (i % 2 ? HOST : PINNED);
+    ASSERT_EQ(alloc.find(address(0, i)), type) << "entry " << i;
+  }
+
+  // entries are listed by address
+  auto host = alloc.entries(HOST);
+  size_t n_host = 0;
+  for (int i = 1; i < n; i += 2) n_host += i % 3 != 0;
+  ASSERT_EQ(host.size(), n_host);
+  for (size_t i = 1; i < host.size(); i++) EXPECT_LT(host[i - 1].first, host[i].first);
+  EXPECT_EQ(host[0].second.size, 101u);
+
+  // an address can be reused once it has been erased
+  alloc.insert(DEVICE, address(0, 0), record(7, 0));
+  EXPECT_EQ(alloc.find(address(0, 0)), DEVICE);
+
+  for (int i = 0; i < n; i++) alloc.erase(i % 2 ? HOST : PINNED, address(0, i));
+  EXPECT_TRUE(alloc.empty(HOST));
+  EXPECT_TRUE(alloc.empty(PINNED));
+  EXPECT_TRUE(alloc.erase(DEVICE, address(0, 0)));
+  EXPECT_TRUE(alloc.empty(DEVICE));
+}
+
+TEST(alloc_tracker, peaks)
+{
+  AllocTracker alloc;
+  alloc.insert(DEVICE, address(0, 0), record(1000, 0));
+  alloc.insert(HOST, address(0, 1), record(100, 0));
+  alloc.insert(PINNED, address(0, 2), record(10, 0));
+  alloc.insert(MAPPED, address(0, 3), record(1, 0));
+  alloc.erase(HOST, address(0, 1));
+  alloc.insert(HOST, address(0, 4), record(50, 0));
+
+  EXPECT_EQ(alloc.peak(DEVICE), 1000);
+  EXPECT_EQ(alloc.peak(HOST), 100);
+  EXPECT_EQ(alloc.peak(PINNED), 10);
+  EXPECT_EQ(alloc.peak(MAPPED), 1);
+
+  // device memory is not host memory, while pinned and mapped memory are both
+  EXPECT_EQ(alloc.peak_host(), 111);
+  EXPECT_EQ(alloc.peak_pinned(), 11);
+}
+
+TEST(alloc_tracker, threads)
+{
+  AllocTracker alloc;
+  const int n_thread = 8;
+  const int n_iter = 20000;
+  const int n_live = 64;
+  const size_t size = 256;
+
+  // each thread keeps a window of live allocations, freeing the oldest as it goes
+  std::vector<std::thread> threads;
+  std::vector<int> errors(n_thread, 0);
+  for (int t = 0; t < n_thread; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < n_iter; i++) {
+        alloc.insert(HOST, address(t, i), record(size, i));
+        if (alloc.find(address(t, i)) != HOST) errors[t]++;
+        if (i >= n_live) {
+          MemAlloc a;
+          if (!alloc.erase(HOST, address(t, i - n_live), &a) || a.line != i - n_live) errors[t]++;
+        }
+      }
+      for (int i = n_iter - n_live; i < n_iter; i++)
+        if (!alloc.erase(HOST, address(t, i))) errors[t]++;
+    });
+  }
+  for (auto &thread : threads) thread.join();
+
+  for (int t = 0; t < n_thread; t++) EXPECT_EQ(errors[t], 0) << "thread " << t;
+  EXPECT_TRUE(alloc.empty(HOST));
+  EXPECT_TRUE(alloc.entries(HOST).empty());
+
+  // the high-water marks lie between one thread's window and all of
+  // them at once; the per-type and host totals are separate counters,
+  // so under concurrency their peaks need not be identical
+  for (long peak : {alloc.peak(HOST), alloc.peak_host()}) {
+    EXPECT_GE(peak, static_cast<long>((n_live + 1) * size));
+    EXPECT_LE(peak, static_cast<long>(n_thread * (n_live + 1) * size));
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
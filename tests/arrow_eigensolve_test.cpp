@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <complex>
+#include <random>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include <quda_internal.h>
+#include <arrow_eigensolve.h>
+#include <comm_quda.h>
+
+#include <gtest/gtest.h>
+
+/**
+   @file arrow_eigensolve_test.cpp
+
+   Tests of the structured arrow matrix eigensolver used by the thick
+   restarted Lanczos solvers against a dense Eigen solve, for plain
+   tridiagonal matrices, arrows with zero entries and a repeated
+   diagonal (where the secular equation deflates), and the trailing
+   window left after some eigenpairs are locked.
+ */
+
+using namespace quda;
+
+static int rank_from_coords(const int *coords, void *fdata)
+{
+  auto dims = static_cast<int *>(fdata);
+  int rank = coords[3];
+  for (int i = 2; i >= 0; i--) rank = dims[i] * rank + coords[i];
+  return rank;
+}
+
+static double conjugate(double x) { return x; }
+static Complex conjugate(const Complex &x) { return std::conj(x); }
+
+template <typename T> using Matrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+
+/** @brief Form the dense Hermitian matrix described by diag, off and arrow_pos */
+template <typename T>
+static Matrix<T> dense_arrow(const std::vector<double> &diag, const std::vector<T> &off, int arrow_pos)
+{
+  const int dim = diag.size();
+  Matrix<T> A = Matrix<T>::Zero(dim, dim);
+  for (int i = 0; i < dim; i++) A(i, i) = diag[i];
+  for (int i = 0; i < dim - 1; i++) {
+    int row = i < arrow_pos ? arrow_pos : i + 1;
+    A(row, i) = off[i];
+    A(i, row) = conjugate(off[i]);
+  }
+  return A;
+}
+
+/**
+   @brief Solve with arrowEigensolve and check the eigenvalues against
+   a dense solve, and the eigenvectors for orthonormality and their
+   residuals (which, unlike the vectors themselves, are unique when
+   eigenvalues are repeated)
+ */
+template <typename T> static void check(const std::vector<double> &diag, const std::vector<T> &off, int arrow_pos)
+{
+  const int dim = diag.size();
+  Matrix<T> A = dense_arrow(diag, off, arrow_pos);
+  const double norm = A.norm();
+  const double tol = 1e-12 * dim * norm;
+
+  std::vector<double> evals;
+  std::vector<T> evecs;
+  arrowEigensolve(evals, evecs, diag, off, arrow_pos);
+  ASSERT_EQ(evals.size(), static_cast<size_t>(dim));
+  ASSERT_EQ(evecs.size(), static_cast<size_t>(dim * dim));
+
+  Eigen::SelfAdjointEigenSolver<Matrix<T>> eigen(A);
+  for (int i = 0; i < dim; i++) EXPECT_NEAR(evals[i], eigen.eigenvalues()[i], tol) << "eigenvalue " << i;
+  EXPECT_TRUE(std::is_sorted(evals.begin(), evals.end()));
+
+  Eigen::Map<const Matrix<T>> V(evecs.data(), dim, dim);
+  EXPECT_LT((V.adjoint() * V - Matrix<T>::Identity(dim, dim)).norm(), tol / norm);
+  for (int i = 0; i < dim; i++)
+    EXPECT_LT((A * V.col(i) - evals[i] * V.col(i)).norm(), tol) << "eigenvector " << i;
+}
+
+static void random_entry(double &x, std::mt19937 &rng) { x = std::normal_distribution<double>()(rng); }
+
+static void random_entry(Complex &x, std::mt19937 &rng)
+{
+  std::normal_distribution<double> normal;
+  double re = normal(rng);
+  x = Complex(re, normal(rng));
+}
+
+template <typename T> struct ArrowEigensolve : public ::testing::Test {
+  std::mt19937 rng {1234};
+
+  std::vector<double> random_diag(int dim)
+  {
+    std::vector<double> diag(dim);
+    for (auto &d : diag) random_entry(d, rng);
+    return diag;
+  }
+
+  std::vector<T> random_off(int dim)
+  {
+    std::vector<T> off(dim - 1);
+    for (auto &o : off) random_entry(o, rng);
+    return off;
+  }
+};
+
+using Types = ::testing::Types<double, Complex>;
+TYPED_TEST_SUITE(ArrowEigensolve, Types);
+
+TYPED_TEST(ArrowEigensolve, tridiagonal)
+{
+  for (int dim : {1, 2, 7, 64}) check(this->random_diag(dim), this->random_off(dim), 0);
+}
+
+TYPED_TEST(ArrowEigensolve, arrow)
+{
+  const int dim = 48;
+  for (int arrow_pos : {1, 16, dim - 2, dim - 1}) check(this->random_diag(dim), this->random_off(dim), arrow_pos);
+}
+
+TYPED_TEST(ArrowEigensolve, zero_arrow_entries)
+{
+  // the rows with a zero arrow entry decouple, leaving their diagonal entries as eigenvalues
+  const int dim = 40, arrow_pos = 20;
+  auto diag = this->random_diag(dim);
+  auto off = this->random_off(dim);
+  for (int i = 0; i < arrow_pos; i += 3) off[i] = 0.0;
+  check(diag, off, arrow_pos);
+
+  // as does everything below a zero in the tridiagonal tail
+  off[arrow_pos + 5] = 0.0;
+  check(diag, off, arrow_pos);
+
+  // and with no arrow at all the head is diagonal
+  for (int i = 0; i < arrow_pos; i++) off[i] = 0.0;
+  check(diag, off, arrow_pos);
+}
+
+TYPED_TEST(ArrowEigensolve, repeated_diagonal)
+{
+  // the kept Ritz values of a restart may coincide, giving repeated poles of the secular equation
+  const int dim = 40, arrow_pos = 20;
+  auto diag = this->random_diag(dim);
+  auto off = this->random_off(dim);
+  for (int i = 0; i < arrow_pos; i++) diag[i] = i < arrow_pos / 2 ? 1.0 : diag[i % 4];
+  check(diag, off, arrow_pos);
+
+  // and may also coincide with the eigenvalues of the tail
+  std::fill(diag.begin(), diag.end(), 0.5);
+  check(diag, off, arrow_pos);
+}
+
+TYPED_TEST(ArrowEigensolve, locked)
+{
+  // the window the thick restarted Lanczos solver passes once num_locked eigenpairs have converged
+  const int n_kr = 64, num_keep = 24;
+  auto alpha = this->random_diag(n_kr);
+  auto beta = this->random_off(n_kr + 1);
+  for (int num_locked : {1, 8, num_keep - 1}) {
+    std::vector<double> diag(alpha.begin() + num_locked, alpha.begin() + n_kr);
+    std::vector<TypeParam> off(beta.begin() + num_locked, beta.begin() + n_kr - 1);
+    check(diag, off, num_keep - num_locked);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+
+  int dims[4] = {1, 1, 1, 1};
+  comm_init(4, dims, rank_from_coords, dims);
+  setVerbosity(QUDA_SILENT);
+
+  int result = RUN_ALL_TESTS();
+
+  comm_finalize();
+  return result;
+}
@@ -0,0 +1,105 @@
+#include <complex>
+#include <random>
+#include <vector>
+
+#include <quda_internal.h>
+#include <blas_lapack.h>
+#include <comm_quda.h>
+
+#include <gtest/gtest.h>
+
+/**
+   @file batch_invert_test.cpp
+
+   Tests of the host batched matrix inversion: each matrix size with a
+   size-specialized Gauss-Jordan kernel, and a size that falls back to
+   Eigen, for matrices that do and do not need row interchanges.
+ */
+
+using namespace quda;
+
+static int rank_from_coords(const int *coords, void *fdata)
+{
+  auto dims = static_cast<int *>(fdata);
+  int rank = coords[3];
+  for (int i = 2; i >= 0; i--) rank = dims[i] * rank + coords[i];
+  return rank;
+}
+
+/**
+   @brief Fill a batch of column-major n x n matrices: a diagonally
+   dominant one, one with a zero diagonal so that every elimination
+   step must pivot, and a scaled reversal permutation
+ */
+template <typename Float> static std::vector<std::complex<Float>> make_batch(int n)
+{
+  std::mt19937 rng(1234 + n);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  auto random = [&]() { return std::complex<Float>(uniform(rng), uniform(rng)); };
+
+  std::vector<std::complex<Float>> A(3 * n * n);
+  for (int j = 0; j < n; j++)
+    for (int i = 0; i < n; i++) {
+      A[j * n + i] = random() + (i == j ? static_cast<Float>(n) : static_cast<Float>(0.0));
+      A[n * n + j * n + i] = i == j ? static_cast<Float>(0.0) : random();
+      A[2 * n * n + j * n + i] = i + j == n - 1 ? std::complex<Float>(1.0 + i, 0.5 * j) : static_cast<Float>(0.0);
+    }
+  return A;
+}
+
+/** @return max |A Ainv - I| over the entries of matrix b of the batch */
+template <typename Float>
+static double identity_error(const std::vector<std::complex<Float>> &A, const std::vector<std::complex<Float>> &Ainv,
+                             int n, int b)
+{
+  const std::complex<Float> *a = A.data() + b * n * n;
+  const std::complex<Float> *ainv = Ainv.data() + b * n * n;
+  double error = 0.0;
+  for (int j = 0; j < n; j++)
+    for (int i = 0; i < n; i++) {
+      std::complex<double> sum = 0.0;
+      for (int k = 0; k < n; k++)
+        sum += std::complex<double>(a[k * n + i]) * std::complex<double>(ainv[j * n + k]);
+      error = std::max(error, std::abs(sum - (i == j ? 1.0 : 0.0)));
+    }
+  return error;
+}
+
+template <typename Float> static void test_invert(int n, QudaPrecision precision, double tol)
+{
+  auto A = make_batch<Float>(n);
+  const auto A_copy = A;
+  std::vector<std::complex<Float>> Ainv(A.size());
+  blas_lapack::generic::BatchInvertMatrix(Ainv.data(), A.data(), n, 3, precision, QUDA_CPU_FIELD_LOCATION);
+
+  // the input is left intact
+  for (size_t i = 0; i < A.size(); i++) ASSERT_EQ(A[i], A_copy[i]) << "element " << i;
+
+  const char *name[] = {"diagonally dominant", "zero diagonal", "reversal"};
+  for (int b = 0; b < 3; b++) EXPECT_LT(identity_error(A, Ainv, n, b), tol) << name[b] << " matrix, n = " << n;
+}
+
+// the sizes with a specialized kernel, and one without
+class BatchInvert : public ::testing::TestWithParam<int>
+{
+};
+
+TEST_P(BatchInvert, double) { test_invert<double>(GetParam(), QUDA_DOUBLE_PRECISION, 1e-10); }
+
+TEST_P(BatchInvert, single) { test_invert<float>(GetParam(), QUDA_SINGLE_PRECISION, 1e-3); }
+
+INSTANTIATE_TEST_SUITE_P(sizes, BatchInvert, ::testing::Values(12, 24, 32, 48, 64, 96, 128, 192, 20));
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+
+  int dims[4] = {1, 1, 1, 1};
+  comm_init(4, dims, rank_from_coords, dims);
+  setVerbosity(QUDA_SILENT);
+
+  int result = RUN_ALL_TESTS();
+
+  comm_finalize();
+  return result;
+}
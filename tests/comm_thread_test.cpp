@@ -0,0 +1,231 @@
+#include <vector>
+
+#include <quda_internal.h>
+#include <comm_quda.h>
+#include <communicator_quda.h>
+#include <blas_quda.h>
+
+#include <gtest/gtest.h>
+
+/**
+   @file comm_thread_test.cpp
+
+   Tests of the in-process communicator, where each rank is a thread
+   started with comm_thread_launch(): halo exchange between
+   neighboring ranks, global reductions (blocking and asynchronous)
+   and communicator splits.
+ */
+
+using namespace quda;
+
+static int rank_from_coords(const int *coords, void *fdata)
+{
+  auto dims = static_cast<int *>(fdata);
+  int rank = coords[3];
+  for (int i = 2; i >= 0; i--) rank = dims[i] * rank + coords[i];
+  return rank;
+}
+
+/**
+   @brief Run body on each rank of a (1, 1, 2, 2) grid of threads,
+   with the communicator initialized for the duration of the call
+ */
+static void run_ranks(const std::function<void(int)> &body)
+{
+  comm_thread_launch(4, [&body](int rank) {
+    int dims[4] = {1, 1, 2, 2};
+    comm_init(4, dims, rank_from_coords, dims);
+    body(rank);
+    comm_finalize();
+  });
+}
+
+TEST(comm_thread, world)
+{
+  // the main thread was not started by comm_thread_launch, so it forms a world of its own
+  int dims[4] = {1, 1, 1, 1};
+  comm_init(4, dims, rank_from_coords, dims);
+  EXPECT_EQ(comm_size(), 1);
+  EXPECT_EQ(comm_rank(), 0);
+  comm_finalize();
+
+  std::vector<int> seen(4, 0);
+  run_ranks([&seen](int rank) {
+    EXPECT_EQ(comm_size(), 4);
+    EXPECT_EQ(comm_rank(), rank);
+    EXPECT_EQ(comm_rank_global(), rank);
+    EXPECT_EQ(comm_coord(2), rank % 2);
+    EXPECT_EQ(comm_coord(3), rank / 2);
+    seen[rank]++;
+  });
+  for (int r = 0; r < 4; r++) EXPECT_EQ(seen[r], 1) << "rank " << r;
+}
+
+TEST(comm_thread, halo)
+{
+  run_ranks([](int rank) {
+    for (int dim = 2; dim < 4; dim++) {
+      // exchange with both neighbors, which are the same rank on a grid of extent two
+      int send_fwd[3] = {rank, dim, +1}, send_back[3] = {rank, dim, -1};
+      int recv_fwd[3] = {-1, -1, -1}, recv_back[3] = {-1, -1, -1};
+      MsgHandle *mh_send_fwd = comm_declare_send_relative(send_fwd, dim, +1, sizeof(send_fwd));
+      MsgHandle *mh_send_back = comm_declare_send_relative(send_back, dim, -1, sizeof(send_back));
+      MsgHandle *mh_recv_fwd = comm_declare_receive_relative(recv_fwd, dim, +1, sizeof(recv_fwd));
+      MsgHandle *mh_recv_back = comm_declare_receive_relative(recv_back, dim, -1, sizeof(recv_back));
+
+      // persistent handles are restarted for every exchange
+      for (int iter = 0; iter < 3; iter++) {
+        comm_start(mh_recv_fwd);
+        comm_start(mh_recv_back);
+        comm_start(mh_send_fwd);
+        comm_start(mh_send_back);
+        comm_wait(mh_send_fwd);
+        comm_wait(mh_send_back);
+        comm_wait(mh_recv_fwd);
+        comm_wait(mh_recv_back);
+
+        // the forward neighbor sent its backward message to us, and vice versa
+        EXPECT_EQ(recv_fwd[0], comm_neighbor_rank(1, dim));
+        EXPECT_EQ(recv_fwd[2], -1);
+        EXPECT_EQ(recv_back[0], comm_neighbor_rank(0, dim));
+        EXPECT_EQ(recv_back[2], +1);
+        EXPECT_EQ(recv_fwd[1], dim);
+        EXPECT_EQ(recv_back[1], dim);
+      }
+
+      comm_free(mh_send_fwd);
+      comm_free(mh_send_back);
+      comm_free(mh_recv_fwd);
+      comm_free(mh_recv_back);
+    }
+
+    // a strided send received into a contiguous buffer
+    int send[4][2], recv[4];
+    for (int i = 0; i < 4; i++) {
+      send[i][0] = 10 * rank + i;
+      send[i][1] = -1;
+    }
+    MsgHandle *mh_send = comm_declare_strided_send_relative(send, 3, +1, sizeof(int), 4, 2 * sizeof(int));
+    MsgHandle *mh_recv = comm_declare_receive_relative(recv, 3, -1, sizeof(recv));
+    comm_start(mh_recv);
+    comm_start(mh_send);
+    comm_wait(mh_send);
+    comm_wait(mh_recv);
+    for (int i = 0; i < 4; i++) EXPECT_EQ(recv[i], 10 * comm_neighbor_rank(0, 3) + i);
+    comm_free(mh_send);
+    comm_free(mh_recv);
+  });
+}
+
+TEST(comm_thread, allreduce)
+{
+  run_ranks([](int rank) {
+    double sum = rank + 1;
+    comm_allreduce(&sum);
+    EXPECT_EQ(sum, 10.0);
+
+    double max = rank, min = rank;
+    comm_allreduce_max(&max);
+    comm_allreduce_min(&min);
+    EXPECT_EQ(max, 3.0);
+    EXPECT_EQ(min, 0.0);
+
+    int isum = 1 << rank;
+    comm_allreduce_int(&isum);
+    EXPECT_EQ(isum, 15);
+
+    uint64_t x = 1ul << (3 * rank);
+    comm_allreduce_xor(&x);
+    EXPECT_EQ(x, 01111ul);
+
+    std::vector<double> array(5);
+    for (int i = 0; i < 5; i++) array[i] = rank * i;
+    comm_allreduce_array(array.data(), array.size());
+    for (int i = 0; i < 5; i++) EXPECT_EQ(array[i], 6.0 * i);
+
+    double bcast[2] = {rank == 0 ? 3.5 : 0.0, rank == 0 ? -1.0 : 0.0};
+    comm_broadcast(bcast, sizeof(bcast));
+    EXPECT_EQ(bcast[0], 3.5);
+    EXPECT_EQ(bcast[1], -1.0);
+  });
+}
+
+TEST(comm_thread, async_reduction)
+{
+  run_ranks([](int rank) {
+    // the asynchronous sums must agree bit for bit with the blocking ones
+    std::vector<double> local(7);
+    for (int i = 0; i < 7; i++) local[i] = 1.0 / (3 + rank + i) - 0.1 * i * rank;
+    std::vector<double> blocking(local), async(local);
+    comm_allreduce_array(blocking.data(), blocking.size());
+
+    ReduceHandle *rh = comm_allreduce_array_async(async.data(), async.size());
+    comm_allreduce_wait(&rh);
+    EXPECT_EQ(rh, nullptr);
+    comm_allreduce_wait(&rh); // waiting on a completed reduction is a no-op
+    for (int i = 0; i < 7; i++) EXPECT_EQ(async[i], blocking[i]) << "element " << i;
+
+    // AsyncReduction evaluates its reduction locally and sums it globally on wait()
+    bool global_in_reduction = true;
+    blas::AsyncReduction<double3> reduction([&]() {
+      global_in_reduction = commGlobalReduction();
+      return make_double3(local[0], local[1], local[2]);
+    });
+    EXPECT_FALSE(global_in_reduction);
+    EXPECT_TRUE(commGlobalReduction());
+    double3 sum = reduction.wait();
+    EXPECT_FALSE(reduction.pending());
+    EXPECT_EQ(sum.x, blocking[0]);
+    EXPECT_EQ(sum.y, blocking[1]);
+    EXPECT_EQ(sum.z, blocking[2]);
+
+    // with global reductions disabled the result stays local
+    commGlobalReductionSet(false);
+    double2 local_sum = blas::AsyncReduction<double2>([&]() { return make_double2(local[3], local[4]); }).wait();
+    commGlobalReductionSet(true);
+    EXPECT_EQ(local_sum.x, local[3]);
+    EXPECT_EQ(local_sum.y, local[4]);
+  });
+}
+
+TEST(comm_thread, split)
+{
+  run_ranks([](int rank) {
+    // split the t dimension into two communicators of two ranks each
+    push_communicator(quda::CommKey {1, 1, 1, 2});
+    EXPECT_EQ(comm_size(), 2);
+    EXPECT_EQ(comm_rank(), rank % 2);
+    EXPECT_EQ(comm_rank_global(), rank);
+    EXPECT_EQ(comm_dim(2), 2);
+    EXPECT_EQ(comm_dim(3), 1);
+
+    double sum = rank;
+    comm_allreduce(&sum);
+    EXPECT_EQ(sum, 4.0 * (rank / 2) + 1.0);
+
+    // the halo exchange stays within the split communicator
+    int send = rank, recv = -1;
+    MsgHandle *mh_send = comm_declare_send_relative(&send, 2, +1, sizeof(int));
+    MsgHandle *mh_recv = comm_declare_receive_relative(&recv, 2, -1, sizeof(int));
+    comm_start(mh_recv);
+    comm_start(mh_send);
+    comm_wait(mh_send);
+    comm_wait(mh_recv);
+    EXPECT_EQ(recv, rank ^ 1);
+    comm_free(mh_send);
+    comm_free(mh_recv);
+
+    push_communicator(default_comm_key);
+    EXPECT_EQ(comm_size(), 4);
+    sum = rank;
+    comm_allreduce(&sum);
+    EXPECT_EQ(sum, 6.0);
+  });
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  setVerbosity(QUDA_SILENT);
+  return RUN_ALL_TESTS();
+}
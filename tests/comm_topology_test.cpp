@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <quda.h>
+#include <quda_internal.h>
+#include <comm_quda.h>
+
+#include <gtest/gtest.h>
+
+/**
+   @file comm_topology_test.cpp
+
+   Tests of the topology-aware process-grid mapping: the mapping built
+   from the hostnames of the ranks, its fallback to the
+   lexicographical mapping, and a single-rank initialization through
+   initCommsGridQuda() with QUDA_ENABLE_TOPOLOGY_MAPPING=1.
+ */
+
+/** hostname buffer in the layout gathered by the communicator, with ranks filled node by node */
+static std::vector<char> hostnames(const std::vector<int> &ranks_per_node)
+{
+  std::vector<char> buf;
+  for (size_t n = 0; n < ranks_per_node.size(); n++) {
+    for (int r = 0; r < ranks_per_node[n]; r++) {
+      char name[128] = {};
+      snprintf(name, sizeof(name), "node%lu", n);
+      buf.insert(buf.end(), name, name + sizeof(name));
+    }
+  }
+  return buf;
+}
+
+TEST(comm_topology, two_nodes)
+{
+  CommTopologyMap map;
+  map.dims = {1, 1, 2, 4};
+  auto buf = hostnames({4, 4});
+  std::string report = comm_build_topology_map(map, buf.data(), 8);
+
+  // a 1x1x2x2 block leaves one partitioned face per rank off node, where the lexicographical 1x1x1x4 leaves two
+  EXPECT_TRUE(map.warnings.empty());
+  EXPECT_NE(report.find("Topology-aware rank mapping: 2 nodes of 4 ranks, node block 1x1x2x2"), std::string::npos)
+    << report;
+
+  // the map is a permutation of the ranks
+  std::vector<int> ranks = map.ranks;
+  std::sort(ranks.begin(), ranks.end());
+  for (int r = 0; r < 8; r++) EXPECT_EQ(ranks[r], r);
+
+  // each half of the grid in t is held by one node
+  for (int t = 0; t < 4; t++)
+    for (int z = 0; z < 2; z++) {
+      int coords[4] = {0, 0, z, t};
+      EXPECT_EQ(comm_topology_rank_from_coords(coords, &map), 4 * (t / 2) + 2 * z + t % 2);
+    }
+}
+
+TEST(comm_topology, fallback)
+{
+  CommTopologyMap map;
+  map.dims = {1, 1, 2, 3};
+  auto buf = hostnames({4, 2});
+  std::string report = comm_build_topology_map(map, buf.data(), 6);
+
+  // nodes of unequal size cannot tile the grid
+  EXPECT_TRUE(report.empty());
+  ASSERT_EQ(map.warnings.size(), 1u);
+  EXPECT_NE(map.warnings[0].find("lexicographical ordering"), std::string::npos);
+  for (int r = 0; r < 6; r++) EXPECT_EQ(map.ranks[r], r);
+}
+
+TEST(comm_topology, single_rank)
+{
+  // the report is printed only once the communicator exists to print it
+  setenv("QUDA_ENABLE_TOPOLOGY_MAPPING", "1", 1);
+  int dims[4] = {1, 1, 1, 1};
+  testing::internal::CaptureStdout();
+  initCommsGridQuda(4, dims, nullptr, nullptr);
+  std::string output = testing::internal::GetCapturedStdout();
+  unsetenv("QUDA_ENABLE_TOPOLOGY_MAPPING");
+
+  EXPECT_EQ(comm_size(), 1);
+  EXPECT_EQ(comm_rank(), 0);
+  EXPECT_EQ(output.find("ERROR"), std::string::npos) << output;
+  EXPECT_NE(output.find("Topology-aware rank mapping: 1 nodes of 1 ranks, node block 1x1x1x1"), std::string::npos)
+    << output;
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int result = RUN_ALL_TESTS();
+  comm_finalize();
+  return result;
+}
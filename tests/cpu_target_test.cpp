@@ -0,0 +1,176 @@
+#include <vector>
+
+#include <quda_internal.h>
+#include <tune_quda.h>
+#include <device.h>
+#include <malloc_quda.h>
+#include <comm_quda.h>
+
+#include <gtest/gtest.h>
+
+/**
+   @file cpu_target_test.cpp
+
+   End-to-end test of the host execution path of the CPU target:
+   device initialization, memory allocation and copies, kernel
+   launch over a multi-dimensional grid and autotuning of a kernel
+   timed on the host.
+ */
+
+using namespace quda;
+
+namespace quda
+{
+
+  struct LaunchArg {
+    int *count;
+    int *index;
+    int nx;
+    int ny;
+    int nz;
+  };
+
+  /**
+     Records how often each site is visited, and the site index as
+     reconstructed from the launch indices
+   */
+  template <typename Arg> __global__ void countKernel(Arg arg)
+  {
+    const int x = blockIdx.x * blockDim.x + threadIdx.x;
+    const int y = blockIdx.y * blockDim.y + threadIdx.y;
+    const int z = blockIdx.z * blockDim.z + threadIdx.z;
+    if (x >= arg.nx || y >= arg.ny || z >= arg.nz) return;
+    const int i = (z * arg.ny + y) * arg.nx + x;
+    arg.count[i]++;
+    arg.index[i] = i;
+  }
+
+  struct AxpyArg {
+    float a;
+    const float *x;
+    float *y;
+    float *z;
+    int n;
+  };
+
+  template <typename Arg> __global__ void axpyKernel(Arg arg)
+  {
+    for (int i = blockIdx.x * blockDim.x + threadIdx.x; i < arg.n; i += gridDim.x * blockDim.x)
+      arg.z[i] = arg.a * arg.x[i] + arg.y[i];
+  }
+
+  class Axpy : public Tunable
+  {
+    AxpyArg arg;
+    unsigned int sharedBytesPerThread() const { return 0; }
+    unsigned int sharedBytesPerBlock(const TuneParam &) const { return 0; }
+    unsigned int minThreads() const { return arg.n; }
+
+  public:
+    Axpy(const AxpyArg &arg) : arg(arg) { }
+
+    void apply(const qudaStream_t &stream)
+    {
+      TuneParam tp = tuneLaunch(*this, QUDA_TUNE_YES, QUDA_SILENT);
+      qudaLaunchKernel(axpyKernel<AxpyArg>, tp, stream, arg);
+    }
+
+    TuneKey tuneKey() const
+    {
+      char vol[32];
+      snprintf(vol, sizeof(vol), "n=%d", arg.n);
+      return TuneKey(vol, typeid(*this).name(), "cpu_target_test");
+    }
+
+    long long flops() const { return 2ll * arg.n; }
+    long long bytes() const { return 3ll * arg.n * sizeof(float); }
+  };
+
+} // namespace quda
+
+TEST(cpu_target, device)
+{
+  EXPECT_GT(deviceProp.multiProcessorCount, 0);
+  EXPECT_GT(deviceProp.totalGlobalMem, 0u);
+  EXPECT_EQ(deviceProp.warpSize, 32);
+}
+
+TEST(cpu_target, memcpy)
+{
+  const size_t n = (1 << 20) + 3; // large enough to use the thread pool, with a ragged tail
+  std::vector<int> h(n), r(n, -1);
+  for (size_t i = 0; i < n; i++) h[i] = static_cast<int>(i * 7 + 1);
+
+  auto d = static_cast<int *>(device_malloc(n * sizeof(int)));
+  qudaMemset(d, 0, n * sizeof(int));
+  qudaMemcpy(d, h.data(), n * sizeof(int), cudaMemcpyHostToDevice);
+  qudaMemcpy(r.data(), d, n * sizeof(int), cudaMemcpyDeviceToHost);
+  device_free(d);
+
+  for (size_t i = 0; i < n; i++) ASSERT_EQ(r[i], h[i]) << "i = " << i;
+}
+
+TEST(cpu_target, launch)
+{
+  // a grid that is ragged in every dimension
+  const int nx = 37, ny = 5, nz = 3;
+  TuneParam tp;
+  tp.block = dim3(8, 2, 2);
+  tp.grid = dim3((nx + tp.block.x - 1) / tp.block.x, (ny + tp.block.y - 1) / tp.block.y,
+                 (nz + tp.block.z - 1) / tp.block.z);
+
+  std::vector<int> count(nx * ny * nz, 0), index(nx * ny * nz, -1);
+  LaunchArg arg = {count.data(), index.data(), nx, ny, nz};
+  ASSERT_EQ(qudaLaunchKernel(countKernel<LaunchArg>, tp, nullptr, arg), QUDA_SUCCESS);
+
+  for (int i = 0; i < nx * ny * nz; i++) {
+    EXPECT_EQ(count[i], 1) << "site " << i;
+    EXPECT_EQ(index[i], i) << "site " << i;
+  }
+}
+
+TEST(cpu_target, tune)
+{
+  const int n = 100003;
+  std::vector<float> x(n), y(n), z(n, 0.0f);
+  for (int i = 0; i < n; i++) {
+    x[i] = 0.5f * i;
+    y[i] = 1.0f - i;
+  }
+
+  AxpyArg arg = {2.0f, x.data(), y.data(), z.data(), n};
+  Axpy axpy(arg);
+  axpy.apply(nullptr);
+
+  // the kernel is launched with the tuned parameters, which must be valid
+  const TuneParam &tp = tuneLaunch(axpy, QUDA_TUNE_YES, QUDA_SILENT);
+  EXPECT_GE(tp.block.x, 1u);
+  EXPECT_GE(tp.grid.x, 1u);
+
+  for (int i = 0; i < n; i++) ASSERT_FLOAT_EQ(z[i], 2.0f * x[i] + y[i]) << "i = " << i;
+}
+
+static int rank_from_coords(const int *coords, void *fdata)
+{
+  auto dims = static_cast<int *>(fdata);
+  int rank = coords[3];
+  for (int i = 2; i >= 0; i--) rank = dims[i] * rank + coords[i];
+  return rank;
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+
+  int dims[4] = {1, 1, 1, 1};
+  comm_init(4, dims, rank_from_coords, dims);
+  setVerbosity(QUDA_SILENT);
+  device::init(0);
+  device::create_context();
+
+  int result = RUN_ALL_TESTS();
+
+  device::destroy();
+  comm_finalize();
+  return result;
+}
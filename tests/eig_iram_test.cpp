@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <complex>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include <quda.h>
+#include <quda_internal.h>
+#include <comm_quda.h>
+#include <dirac_quda.h>
+#include <eigensolve_quda.h>
+
+#include <gtest/gtest.h>
+
+/**
+   @file eig_iram_test.cpp
+
+   Tests of the host QR algorithm of the implicitly restarted Arnoldi
+   solver on small upper Hessenberg matrices: that the bulge-chasing
+   sweeps and their deferred application are a unitary similarity
+   transform which keeps H upper Hessenberg, and that the eigenpairs
+   found from the Schur form agree with Eigen's.  None of these touch
+   the operator, so the solver is built around an empty one.
+ */
+
+using namespace quda;
+
+using Eigen::MatrixXcd;
+
+static int rank_from_coords(const int *coords, void *fdata)
+{
+  auto dims = static_cast<int *>(fdata);
+  int rank = coords[3];
+  for (int i = 2; i >= 0; i--) rank = dims[i] * rank + coords[i];
+  return rank;
+}
+
+/** IRAM with the residua of its eigenpairs exposed */
+struct TestIRAM : public IRAM {
+  using IRAM::IRAM;
+  using EigenSolver::residua;
+};
+
+class IRAMTest : public ::testing::Test
+{
+protected:
+  static constexpr int n_kr = 48;
+  QudaEigParam eig_param;
+  TimeProfile profile {"eig_iram_test"};
+  DiracM mat {static_cast<const Dirac *>(nullptr)};
+  std::unique_ptr<TestIRAM> iram;
+  std::mt19937 rng {1234};
+
+  void SetUp()
+  {
+    eig_param = newQudaEigParam();
+    eig_param.eig_type = QUDA_EIG_IR_ARNOLDI;
+    eig_param.spectrum = QUDA_SPECTRUM_LR_EIG;
+    eig_param.n_ev = n_kr / 2;
+    eig_param.n_kr = n_kr;
+    eig_param.n_conv = n_kr / 2;
+    eig_param.tol = 1e-12;
+    eig_param.qr_tol = 1e-14;
+    eig_param.use_eigen_qr = QUDA_BOOLEAN_FALSE;
+    iram = std::make_unique<TestIRAM>(mat, &eig_param, profile);
+  }
+
+  /** a random upper Hessenberg matrix, with the subdiagonal zeroed below each row in split */
+  MatrixXcd random_hessenberg(const std::vector<int> &split = {})
+  {
+    std::normal_distribution<double> normal;
+    MatrixXcd H = MatrixXcd::Zero(n_kr, n_kr);
+    for (int i = 0; i < n_kr; i++)
+      for (int j = std::max(i - 1, 0); j < n_kr; j++) H(i, j) = Complex(normal(rng), normal(rng));
+    for (int i : split) H(i + 1, i) = 0.0;
+    return H;
+  }
+
+  void set_upper_hess(const MatrixXcd &H)
+  {
+    for (int i = 0; i < n_kr; i++)
+      for (int j = 0; j < n_kr; j++) iram->upperHess[i][j] = H(i, j);
+  }
+
+  MatrixXcd get(Complex **A)
+  {
+    MatrixXcd M(n_kr, n_kr);
+    for (int i = 0; i < n_kr; i++)
+      for (int j = 0; j < n_kr; j++) M(i, j) = A[i][j];
+    return M;
+  }
+
+  /**
+     @brief Apply shifted QR sweeps to the windows, as qrShifts
+     and the Schur reduction do, and check the result
+  */
+  void check_sweeps(const MatrixXcd &H0, const std::vector<std::pair<int, int>> &windows, int n_shifts)
+  {
+    set_upper_hess(H0);
+    for (int i = 0; i < n_kr; i++)
+      for (int j = 0; j < n_kr; j++) iram->Qmat[i][j] = i == j ? 1.0 : 0.0;
+
+    std::normal_distribution<double> normal;
+    std::vector<IRAM::GivensSweep> sweeps;
+    for (int shift = 0; shift < n_shifts; shift++)
+      for (auto &w : windows)
+        iram->qrBulgeChase(iram->Qmat, iram->upperHess, sweeps, w.first, w.second, Complex(normal(rng), normal(rng)));
+    iram->applySweeps(iram->Qmat, iram->upperHess, sweeps);
+    EXPECT_TRUE(sweeps.empty());
+
+    MatrixXcd Q = get(iram->Qmat);
+    MatrixXcd H = get(iram->upperHess);
+    const double tol = 1e-12 * H0.norm();
+
+    EXPECT_LT((Q.adjoint() * Q - MatrixXcd::Identity(n_kr, n_kr)).norm(), 1e-12);
+    EXPECT_LT((Q * H * Q.adjoint() - H0).norm(), tol);
+
+    // H stays upper Hessenberg, and the windows stay decoupled
+    for (int j = 0; j < n_kr; j++)
+      for (int i = j + 2; i < n_kr; i++) EXPECT_LT(abs(H(i, j)), tol) << "H(" << i << ", " << j << ")";
+    for (int j = 0; j < n_kr - 1; j++)
+      if (H0(j + 1, j) == 0.0) EXPECT_LT(abs(H(j + 1, j)), tol) << "H(" << j + 1 << ", " << j << ")";
+  }
+
+  /**
+     @brief Check the eigenpairs of H0 found by eigensolveFromUpperHess
+     against its eigenvalues from Eigen and their residuals
+  */
+  void check_eigensolve(const MatrixXcd &H0)
+  {
+    set_upper_hess(H0);
+    const double beta = 0.5;
+    std::vector<Complex> evals(n_kr);
+    iram->eigensolveFromUpperHess(evals, beta);
+    MatrixXcd X = get(iram->Qmat);
+
+    Eigen::ComplexSchur<MatrixXcd> schur(H0);
+    std::vector<Complex> reference(n_kr);
+    for (int i = 0; i < n_kr; i++) reference[i] = schur.matrixT()(i, i);
+
+    const double tol = 1e-10 * H0.norm();
+    for (int i = 0; i < n_kr; i++) {
+      // the eigenvalues are matched to the nearest of Eigen's, which are removed as they are matched
+      auto nearest = std::min_element(reference.begin(), reference.end(),
+                                      [&](const Complex &a, const Complex &b) { return abs(a - evals[i]) < abs(b - evals[i]); });
+      EXPECT_LT(abs(*nearest - evals[i]), tol) << "eigenvalue " << i;
+      reference.erase(nearest);
+
+      EXPECT_NEAR(X.col(i).norm(), 1.0, 1e-12);
+      EXPECT_LT((H0 * X.col(i) - evals[i] * X.col(i)).norm(), tol) << "eigenvector " << i;
+      EXPECT_NEAR(iram->residua[i], beta * abs(X(n_kr - 1, i)), 1e-15);
+    }
+  }
+};
+
+TEST_F(IRAMTest, sweep_full)
+{
+  // a single sweep, and enough to force the deferred rotations to be applied in batches
+  check_sweeps(random_hessenberg(), {{0, n_kr - 1}}, 1);
+  check_sweeps(random_hessenberg(), {{0, n_kr - 1}}, IRAM::max_deferred_sweeps + 5);
+}
+
+TEST_F(IRAMTest, sweep_windows)
+{
+  // the unreduced blocks left between zero subdiagonal entries, visited in order
+  const std::vector<int> split = {9, 20, 21, 40};
+  check_sweeps(random_hessenberg(split), {{0, 9}, {10, 20}, {22, 40}, {41, n_kr - 1}}, 3);
+
+  // the shrinking windows of the Schur reduction, which deflates from the bottom
+  check_sweeps(random_hessenberg(split), {{22, 40}, {22, 40}, {10, 20}, {0, 9}, {0, 9}}, 4);
+
+  // a window that grows past the deferred ones, which must be applied first
+  check_sweeps(random_hessenberg({20, 30}), {{21, 30}, {0, 20}, {21, n_kr - 1}}, 2);
+}
+
+TEST_F(IRAMTest, eigensolve)
+{
+  check_eigensolve(random_hessenberg());
+  check_eigensolve(random_hessenberg({15, 30}));
+}
+
+TEST_F(IRAMTest, eigensolve_exceptional_shift)
+{
+  // the Wilkinson shift of a cyclic permutation is zero, which stagnates until an exceptional shift is taken
+  MatrixXcd H = MatrixXcd::Zero(n_kr, n_kr);
+  for (int i = 0; i < n_kr - 1; i++) H(i + 1, i) = Complex(0.0, 1.0);
+  H(0, n_kr - 1) = Complex(0.0, 1.0);
+  check_eigensolve(H);
+
+  // a small cyclic block deflated first, whose subdiagonal is still imaginary when the exceptional shift is
+  // taken, so a shift that only uses its real part stagnates as well
+  const int m = 6;
+  H = random_hessenberg({n_kr - m - 1});
+  H.bottomRightCorner(m, m).setZero();
+  for (int i = n_kr - m; i < n_kr - 1; i++) H(i + 1, i) = Complex(0.0, 1.0);
+  H(n_kr - m, n_kr - 1) = Complex(0.0, 1.0);
+  check_eigensolve(H);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+
+  int dims[4] = {1, 1, 1, 1};
+  comm_init(4, dims, rank_from_coords, dims);
+  setVerbosity(QUDA_SILENT);
+
+  int result = RUN_ALL_TESTS();
+
+  comm_finalize();
+  return result;
+}
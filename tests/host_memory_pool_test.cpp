@@ -0,0 +1,185 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include <quda_internal.h>
+#include <malloc_quda.h>
+#include <comm_quda.h>
+
+#include <gtest/gtest.h>
+
+/**
+   @file host_memory_pool_test.cpp
+
+   Tests of the size-class host memory pool behind safe_malloc() and
+   host_free(), which is enabled for this test with
+   QUDA_ENABLE_HOST_MEMORY_POOL=1.
+ */
+
+using namespace quda;
+
+static const size_t page_size = getpagesize();
+
+/**
+   @brief Read the reuse statistics reported by pool::print_host_stats()
+   @param[out] hits Allocations served from the free lists
+   @param[out] total All pooled allocations
+ */
+static void host_stats(unsigned long &hits, unsigned long &total)
+{
+  FILE *out = getOutputFile();
+  FILE *stats = tmpfile();
+  setOutputFile(stats);
+  pool::print_host_stats();
+  setOutputFile(out);
+
+  rewind(stats);
+  char line[256];
+  hits = total = 0;
+  while (fgets(line, sizeof(line), stats)) {
+    const char *reused = strstr(line, "reused");
+    if (reused) sscanf(reused, "reused %lu of %lu", &hits, &total);
+  }
+  fclose(stats);
+}
+
+TEST(host_memory_pool, size_class)
+{
+  ASSERT_TRUE(pool::host_memory_pool());
+
+  // small requests are not pooled
+  size_t base_size;
+  void *small = pool::host_acquire(100, base_size);
+  EXPECT_EQ(base_size, 100u);
+  pool::host_release(small, 100, base_size);
+
+  // up to eight pages the classes are multiples of the page size, and
+  // beyond four per power of two, so at most a quarter is wasted
+  for (size_t size : {page_size, page_size + 1, 8 * page_size - 1, 8 * page_size + 1, (size_t)3 << 20, (size_t)5 << 20}) {
+    void *ptr = pool::host_acquire(size, base_size);
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_GE(base_size, size);
+    EXPECT_EQ(base_size % page_size, 0u);
+    EXPECT_LE(base_size - size, std::max(page_size, size / 4)) << "size " << size;
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % page_size, 0u);
+    if (base_size >= (2 << 20)) EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % (2 << 20), 0u);
+    memset(ptr, 1, size);
+    pool::host_release(ptr, size, base_size);
+  }
+  pool::flush_host();
+}
+
+TEST(host_memory_pool, reuse)
+{
+  unsigned long hits0, total0, hits, total;
+  host_stats(hits0, total0);
+
+  // a freed block is handed out again for any request of its size class
+  const size_t size = 10 * page_size + 123;
+  void *ptr = safe_malloc(size);
+  memset(ptr, 2, size);
+  host_free(ptr);
+  void *again = safe_malloc(size - 100);
+  EXPECT_EQ(again, ptr);
+
+  // while a block of another class, or a second live block, is new
+  void *other = safe_malloc(4 * size);
+  void *second = safe_malloc(size);
+  EXPECT_NE(other, ptr);
+  EXPECT_NE(second, ptr);
+  host_free(second);
+  host_free(other);
+  host_free(again);
+
+  host_stats(hits, total);
+  EXPECT_EQ(total - total0, 4u);
+  EXPECT_EQ(hits - hits0, 1u);
+}
+
+TEST(host_memory_pool, flush)
+{
+  const size_t size = 20 * page_size;
+  std::vector<void *> ptrs;
+  for (int i = 0; i < 4; i++) ptrs.push_back(safe_malloc(size));
+  for (auto ptr : ptrs) host_free(ptr);
+
+  unsigned long hits0, total0, hits, total;
+  host_stats(hits0, total0);
+
+  // the cached blocks are reused until they are flushed
+  void *ptr = safe_malloc(size);
+  host_free(ptr);
+  host_stats(hits, total);
+  EXPECT_EQ(hits - hits0, 1u);
+
+  pool::flush_host();
+  ptr = safe_malloc(size);
+  host_free(ptr);
+  host_stats(hits0, total0);
+  EXPECT_EQ(hits0, hits);
+  EXPECT_EQ(total0, total + 1);
+  pool::flush_host();
+}
+
+TEST(host_memory_pool, threads)
+{
+  // concurrent allocations never share a block, and blocks come back intact
+  const int n_thread = 8;
+  const int n_iter = 200;
+  std::vector<std::thread> threads;
+  std::vector<int> errors(n_thread, 0);
+  for (int t = 0; t < n_thread; t++) {
+    threads.emplace_back([t, &errors]() {
+      std::vector<std::pair<unsigned char *, size_t>> live;
+      for (int i = 0; i < n_iter; i++) {
+        const size_t size = (1 + (i * 7 + t) % 13) * page_size + t;
+        auto ptr = static_cast<unsigned char *>(safe_malloc(size));
+        memset(ptr, t + 1, size);
+        live.push_back(std::make_pair(ptr, size));
+        if (i % 3 == 2) { // free the oldest blocks, checking nobody else wrote to them
+          for (int j = 0; j < 2; j++) {
+            auto block = live.front();
+            live.erase(live.begin());
+            for (size_t k = 0; k < block.second; k++)
+              if (block.first[k] != t + 1) {
+                errors[t]++;
+                break;
+              }
+            host_free(block.first);
+          }
+        }
+      }
+      for (auto &block : live) host_free(block.first);
+    });
+  }
+  for (auto &thread : threads) thread.join();
+  for (int t = 0; t < n_thread; t++) EXPECT_EQ(errors[t], 0) << "thread " << t;
+  pool::flush_host();
+}
+
+static int rank_from_coords(const int *coords, void *fdata)
+{
+  auto dims = static_cast<int *>(fdata);
+  int rank = coords[3];
+  for (int i = 2; i >= 0; i--) rank = dims[i] * rank + coords[i];
+  return rank;
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+
+  setenv("QUDA_ENABLE_HOST_MEMORY_POOL", "1", 1);
+  int dims[4] = {1, 1, 1, 1};
+  comm_init(4, dims, rank_from_coords, dims);
+  setVerbosity(QUDA_SILENT);
+
+  int result = RUN_ALL_TESTS();
+
+  comm_finalize();
+  return result;
+}
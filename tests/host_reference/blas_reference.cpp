@@ -105,6 +105,7 @@ double blasGEMMEigenVerify(void *A_data, void *B_data, void *C_data_copy, void *
     std::swap(blas_param->a_offset, blas_param->b_offset);
     std::swap(blas_param->a_stride, blas_param->b_stride);
     std::swap(A_data, B_data);
+    std::swap(refA_size, refB_size);
   }
 
   // Problem parameters
@@ -155,12 +156,20 @@ double blasGEMMEigenVerify(void *A_data, void *B_data, void *C_data_copy, void *
   printfQuda("Computing Eigen matrix operation a * A_{%lu,%lu} * B_{%lu,%lu} + b * C_{%lu,%lu} = C_{%lu,%lu}\n",
              A.rows(), A.cols(), B.rows(), B.cols(), C_eigen.rows(), C_eigen.cols(), C_eigen.rows(), C_eigen.cols());
 
+  // A and B are stored as the transposes of op(A) and op(B) when they are transposed
+  int a_rows = blas_param->trans_a == QUDA_BLAS_OP_N ? m : k;
+  int a_cols = blas_param->trans_a == QUDA_BLAS_OP_N ? k : m;
+  int b_rows = blas_param->trans_b == QUDA_BLAS_OP_N ? k : n;
+  int b_cols = blas_param->trans_b == QUDA_BLAS_OP_N ? n : k;
+
   double max_relative_deviation = 0.0;
   for (int batch = 0; batch < batches; batch += max_stride) {
 
     // Populate Eigen objects
-    fillEigenArray(A, A_ptr, m, k, lda, a_offset);
-    fillEigenArray(B, B_ptr, k, n, ldb, b_offset);
+    A.resize(a_rows, a_cols);
+    B.resize(b_rows, b_cols);
+    fillEigenArray(A, A_ptr, a_rows, a_cols, lda, a_offset);
+    fillEigenArray(B, B_ptr, b_rows, b_cols, ldb, b_offset);
     fillEigenArray(C_eigen, Ccopy_ptr, m, n, ldc, c_offset);
     fillEigenArray(C_gpu, C_ptr, m, n, ldc, c_offset);
 
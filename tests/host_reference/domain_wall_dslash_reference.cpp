@@ -5,6 +5,11 @@
 #include <math.h>
 #include <complex.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
 #include <quda.h>
 #include <host_utils.h>
 #include <dslash_reference.h>
@@ -15,154 +20,6 @@
 
 using namespace quda;
 
-// i represents a "half index" into an even or odd "half lattice".
-// when oddBit={0,1} the half lattice is {even,odd}.
-// 
-// the displacements, such as dx, refer to the full lattice coordinates. 
-//
-// neighborIndex() takes a "half index", displaces it, and returns the
-// new "half index", which can be an index into either the even or odd lattices.
-// displacements of magnitude one always interchange odd and even lattices.
-//
-//
-int neighborIndex_4d(int i, int oddBit, int dx4, int dx3, int dx2, int dx1) {
-  // On input i should be in the range [0 , ... , Z[0]*Z[1]*Z[2]*Z[3]/2-1].
-  if (i < 0 || i >= (Z[0]*Z[1]*Z[2]*Z[3]/2))
-    { printf("i out of range in neighborIndex_4d\n"); exit(-1); }
-  // Compute the linear index.  Then dissect.
-  // fullLatticeIndex_4d is in util_quda.cpp.
-  // The gauge fields live on a 4d sublattice.
-  int X = fullLatticeIndex_4d(i, oddBit);
-  int x4 = X/(Z[2]*Z[1]*Z[0]);
-  int x3 = (X/(Z[1]*Z[0])) % Z[2];
-  int x2 = (X/Z[0]) % Z[1];
-  int x1 = X % Z[0];
-
-  x4 = (x4+dx4+Z[3]) % Z[3];
-  x3 = (x3+dx3+Z[2]) % Z[2];
-  x2 = (x2+dx2+Z[1]) % Z[1];
-  x1 = (x1+dx1+Z[0]) % Z[0];
-
-  return (x4*(Z[2]*Z[1]*Z[0]) + x3*(Z[1]*Z[0]) + x2*(Z[0]) + x1) / 2;
-}
-
-
-
-//#ifndef MULTI_GPU
-// This is just a copy of gaugeLink() from the quda code, except
-// that neighborIndex() is replaced by the renamed version
-// neighborIndex_4d().
-//ok
-template <typename Float>
-Float *gaugeLink_sgpu(int i, int dir, int oddBit, Float **gaugeEven,
-                Float **gaugeOdd) {
-  Float **gaugeField;
-  int j;
-  
-  // If going forward, just grab link at site, U_\mu(x).
-  if (dir % 2 == 0) {
-    j = i;
-    // j will get used in the return statement below.
-    gaugeField = (oddBit ? gaugeOdd : gaugeEven);
-  } else {
-    // If going backward, a shift must occur, U_\mu(x-\muhat)^\dagger;
-    // dagger happens elsewhere, here we're just doing index gymnastics.
-    switch (dir) {
-    case 1: j = neighborIndex_4d(i, oddBit, 0, 0, 0, -1); break;
-    case 3: j = neighborIndex_4d(i, oddBit, 0, 0, -1, 0); break;
-    case 5: j = neighborIndex_4d(i, oddBit, 0, -1, 0, 0); break;
-    case 7: j = neighborIndex_4d(i, oddBit, -1, 0, 0, 0); break;
-    default: j = -1; break;
-    }
-    gaugeField = (oddBit ? gaugeEven : gaugeOdd);
-  }
-  
-  return &gaugeField[dir/2][j*(3*3*2)];
-}
-
-
-//#else
-
-//Standard 4d version (nothing to change)
-template <typename Float>
-Float *gaugeLink_mgpu(int i, int dir, int oddBit, Float **gaugeEven, Float **gaugeOdd, Float** ghostGaugeEven, Float** ghostGaugeOdd, int n_ghost_faces, int nbr_distance) {
-  Float **gaugeField;
-  int j;
-  int d = nbr_distance;
-  if (dir % 2 == 0) {
-    j = i;
-    gaugeField = (oddBit ? gaugeOdd : gaugeEven);
-  }
-  else {
-
-    int Y = fullLatticeIndex(i, oddBit);
-    int x4 = Y/(Z[2]*Z[1]*Z[0]);
-    int x3 = (Y/(Z[1]*Z[0])) % Z[2];
-    int x2 = (Y/Z[0]) % Z[1];
-    int x1 = Y % Z[0];
-    int X1= Z[0];
-    int X2= Z[1];
-    int X3= Z[2];
-    int X4= Z[3];
-    Float* ghostGaugeField;
-
-    switch (dir) {
-    case 1:
-      { //-X direction
-        int new_x1 = (x1 - d + X1 )% X1;
-        if (x1 -d < 0 && comm_dim_partitioned(0)){
-	  ghostGaugeField = (oddBit?ghostGaugeEven[0]: ghostGaugeOdd[0]);
-	  int offset = (n_ghost_faces + x1 -d)*X4*X3*X2/2 + (x4*X3*X2 + x3*X2+x2)/2;
-	  return &ghostGaugeField[offset*(3*3*2)];
-        }
-        j = (x4*X3*X2*X1 + x3*X2*X1 + x2*X1 + new_x1) / 2;
-        break;
-      }
-    case 3:
-      { //-Y direction
-        int new_x2 = (x2 - d + X2 )% X2;
-        if (x2 -d < 0 && comm_dim_partitioned(1)){
-          ghostGaugeField = (oddBit?ghostGaugeEven[1]: ghostGaugeOdd[1]);
-          int offset = (n_ghost_faces + x2 -d)*X4*X3*X1/2 + (x4*X3*X1 + x3*X1+x1)/2;
-          return &ghostGaugeField[offset*(3*3*2)];
-        }
-        j = (x4*X3*X2*X1 + x3*X2*X1 + new_x2*X1 + x1) / 2;
-        break;
-
-      }
-    case 5:
-      { //-Z direction
-        int new_x3 = (x3 - d + X3 )% X3;
-        if (x3 -d < 0 && comm_dim_partitioned(2)){
-          ghostGaugeField = (oddBit?ghostGaugeEven[2]: ghostGaugeOdd[2]);
-          int offset = (n_ghost_faces + x3 -d)*X4*X2*X1/2 + (x4*X2*X1 + x2*X1+x1)/2;
-          return &ghostGaugeField[offset*(3*3*2)];
-        }
-        j = (x4*X3*X2*X1 + new_x3*X2*X1 + x2*X1 + x1) / 2;
-        break;
-      }
-    case 7:
-      { //-T direction
-        int new_x4 = (x4 - d + X4)% X4;
-        if (x4 -d < 0 && comm_dim_partitioned(3)){
-          ghostGaugeField = (oddBit?ghostGaugeEven[3]: ghostGaugeOdd[3]);
-          int offset = (n_ghost_faces + x4 -d)*X1*X2*X3/2 + (x3*X2*X1 + x2*X1+x1)/2;
-          return &ghostGaugeField[offset*(3*3*2)];
-        }
-        j = (new_x4*(X3*X2*X1) + x3*(X2*X1) + x2*(X1) + x1) / 2;
-        break;
-      }//7
-
-    default: j = -1; printf("ERROR: wrong dir \n"); exit(1);
-    }
-    gaugeField = (oddBit ? gaugeEven : gaugeOdd);
-
-  }
-
-  return &gaugeField[dir/2][j*(3*3*2)];
-}
-
-
 //J  Directions 0..7 were used in the 4d code.
 //J  Directions 8,9 will be for P_- and P_+, chiral
 //J  projectors.
@@ -232,32 +89,100 @@ const double projector[10][4][4][2] = {
 };
 
 
-// todo pass projector
-template <typename Float>
-void multiplySpinorByDiracProjector5(Float *res, int projIdx, Float *spinorIn) {
-  for (int i=0; i<4*3*2; i++) res[i] = 0.0;
 
-  for (int s = 0; s < 4; s++) {
-    for (int t = 0; t < 4; t++) {
-      Float projRe = projector[projIdx][s][t][0];
-      Float projIm = projector[projIdx][s][t][1];
+static const HalfProjector *halfProjectors()
+{
+  static const auto table = extractHalfProjectors<8>(projector);
+  return table.data();
+}
+
+/**
+   Neighbour table for the 4-d hopping term.  The gauge field, and
+   hence the neighbour structure, is four dimensional, so the table is
+   built over the 4-d checkerboard and shared by all Ls slices of the
+   fifth dimension.  The upper bits of each entry encode the buffer
+   (body, or the forwards / backwards ghost zone of a given dimension)
+   and the lower bits the 4-d half-lattice index, or for the ghost
+   zones the lexicographic face index from which both the spinor and
+   gauge ghost offsets follow.  The tables depend only on the local
+   geometry and partitioning so are built once per parity and reused
+   across calls.
+*/
+class DomainWallNeighborTable
+{
+  static constexpr int src_shift = 28;
+  static constexpr uint32_t idx_mask = (1u << src_shift) - 1;
+
+  int dims[4] = {};
+  int partitioned[4] = {};
+  std::vector<uint32_t> table[2];
+
+  void build(int parity)
+  {
+    std::vector<uint32_t> &nbr = table[parity];
+    nbr.resize(8 * static_cast<size_t>(Vh));
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (int i = 0; i < Vh; i++) {
+      int Y = fullLatticeIndex(i, parity);
+      const int x[4] = {Y % Z[0], (Y / Z[0]) % Z[1], (Y / (Z[1] * Z[0])) % Z[2], Y / (Z[2] * Z[1] * Z[0])};
 
-      for (int m = 0; m < 3; m++) {
-	Float spinorRe = spinorIn[t*(3*2) + m*(2) + 0];
-	Float spinorIm = spinorIn[t*(3*2) + m*(2) + 1];
-	res[s*(3*2) + m*(2) + 0] += projRe*spinorRe - projIm*spinorIm;
-	res[s*(3*2) + m*(2) + 1] += projRe*spinorIm + projIm*spinorRe;
+      for (int dir = 0; dir < 8; dir++) {
+        const int d = dir / 2;
+        const int fwd = dir % 2 == 0;
+        int y[4] = {x[0], x[1], x[2], x[3]};
+        y[d] += fwd ? +1 : -1;
+
+        if ((y[d] < 0 || y[d] >= Z[d]) && partitioned[d]) {
+          int face = 0;
+          for (int e = 3; e >= 0; e--)
+            if (e != d) face = face * Z[e] + x[e];
+          nbr[i * 8 + dir] = ((fwd ? 1 + d : 5 + d) << src_shift) | face;
+        } else {
+          y[d] = (y[d] + Z[d]) % Z[d];
+          nbr[i * 8 + dir] = (((y[3] * Z[2] + y[2]) * Z[1] + y[1]) * Z[0] + y[0]) / 2;
+        }
       }
     }
   }
-}
 
+public:
+  static int source(uint32_t entry) { return entry >> src_shift; }
+  static int index(uint32_t entry) { return entry & idx_mask; }
+
+  const uint32_t *get(int parity)
+  {
+    bool stale = false;
+    for (int d = 0; d < 4; d++) {
+#ifdef MULTI_GPU
+      int p = comm_dim_partitioned(d);
+#else
+      int p = 0;
+#endif
+      if (dims[d] != Z[d] || partitioned[d] != p) stale = true;
+      dims[d] = Z[d];
+      partitioned[d] = p;
+    }
+    if (stale) table[0].clear(), table[1].clear();
+    if (Vh > static_cast<int>(idx_mask)) errorQuda("Local volume %d too large for neighbour table", Vh);
+    if (table[parity].empty()) build(parity);
+    return table[parity].data();
+  }
+};
 
-//#ifndef MULTI_GPU
+//
 // dslashReference_4d()
-//J  This is just the 4d wilson dslash of quda code, with a
-//J  few small changes to take into account that the spinors
-//J  are 5d and the gauge fields are 4d.
+//
+// The 4-d Wilson hopping term applied to a 5-d spinor field.  The
+// outer loop runs over 4-d sites, so each gauge link is loaded (and
+// daggered) once and then applied to every slice of the fifth
+// dimension.  Once all slices of a site are done, the result is
+// handed to the epilogue as a contiguous block of Ls spinors, together
+// with a scratch area of two such blocks.  This lets the
+// fifth-dimension operators that follow the hop be applied while the
+// site is still in cache (see mdwHop below).
 //
 // if oddBit is zero: calculate odd parity spinor elements (using even parity spinor)
 // if oddBit is one:  calculate even parity spinor elements
@@ -265,340 +190,232 @@ void multiplySpinorByDiracProjector5(Float *res, int projIdx, Float *spinorIn) {
 // if daggerBit is zero: perform ordinary dslash operator
 // if daggerBit is one:  perform hermitian conjugate of dslash
 //
-//An "ok" will only be granted once check2.tex is deemed complete,
-//since the logic in this function is important and nontrivial.
-template <QudaPCType type, typename sFloat, typename gFloat>
-void dslashReference_4d_sgpu(sFloat *res, gFloat **gaugeFull, sFloat *spinorField, int oddBit, int daggerBit)
+// With 4-d preconditioning all slices share the 4-d parity oddBit.
+// With 5-d preconditioning the 4-d parity alternates with s, so each
+// 4-d parity is swept in turn over every other slice; the epilogue is
+// told which 4-d parity the block holds.  The ghost pointers are only
+// dereferenced for partitioned dimensions, so may be null for
+// single-process builds.
+//
+template <QudaPCType type, typename sFloat, typename gFloat, typename Epilogue>
+void dslashReference_4d(gFloat **gaugeFull, gFloat **ghostGauge, sFloat *spinorField, sFloat **fwdSpinor,
+                        sFloat **backSpinor, int oddBit, int daggerBit, const Epilogue &epilogue)
 {
+  static DomainWallNeighborTable neighbors;
+  const HalfProjector *half = halfProjectors();
 
-  // Initialize the return half-spinor to zero.  Note that it is a
-  // 5d spinor, hence the use of V5h.
-  for (int i=0; i<V5h*4*3*2; i++) res[i] = 0.0;
-  
-  // Some pointers that we use to march through arrays.
   gFloat *gaugeEven[4], *gaugeOdd[4];
-  // Initialize to beginning of even and odd parts of
-  // gauge array.
-  for (int dir = 0; dir < 4; dir++) {  
+  gFloat *ghostGaugeEven[4] = {}, *ghostGaugeOdd[4] = {};
+  for (int dir = 0; dir < 4; dir++) {
     gaugeEven[dir] = gaugeFull[dir];
-    // Note the use of Vh here, since the gauge fields
-    // are 4-dim'l.
     gaugeOdd[dir] = gaugeFull[dir] + Vh * gauge_site_size;
-  }
-  int sp_idx,gaugeOddBit;
-  for (int xs=0;xs<Ls;xs++) {
-    for (int gge_idx = 0; gge_idx < Vh; gge_idx++) {
-      for (int dir = 0; dir < 8; dir++) {
-        sp_idx=gge_idx+Vh*xs;
-        // Here is a function call to study.  It is defined near
-        // Line 90 of this file.
-        // Here we have to switch oddBit depending on the value of xs.  E.g., suppose
-        // xs=1.  Then the odd spinor site x1=x2=x3=x4=0 wants the even gauge array
-        // element 0, so that we get U_\mu(0).
-	gaugeOddBit = (xs%2 == 0 || type == QUDA_4D_PC) ? oddBit : (oddBit+1) % 2;
-        gFloat *gauge = gaugeLink_sgpu(gge_idx, dir, gaugeOddBit, gaugeEven, gaugeOdd);
-        
-        // Even though we're doing the 4d part of the dslash, we need
-        // to use a 5d neighbor function, to get the offsets right.
-        sFloat *spinor = spinorNeighbor_5d<type>(sp_idx, dir, oddBit, spinorField);
-        sFloat projectedSpinor[4*3*2], gaugedSpinor[4*3*2];
-        int projIdx = 2*(dir/2)+(dir+daggerBit)%2;
-        multiplySpinorByDiracProjector5(projectedSpinor, projIdx, spinor);
-      
-        for (int s = 0; s < 4; s++) {
-	  if (dir % 2 == 0) {
-	    su3Mul(&gaugedSpinor[s*(3*2)], gauge, &projectedSpinor[s*(3*2)]);
-#ifdef DBUG_VERBOSE            
-	    std::cout << "spinor:" << std::endl;
-	    printSpinorElement(&projectedSpinor[s*(3*2)],0,QUDA_DOUBLE_PRECISION);
-	    std::cout << "gauge:" << std::endl;
-#endif
-          } else {
-	    su3Tmul(&gaugedSpinor[s*(3*2)], gauge, &projectedSpinor[s*(3*2)]);
-          }
-        }
-      
-        sum(&res[sp_idx*(4*3*2)], &res[sp_idx*(4*3*2)], gaugedSpinor, 4*3*2);
-      }
+
+    if (ghostGauge) {
+      ghostGaugeEven[dir] = ghostGauge[dir];
+      ghostGaugeOdd[dir] = ghostGauge[dir] + (faceVolume[dir] / 2) * gauge_site_size;
     }
   }
-}
 
-#ifdef MULTI_GPU
-template <QudaPCType type, typename sFloat, typename gFloat>
-void dslashReference_4d_mgpu(sFloat *res, gFloat **gaugeFull, gFloat **ghostGauge, sFloat *spinorField,
-    sFloat **fwdSpinor, sFloat **backSpinor, int oddBit, int daggerBit)
-{
-  // int my_spinor_site_size = 24;
-  for (int i = 0; i < V5h * spinor_site_size; i++) res[i] = 0.0;
-
-  gFloat *gaugeEven[4], *gaugeOdd[4];
-  gFloat *ghostGaugeEven[4], *ghostGaugeOdd[4];
-  
-  for (int dir = 0; dir < 4; dir++) 
-  {  
-    gaugeEven[dir] = gaugeFull[dir];
-    gaugeOdd[dir] = gaugeFull[dir] + Vh * gauge_site_size;
+  for (int parity = 0; parity < 2; parity++) {
+    if (type == QUDA_4D_PC && parity != oddBit) continue;
+    const uint32_t *nbr = neighbors.get(parity);
+    const int s_begin = type == QUDA_4D_PC ? 0 : (parity + oddBit) % 2;
+    const int s_step = type == QUDA_4D_PC ? 1 : 2;
 
-    ghostGaugeEven[dir] = ghostGauge[dir];
-    ghostGaugeOdd[dir] = ghostGauge[dir] + (faceVolume[dir] / 2) * gauge_site_size;
-  }
-  for (int xs=0;xs<Ls;xs++) 
-  {  
-    int sp_idx;
-    for (int i = 0; i < Vh; i++) 
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
     {
-      sp_idx = i + Vh*xs;
-      for (int dir = 0; dir < 8; dir++) 
-      {
-	int gaugeOddBit = (xs%2 == 0 || type == QUDA_4D_PC) ? oddBit : (oddBit + 1) % 2;
-	
-	gFloat *gauge = gaugeLink_mgpu(i, dir, gaugeOddBit, gaugeEven, gaugeOdd, ghostGaugeEven, ghostGaugeOdd, 1, 1);//this is unchanged from MPi version
-	sFloat *spinor = spinorNeighbor_5d_mgpu<type>(sp_idx, dir, oddBit, spinorField, fwdSpinor, backSpinor, 1, 1);
-
-        sFloat projectedSpinor[spinor_site_size], gaugedSpinor[spinor_site_size];
-        int projIdx = 2 * (dir / 2) + (dir + daggerBit) % 2;
-        multiplySpinorByDiracProjector5(projectedSpinor, projIdx, spinor);
-
-        for (int s = 0; s < 4; s++) {
-          if (dir % 2 == 0)
-            su3Mul(&gaugedSpinor[s * (3 * 2)], gauge, &projectedSpinor[s * (3 * 2)]);
-          else
-            su3Tmul(&gaugedSpinor[s * (3 * 2)], gauge, &projectedSpinor[s * (3 * 2)]);
-        }
-        sum(&res[sp_idx * (4 * 3 * 2)], &res[sp_idx * (4 * 3 * 2)], gaugedSpinor, 4 * 3 * 2);
-      }
-    }
-  }
-}
+      std::vector<sFloat> block(3 * Ls * spinor_site_size);
+      sFloat *hop = block.data();
+      sFloat *work = hop + Ls * spinor_site_size;
+
+#ifdef _OPENMP
+#pragma omp for
 #endif
+      for (int i = 0; i < Vh; i++) {
+        std::fill(hop, hop + Ls * spinor_site_size, static_cast<sFloat>(0.0));
 
-template <bool plus, class sFloat> // plus = true -> gamma_+; plus = false -> gamma_-
-void axpby_ssp_project(sFloat *z, sFloat a, sFloat *x, sFloat b, sFloat *y, int idx_cb_4d, int s, int sp)
-{
-  // z_s = a*x_s + b*\gamma_+/-*y_sp
-  // Will use the DeGrand-Rossi/CPS basis, where gamma5 is diagonal:
-  // +1   0
-  //  0  -1
-  for (int spin = (plus ? 0 : 2); spin < (plus ? 2 : 4); spin++) {
-    for (int color_comp = 0; color_comp < 6; color_comp++) {
-      z[(s * Vh + idx_cb_4d) * 24 + spin * 6 + color_comp] = a * x[(s * Vh + idx_cb_4d) * 24 + spin * 6 + color_comp]
-        + b * y[(sp * Vh + idx_cb_4d) * 24 + spin * 6 + color_comp];
-    }
-  }
-  for (int spin = (plus ? 2 : 0); spin < (plus ? 4 : 2); spin++) {
-    for (int color_comp = 0; color_comp < 6; color_comp++) {
-      z[(s * Vh + idx_cb_4d) * 24 + spin * 6 + color_comp] = a * x[(s * Vh + idx_cb_4d) * 24 + spin * 6 + color_comp];
-    }
-  }
-}
+        for (int dir = 0; dir < 8; dir++) {
+          const int d = dir / 2;
+          const uint32_t entry = nbr[i * 8 + dir];
+          const int src = DomainWallNeighborTable::source(entry);
+          const int j = DomainWallNeighborTable::index(entry);
 
-template <typename sFloat>
-void mdw_eofa_m5_ref(sFloat *res, sFloat *spinorField, int oddBit, int daggerBit, sFloat mferm, sFloat m5, sFloat b,
-                     sFloat c, sFloat mq1, sFloat mq2, sFloat mq3, int eofa_pm, sFloat eofa_shift)
-{
-  // res: the output spinor field
-  // spinorField: the input spinor field
-  // oddBit: even-odd bit
-  // daggerBit: dagger or not
-  // mferm: m_f
-
-  sFloat alpha = b + c;
-  sFloat eofa_norm = alpha * (mq3 - mq2) * std::pow(alpha + 1., 2 * Ls)
-    / (std::pow(alpha + 1., Ls) + mq2 * std::pow(alpha - 1., Ls))
-    / (std::pow(alpha + 1., Ls) + mq3 * std::pow(alpha - 1., Ls));
-
-  sFloat kappa = 0.5 * (c * (4. + m5) - 1.) / (b * (4. + m5) + 1.);
-
-  constexpr int spinor_size = 4 * 3 * 2;
-  for (int i = 0; i < V5h; i++) {
-    for (int one_site = 0; one_site < 24; one_site++) { res[i * spinor_size + one_site] = 0.; }
-    for (int dir = 8; dir < 10; dir++) {
-      // Calls for an extension of the original function.
-      // 8 is forward hop, which wants P_+, 9 is backward hop,
-      // which wants P_-.  Dagger reverses these.
-      sFloat *spinor = spinorNeighbor_5d<QUDA_4D_PC>(i, dir, oddBit, spinorField);
-      sFloat projectedSpinor[spinor_size];
-      int projIdx = 2 * (dir / 2) + (dir + daggerBit) % 2;
-      multiplySpinorByDiracProjector5(projectedSpinor, projIdx, spinor);
-      // J  Need a conditional here for s=0 and s=Ls-1.
-      int X = fullLatticeIndex_5d_4dpc(i, oddBit);
-      int xs = X / (Z[3] * Z[2] * Z[1] * Z[0]);
-
-      if ((xs == 0 && dir == 9) || (xs == Ls - 1 && dir == 8)) {
-        ax(projectedSpinor, -mferm, projectedSpinor, spinor_size);
-      }
-      sum(&res[i * spinor_size], &res[i * spinor_size], projectedSpinor, spinor_size);
-    }
-    // 1 + kappa*D5
-    axpby((sFloat)1., &spinorField[i * spinor_size], kappa, &res[i * spinor_size], spinor_size);
-  }
+          gFloat *gauge;
+          if (dir % 2 == 0) gauge = (parity ? gaugeOdd : gaugeEven)[d] + i * gauge_site_size;
+          else if (src == 0) gauge = (parity ? gaugeEven : gaugeOdd)[d] + j * gauge_site_size;
+          else gauge = (parity ? ghostGaugeEven : ghostGaugeOdd)[d] + (j / 2) * gauge_site_size;
 
-  // Initialize
-  std::vector<sFloat> shift_coeffs(Ls);
+          gFloat link[3 * 3 * 2];
+          if (dir % 2 == 0) for (int k = 0; k < 3 * 3 * 2; k++) link[k] = gauge[k];
+          else su3Transpose(link, gauge);
 
-  // Construct Mooee_shift
-  sFloat N = (eofa_pm ? 1.0 : -1.0) * (2.0 * eofa_shift * eofa_norm)
-    * (std::pow(alpha + 1.0, Ls) + mq1 * std::pow(alpha - 1.0, Ls));
+          const HalfProjector &p = half[2 * d + (dir + daggerBit) % 2];
 
-  // For the kappa preconditioning
-  int idx = 0;
-  N *= 1. / (b * (m5 + 4.) + 1.);
-  for (int s = 0; s < Ls; s++) {
-    idx = eofa_pm ? (s) : (Ls - 1 - s);
-    shift_coeffs[idx] = N * std::pow(-1.0, s) * std::pow(alpha - 1.0, s) / std::pow(alpha + 1.0, Ls + s + 1);
-  }
+          for (int s = s_begin; s < Ls; s += s_step) {
+            // the ghost zones hold all Ls slices of the face, checkerboarded in 5-d
+            const sFloat *spinor;
+            if (src == 0) spinor = spinorField + (s * Vh + j) * spinor_site_size;
+            else if (src <= 4) spinor = fwdSpinor[src - 1] + ((s * faceVolume[d] + j) >> 1) * spinor_site_size;
+            else spinor = backSpinor[src - 5] + ((s * faceVolume[d] + j) >> 1) * spinor_site_size;
 
-  // The eofa part.
-  for (int idx_cb_4d = 0; idx_cb_4d < Vh; idx_cb_4d++) {
-    for (int s = 0; s < Ls; s++) {
-      if (daggerBit == 0) {
-        if (eofa_pm) {
-          axpby_ssp_project<true>(res, (sFloat)1., res, shift_coeffs[s], spinorField, idx_cb_4d, s, Ls - 1);
-        } else {
-          axpby_ssp_project<false>(res, (sFloat)1., res, shift_coeffs[s], spinorField, idx_cb_4d, s, 0);
-        }
-      } else {
-        if (eofa_pm) {
-          axpby_ssp_project<true>(res, (sFloat)1., res, shift_coeffs[s], spinorField, idx_cb_4d, Ls - 1, s);
-        } else {
-          axpby_ssp_project<false>(res, (sFloat)1., res, shift_coeffs[s], spinorField, idx_cb_4d, 0, s);
+            halfSpinorHop(hop + s * spinor_site_size, link, spinor, p);
+          }
         }
+
+        epilogue(i, parity, hop, work);
       }
     }
   }
 }
 
-void mdw_eofa_m5(void *res, void *spinorField, int oddBit, int daggerBit, double mferm, double m5, double b, double c,
-                 double mq1, double mq2, double mq3, int eofa_pm, double eofa_shift, QudaPrecision precision)
+/**
+   @brief Apply the 4-d hopping term of parity oddBit to in.  In
+   multi-process builds the spinor and gauge ghost zones are exchanged
+   first.  All of the domain-wall operators below are built on this,
+   and QUDA is checked against them by dslash_ctest, i.e., the
+   dslash_domain-wall*, dslash_mobius* and dslash_mobius_eofa* ctest
+   entries.
+*/
+template <QudaPCType type, typename sFloat, typename Epilogue>
+void dslash4(void **gauge, sFloat *in, int oddBit, int daggerBit, QudaPrecision precision, QudaGaugeParam &gauge_param,
+             const Epilogue &epilogue)
 {
-  if (precision == QUDA_DOUBLE_PRECISION) {
-    mdw_eofa_m5_ref<double>((double *)res, (double *)spinorField, oddBit, daggerBit, mferm, m5, b, c, mq1, mq2, mq3,
-                            eofa_pm, eofa_shift);
-  } else {
-    mdw_eofa_m5_ref<float>((float *)res, (float *)spinorField, oddBit, daggerBit, mferm, m5, b, c, mq1, mq2, mq3,
-                           eofa_pm, eofa_shift);
+#ifndef MULTI_GPU
+  dslashReference_4d<type>((sFloat **)gauge, (sFloat **)nullptr, in, (sFloat **)nullptr, (sFloat **)nullptr, oddBit,
+                           daggerBit, epilogue);
+#else
+
+  GaugeFieldParam gauge_field_param(gauge, gauge_param);
+  gauge_field_param.ghostExchange = QUDA_GHOST_EXCHANGE_PAD;
+  cpuGaugeField cpu(gauge_field_param);
+  void **ghostGauge = (void **)cpu.Ghost();
+
+  // Get spinor ghost fields
+  // First wrap the input spinor into a ColorSpinorField
+  ColorSpinorParam csParam;
+  csParam.v = in;
+  csParam.nColor = 3;
+  csParam.nSpin = 4;
+  csParam.nDim = 5; // for DW dslash
+  for (int d = 0; d < 4; d++) csParam.x[d] = Z[d];
+  csParam.x[4] = Ls; // 5th dimention
+  csParam.setPrecision(precision);
+  csParam.pad = 0;
+  csParam.siteSubset = QUDA_PARITY_SITE_SUBSET;
+  csParam.x[0] /= 2;
+  csParam.siteOrder = QUDA_EVEN_ODD_SITE_ORDER;
+  csParam.fieldOrder = QUDA_SPACE_SPIN_COLOR_FIELD_ORDER;
+  csParam.gammaBasis = QUDA_DEGRAND_ROSSI_GAMMA_BASIS;
+  csParam.create = QUDA_REFERENCE_FIELD_CREATE;
+  csParam.pc_type = type;
+
+  cpuColorSpinorField inField(csParam);
+
+  { // Now do the exchange
+    QudaParity otherParity = QUDA_INVALID_PARITY;
+    if (oddBit == QUDA_EVEN_PARITY) otherParity = QUDA_ODD_PARITY;
+    else if (oddBit == QUDA_ODD_PARITY) otherParity = QUDA_EVEN_PARITY;
+    else errorQuda("ERROR: full parity not supported in function %s", __FUNCTION__);
+    const int nFace = 1;
+
+    inField.exchangeGhost(otherParity, nFace, daggerBit);
   }
-  return;
+  void **fwd_nbr_spinor = inField.fwdGhostFaceBuffer;
+  void **back_nbr_spinor = inField.backGhostFaceBuffer;
+  // NOTE: hopping in 5th dimension does not use MPI.
+  dslashReference_4d<type>((sFloat **)gauge, (sFloat **)ghostGauge, in, (sFloat **)fwd_nbr_spinor,
+                           (sFloat **)back_nbr_spinor, oddBit, daggerBit, epilogue);
+#endif
 }
 
-//Currently we consider only spacetime decomposition (not in 5th dim), so this operator is local
-template <QudaPCType type, bool zero_initialize = false, typename sFloat>
-void dslashReference_5th(sFloat *res, sFloat *spinorField, int oddBit, int daggerBit, sFloat mferm)
+//
+// Fifth-dimension operators.  These are local in 4-d, so they are
+// written for a single 4-d site and act on a contiguous block of the
+// Ls spinors at that site.  They are applied to a whole field with
+// applyFifthDim, or fused into the epilogue of the 4-d hop.
+//
+
+template <typename sFloat> using FifthDimOp = std::function<void(sFloat *out, const sFloat *in)>;
+
+template <typename sFloat> static inline void gatherSite(sFloat *block, const sFloat *field, int i)
 {
-  for (int i = 0; i < V5h; i++) {
-    if (zero_initialize) for(int one_site = 0 ; one_site < 24 ; one_site++)
-      res[i*(4*3*2)+one_site] = 0.0;
-    for (int dir = 8; dir < 10; dir++) {
-      // Calls for an extension of the original function.
-      // 8 is forward hop, which wants P_+, 9 is backward hop,
-      // which wants P_-.  Dagger reverses these.
-      sFloat *spinor = spinorNeighbor_5d<type>(i, dir, oddBit, spinorField);
-      sFloat projectedSpinor[4*3*2];
-      int projIdx = 2*(dir/2)+(dir+daggerBit)%2;
-      multiplySpinorByDiracProjector5(projectedSpinor, projIdx, spinor);
-      //J  Need a conditional here for s=0 and s=Ls-1.
-      int X = (type == QUDA_5D_PC) ? fullLatticeIndex_5d(i, oddBit) : fullLatticeIndex_5d_4dpc(i, oddBit);
-      int xs = X/(Z[3]*Z[2]*Z[1]*Z[0]);
-
-      if ( (xs == 0 && dir == 9) || (xs == Ls-1 && dir == 8) ) {
-        ax(projectedSpinor,(sFloat)(-mferm),projectedSpinor,4*3*2);
-      } 
-      sum(&res[i*(4*3*2)], &res[i*(4*3*2)], projectedSpinor, 4*3*2);
-    }
-  }
+  for (int s = 0; s < Ls; s++)
+    std::copy(field + (s * Vh + i) * spinor_site_size, field + (s * Vh + i + 1) * spinor_site_size,
+              block + s * spinor_site_size);
 }
 
-//Currently we consider only spacetime decomposition (not in 5th dim), so this operator is local
-template <typename sFloat>
-void dslashReference_5th_inv(sFloat *res, sFloat *spinorField, int oddBit, int daggerBit, sFloat mferm, double *kappa)
+template <typename sFloat> static inline void scatterSite(sFloat *field, const sFloat *block, int i)
 {
-  double *inv_Ftr = (double*)malloc(Ls*sizeof(sFloat));
-  double *Ftr = (double*)malloc(Ls*sizeof(sFloat));
-  for(int xs = 0 ; xs < Ls ; xs++)
+  for (int s = 0; s < Ls; s++)
+    std::copy(block + s * spinor_site_size, block + (s + 1) * spinor_site_size,
+              field + (s * Vh + i) * spinor_site_size);
+}
+
+/**
+   @brief Apply a fifth-dimension operator to every 4-d site of a
+   field, out = op(in).  If load_out is set the output block is
+   initialized with the current contents of out, for operators that
+   accumulate.
+*/
+template <typename sFloat, typename Op>
+void applyFifthDim(sFloat *out, const sFloat *in, const Op &op, bool load_out = false)
+{
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
   {
-    inv_Ftr[xs] = 1.0/(1.0+pow(2.0*kappa[xs], Ls)*mferm);
-    Ftr[xs] = -2.0*kappa[xs]*mferm*inv_Ftr[xs]; 
+    std::vector<sFloat> x(Ls * spinor_site_size), y(Ls * spinor_site_size);
+
+#ifdef _OPENMP
+#pragma omp for
+#endif
     for (int i = 0; i < Vh; i++) {
-      memcpy(&res[24*(i+Vh*xs)], &spinorField[24*(i+Vh*xs)], 24*sizeof(sFloat));
+      gatherSite(x.data(), in, i);
+      if (load_out) gatherSite(y.data(), out, i);
+      op(y.data(), x.data());
+      scatterSite(out, y.data(), i);
     }
   }
-  if(daggerBit == 0)
-  {
-    // s = 0
-    for (int i = 0; i < Vh; i++) {
-      ax(&res[12+24*(i+Vh*(Ls-1))],(sFloat)(inv_Ftr[0]), &spinorField[12+24*(i+Vh*(Ls-1))], 12);
-    }
+}
 
-    // s = 1 ... ls-2
-    for(int xs = 0 ; xs <= Ls-2 ; ++xs)
-    {
-      for (int i = 0; i < Vh; i++) {
-        axpy((sFloat)(2.0*kappa[xs]), &res[24*(i+Vh*xs)], &res[24*(i+Vh*(xs+1))], 12);
-        axpy((sFloat)Ftr[xs], &res[12+24*(i+Vh*xs)], &res[12+24*(i+Vh*(Ls-1))], 12);
-      }
-      for (int tmp_s = 0 ; tmp_s < Ls ; tmp_s++)
-        Ftr[tmp_s] *= 2.0*kappa[tmp_s];
-    }
-    for(int xs = 0 ; xs < Ls ; xs++)
-    {
-      Ftr[xs] = -pow(2.0*kappa[xs],Ls-1)*mferm*inv_Ftr[xs]; 
-    }
-    // s = ls-2 ... 0
-    for(int xs = Ls-2 ; xs >=0 ; --xs)
-    {
-      for (int i = 0; i < Vh; i++) {
-        axpy((sFloat)Ftr[xs], &res[24*(i+Vh*(Ls-1))], &res[24*(i+Vh*xs)], 12);
-        axpy((sFloat)(2.0*kappa[xs]), &res[12+24*(i+Vh*(xs+1))], &res[12+24*(i+Vh*xs)], 12);
-      }
-      for (int tmp_s = 0 ; tmp_s < Ls ; tmp_s++)
-        Ftr[tmp_s] /= 2.0*kappa[tmp_s];
-    }
-    // s = ls -1
-    for (int i = 0; i < Vh; i++) {
-      ax(&res[24*(i+Vh*(Ls-1))], (sFloat)(inv_Ftr[Ls-1]), &res[24*(i+Vh*(Ls-1))], 12);
-    }
+// y = a*x + b*y for complex a and b, rounded to the field precision first
+template <typename sFloat> static inline void caxpby(Complex a, const sFloat *x, Complex b, sFloat *y, int len)
+{
+  const sFloat a_re = a.real(), a_im = a.imag(), b_re = b.real(), b_im = b.imag();
+  for (int k = 0; k < len; k += 2) {
+    const sFloat x_re = x[k], x_im = x[k + 1], y_re = y[k], y_im = y[k + 1];
+    y[k + 0] = (a_re * x_re - a_im * x_im) + (b_re * y_re - b_im * y_im);
+    y[k + 1] = (a_re * x_im + a_im * x_re) + (b_re * y_im + b_im * y_re);
   }
-  else
-  {
-    // s = 0
-    for (int i = 0; i < Vh; i++) {
-      ax(&res[24*(i+Vh*(Ls-1))],(sFloat)(inv_Ftr[0]), &spinorField[24*(i+Vh*(Ls-1))], 12);
-    }
+}
 
-    // s = 1 ... ls-2
-    for(int xs = 0 ; xs <= Ls-2 ; ++xs)
-    {
-      for (int i = 0; i < Vh; i++) {
-        axpy((sFloat)Ftr[xs], &res[24*(i+Vh*xs)], &res[24*(i+Vh*(Ls-1))], 12);
-        axpy((sFloat)(2.0*kappa[xs]), &res[12+24*(i+Vh*xs)], &res[12+24*(i+Vh*(xs+1))], 12);
-      }
-      for (int tmp_s = 0 ; tmp_s < Ls ; tmp_s++)
-        Ftr[tmp_s] *= 2.0*kappa[tmp_s];
-    }
-    for(int xs = 0 ; xs < Ls ; xs++)
-    {
-      Ftr[xs] = -pow(2.0*kappa[xs],Ls-1)*mferm*inv_Ftr[xs]; 
-    }
-    // s = ls-2 ... 0
-    for(int xs = Ls-2 ; xs >=0 ; --xs)
-    {
-      for (int i = 0; i < Vh; i++) {
-        axpy((sFloat)(2.0*kappa[xs]), &res[24*(i+Vh*(xs+1))], &res[24*(i+Vh*xs)], 12);
-        axpy((sFloat)Ftr[xs], &res[12+24*(i+Vh*(Ls-1))], &res[12+24*(i+Vh*xs)], 12);
-      }
-      for (int tmp_s = 0 ; tmp_s < Ls ; tmp_s++)
-        Ftr[tmp_s] /= 2.0*kappa[tmp_s];
-    }
-    // s = ls -1
-    for (int i = 0; i < Vh; i++) {
-      ax(&res[12+24*(i+Vh*(Ls-1))], (sFloat)(inv_Ftr[Ls-1]), &res[12+24*(i+Vh*(Ls-1))], 12);
-    }
+// y = a*x + y for complex a
+template <typename sFloat> static inline void caxpy(Complex a, const sFloat *x, sFloat *y, int len)
+{
+  const sFloat a_re = a.real(), a_im = a.imag();
+  for (int k = 0; k < len; k += 2) {
+    const sFloat x_re = x[k], x_im = x[k + 1];
+    y[k + 0] = (a_re * x_re - a_im * x_im) + y[k + 0];
+    y[k + 1] = (a_re * x_im + a_im * x_re) + y[k + 1];
   }
-  free(inv_Ftr);
-  free(Ftr);
 }
 
+// y = a*x for complex a
+template <typename sFloat> static inline void cax(Complex a, const sFloat *x, sFloat *y, int len)
+{
+  const sFloat a_re = a.real(), a_im = a.imag();
+  for (int k = 0; k < len; k += 2) {
+    const sFloat x_re = x[k], x_im = x[k + 1];
+    y[k + 0] = a_re * x_re - a_im * x_im;
+    y[k + 1] = a_re * x_im + a_im * x_re;
+  }
+}
+
+static inline Complex toComplex(double x) { return Complex(x, 0.0); }
+static inline Complex toComplex(double _Complex x) { return reinterpret_cast<const Complex &>(x); }
+
 template <typename sComplex>
 sComplex cpow(const sComplex &x, int y)
 {
@@ -610,332 +427,429 @@ sComplex cpow(const sComplex &x, int y)
   return z;
 }
 
-// Currently we consider only spacetime decomposition (not in 5th dim), so this operator is local
-template <typename sFloat, typename sComplex>
-void mdslashReference_5th_inv(sFloat *res, sFloat *spinorField, int oddBit, int daggerBit, sFloat mferm, sComplex *kappa)
+static inline double powLs(double x, int n) { return pow(x, n); }
+static inline double _Complex powLs(double _Complex x, int n) { return cpow(x, n); }
+
+/**
+   @brief The fifth-dimension hopping term at one 4-d site: the chiral
+   projectors P_+ and P_- (projector[8] and projector[9] above, which
+   carry a factor of two) applied to the s+1 and s-1 neighbours, with
+   the -mferm boundary condition.  With accumulate set the result is
+   added to out rather than overwriting it.
+*/
+template <typename sFloat>
+void hop5Site(sFloat *out, const sFloat *in, int daggerBit, sFloat mferm, bool accumulate)
+{
+  // in the DeGrand-Rossi basis P_+ keeps the lower two spins and P_- the upper two
+  const int fwd_spin = daggerBit ? 0 : 2;
+  const int back_spin = daggerBit ? 2 : 0;
+
+  for (int s = 0; s < Ls; s++) {
+    const sFloat *fwd = in + ((s + 1) % Ls) * spinor_site_size + fwd_spin * (3 * 2);
+    const sFloat *back = in + ((s + Ls - 1) % Ls) * spinor_site_size + back_spin * (3 * 2);
+    const sFloat fwd_coeff = s == Ls - 1 ? -mferm : 1.0;
+    const sFloat back_coeff = s == 0 ? -mferm : 1.0;
+    sFloat *out_fwd = out + s * spinor_site_size + fwd_spin * (3 * 2);
+    sFloat *out_back = out + s * spinor_site_size + back_spin * (3 * 2);
+
+    for (int k = 0; k < 2 * 3 * 2; k++) {
+      const sFloat f = fwd_coeff * (static_cast<sFloat>(2.0) * fwd[k]);
+      const sFloat b = back_coeff * (static_cast<sFloat>(2.0) * back[k]);
+      out_fwd[k] = accumulate ? out_fwd[k] + f : f;
+      out_back[k] = accumulate ? out_back[k] + b : b;
+    }
+  }
+}
+
+// Mobius m5 at one site: out = in + kappa_s D5 in
+template <typename sFloat>
+void m5Site(sFloat *out, const sFloat *in, int daggerBit, sFloat mferm, const Complex *kappa, bool accumulate = false)
+{
+  hop5Site(out, in, daggerBit, mferm, accumulate);
+  for (int s = 0; s < Ls; s++)
+    caxpby(Complex(1.0), in + s * spinor_site_size, kappa[s], out + s * spinor_site_size, spinor_site_size);
+}
+
+// Mobius pre-hop operator at one site: out = b5_s in + c5_s / 2 D5 in
+template <typename sFloat>
+void m4preSite(sFloat *out, const sFloat *in, int daggerBit, sFloat mferm, const Complex *b5, const Complex *half_c5,
+               bool accumulate = false)
 {
-  sComplex *inv_Ftr = (sComplex *)malloc(Ls * sizeof(sComplex));
-  sComplex *Ftr = (sComplex *)malloc(Ls * sizeof(sComplex));
+  hop5Site(out, in, daggerBit, mferm, accumulate);
+  for (int s = 0; s < Ls; s++)
+    caxpby(b5[s], in + s * spinor_site_size, half_c5[s], out + s * spinor_site_size, spinor_site_size);
+}
+
+/**
+   Coefficients of the two sweeps used to invert the fifth-dimension
+   operator (1 - 2 kappa_s D5).  They depend only on kappa and mferm so
+   are computed once per call rather than once per site.
+*/
+struct M5invCoeffs {
+  std::vector<Complex> two_kappa; // hop along the sweep
+  std::vector<Complex> fwd;       // coupling to slice Ls-1 in the forwards sweep
+  std::vector<Complex> back;      // coupling to slice Ls-1 in the backwards sweep
+  Complex inv_first;
+  Complex inv_last;
+};
+
+template <typename kFloat> M5invCoeffs m5invCoefficients(const kFloat *kappa, double mferm)
+{
+  M5invCoeffs c;
+  c.two_kappa.resize(Ls);
+  c.fwd.resize(Ls);
+  c.back.resize(Ls);
+
+  std::vector<kFloat> inv_Ftr(Ls), Ftr(Ls);
   for (int xs = 0; xs < Ls; xs++) {
-    inv_Ftr[xs] = 1.0 / (1.0 + cpow(2.0 * kappa[xs], Ls) * mferm);
+    inv_Ftr[xs] = 1.0 / (1.0 + powLs(2.0 * kappa[xs], Ls) * mferm);
     Ftr[xs] = -2.0 * kappa[xs] * mferm * inv_Ftr[xs];
-    for (int i = 0; i < Vh; i++) {
-      memcpy(&res[24 * (i + Vh * xs)], &spinorField[24 * (i + Vh * xs)], 24 * sizeof(sFloat));
-    }
+    c.two_kappa[xs] = toComplex(2.0 * kappa[xs]);
   }
-  if (daggerBit == 0) {
-    // s = 0
-    for (int i = 0; i < Vh; i++) {
-      ax((sComplex *)&res[12 + 24 * (i + Vh * (Ls - 1))], inv_Ftr[0],
-          (sComplex *)&spinorField[12 + 24 * (i + Vh * (Ls - 1))], 6);
-    }
+  for (int xs = 0; xs <= Ls - 2; ++xs) {
+    c.fwd[xs] = toComplex(Ftr[xs]);
+    for (int tmp_s = 0; tmp_s < Ls; tmp_s++) Ftr[tmp_s] *= 2.0 * kappa[tmp_s];
+  }
+  for (int xs = 0; xs < Ls; xs++) Ftr[xs] = -powLs(2.0 * kappa[xs], Ls - 1) * mferm * inv_Ftr[xs];
+  for (int xs = Ls - 2; xs >= 0; --xs) {
+    c.back[xs] = toComplex(Ftr[xs]);
+    for (int tmp_s = 0; tmp_s < Ls; tmp_s++) Ftr[tmp_s] /= 2.0 * kappa[tmp_s];
+  }
+  c.inv_first = toComplex(inv_Ftr[0]);
+  c.inv_last = toComplex(inv_Ftr[Ls - 1]);
+  return c;
+}
 
-    // s = 1 ... ls-2
-    for (int xs = 0; xs <= Ls - 2; ++xs) {
-      for (int i = 0; i < Vh; i++) {
-        axpy((2.0 * kappa[xs]), (sComplex *)&res[24 * (i + Vh * xs)], (sComplex *)&res[24 * (i + Vh * (xs + 1))], 6);
-        axpy(Ftr[xs], (sComplex *)&res[12 + 24 * (i + Vh * xs)], (sComplex *)&res[12 + 24 * (i + Vh * (Ls - 1))], 6);
-      }
-      for (int tmp_s = 0; tmp_s < Ls; tmp_s++) Ftr[tmp_s] *= 2.0 * kappa[tmp_s];
-    }
-    for (int xs = 0; xs < Ls; xs++) Ftr[xs] = -cpow(2.0 * kappa[xs], Ls - 1) * mferm * inv_Ftr[xs];
+// (1 - 2 kappa_s D5)^{-1} at one site.  Spins 0,1 and 2,3 are the two chiralities.
+template <typename sFloat> void m5invSite(sFloat *out, const sFloat *in, int daggerBit, const M5invCoeffs &c)
+{
+  constexpr int half = spinor_site_size / 2;
+  auto upper = [&](int s) { return out + s * spinor_site_size; };
+  auto lower = [&](int s) { return out + s * spinor_site_size + half; };
+  const int L = Ls - 1;
 
-    // s = ls-2 ... 0
-    for (int xs = Ls - 2; xs >= 0; --xs) {
-      for (int i = 0; i < Vh; i++) {
-        axpy(Ftr[xs], (sComplex *)&res[24 * (i + Vh * (Ls - 1))], (sComplex *)&res[24 * (i + Vh * xs)], 6);
-        axpy((2.0 * kappa[xs]), (sComplex *)&res[12 + 24 * (i + Vh * (xs + 1))],
-            (sComplex *)&res[12 + 24 * (i + Vh * xs)], 6);
-      }
-      for (int tmp_s = 0; tmp_s < Ls; tmp_s++) Ftr[tmp_s] /= 2.0 * kappa[tmp_s];
+  std::copy(in, in + Ls * spinor_site_size, out);
+  if (daggerBit == 0) {
+    cax(c.inv_first, in + L * spinor_site_size + half, lower(L), half);
+    for (int xs = 0; xs <= L - 1; ++xs) {
+      caxpy(c.two_kappa[xs], upper(xs), upper(xs + 1), half);
+      caxpy(c.fwd[xs], lower(xs), lower(L), half);
     }
-    // s = ls -1
-    for (int i = 0; i < Vh; i++) {
-      ax((sComplex *)&res[24 * (i + Vh * (Ls - 1))], inv_Ftr[Ls - 1], (sComplex *)&res[24 * (i + Vh * (Ls - 1))], 6);
+    for (int xs = L - 1; xs >= 0; --xs) {
+      caxpy(c.back[xs], upper(L), upper(xs), half);
+      caxpy(c.two_kappa[xs], lower(xs + 1), lower(xs), half);
     }
+    cax(c.inv_last, upper(L), upper(L), half);
   } else {
-    // s = 0
-    for (int i = 0; i < Vh; i++) {
-      ax((sComplex *)&res[24 * (i + Vh * (Ls - 1))], inv_Ftr[0], (sComplex *)&spinorField[24 * (i + Vh * (Ls - 1))], 6);
+    cax(c.inv_first, in + L * spinor_site_size, upper(L), half);
+    for (int xs = 0; xs <= L - 1; ++xs) {
+      caxpy(c.fwd[xs], upper(xs), upper(L), half);
+      caxpy(c.two_kappa[xs], lower(xs), lower(xs + 1), half);
     }
-
-    // s = 1 ... ls-2
-    for (int xs = 0; xs <= Ls - 2; ++xs) {
-      for (int i = 0; i < Vh; i++) {
-        axpy(Ftr[xs], (sComplex *)&res[24 * (i + Vh * xs)], (sComplex *)&res[24 * (i + Vh * (Ls - 1))], 6);
-        axpy((2.0 * kappa[xs]), (sComplex *)&res[12 + 24 * (i + Vh * xs)],
-            (sComplex *)&res[12 + 24 * (i + Vh * (xs + 1))], 6);
-      }
-      for (int tmp_s = 0; tmp_s < Ls; tmp_s++) Ftr[tmp_s] *= 2.0 * kappa[tmp_s];
-    }
-    for (int xs = 0; xs < Ls; xs++) Ftr[xs] = -cpow(2.0 * kappa[xs], Ls - 1) * mferm * inv_Ftr[xs];
-
-    // s = ls-2 ... 0
-    for (int xs = Ls - 2; xs >= 0; --xs) {
-      for (int i = 0; i < Vh; i++) {
-        axpy((2.0 * kappa[xs]), (sComplex *)&res[24 * (i + Vh * (xs + 1))], (sComplex *)&res[24 * (i + Vh * xs)], 6);
-        axpy(Ftr[xs], (sComplex *)&res[12 + 24 * (i + Vh * (Ls - 1))], (sComplex *)&res[12 + 24 * (i + Vh * xs)], 6);
-      }
-      for (int tmp_s = 0; tmp_s < Ls; tmp_s++) Ftr[tmp_s] /= 2.0 * kappa[tmp_s];
-    }
-    // s = ls -1
-    for (int i = 0; i < Vh; i++) {
-      ax((sComplex *)&res[12 + 24 * (i + Vh * (Ls - 1))], inv_Ftr[Ls - 1],
-          (sComplex *)&res[12 + 24 * (i + Vh * (Ls - 1))], 6);
+    for (int xs = L - 1; xs >= 0; --xs) {
+      caxpy(c.two_kappa[xs], upper(xs + 1), upper(xs), half);
+      caxpy(c.back[xs], lower(L), lower(xs), half);
     }
+    cax(c.inv_last, lower(L), lower(L), half);
   }
-  free(inv_Ftr);
-  free(Ftr);
 }
 
-template <typename sFloat>
-void mdw_eofa_m5inv_ref(sFloat *res, sFloat *spinorField, int oddBit, int daggerBit, sFloat mferm, sFloat m5, sFloat b,
-                        sFloat c, sFloat mq1, sFloat mq2, sFloat mq3, int eofa_pm, sFloat eofa_shift)
+// z += b * P_+/- y on the chirality selected by plus (gamma5 is diagonal in the DeGrand-Rossi basis)
+template <typename sFloat> static inline void axpy_project(bool plus, sFloat b, const sFloat *y, sFloat *z)
 {
-  // res: the output spinor field
-  // spinorField: the input spinor field
-  // oddBit: even-odd bit
-  // daggerBit: dagger or not
-  // mferm: m_f
-
-  sFloat alpha = b + c;
-  sFloat eofa_norm = alpha * (mq3 - mq2) * std::pow(alpha + 1., 2 * Ls)
-    / (std::pow(alpha + 1., Ls) + mq2 * std::pow(alpha - 1., Ls))
-    / (std::pow(alpha + 1., Ls) + mq3 * std::pow(alpha - 1., Ls));
-  sFloat kappa5 = (c * (4. + m5) - 1.) / (b * (4. + m5) + 1.); // alpha = b+c
+  const int begin = plus ? 0 : spinor_site_size / 2;
+  for (int k = begin; k < begin + spinor_site_size / 2; k++) z[k] = z[k] + b * y[k];
+}
 
-  using sComplex = double _Complex;
+/**
+   Coefficients of the EOFA (exact one flavor algorithm) m5 operator
+   and of its inverse, which is the Mobius inverse plus a rank-one
+   Sherman-Morrison correction.  These are computed once per call in
+   the field precision.
+*/
+template <typename sFloat> struct EofaCoeffs {
+  int daggerBit;
+  int eofa_pm;
+  sFloat mferm;
+  sFloat kappa;                   // fifth-dimension hopping coefficient of m5
+  std::vector<sFloat> shift;      // m5 shift coefficients
+  M5invCoeffs m5inv;              // the Mobius part of m5inv
+  std::vector<sFloat> sherman;    // Ls x Ls rank-one correction of m5inv
+
+  EofaCoeffs(int daggerBit, sFloat mferm, sFloat m5, sFloat b, sFloat c, sFloat mq1, sFloat mq2, sFloat mq3,
+             int eofa_pm, sFloat eofa_shift) :
+    daggerBit(daggerBit), eofa_pm(eofa_pm), mferm(mferm), shift(Ls), sherman(Ls * Ls)
+  {
+    sFloat alpha = b + c;
+    sFloat eofa_norm = alpha * (mq3 - mq2) * std::pow(alpha + 1., 2 * Ls)
+      / (std::pow(alpha + 1., Ls) + mq2 * std::pow(alpha - 1., Ls))
+      / (std::pow(alpha + 1., Ls) + mq3 * std::pow(alpha - 1., Ls));
 
-  std::vector<sComplex> kappa_array(Ls, -0.5 * kappa5);
-  std::vector<sFloat> eofa_u(Ls);
-  std::vector<sFloat> eofa_x(Ls);
-  std::vector<sFloat> eofa_y(Ls);
+    kappa = 0.5 * (c * (4. + m5) - 1.) / (b * (4. + m5) + 1.);
 
-  mdslashReference_5th_inv(res, spinorField, oddBit, daggerBit, mferm, kappa_array.data());
+    // Construct Mooee_shift
+    sFloat N = (eofa_pm ? 1.0 : -1.0) * (2.0 * eofa_shift * eofa_norm)
+      * (std::pow(alpha + 1.0, Ls) + mq1 * std::pow(alpha - 1.0, Ls));
 
-  sFloat N = (eofa_pm ? +1. : -1.) * (2. * eofa_shift * eofa_norm)
-    * (std::pow(alpha + 1., Ls) + mq1 * std::pow(alpha - 1., Ls)) / (b * (m5 + 4.) + 1.);
+    // For the kappa preconditioning
+    N *= 1. / (b * (m5 + 4.) + 1.);
+    for (int s = 0; s < Ls; s++) {
+      int idx = eofa_pm ? (s) : (Ls - 1 - s);
+      shift[idx] = N * std::pow(-1.0, s) * std::pow(alpha - 1.0, s) / std::pow(alpha + 1.0, Ls + s + 1);
+    }
 
-  // Here the signs are somewhat mixed:
-  // There is one -1 from N for eofa_pm = minus, thus the u_- here is actually -u_- in the document
-  // It turns out this actually simplies things.
-  for (int s = 0; s < Ls; s++) {
-    eofa_u[eofa_pm ? s : Ls - 1 - s] = N * std::pow(-1., s) * std::pow(alpha - 1., s) / std::pow(alpha + 1., Ls + s + 1);
-  }
+    // the inverse
+    sFloat kappa5 = (c * (4. + m5) - 1.) / (b * (4. + m5) + 1.); // alpha = b+c
+
+    using sComplex = double _Complex;
+    std::vector<sComplex> kappa_array(Ls, -0.5 * kappa5);
+    m5inv = m5invCoefficients(kappa_array.data(), mferm);
+
+    std::vector<sFloat> eofa_u(Ls);
+    std::vector<sFloat> eofa_x(Ls);
+    std::vector<sFloat> eofa_y(Ls);
 
-  sFloat sherman_morrison_fac;
+    N = (eofa_pm ? +1. : -1.) * (2. * eofa_shift * eofa_norm)
+      * (std::pow(alpha + 1., Ls) + mq1 * std::pow(alpha - 1., Ls)) / (b * (m5 + 4.) + 1.);
 
-  sFloat factor = -kappa5 * mferm;
-  if (eofa_pm) {
-    // eofa_pm = plus
-    // Computing x
-    eofa_x[0] = eofa_u[0];
-    for (int s = Ls - 1; s > 0; s--) {
-      eofa_x[0] -= factor * eofa_u[s];
-      factor *= -kappa5;
+    // Here the signs are somewhat mixed:
+    // There is one -1 from N for eofa_pm = minus, thus the u_- here is actually -u_- in the document
+    // It turns out this actually simplies things.
+    for (int s = 0; s < Ls; s++) {
+      eofa_u[eofa_pm ? s : Ls - 1 - s] = N * std::pow(-1., s) * std::pow(alpha - 1., s) / std::pow(alpha + 1., Ls + s + 1);
     }
-    eofa_x[0] /= 1. + factor;
-    for (int s = 1; s < Ls; s++) { eofa_x[s] = eofa_x[s - 1] * (-kappa5) + eofa_u[s]; }
-    // Computing y
-    eofa_y[Ls - 1] = 1. / (1. + factor);
-    sherman_morrison_fac = eofa_x[Ls - 1];
-    for (int s = Ls - 1; s > 0; s--) { eofa_y[s - 1] = eofa_y[s] * (-kappa5); }
-  } else {
-    // eofa_pm = minus
-    // Computing x
-    eofa_x[Ls - 1] = eofa_u[Ls - 1];
-    for (int s = 0; s < Ls - 1; s++) {
-      eofa_x[Ls - 1] -= factor * eofa_u[s];
-      factor *= -kappa5;
+
+    sFloat sherman_morrison_fac;
+
+    sFloat factor = -kappa5 * mferm;
+    if (eofa_pm) {
+      // eofa_pm = plus
+      // Computing x
+      eofa_x[0] = eofa_u[0];
+      for (int s = Ls - 1; s > 0; s--) {
+        eofa_x[0] -= factor * eofa_u[s];
+        factor *= -kappa5;
+      }
+      eofa_x[0] /= 1. + factor;
+      for (int s = 1; s < Ls; s++) { eofa_x[s] = eofa_x[s - 1] * (-kappa5) + eofa_u[s]; }
+      // Computing y
+      eofa_y[Ls - 1] = 1. / (1. + factor);
+      sherman_morrison_fac = eofa_x[Ls - 1];
+      for (int s = Ls - 1; s > 0; s--) { eofa_y[s - 1] = eofa_y[s] * (-kappa5); }
+    } else {
+      // eofa_pm = minus
+      // Computing x
+      eofa_x[Ls - 1] = eofa_u[Ls - 1];
+      for (int s = 0; s < Ls - 1; s++) {
+        eofa_x[Ls - 1] -= factor * eofa_u[s];
+        factor *= -kappa5;
+      }
+      eofa_x[Ls - 1] /= 1. + factor;
+      for (int s = Ls - 1; s > 0; s--) { eofa_x[s - 1] = eofa_x[s] * (-kappa5) + eofa_u[s - 1]; }
+      // Computing y
+      eofa_y[0] = 1. / (1. + factor);
+      sherman_morrison_fac = eofa_x[0];
+      for (int s = 1; s < Ls; s++) { eofa_y[s] = eofa_y[s - 1] * (-kappa5); }
     }
-    eofa_x[Ls - 1] /= 1. + factor;
-    for (int s = Ls - 1; s > 0; s--) { eofa_x[s - 1] = eofa_x[s] * (-kappa5) + eofa_u[s - 1]; }
-    // Computing y
-    eofa_y[0] = 1. / (1. + factor);
-    sherman_morrison_fac = eofa_x[0];
-    for (int s = 1; s < Ls; s++) { eofa_y[s] = eofa_y[s - 1] * (-kappa5); }
-  }
-  sherman_morrison_fac = -0.5 / (1. + sherman_morrison_fac); // 0.5 for the spin project factor
+    sherman_morrison_fac = -0.5 / (1. + sherman_morrison_fac); // 0.5 for the spin project factor
 
-  // The EOFA stuff
-  for (int idx_cb_4d = 0; idx_cb_4d < Vh; idx_cb_4d++) {
     for (int s = 0; s < Ls; s++) {
       for (int sp = 0; sp < Ls; sp++) {
         sFloat t = 2.0 * sherman_morrison_fac;
-        if (daggerBit == 0) {
-          t *= eofa_x[s] * eofa_y[sp];
-          if (eofa_pm) {
-            axpby_ssp_project<true>(res, (sFloat)1., res, t, spinorField, idx_cb_4d, s, sp);
-          } else {
-            axpby_ssp_project<false>(res, (sFloat)1., res, t, spinorField, idx_cb_4d, s, sp);
-          }
-        } else {
-          t *= eofa_y[s] * eofa_x[sp];
-          if (eofa_pm) {
-            axpby_ssp_project<true>(res, (sFloat)1., res, t, spinorField, idx_cb_4d, s, sp);
-          } else {
-            axpby_ssp_project<false>(res, (sFloat)1., res, t, spinorField, idx_cb_4d, s, sp);
-          }
-        }
+        t *= daggerBit == 0 ? eofa_x[s] * eofa_y[sp] : eofa_y[s] * eofa_x[sp];
+        sherman[s * Ls + sp] = t;
       }
     }
   }
+};
+
+// EOFA m5 at one site
+template <typename sFloat> void eofaM5Site(sFloat *out, const sFloat *in, const EofaCoeffs<sFloat> &e)
+{
+  hop5Site(out, in, e.daggerBit, e.mferm, false);
+  // 1 + kappa*D5
+  for (int s = 0; s < Ls; s++) {
+    for (int k = 0; k < spinor_site_size; k++)
+      out[s * spinor_site_size + k] = in[s * spinor_site_size + k] + e.kappa * out[s * spinor_site_size + k];
+  }
+
+  // The eofa part.
+  const int edge = e.eofa_pm ? Ls - 1 : 0;
+  for (int s = 0; s < Ls; s++) {
+    if (e.daggerBit == 0)
+      axpy_project(e.eofa_pm, e.shift[s], in + edge * spinor_site_size, out + s * spinor_site_size);
+    else
+      axpy_project(e.eofa_pm, e.shift[s], in + s * spinor_site_size, out + edge * spinor_site_size);
+  }
+}
+
+// EOFA m5inv at one site
+template <typename sFloat> void eofaM5invSite(sFloat *out, const sFloat *in, const EofaCoeffs<sFloat> &e)
+{
+  m5invSite(out, in, e.daggerBit, e.m5inv);
+  for (int s = 0; s < Ls; s++)
+    for (int sp = 0; sp < Ls; sp++)
+      axpy_project(e.eofa_pm, e.sherman[s * Ls + sp], in + sp * spinor_site_size, out + s * spinor_site_size);
+}
+
+/**
+   @brief The fused 4-d hop used by the Mobius operators,
+
+     out = x_op(x) + a_s * post(D4 pre(in)),
+
+   where pre is a fifth-dimension operator and post a sequence of them
+   (both may be empty), and the x term is only present when x is
+   non-null (x_op may be empty, in which case it is x itself).  The
+   pre stage is a separate pass since the hop needs it at the
+   neighbouring sites, but post and the x term are applied to each
+   site as soon as its hop is complete.
+*/
+template <typename sFloat>
+void mdwHop(sFloat *out, void **gauge, sFloat *in, int oddBit, int daggerBit, QudaPrecision precision,
+            QudaGaugeParam &gauge_param, const FifthDimOp<sFloat> &pre, const std::vector<FifthDimOp<sFloat>> &post,
+            const sFloat *x = nullptr, const FifthDimOp<sFloat> &x_op = nullptr, const std::vector<Complex> &a = {})
+{
+  std::vector<sFloat> tmp;
+  if (pre) {
+    tmp.resize(V5h * spinor_site_size);
+    applyFifthDim(tmp.data(), in, pre);
+    in = tmp.data();
+  }
+
+  dslash4<QUDA_4D_PC>(gauge, in, oddBit, daggerBit, precision, gauge_param,
+                      [&](int i, int, sFloat *hop, sFloat *work) {
+                        sFloat *y = hop;
+                        sFloat *spare = work;
+                        for (auto &op : post) {
+                          op(spare, y);
+                          std::swap(y, spare);
+                        }
+
+                        if (x) {
+                          gatherSite(spare, x, i);
+                          const sFloat *x_site = spare;
+                          if (x_op) {
+                            sFloat *other = work + Ls * spinor_site_size;
+                            x_op(other, spare);
+                            x_site = other;
+                          }
+                          for (int s = 0; s < Ls; s++)
+                            caxpby(Complex(1.0), x_site + s * spinor_site_size, a[s], y + s * spinor_site_size,
+                                   spinor_site_size);
+                        }
+
+                        scatterSite(out, y, i);
+                      });
+}
+
+template <typename sFloat>
+void mdw_eofa_m5_ref(sFloat *res, sFloat *spinorField, int daggerBit, sFloat mferm, sFloat m5, sFloat b, sFloat c,
+                     sFloat mq1, sFloat mq2, sFloat mq3, int eofa_pm, sFloat eofa_shift)
+{
+  const EofaCoeffs<sFloat> eofa(daggerBit, mferm, m5, b, c, mq1, mq2, mq3, eofa_pm, eofa_shift);
+  applyFifthDim(res, spinorField, [&](sFloat *out, const sFloat *in) { eofaM5Site(out, in, eofa); });
+}
+
+void mdw_eofa_m5(void *res, void *spinorField, int oddBit, int daggerBit, double mferm, double m5, double b, double c,
+                 double mq1, double mq2, double mq3, int eofa_pm, double eofa_shift, QudaPrecision precision)
+{
+  if (precision == QUDA_DOUBLE_PRECISION) {
+    mdw_eofa_m5_ref<double>((double *)res, (double *)spinorField, daggerBit, mferm, m5, b, c, mq1, mq2, mq3, eofa_pm,
+                            eofa_shift);
+  } else {
+    mdw_eofa_m5_ref<float>((float *)res, (float *)spinorField, daggerBit, mferm, m5, b, c, mq1, mq2, mq3, eofa_pm,
+                           eofa_shift);
+  }
+  return;
+}
+
+//Currently we consider only spacetime decomposition (not in 5th dim), so this operator is local
+template <typename sFloat>
+void dslashReference_5th(sFloat *res, sFloat *spinorField, int daggerBit, sFloat mferm, bool zero_initialize)
+{
+  applyFifthDim(
+    res, spinorField, [&](sFloat *out, const sFloat *in) { hop5Site(out, in, daggerBit, mferm, !zero_initialize); },
+    !zero_initialize);
+}
+
+//Currently we consider only spacetime decomposition (not in 5th dim), so this operator is local
+template <typename sFloat, typename kFloat>
+void dslashReference_5th_inv(sFloat *res, sFloat *spinorField, int daggerBit, sFloat mferm, const kFloat *kappa)
+{
+  const M5invCoeffs coeffs = m5invCoefficients(kappa, mferm);
+  applyFifthDim(res, spinorField, [&](sFloat *out, const sFloat *in) { m5invSite(out, in, daggerBit, coeffs); });
+}
+
+template <typename sFloat>
+void mdw_eofa_m5inv_ref(sFloat *res, sFloat *spinorField, int daggerBit, sFloat mferm, sFloat m5, sFloat b, sFloat c,
+                        sFloat mq1, sFloat mq2, sFloat mq3, int eofa_pm, sFloat eofa_shift)
+{
+  const EofaCoeffs<sFloat> eofa(daggerBit, mferm, m5, b, c, mq1, mq2, mq3, eofa_pm, eofa_shift);
+  applyFifthDim(res, spinorField, [&](sFloat *out, const sFloat *in) { eofaM5invSite(out, in, eofa); });
 }
 
 void mdw_eofa_m5inv(void *res, void *spinorField, int oddBit, int daggerBit, double mferm, double m5, double b, double c,
                     double mq1, double mq2, double mq3, int eofa_pm, double eofa_shift, QudaPrecision precision)
 {
   if (precision == QUDA_DOUBLE_PRECISION) {
-    mdw_eofa_m5inv_ref<double>((double *)res, (double *)spinorField, oddBit, daggerBit, mferm, m5, b, c, mq1, mq2, mq3,
+    mdw_eofa_m5inv_ref<double>((double *)res, (double *)spinorField, daggerBit, mferm, m5, b, c, mq1, mq2, mq3,
                                eofa_pm, eofa_shift);
   } else {
-    mdw_eofa_m5inv_ref<float>((float *)res, (float *)spinorField, oddBit, daggerBit, mferm, m5, b, c, mq1, mq2, mq3,
-                              eofa_pm, eofa_shift);
+    mdw_eofa_m5inv_ref<float>((float *)res, (float *)spinorField, daggerBit, mferm, m5, b, c, mq1, mq2, mq3, eofa_pm,
+                              eofa_shift);
   }
   return;
 }
 
+template <QudaPCType type, typename sFloat>
+void dslashReference_4d_store(sFloat *out, void **gauge, sFloat *in, int oddBit, int daggerBit,
+                              QudaPrecision precision, QudaGaugeParam &gauge_param)
+{
+  dslash4<type>(gauge, in, oddBit, daggerBit, precision, gauge_param, [&](int i, int parity, sFloat *hop, sFloat *) {
+    const int s_begin = type == QUDA_4D_PC ? 0 : (parity + oddBit) % 2;
+    const int s_step = type == QUDA_4D_PC ? 1 : 2;
+    for (int s = s_begin; s < Ls; s += s_step)
+      std::copy(hop + s * spinor_site_size, hop + (s + 1) * spinor_site_size, out + (s * Vh + i) * spinor_site_size);
+  });
+}
+
 // this actually applies the preconditioned dslash, e.g., D_ee^{-1} D_eo or D_oo^{-1} D_oe
 void dw_dslash(void *out, void **gauge, void *in, int oddBit, int daggerBit, QudaPrecision precision,
     QudaGaugeParam &gauge_param, double mferm)
 {
-#ifndef MULTI_GPU
   if (precision == QUDA_DOUBLE_PRECISION) {
-    dslashReference_4d_sgpu<QUDA_5D_PC>((double*)out, (double**)gauge, (double*)in, oddBit, daggerBit);
-    dslashReference_5th<QUDA_5D_PC>((double*)out, (double*)in, oddBit, daggerBit, mferm);
+    dslashReference_4d_store<QUDA_5D_PC>((double *)out, gauge, (double *)in, oddBit, daggerBit, precision, gauge_param);
+    dslashReference_5th((double *)out, (double *)in, daggerBit, mferm, false);
   } else {
-    dslashReference_4d_sgpu<QUDA_5D_PC>((float*)out, (float**)gauge, (float*)in, oddBit, daggerBit);
-    dslashReference_5th<QUDA_5D_PC>((float*)out, (float*)in, oddBit, daggerBit, (float)mferm);
+    dslashReference_4d_store<QUDA_5D_PC>((float *)out, gauge, (float *)in, oddBit, daggerBit, precision, gauge_param);
+    dslashReference_5th((float *)out, (float *)in, daggerBit, (float)mferm, false);
   }
-#else
-
-    GaugeFieldParam gauge_field_param(gauge, gauge_param);
-    gauge_field_param.ghostExchange = QUDA_GHOST_EXCHANGE_PAD;
-    cpuGaugeField cpu(gauge_field_param);
-    void **ghostGauge = (void**)cpu.Ghost();    
-  
-    // Get spinor ghost fields
-    // First wrap the input spinor into a ColorSpinorField
-    ColorSpinorParam csParam;
-    csParam.v = in;
-    csParam.nColor = 3;
-    csParam.nSpin = 4;
-    csParam.nDim = 5; //for DW dslash
-    for (int d=0; d<4; d++) csParam.x[d] = Z[d];
-    csParam.x[4] = Ls;//5th dimention
-    csParam.setPrecision(precision);
-    csParam.pad = 0;
-    csParam.siteSubset = QUDA_PARITY_SITE_SUBSET;
-    csParam.x[0] /= 2;
-    csParam.siteOrder = QUDA_EVEN_ODD_SITE_ORDER;
-    csParam.fieldOrder = QUDA_SPACE_SPIN_COLOR_FIELD_ORDER;
-    csParam.gammaBasis = QUDA_DEGRAND_ROSSI_GAMMA_BASIS;
-    csParam.create = QUDA_REFERENCE_FIELD_CREATE;
-    csParam.pc_type = QUDA_5D_PC;
-
-    cpuColorSpinorField inField(csParam);
-
-    {  // Now do the exchange
-      QudaParity otherParity = QUDA_INVALID_PARITY;
-      if (oddBit == QUDA_EVEN_PARITY) otherParity = QUDA_ODD_PARITY;
-      else if (oddBit == QUDA_ODD_PARITY) otherParity = QUDA_EVEN_PARITY;
-      else errorQuda("ERROR: full parity not supported in function %s", __FUNCTION__);
-      const int nFace = 1;
-
-      inField.exchangeGhost(otherParity, nFace, daggerBit);
-    }
-    void** fwd_nbr_spinor = inField.fwdGhostFaceBuffer;
-    void** back_nbr_spinor = inField.backGhostFaceBuffer;
-  //NOTE: hopping  in 5th dimension does not use MPI. 
-    if (precision == QUDA_DOUBLE_PRECISION) {
-      dslashReference_4d_mgpu<QUDA_5D_PC>((double*)out, (double**)gauge, (double**)ghostGauge, (double*)in,(double**)fwd_nbr_spinor, (double**)back_nbr_spinor, oddBit, daggerBit);
-      //dslashReference_4d_sgpu<QUDA_5D_PC>((double*)out, (double**)gauge, (double*)in, oddBit, daggerBit);
-      dslashReference_5th<QUDA_5D_PC>((double*)out, (double*)in, oddBit, daggerBit, mferm);
-    } else {
-      dslashReference_4d_mgpu<QUDA_5D_PC>((float*)out, (float**)gauge, (float**)ghostGauge, (float*)in,
-					  (float**)fwd_nbr_spinor, (float**)back_nbr_spinor, oddBit, daggerBit);
-      dslashReference_5th<QUDA_5D_PC>((float*)out, (float*)in, oddBit, daggerBit, (float)mferm);
-    }
-
-#endif
-
 }
 
-void dslash_4_4d(void *out, void **gauge, void *in, int oddBit, int daggerBit, QudaPrecision precision, QudaGaugeParam &gauge_param, double mferm) 
+void dslash_4_4d(void *out, void **gauge, void *in, int oddBit, int daggerBit, QudaPrecision precision, QudaGaugeParam &gauge_param, double mferm)
 {
-#ifndef MULTI_GPU
   if (precision == QUDA_DOUBLE_PRECISION) {
-    dslashReference_4d_sgpu<QUDA_4D_PC>((double*)out, (double**)gauge, (double*)in, oddBit, daggerBit);
+    dslashReference_4d_store<QUDA_4D_PC>((double *)out, gauge, (double *)in, oddBit, daggerBit, precision, gauge_param);
   } else {
-    dslashReference_4d_sgpu<QUDA_4D_PC>((float*)out, (float**)gauge, (float*)in, oddBit, daggerBit);
+    dslashReference_4d_store<QUDA_4D_PC>((float *)out, gauge, (float *)in, oddBit, daggerBit, precision, gauge_param);
   }
-#else
-
-    GaugeFieldParam gauge_field_param(gauge, gauge_param);
-    gauge_field_param.ghostExchange = QUDA_GHOST_EXCHANGE_PAD;
-    cpuGaugeField cpu(gauge_field_param);
-    void **ghostGauge = (void**)cpu.Ghost();    
-  
-    // Get spinor ghost fields
-    // First wrap the input spinor into a ColorSpinorField
-    ColorSpinorParam csParam;
-    csParam.v = in;
-    csParam.nColor = 3;
-    csParam.nSpin = 4;
-    csParam.nDim = 5; //for DW dslash
-    for (int d=0; d<4; d++) csParam.x[d] = Z[d];
-    csParam.x[4] = Ls;//5th dimention
-    csParam.setPrecision(precision);
-    csParam.pad = 0;
-    csParam.siteSubset = QUDA_PARITY_SITE_SUBSET;
-    csParam.x[0] /= 2;
-    csParam.siteOrder = QUDA_EVEN_ODD_SITE_ORDER;
-    csParam.fieldOrder = QUDA_SPACE_SPIN_COLOR_FIELD_ORDER;
-    csParam.gammaBasis = QUDA_DEGRAND_ROSSI_GAMMA_BASIS;
-    csParam.create = QUDA_REFERENCE_FIELD_CREATE;
-    csParam.pc_type = QUDA_4D_PC;
-
-    cpuColorSpinorField inField(csParam);
-
-    {  // Now do the exchange
-      QudaParity otherParity = QUDA_INVALID_PARITY;
-      if (oddBit == QUDA_EVEN_PARITY) otherParity = QUDA_ODD_PARITY;
-      else if (oddBit == QUDA_ODD_PARITY) otherParity = QUDA_EVEN_PARITY;
-      else errorQuda("ERROR: full parity not supported in function %s", __FUNCTION__);
-      const int nFace = 1;
-
-      inField.exchangeGhost(otherParity, nFace, daggerBit);
-    }
-    void** fwd_nbr_spinor = inField.fwdGhostFaceBuffer;
-    void** back_nbr_spinor = inField.backGhostFaceBuffer;
-    if (precision == QUDA_DOUBLE_PRECISION) {
-      dslashReference_4d_mgpu<QUDA_4D_PC>((double*)out, (double**)gauge, (double**)ghostGauge, (double*)in,(double**)fwd_nbr_spinor, (double**)back_nbr_spinor, oddBit, daggerBit);
-    } else {
-      dslashReference_4d_mgpu<QUDA_4D_PC>((float*)out, (float**)gauge, (float**)ghostGauge, (float*)in,
-					  (float**)fwd_nbr_spinor, (float**)back_nbr_spinor, oddBit, daggerBit);
-    }
-
-#endif
-
 }
 
 void dw_dslash_5_4d(void *out, void **gauge, void *in, int oddBit, int daggerBit, QudaPrecision precision, QudaGaugeParam &gauge_param, double mferm, bool zero_initialize)
 {
   if (precision == QUDA_DOUBLE_PRECISION) {
-    if (zero_initialize) dslashReference_5th<QUDA_4D_PC, true>((double*)out, (double*)in, oddBit, daggerBit, mferm);
-    else dslashReference_5th<QUDA_4D_PC, false>((double*)out, (double*)in, oddBit, daggerBit, mferm);
+    dslashReference_5th((double *)out, (double *)in, daggerBit, mferm, zero_initialize);
   } else {
-    if (zero_initialize) dslashReference_5th<QUDA_4D_PC, true>((float*)out, (float*)in, oddBit, daggerBit, (float)mferm);
-    else dslashReference_5th<QUDA_4D_PC, false>((float*)out, (float*)in, oddBit, daggerBit, (float)mferm);
+    dslashReference_5th((float *)out, (float *)in, daggerBit, (float)mferm, zero_initialize);
   }
 }
 
-void dslash_5_inv(void *out, void **gauge, void *in, int oddBit, int daggerBit, QudaPrecision precision, QudaGaugeParam &gauge_param, double mferm, double *kappa) 
+void dslash_5_inv(void *out, void **gauge, void *in, int oddBit, int daggerBit, QudaPrecision precision, QudaGaugeParam &gauge_param, double mferm, double *kappa)
 {
   if (precision == QUDA_DOUBLE_PRECISION) {
-    dslashReference_5th_inv((double*)out, (double*)in, oddBit, daggerBit, mferm, kappa);
+    dslashReference_5th_inv((double*)out, (double*)in, daggerBit, mferm, kappa);
   } else {
-    dslashReference_5th_inv((float*)out, (float*)in, oddBit, daggerBit, (float)mferm, kappa);
+    dslashReference_5th_inv((float*)out, (float*)in, daggerBit, (float)mferm, kappa);
   }
 }
 
@@ -943,51 +857,170 @@ void mdw_dslash_5_inv(void *out, void **gauge, void *in, int oddBit, int daggerB
     QudaGaugeParam &gauge_param, double mferm, double _Complex *kappa)
 {
   if (precision == QUDA_DOUBLE_PRECISION) {
-    mdslashReference_5th_inv((double *)out, (double *)in, oddBit, daggerBit, mferm, kappa);
+    dslashReference_5th_inv((double *)out, (double *)in, daggerBit, mferm, kappa);
   } else {
-    mdslashReference_5th_inv((float *)out, (float *)in, oddBit, daggerBit, (float)mferm, kappa);
+    dslashReference_5th_inv((float *)out, (float *)in, daggerBit, (float)mferm, kappa);
   }
 }
 
+static std::vector<Complex> toComplexArray(const double _Complex *x)
+{
+  std::vector<Complex> z(Ls);
+  for (int s = 0; s < Ls; s++) z[s] = toComplex(x[s]);
+  return z;
+}
+
+template <typename sFloat>
+void mdw_dslash_5_ref(sFloat *out, sFloat *in, int daggerBit, sFloat mferm, double _Complex *kappa, bool zero_initialize)
+{
+  const auto k = toComplexArray(kappa);
+  applyFifthDim(
+    out, in, [&](sFloat *y, const sFloat *x) { m5Site(y, x, daggerBit, mferm, k.data(), !zero_initialize); },
+    !zero_initialize);
+}
+
 void mdw_dslash_5(void *out, void **gauge, void *in, int oddBit, int daggerBit, QudaPrecision precision,
     QudaGaugeParam &gauge_param, double mferm, double _Complex *kappa, bool zero_initialize)
 {
   if (precision == QUDA_DOUBLE_PRECISION) {
-    if (zero_initialize) dslashReference_5th<QUDA_4D_PC,true>((double*)out, (double*)in, oddBit, daggerBit, mferm);
-    else dslashReference_5th<QUDA_4D_PC,false>((double*)out, (double*)in, oddBit, daggerBit, mferm);
+    mdw_dslash_5_ref((double *)out, (double *)in, daggerBit, mferm, kappa, zero_initialize);
   } else {
-    if (zero_initialize) dslashReference_5th<QUDA_4D_PC,true>((float*)out, (float*)in, oddBit, daggerBit, (float)mferm);
-    else dslashReference_5th<QUDA_4D_PC,false>((float*)out, (float*)in, oddBit, daggerBit, (float)mferm);
+    mdw_dslash_5_ref((float *)out, (float *)in, daggerBit, (float)mferm, kappa, zero_initialize);
   }
-  for(int xs = 0 ; xs < Ls ; xs++) {
-    cxpay((char *)in + precision * Vh * spinor_site_size * xs, kappa[xs],
-          (char *)out + precision * Vh * spinor_site_size * xs, Vh * spinor_site_size, precision);
+}
+
+template <typename sFloat>
+void mdw_dslash_4_pre_ref(sFloat *out, sFloat *in, int daggerBit, sFloat mferm, double _Complex *b5,
+                          double _Complex *c5, bool zero_initialize)
+{
+  std::vector<Complex> b(Ls), half_c(Ls);
+  for (int s = 0; s < Ls; s++) {
+    b[s] = toComplex(b5[s]);
+    half_c[s] = toComplex(0.5 * c5[s]);
   }
+  applyFifthDim(
+    out, in,
+    [&](sFloat *y, const sFloat *x) { m4preSite(y, x, daggerBit, mferm, b.data(), half_c.data(), !zero_initialize); },
+    !zero_initialize);
 }
 
 void mdw_dslash_4_pre(void *out, void **gauge, void *in, int oddBit, int daggerBit, QudaPrecision precision,
     QudaGaugeParam &gauge_param, double mferm, double _Complex *b5, double _Complex *c5, bool zero_initialize)
 {
   if (precision == QUDA_DOUBLE_PRECISION) {
-    if (zero_initialize) dslashReference_5th<QUDA_4D_PC, true>((double*)out, (double*)in, oddBit, daggerBit, mferm);
-    else dslashReference_5th<QUDA_4D_PC, false>((double*)out, (double*)in, oddBit, daggerBit, mferm);
-    for(int xs = 0 ; xs < Ls ; xs++)
-    {
-      axpby(b5[xs], (double _Complex *)in + Vh * spinor_site_size / 2 * xs, 0.5 * c5[xs],
-            (double _Complex *)out + Vh * spinor_site_size / 2 * xs, Vh * spinor_site_size / 2);
-    }
+    mdw_dslash_4_pre_ref((double *)out, (double *)in, daggerBit, mferm, b5, c5, zero_initialize);
   } else {
-    if (zero_initialize)
-      dslashReference_5th<QUDA_4D_PC, true>((float *)out, (float *)in, oddBit, daggerBit, (float)mferm);
-    else dslashReference_5th<QUDA_4D_PC,false>((float*)out, (float*)in, oddBit, daggerBit, (float)mferm);
-    for(int xs = 0 ; xs < Ls ; xs++)
-    {
-      axpby((float _Complex)(b5[xs]), (float _Complex *)in + Vh * (spinor_site_size / 2) * xs,
-            (float _Complex)(0.5 * c5[xs]), (float _Complex *)out + Vh * (spinor_site_size / 2) * xs,
-            Vh * spinor_site_size / 2);
+    mdw_dslash_4_pre_ref((float *)out, (float *)in, daggerBit, (float)mferm, b5, c5, zero_initialize);
+  }
+}
+
+/**
+   The fifth-dimension operators that make up the Mobius and EOFA
+   matrices, bound to their coefficients.  m5 is the diagonal block
+   M5, m5inv its inverse and m4pre the operator applied before (or
+   after, for the dagger) the 4-d hop.
+*/
+template <typename sFloat> struct MobiusOps {
+  FifthDimOp<sFloat> m5;
+  FifthDimOp<sFloat> m5inv;
+  FifthDimOp<sFloat> m4pre;
+};
+
+template <typename sFloat> struct MobiusCoeffs {
+  std::vector<Complex> b5, half_c5, kappa5;
+  M5invCoeffs m5inv;
+
+  MobiusCoeffs(const double _Complex *b5_, const double _Complex *c5_, const double _Complex *kappa_b,
+               const double _Complex *kappa_c, double mferm) :
+    b5(Ls), half_c5(Ls), kappa5(Ls)
+  {
+    std::vector<double _Complex> kappa_mdwf(Ls);
+    for (int s = 0; s < Ls; s++) {
+      b5[s] = toComplex(b5_[s]);
+      half_c5[s] = toComplex(0.5 * c5_[s]);
+      double _Complex k5 = 0.5 * kappa_b[s] / kappa_c[s];
+      kappa5[s] = toComplex(k5);
+      kappa_mdwf[s] = -k5;
     }
+    m5inv = m5invCoefficients(kappa_mdwf.data(), mferm);
+  }
+
+  MobiusOps<sFloat> ops(int dagger, sFloat mferm) const
+  {
+    MobiusOps<sFloat> o;
+    o.m5 = [this, dagger, mferm](sFloat *y, const sFloat *x) { m5Site(y, x, dagger, mferm, kappa5.data()); };
+    o.m5inv = [this, dagger](sFloat *y, const sFloat *x) { m5invSite(y, x, dagger, m5inv); };
+    o.m4pre = [this, dagger, mferm](sFloat *y, const sFloat *x) {
+      m4preSite(y, x, dagger, mferm, b5.data(), half_c5.data());
+    };
+    return o;
+  }
+};
+
+template <typename sFloat> MobiusOps<sFloat> eofaOps(const EofaCoeffs<sFloat> &e, const MobiusCoeffs<sFloat> &mobius)
+{
+  MobiusOps<sFloat> o = mobius.ops(e.daggerBit, e.mferm);
+  o.m5 = [&e](sFloat *y, const sFloat *x) { eofaM5Site(y, x, e); };
+  o.m5inv = [&e](sFloat *y, const sFloat *x) { eofaM5invSite(y, x, e); };
+  return o;
+}
+
+/**
+   @brief The full Mobius-type operator from its fifth-dimension
+   parts, e.g. out_odd = M5 in_odd - kappa_b M4pre D4 in_even.  The
+   M4pre stage follows the hop for the dagger operator, where it is
+   fused with it.
+*/
+template <typename sFloat>
+void mdwMat(sFloat *out, void **gauge, sFloat *in, int dagger, QudaPrecision precision, QudaGaugeParam &gauge_param,
+            const MobiusOps<sFloat> &op, const std::vector<Complex> &minus_kappa_b)
+{
+  sFloat *inEven = in;
+  sFloat *inOdd = in + V5h * spinor_site_size;
+  sFloat *outEven = out;
+  sFloat *outOdd = out + V5h * spinor_site_size;
+
+  if (!dagger) {
+    mdwHop<sFloat>(outOdd, gauge, inEven, 1, dagger, precision, gauge_param, op.m4pre, {}, inOdd, op.m5, minus_kappa_b);
+    mdwHop<sFloat>(outEven, gauge, inOdd, 0, dagger, precision, gauge_param, op.m4pre, {}, inEven, op.m5, minus_kappa_b);
+  } else {
+    mdwHop<sFloat>(outOdd, gauge, inEven, 1, dagger, precision, gauge_param, nullptr, {op.m4pre}, inOdd, op.m5, minus_kappa_b);
+    mdwHop<sFloat>(outEven, gauge, inOdd, 0, dagger, precision, gauge_param, nullptr, {op.m4pre}, inEven, op.m5,
+           minus_kappa_b);
+  }
+}
+
+/**
+   @brief The even-odd preconditioned Mobius-type operator from its
+   fifth-dimension parts.  Every M5^{-1} and M4pre that follows a hop
+   is fused with it, as is the final kappa2 term.
+*/
+template <typename sFloat>
+void mdwMatPC(sFloat *out, void **gauge, sFloat *in, QudaMatPCType matpc_type, int dagger, QudaPrecision precision,
+              QudaGaugeParam &gauge_param, const MobiusOps<sFloat> &op, const std::vector<Complex> &kappa2)
+{
+  std::vector<sFloat> tmp_(V5h * spinor_site_size);
+  sFloat *tmp = tmp_.data();
+
+  int odd_bit = (matpc_type == QUDA_MATPC_ODD_ODD || matpc_type == QUDA_MATPC_ODD_ODD_ASYMMETRIC) ? 1 : 0;
+  bool symmetric = (matpc_type == QUDA_MATPC_EVEN_EVEN || matpc_type == QUDA_MATPC_ODD_ODD) ? true : false;
+  QudaParity parity[2] = {static_cast<QudaParity>((1 + odd_bit) % 2), static_cast<QudaParity>((0 + odd_bit) % 2)};
+
+  if (symmetric && !dagger) {
+    mdwHop<sFloat>(tmp, gauge, in, parity[0], dagger, precision, gauge_param, op.m4pre, {op.m5inv});
+    mdwHop<sFloat>(out, gauge, tmp, parity[1], dagger, precision, gauge_param, op.m4pre, {op.m5inv}, in, nullptr, kappa2);
+  } else if (symmetric && dagger) {
+    mdwHop<sFloat>(tmp, gauge, in, parity[0], dagger, precision, gauge_param, op.m5inv, {op.m4pre});
+    mdwHop<sFloat>(out, gauge, tmp, parity[1], dagger, precision, gauge_param, op.m5inv, {op.m4pre}, in, nullptr, kappa2);
+  } else if (!symmetric && !dagger) {
+    mdwHop<sFloat>(tmp, gauge, in, parity[0], dagger, precision, gauge_param, op.m4pre, {op.m5inv});
+    mdwHop<sFloat>(out, gauge, tmp, parity[1], dagger, precision, gauge_param, op.m4pre, {}, in, op.m5, kappa2);
+  } else if (!symmetric && dagger) {
+    mdwHop<sFloat>(tmp, gauge, in, parity[0], dagger, precision, gauge_param, nullptr, {op.m4pre, op.m5inv});
+    mdwHop<sFloat>(out, gauge, tmp, parity[1], dagger, precision, gauge_param, nullptr, {op.m4pre}, in, op.m5, kappa2);
+  } else {
+    errorQuda("Unsupported matpc_type=%d dagger=%d", matpc_type, dagger);
   }
-  
 }
 
 void dw_mat(void *out, void **gauge, void *in, double kappa, int dagger_bit, QudaPrecision precision, QudaGaugeParam &gauge_param, double mferm) {
@@ -1024,104 +1057,53 @@ void dw_4d_mat(void *out, void **gauge, void *in, double kappa, int dagger_bit,
 void mdw_mat(void *out, void **gauge, void *in, double _Complex *kappa_b, double _Complex *kappa_c, int dagger,
              QudaPrecision precision, QudaGaugeParam &gauge_param, double mferm, double _Complex *b5, double _Complex *c5)
 {
-  void *tmp = malloc(V5h * spinor_site_size * precision);
-  double _Complex *kappa5 = (double _Complex *)malloc(Ls * sizeof(double _Complex));
-
-  for(int xs = 0; xs < Ls ; xs++) kappa5[xs] = 0.5*kappa_b[xs]/kappa_c[xs];
-
-  void *inEven = in;
-  void *inOdd = (char *)in + V5h * spinor_site_size * precision;
-  void *outEven = out;
-  void *outOdd = (char *)out + V5h * spinor_site_size * precision;
+  std::vector<Complex> minus_kappa_b(Ls);
+  for (int xs = 0; xs < Ls; xs++) minus_kappa_b[xs] = toComplex(-kappa_b[xs]);
 
-  if (!dagger) {
-    mdw_dslash_4_pre(tmp, gauge, inEven, 0, dagger, precision, gauge_param, mferm, b5, c5, true);
-    dslash_4_4d(outOdd, gauge, tmp, 1, dagger, precision, gauge_param, mferm);
-    mdw_dslash_5(tmp, gauge, inOdd, 1, dagger, precision, gauge_param, mferm, kappa5, true);
-  } else {
-    dslash_4_4d(tmp, gauge, inEven, 1, dagger, precision, gauge_param, mferm);
-    mdw_dslash_4_pre(outOdd, gauge, tmp, 0, dagger, precision, gauge_param, mferm, b5, c5, true);
-    mdw_dslash_5(tmp, gauge, inOdd, 1, dagger, precision, gauge_param, mferm, kappa5, true);
-  }
-
-  for(int xs = 0 ; xs < Ls ; xs++) {
-    cxpay((char *)tmp + precision * Vh * spinor_site_size * xs, -kappa_b[xs],
-          (char *)outOdd + precision * Vh * spinor_site_size * xs, Vh * spinor_site_size, precision);
-  }
-
-  if (!dagger) {
-    mdw_dslash_4_pre(tmp, gauge, inOdd, 1, dagger, precision, gauge_param, mferm, b5, c5, true);
-    dslash_4_4d(outEven, gauge, tmp, 0, dagger, precision, gauge_param, mferm);
-    mdw_dslash_5(tmp, gauge, inEven, 0, dagger, precision, gauge_param, mferm, kappa5, true);
+  if (precision == QUDA_DOUBLE_PRECISION) {
+    const MobiusCoeffs<double> mobius(b5, c5, kappa_b, kappa_c, mferm);
+    mdwMat((double *)out, gauge, (double *)in, dagger, precision, gauge_param, mobius.ops(dagger, mferm),
+           minus_kappa_b);
   } else {
-    dslash_4_4d(tmp, gauge, inOdd, 0, dagger, precision, gauge_param, mferm);
-    mdw_dslash_4_pre(outEven, gauge, tmp, 1, dagger, precision, gauge_param, mferm, b5, c5, true);
-    mdw_dslash_5(tmp, gauge, inEven, 0, dagger, precision, gauge_param, mferm, kappa5, true);
-  }
-
-  for(int xs = 0 ; xs < Ls ; xs++) {
-    cxpay((char *)tmp + precision * Vh * spinor_site_size * xs, -kappa_b[xs],
-          (char *)outEven + precision * Vh * spinor_site_size * xs, Vh * spinor_site_size, precision);
+    const MobiusCoeffs<float> mobius(b5, c5, kappa_b, kappa_c, (float)mferm);
+    mdwMat((float *)out, gauge, (float *)in, dagger, precision, gauge_param, mobius.ops(dagger, (float)mferm),
+           minus_kappa_b);
   }
-
-  free(kappa5);
-  free(tmp);
 }
 
-void mdw_eofa_mat(void *out, void **gauge, void *in, int dagger, QudaPrecision precision, QudaGaugeParam &gauge_param,
-                  double mferm, double m5, double b, double c, double mq1, double mq2, double mq3, int eofa_pm,
-                  double eofa_shift)
+template <typename sFloat>
+void mdw_eofa_mat_ref(sFloat *out, void **gauge, sFloat *in, int dagger, QudaPrecision precision,
+                      QudaGaugeParam &gauge_param, double mferm, double m5, double b, double c, double mq1, double mq2,
+                      double mq3, int eofa_pm, double eofa_shift)
 {
-  void *tmp = malloc(V5h * spinor_site_size * precision);
-
   using sComplex = double _Complex;
-
   std::vector<sComplex> b_array(Ls, b);
   std::vector<sComplex> c_array(Ls, c);
+  // only b5 and c5 are used by the Mobius part of the EOFA operator
+  std::vector<sComplex> kappa_array(Ls, 1.0);
 
-  auto b5 = b_array.data();
-  auto c5 = c_array.data();
+  const EofaCoeffs<sFloat> eofa(dagger, mferm, m5, b, c, mq1, mq2, mq3, eofa_pm, eofa_shift);
+  const MobiusCoeffs<sFloat> mobius(b_array.data(), c_array.data(), kappa_array.data(), kappa_array.data(), (sFloat)mferm);
 
   auto kappa_b = 0.5 / (b * (4. + m5) + 1.);
+  std::vector<Complex> minus_kappa_b(Ls, -kappa_b);
 
-  void *inEven = in;
-  void *inOdd = (char *)in + V5h * spinor_site_size * precision;
-  void *outEven = out;
-  void *outOdd = (char *)out + V5h * spinor_site_size * precision;
-
-  if (!dagger) {
-    mdw_dslash_4_pre(tmp, gauge, inEven, 0, dagger, precision, gauge_param, mferm, b5, c5, true);
-    dslash_4_4d(outOdd, gauge, tmp, 1, dagger, precision, gauge_param, mferm);
-    mdw_eofa_m5(tmp, inOdd, 1, dagger, mferm, m5, b, c, mq1, mq2, mq3, eofa_pm, eofa_shift, precision);
-  } else {
-    dslash_4_4d(tmp, gauge, inEven, 1, dagger, precision, gauge_param, mferm);
-    mdw_dslash_4_pre(outOdd, gauge, tmp, 0, dagger, precision, gauge_param, mferm, b5, c5, true);
-    mdw_eofa_m5(tmp, inOdd, 1, dagger, mferm, m5, b, c, mq1, mq2, mq3, eofa_pm, eofa_shift, precision);
-  }
-
-  for (int xs = 0; xs < Ls; xs++) {
-    cxpay((char *)tmp + precision * Vh * spinor_site_size * xs, -kappa_b,
-          (char *)outOdd + precision * Vh * spinor_site_size * xs, Vh * spinor_site_size, precision);
-  }
+  mdwMat(out, gauge, in, dagger, precision, gauge_param, eofaOps(eofa, mobius), minus_kappa_b);
+}
 
-  if (!dagger) {
-    mdw_dslash_4_pre(tmp, gauge, inOdd, 1, dagger, precision, gauge_param, mferm, b5, c5, true);
-    dslash_4_4d(outEven, gauge, tmp, 0, dagger, precision, gauge_param, mferm);
-    mdw_eofa_m5(tmp, inEven, 0, dagger, mferm, m5, b, c, mq1, mq2, mq3, eofa_pm, eofa_shift, precision);
+void mdw_eofa_mat(void *out, void **gauge, void *in, int dagger, QudaPrecision precision, QudaGaugeParam &gauge_param,
+                  double mferm, double m5, double b, double c, double mq1, double mq2, double mq3, int eofa_pm,
+                  double eofa_shift)
+{
+  if (precision == QUDA_DOUBLE_PRECISION) {
+    mdw_eofa_mat_ref((double *)out, gauge, (double *)in, dagger, precision, gauge_param, mferm, m5, b, c, mq1, mq2, mq3,
+                     eofa_pm, eofa_shift);
   } else {
-    dslash_4_4d(tmp, gauge, inOdd, 0, dagger, precision, gauge_param, mferm);
-    mdw_dslash_4_pre(outEven, gauge, tmp, 1, dagger, precision, gauge_param, mferm, b5, c5, true);
-    mdw_eofa_m5(tmp, inEven, 0, dagger, mferm, m5, b, c, mq1, mq2, mq3, eofa_pm, eofa_shift, precision);
-  }
-
-  for (int xs = 0; xs < Ls; xs++) {
-    cxpay((char *)tmp + precision * Vh * spinor_site_size * xs, -kappa_b,
-          (char *)outEven + precision * Vh * spinor_site_size * xs, Vh * spinor_site_size, precision);
+    mdw_eofa_mat_ref((float *)out, gauge, (float *)in, dagger, precision, gauge_param, mferm, m5, b, c, mq1, mq2, mq3,
+                     eofa_pm, eofa_shift);
   }
-
-  free(tmp);
 }
-//
+
 void dw_matdagmat(void *out, void **gauge, void *in, double kappa, int dagger_bit, QudaPrecision precision, QudaGaugeParam &gauge_param, double mferm)
 {
 
@@ -1197,146 +1179,53 @@ void mdw_matpc(void *out, void **gauge, void *in, double _Complex *kappa_b, doub
     QudaMatPCType matpc_type, int dagger, QudaPrecision precision, QudaGaugeParam &gauge_param, double mferm,
     double _Complex *b5, double _Complex *c5)
 {
-  void *tmp = malloc(V5h * spinor_site_size * precision);
-  double _Complex *kappa5 = (double _Complex *)malloc(Ls * sizeof(double _Complex));
-  double _Complex *kappa2 = (double _Complex *)malloc(Ls * sizeof(double _Complex));
-  double _Complex *kappa_mdwf = (double _Complex *)malloc(Ls * sizeof(double _Complex));
-  for(int xs = 0; xs < Ls ; xs++)
-  {
-    kappa5[xs] = 0.5*kappa_b[xs]/kappa_c[xs];
-    kappa2[xs] = -kappa_b[xs]*kappa_b[xs];
-    kappa_mdwf[xs] = -kappa5[xs];
-  }
-
-  int odd_bit = (matpc_type == QUDA_MATPC_ODD_ODD || matpc_type == QUDA_MATPC_ODD_ODD_ASYMMETRIC) ? 1 : 0;
-  bool symmetric =(matpc_type == QUDA_MATPC_EVEN_EVEN || matpc_type == QUDA_MATPC_ODD_ODD) ? true : false;
-  QudaParity parity[2] = {static_cast<QudaParity>((1 + odd_bit) % 2), static_cast<QudaParity>((0 + odd_bit) % 2)};
+  std::vector<Complex> kappa2(Ls);
+  for (int xs = 0; xs < Ls; xs++) kappa2[xs] = toComplex(-kappa_b[xs] * kappa_b[xs]);
 
-  if (symmetric && !dagger) {
-    mdw_dslash_4_pre(tmp, gauge, in, parity[1], dagger, precision, gauge_param, mferm, b5, c5, true);
-    dslash_4_4d(out, gauge, tmp, parity[0], dagger, precision, gauge_param, mferm);
-    mdw_dslash_5_inv(tmp, gauge, out, parity[1], dagger, precision, gauge_param, mferm, kappa_mdwf);
-    mdw_dslash_4_pre(out, gauge, tmp, parity[0], dagger, precision, gauge_param, mferm, b5, c5, true);
-    dslash_4_4d(tmp, gauge, out, parity[1], dagger, precision, gauge_param, mferm);
-    mdw_dslash_5_inv(out, gauge, tmp, parity[0], dagger, precision, gauge_param, mferm, kappa_mdwf);
-    for(int xs = 0 ; xs < Ls ; xs++) {
-      cxpay((char *)in + precision * Vh * spinor_site_size * xs, kappa2[xs],
-            (char *)out + precision * Vh * spinor_site_size * xs, Vh * spinor_site_size, precision);
-    }
-  } else if (symmetric && dagger) {
-    mdw_dslash_5_inv(tmp, gauge, in, parity[1], dagger, precision, gauge_param, mferm, kappa_mdwf);
-    dslash_4_4d(out, gauge, tmp, parity[0], dagger, precision, gauge_param, mferm);
-    mdw_dslash_4_pre(tmp, gauge, out, parity[0], dagger, precision, gauge_param, mferm, b5, c5, true);
-    mdw_dslash_5_inv(out, gauge, tmp, parity[0], dagger, precision, gauge_param, mferm, kappa_mdwf);
-    dslash_4_4d(tmp, gauge, out, parity[1], dagger, precision, gauge_param, mferm);
-    mdw_dslash_4_pre(out, gauge, tmp, parity[1], dagger, precision, gauge_param, mferm, b5, c5, true);
-    for(int xs = 0 ; xs < Ls ; xs++) {
-      cxpay((char *)in + precision * Vh * spinor_site_size * xs, kappa2[xs],
-            (char *)out + precision * Vh * spinor_site_size * xs, Vh * spinor_site_size, precision);
-    }
-  } else if (!symmetric && !dagger) {
-    mdw_dslash_4_pre(out, gauge, in, parity[1], dagger, precision, gauge_param, mferm, b5, c5, true);
-    dslash_4_4d(tmp, gauge, out, parity[0], dagger, precision, gauge_param, mferm);
-    mdw_dslash_5_inv(out, gauge, tmp, parity[1], dagger, precision, gauge_param, mferm, kappa_mdwf);
-    mdw_dslash_4_pre(tmp, gauge, out, parity[0], dagger, precision, gauge_param, mferm, b5, c5, true);
-    dslash_4_4d(out, gauge, tmp, parity[1], dagger, precision, gauge_param, mferm);
-    mdw_dslash_5(tmp, gauge, in, parity[0], dagger, precision, gauge_param, mferm, kappa5, true);
-    for(int xs = 0 ; xs < Ls ; xs++) {
-      cxpay((char *)tmp + precision * Vh * spinor_site_size * xs, kappa2[xs],
-            (char *)out + precision * Vh * spinor_site_size * xs, Vh * spinor_site_size, precision);
-    }
-  } else if (!symmetric && dagger) {
-    dslash_4_4d(out, gauge, in, parity[0], dagger, precision, gauge_param, mferm);
-    mdw_dslash_4_pre(tmp, gauge, out, parity[1], dagger, precision, gauge_param, mferm, b5, c5, true);
-    mdw_dslash_5_inv(out, gauge, tmp, parity[0], dagger, precision, gauge_param, mferm, kappa_mdwf);
-    dslash_4_4d(tmp, gauge, out, parity[1], dagger, precision, gauge_param, mferm);
-    mdw_dslash_4_pre(out, gauge, tmp, parity[0], dagger, precision, gauge_param, mferm, b5, c5, true);
-    mdw_dslash_5(tmp, gauge, in, parity[0], dagger, precision, gauge_param, mferm, kappa5, true);
-    for(int xs = 0 ; xs < Ls ; xs++) {
-      cxpay((char *)tmp + precision * Vh * spinor_site_size * xs, kappa2[xs],
-            (char *)out + precision * Vh * spinor_site_size * xs, Vh * spinor_site_size, precision);
-    }
+  if (precision == QUDA_DOUBLE_PRECISION) {
+    const MobiusCoeffs<double> mobius(b5, c5, kappa_b, kappa_c, mferm);
+    mdwMatPC((double *)out, gauge, (double *)in, matpc_type, dagger, precision, gauge_param, mobius.ops(dagger, mferm),
+             kappa2);
   } else {
-    errorQuda("Unsupported matpc_type=%d dagger=%d", matpc_type, dagger);
+    const MobiusCoeffs<float> mobius(b5, c5, kappa_b, kappa_c, (float)mferm);
+    mdwMatPC((float *)out, gauge, (float *)in, matpc_type, dagger, precision, gauge_param,
+             mobius.ops(dagger, (float)mferm), kappa2);
   }
-
-  free(tmp);
-  free(kappa5);
-  free(kappa2);
-  free(kappa_mdwf);
 }
 
-void mdw_eofa_matpc(void *out, void **gauge, void *in, QudaMatPCType matpc_type, int dagger, QudaPrecision precision,
-                    QudaGaugeParam &gauge_param, double mferm, double m5, double b, double c, double mq1, double mq2,
-                    double mq3, int eofa_pm, double eofa_shift)
+template <typename sFloat>
+void mdw_eofa_matpc_ref(sFloat *out, void **gauge, sFloat *in, QudaMatPCType matpc_type, int dagger,
+                        QudaPrecision precision, QudaGaugeParam &gauge_param, double mferm, double m5, double b,
+                        double c, double mq1, double mq2, double mq3, int eofa_pm, double eofa_shift)
 {
-  void *tmp = malloc(V5h * spinor_site_size * precision);
-
   using sComplex = double _Complex;
-
-  std::vector<sComplex> kappa2_array(Ls, -0.25 / (b * (4. + m5) + 1.) / (b * (4. + m5) + 1.));
   std::vector<sComplex> b_array(Ls, b);
   std::vector<sComplex> c_array(Ls, c);
+  // only b5 and c5 are used by the Mobius part of the EOFA operator
+  std::vector<sComplex> kappa_array(Ls, 1.0);
 
-  auto kappa2 = kappa2_array.data();
-  auto b5 = b_array.data();
-  auto c5 = c_array.data();
+  const EofaCoeffs<sFloat> eofa(dagger, mferm, m5, b, c, mq1, mq2, mq3, eofa_pm, eofa_shift);
+  const MobiusCoeffs<sFloat> mobius(b_array.data(), c_array.data(), kappa_array.data(), kappa_array.data(), (sFloat)mferm);
 
-  int odd_bit = (matpc_type == QUDA_MATPC_ODD_ODD || matpc_type == QUDA_MATPC_ODD_ODD_ASYMMETRIC) ? 1 : 0;
-  bool symmetric = (matpc_type == QUDA_MATPC_EVEN_EVEN || matpc_type == QUDA_MATPC_ODD_ODD) ? true : false;
-  QudaParity parity[2] = {static_cast<QudaParity>((1 + odd_bit) % 2), static_cast<QudaParity>((0 + odd_bit) % 2)};
+  std::vector<Complex> kappa2(Ls, -0.25 / (b * (4. + m5) + 1.) / (b * (4. + m5) + 1.));
 
-  if (symmetric && !dagger) {
-    mdw_dslash_4_pre(tmp, gauge, in, parity[1], dagger, precision, gauge_param, mferm, b5, c5, true);
-    dslash_4_4d(out, gauge, tmp, parity[0], dagger, precision, gauge_param, mferm);
-    mdw_eofa_m5inv(tmp, out, parity[1], dagger, mferm, m5, b, c, mq1, mq2, mq3, eofa_pm, eofa_shift, precision);
-    mdw_dslash_4_pre(out, gauge, tmp, parity[0], dagger, precision, gauge_param, mferm, b5, c5, true);
-    dslash_4_4d(tmp, gauge, out, parity[1], dagger, precision, gauge_param, mferm);
-    mdw_eofa_m5inv(out, tmp, parity[0], dagger, mferm, m5, b, c, mq1, mq2, mq3, eofa_pm, eofa_shift, precision);
-    for (int xs = 0; xs < Ls; xs++) {
-      cxpay((char *)in + precision * Vh * spinor_site_size * xs, kappa2[xs],
-            (char *)out + precision * Vh * spinor_site_size * xs, Vh * spinor_site_size, precision);
-    }
-  } else if (symmetric && dagger) {
-    mdw_eofa_m5inv(tmp, in, parity[1], dagger, mferm, m5, b, c, mq1, mq2, mq3, eofa_pm, eofa_shift, precision);
-    dslash_4_4d(out, gauge, tmp, parity[0], dagger, precision, gauge_param, mferm);
-    mdw_dslash_4_pre(tmp, gauge, out, parity[0], dagger, precision, gauge_param, mferm, b5, c5, true);
-    mdw_eofa_m5inv(out, tmp, parity[0], dagger, mferm, m5, b, c, mq1, mq2, mq3, eofa_pm, eofa_shift, precision);
-    dslash_4_4d(tmp, gauge, out, parity[1], dagger, precision, gauge_param, mferm);
-    mdw_dslash_4_pre(out, gauge, tmp, parity[1], dagger, precision, gauge_param, mferm, b5, c5, true);
-    for (int xs = 0; xs < Ls; xs++) {
-      cxpay((char *)in + precision * Vh * spinor_site_size * xs, kappa2[xs],
-            (char *)out + precision * Vh * spinor_site_size * xs, Vh * spinor_site_size, precision);
-    }
-  } else if (!symmetric && !dagger) {
-    mdw_dslash_4_pre(out, gauge, in, parity[1], dagger, precision, gauge_param, mferm, b5, c5, true);
-    dslash_4_4d(tmp, gauge, out, parity[0], dagger, precision, gauge_param, mferm);
-    mdw_eofa_m5inv(out, tmp, parity[1], dagger, mferm, m5, b, c, mq1, mq2, mq3, eofa_pm, eofa_shift, precision);
-    mdw_dslash_4_pre(tmp, gauge, out, parity[0], dagger, precision, gauge_param, mferm, b5, c5, true);
-    dslash_4_4d(out, gauge, tmp, parity[1], dagger, precision, gauge_param, mferm);
-    mdw_eofa_m5(tmp, in, parity[0], dagger, mferm, m5, b, c, mq1, mq2, mq3, eofa_pm, eofa_shift, precision);
-    for (int xs = 0; xs < Ls; xs++) {
-      cxpay((char *)tmp + precision * Vh * spinor_site_size * xs, kappa2[xs],
-            (char *)out + precision * Vh * spinor_site_size * xs, Vh * spinor_site_size, precision);
-    }
-  } else if (!symmetric && dagger) {
-    dslash_4_4d(out, gauge, in, parity[0], dagger, precision, gauge_param, mferm);
-    mdw_dslash_4_pre(tmp, gauge, out, parity[1], dagger, precision, gauge_param, mferm, b5, c5, true);
-    mdw_eofa_m5inv(out, tmp, parity[0], dagger, mferm, m5, b, c, mq1, mq2, mq3, eofa_pm, eofa_shift, precision);
-    dslash_4_4d(tmp, gauge, out, parity[1], dagger, precision, gauge_param, mferm);
-    mdw_dslash_4_pre(out, gauge, tmp, parity[0], dagger, precision, gauge_param, mferm, b5, c5, true);
-    mdw_eofa_m5(tmp, in, parity[0], dagger, mferm, m5, b, c, mq1, mq2, mq3, eofa_pm, eofa_shift, precision);
-    for (int xs = 0; xs < Ls; xs++) {
-      cxpay((char *)tmp + precision * Vh * spinor_site_size * xs, kappa2[xs],
-            (char *)out + precision * Vh * spinor_site_size * xs, Vh * spinor_site_size, precision);
-    }
+  mdwMatPC(out, gauge, in, matpc_type, dagger, precision, gauge_param, eofaOps(eofa, mobius), kappa2);
+}
+
+void mdw_eofa_matpc(void *out, void **gauge, void *in, QudaMatPCType matpc_type, int dagger, QudaPrecision precision,
+                    QudaGaugeParam &gauge_param, double mferm, double m5, double b, double c, double mq1, double mq2,
+                    double mq3, int eofa_pm, double eofa_shift)
+{
+  if (precision == QUDA_DOUBLE_PRECISION) {
+    mdw_eofa_matpc_ref((double *)out, gauge, (double *)in, matpc_type, dagger, precision, gauge_param, mferm, m5, b, c,
+                       mq1, mq2, mq3, eofa_pm, eofa_shift);
   } else {
-    errorQuda("Unsupported matpc_type=%d dagger=%d", matpc_type, dagger);
+    mdw_eofa_matpc_ref((float *)out, gauge, (float *)in, matpc_type, dagger, precision, gauge_param, mferm, m5, b, c,
+                       mq1, mq2, mq3, eofa_pm, eofa_shift);
   }
-
-  free(tmp);
 }
 
+
 void mdw_mdagm_local(void *out, void **gauge, void *in, double _Complex *kappa_b, double _Complex *kappa_c,
                      QudaMatPCType matpc_type, QudaPrecision precision, QudaGaugeParam &gauge_param, double mferm,
                      double _Complex *b5, double _Complex *c5)
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 // QUDA header (for HeavyQuarkResidualNorm)
 #include <blas_quda.h>
 
@@ -11,34 +13,36 @@
 #include <command_line_params.h>
 
 // Overload for workflows without multishift
-void verifyInversion(void *spinorOut, void *spinorIn, void *spinorCheck, QudaGaugeParam &gauge_param,
-                     QudaInvertParam &inv_param, void **gauge, void *clover, void *clover_inv)
+double verifyInversion(void *spinorOut, void *spinorIn, void *spinorCheck, QudaGaugeParam &gauge_param,
+                       QudaInvertParam &inv_param, void **gauge, void *clover, void *clover_inv)
 {
   void **spinorOutMulti = nullptr;
-  verifyInversion(spinorOut, spinorOutMulti, spinorIn, spinorCheck, gauge_param, inv_param, gauge, clover, clover_inv);
+  return verifyInversion(spinorOut, spinorOutMulti, spinorIn, spinorCheck, gauge_param, inv_param, gauge, clover,
+                         clover_inv);
 }
 
-void verifyInversion(void *spinorOut, void **spinorOutMulti, void *spinorIn, void *spinorCheck,
-                     QudaGaugeParam &gauge_param, QudaInvertParam &inv_param, void **gauge, void *clover,
-                     void *clover_inv)
+double verifyInversion(void *spinorOut, void **spinorOutMulti, void *spinorIn, void *spinorCheck,
+                       QudaGaugeParam &gauge_param, QudaInvertParam &inv_param, void **gauge, void *clover,
+                       void *clover_inv)
 {
 
   if (dslash_type == QUDA_DOMAIN_WALL_DSLASH || dslash_type == QUDA_DOMAIN_WALL_4D_DSLASH
       || dslash_type == QUDA_MOBIUS_DWF_DSLASH || dslash_type == QUDA_MOBIUS_DWF_EOFA_DSLASH) {
-    verifyDomainWallTypeInversion(spinorOut, spinorOutMulti, spinorIn, spinorCheck, gauge_param, inv_param, gauge,
-                                  clover, clover_inv);
+    return verifyDomainWallTypeInversion(spinorOut, spinorOutMulti, spinorIn, spinorCheck, gauge_param, inv_param,
+                                         gauge, clover, clover_inv);
   } else if (dslash_type == QUDA_WILSON_DSLASH || dslash_type == QUDA_CLOVER_WILSON_DSLASH
              || dslash_type == QUDA_TWISTED_MASS_DSLASH || dslash_type == QUDA_TWISTED_CLOVER_DSLASH) {
-    verifyWilsonTypeInversion(spinorOut, spinorOutMulti, spinorIn, spinorCheck, gauge_param, inv_param, gauge, clover,
-                              clover_inv);
+    return verifyWilsonTypeInversion(spinorOut, spinorOutMulti, spinorIn, spinorCheck, gauge_param, inv_param, gauge,
+                                     clover, clover_inv);
   } else {
     errorQuda("Unsupported dslash_type=%s", get_dslash_str(dslash_type));
   }
+  return 0.0;
 }
 
-void verifyDomainWallTypeInversion(void *spinorOut, void **spinorOutMulti, void *spinorIn, void *spinorCheck,
-                                   QudaGaugeParam &gauge_param, QudaInvertParam &inv_param, void **gauge, void *clover,
-                                   void *clover_inv)
+double verifyDomainWallTypeInversion(void *spinorOut, void **spinorOutMulti, void *spinorIn, void *spinorCheck,
+                                     QudaGaugeParam &gauge_param, QudaInvertParam &inv_param, void **gauge,
+                                     void *clover, void *clover_inv)
 {
   if (inv_param.solution_type == QUDA_MAT_SOLUTION) {
     if (dslash_type == QUDA_DOMAIN_WALL_DSLASH) {
@@ -160,12 +164,14 @@ void verifyDomainWallTypeInversion(void *spinorOut, void **spinorOutMulti, void
 
   printfQuda("Residuals: (L2 relative) tol %9.6e, QUDA = %9.6e, host = %9.6e; (heavy-quark) tol %9.6e, QUDA = %9.6e\n",
              inv_param.tol, inv_param.true_res, l2r, inv_param.tol_hq, inv_param.true_res_hq);
+  return l2r / inv_param.tol;
 }
 
-void verifyWilsonTypeInversion(void *spinorOut, void **spinorOutMulti, void *spinorIn, void *spinorCheck,
-                               QudaGaugeParam &gauge_param, QudaInvertParam &inv_param, void **gauge, void *clover,
-                               void *clover_inv)
+double verifyWilsonTypeInversion(void *spinorOut, void **spinorOutMulti, void *spinorIn, void *spinorCheck,
+                                 QudaGaugeParam &gauge_param, QudaInvertParam &inv_param, void **gauge, void *clover,
+                                 void *clover_inv)
 {
+  double deviation = 0.0;
   if (multishift > 1) {
     // ONLY WILSON/CLOVER/TWISTED TYPES
     if (inv_param.mass_normalization == QUDA_MASS_NORMALIZATION) {
@@ -231,6 +237,7 @@ void verifyWilsonTypeInversion(void *spinorOut, void **spinorOutMulti, void *spi
                  "QUDA = %9.6e\n",
                  i, inv_param.tol_offset[i], inv_param.true_res_offset[i], l2r, inv_param.tol_hq_offset[i],
                  inv_param.true_res_hq_offset[i]);
+      deviation = std::max(deviation, l2r / inv_param.tol_offset[i]);
     }
     free(spinorTmp);
 
@@ -372,7 +379,9 @@ void verifyWilsonTypeInversion(void *spinorOut, void **spinorOutMulti, void *spi
     printfQuda(
       "Residuals: (L2 relative) tol %9.6e, QUDA = %9.6e, host = %9.6e; (heavy-quark) tol %9.6e, QUDA = %9.6e\n",
       inv_param.tol, inv_param.true_res, l2r, inv_param.tol_hq, inv_param.true_res_hq);
+    deviation = l2r / inv_param.tol;
   }
+  return deviation;
 }
 
 void verifyStaggeredInversion(quda::ColorSpinorField *tmp, quda::ColorSpinorField *ref, quda::ColorSpinorField *in,
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+
 #include <host_utils.h>
 #include <comm_quda.h>
 
@@ -86,20 +88,102 @@ static inline void su3Tmul(sFloat *res, gFloat *mat, sFloat *vec) {
   su3Transpose(matT, mat);
   su3Mul(res, matT, vec);
 }
-void verifyInversion(void *spinorOut, void *spinorIn, void *spinorCheck, QudaGaugeParam &gauge_param,
-                     QudaInvertParam &inv_param, void **gauge, void *clover, void *clover_inv);
 
-void verifyInversion(void *spinorOut, void **spinorOutMulti, void *spinorIn, void *spinorCheck,
-                     QudaGaugeParam &gauge_param, QudaInvertParam &inv_param, void **gauge, void *clover,
-                     void *clover_inv);
+/**
+   The Wilson spin projectors (1 -/+ gamma_mu) have rank two: the
+   lower two rows of each projector are a multiple of one of the
+   upper two rows.  We therefore only need to form the two upper
+   components of the projected spinor (the "half spinor"), apply the
+   gauge link to those, and reconstruct the lower components, which
+   halves the number of SU(3) matrix-vector products.
+*/
+struct HalfProjector {
+  int col[2];          // column (2 or 3) mixed into upper row a
+  double coeff[2][2];  // complex coefficient of that column
+  int row[2];          // upper row that lower row 2+r is proportional to
+  double recon[2][2];  // complex proportionality constant
+};
+
+/**
+   @brief Extract the rank-two structure of the first n entries of a
+   dense projector table, so the two representations cannot drift
+   apart.
+*/
+template <int n> std::array<HalfProjector, n> extractHalfProjectors(const double (*projector)[4][4][2])
+{
+  std::array<HalfProjector, n> p;
+  for (int idx = 0; idx < n; idx++) {
+    for (int a = 0; a < 2; a++) {
+      int b = projector[idx][a][2][0] != 0.0 || projector[idx][a][2][1] != 0.0 ? 2 : 3;
+      p[idx].col[a] = b;
+      p[idx].coeff[a][0] = projector[idx][a][b][0];
+      p[idx].coeff[a][1] = projector[idx][a][b][1];
+    }
+    for (int r = 0; r < 2; r++) {
+      // the upper rows have unit diagonal, so the entry in column a is the constant
+      int a = projector[idx][2 + r][0][0] != 0.0 || projector[idx][2 + r][0][1] != 0.0 ? 0 : 1;
+      p[idx].row[r] = a;
+      p[idx].recon[r][0] = projector[idx][2 + r][a][0];
+      p[idx].recon[r][1] = projector[idx][2 + r][a][1];
+    }
+  }
+  return p;
+}
+
+/**
+   @brief Accumulate link * (projected spinor) into accum, using the
+   half-spinor form of the projector.  The link must already be
+   daggered for backwards hops.
+*/
+template <typename sFloat, typename gFloat>
+static inline void halfSpinorHop(sFloat *accum, gFloat *link, const sFloat *spinor, const HalfProjector &p)
+{
+  // project onto the two upper spin components
+  sFloat projected[2][3 * 2], gauged[2][3 * 2];
+  for (int a = 0; a < 2; a++) {
+    const sFloat cRe = p.coeff[a][0], cIm = p.coeff[a][1];
+    for (int m = 0; m < 3; m++) {
+      sFloat sRe = spinor[p.col[a] * (3 * 2) + m * 2 + 0];
+      sFloat sIm = spinor[p.col[a] * (3 * 2) + m * 2 + 1];
+      projected[a][m * 2 + 0] = spinor[a * (3 * 2) + m * 2 + 0] + cRe * sRe - cIm * sIm;
+      projected[a][m * 2 + 1] = spinor[a * (3 * 2) + m * 2 + 1] + cRe * sIm + cIm * sRe;
+    }
+    su3Mul(gauged[a], link, projected[a]);
+  }
 
-void verifyDomainWallTypeInversion(void *spinorOut, void **spinorOutMulti, void *spinorIn, void *spinorCheck,
-                                   QudaGaugeParam &gauge_param, QudaInvertParam &inv_param, void **gauge, void *clover,
-                                   void *clover_inv);
+  // accumulate and reconstruct the lower spin components
+  for (int a = 0; a < 2; a++)
+    for (int k = 0; k < 3 * 2; k++) accum[a * (3 * 2) + k] += gauged[a][k];
+  for (int r = 0; r < 2; r++) {
+    const sFloat kRe = p.recon[r][0], kIm = p.recon[r][1];
+    for (int m = 0; m < 3; m++) {
+      sFloat gRe = gauged[p.row[r]][m * 2 + 0];
+      sFloat gIm = gauged[p.row[r]][m * 2 + 1];
+      accum[(2 + r) * (3 * 2) + m * 2 + 0] += kRe * gRe - kIm * gIm;
+      accum[(2 + r) * (3 * 2) + m * 2 + 1] += kRe * gIm + kIm * gRe;
+    }
+  }
+}
 
-void verifyWilsonTypeInversion(void *spinorOut, void **spinorOutMulti, void *spinorIn, void *spinorCheck,
-                               QudaGaugeParam &gauge_param, QudaInvertParam &inv_param, void **gauge, void *clover,
-                               void *clover_inv);
+/**
+   @brief Check the residual of a QUDA solve with the host operator
+   @return The largest ratio of the host-computed L2 relative residual
+   to the requested tolerance, over all shifts
+*/
+double verifyInversion(void *spinorOut, void *spinorIn, void *spinorCheck, QudaGaugeParam &gauge_param,
+                       QudaInvertParam &inv_param, void **gauge, void *clover, void *clover_inv);
+
+double verifyInversion(void *spinorOut, void **spinorOutMulti, void *spinorIn, void *spinorCheck,
+                       QudaGaugeParam &gauge_param, QudaInvertParam &inv_param, void **gauge, void *clover,
+                       void *clover_inv);
+
+double verifyDomainWallTypeInversion(void *spinorOut, void **spinorOutMulti, void *spinorIn, void *spinorCheck,
+                                     QudaGaugeParam &gauge_param, QudaInvertParam &inv_param, void **gauge,
+                                     void *clover, void *clover_inv);
+
+double verifyWilsonTypeInversion(void *spinorOut, void **spinorOutMulti, void *spinorIn, void *spinorCheck,
+                                 QudaGaugeParam &gauge_param, QudaInvertParam &inv_param, void **gauge, void *clover,
+                                 void *clover_inv);
 
 void verifyStaggeredInversion(quda::ColorSpinorField *tmp, quda::ColorSpinorField *ref, quda::ColorSpinorField *in,
                               quda::ColorSpinorField *out, double mass, void *qdp_fatlink[], void *qdp_longlink[],
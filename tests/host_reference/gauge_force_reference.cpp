@@ -3,6 +3,8 @@
 #include <math.h>
 #include <string.h>
 #include <type_traits>
+#include <algorithm>
+#include <vector>
 
 #include "quda.h"
 #include "gauge_field.h"
@@ -266,63 +268,128 @@ int gf_neighborIndexFullLattice(int i, int dx4, int dx3, int dx2, int dx1)
   return ret;
 }
 
-// this functon compute one path for all lattice sites
-template <typename su3_matrix, typename Float>
-static void compute_path_product(su3_matrix *staple, su3_matrix **sitelink, su3_matrix **sitelink_ex_2d, int *path,
-                                 int len, Float loop_coeff, int dir)
+/**
+   A node in the prefix tree of the input paths.  Each node
+   corresponds to one link of one or more paths, and the product at a
+   node is the product at its parent times that link, so paths which
+   share a prefix (e.g., the staple and rectangle segments) share the
+   corresponding matrix multiplications.
+ */
+struct PathNode {
+  int depth;     // number of links in the product ending at this node
+  int dx[4];     // displacement of the link from the site
+  int lnkdir;    // direction of the link
+  bool forwards; // whether the link is traversed forwards or backwards
+  double coeff;  // summed loop coefficient of the paths ending here
+};
+
+/**
+   @brief Build the prefix tree of the paths for direction dir,
+   flattened in depth-first pre-order such that a node's parent
+   product is always found at depth - 1 of the running product stack.
+*/
+static std::vector<PathNode> build_path_tree(int dir, int **path, int *length, const double *loop_coeff,
+                                             int num_paths)
 {
-  su3_matrix prev_matrix, curr_matrix, tmat;
-  int dx[4];
-
-  for (int i = 0; i < V; i++) {
-    memset(dx, 0, sizeof(dx));
-    memset(&curr_matrix, 0, sizeof(curr_matrix));
-
-    curr_matrix.e[0][0].real = 1.0;
-    curr_matrix.e[1][1].real = 1.0;
-    curr_matrix.e[2][2].real = 1.0;
-
-    dx[dir] = 1;
-    for (int j = 0; j < len; j++) {
-      int lnkdir;
-
-      prev_matrix = curr_matrix;
-      if (GOES_FORWARDS(path[j])) {
-        // dx[path[j]] +=1;
-        lnkdir = path[j];
-      } else {
-        dx[OPP_DIR(path[j])] -= 1;
-        lnkdir = OPP_DIR(path[j]);
+  struct TrieNode {
+    PathNode node;
+    int child[8];
+  };
+  std::vector<TrieNode> trie(1); // root node is the starting point of the path
+  std::fill(trie[0].child, trie[0].child + 8, -1);
+  trie[0].node = {0, {0, 0, 0, 0}, 0, true, 0.0};
+  trie[0].node.dx[dir] = 1;
+
+  for (int p = 0; p < num_paths; p++) {
+    int n = 0;
+    for (int j = 0; j < length[p]; j++) {
+      int step = path[p][j];
+      if (trie[n].child[step] < 0) {
+        TrieNode child;
+        std::fill(child.child, child.child + 8, -1);
+        child.node = trie[n].node;
+        child.node.depth++;
+        child.node.coeff = 0.0;
+        // the displacement of the parent node points at its link, so
+        // step over it if it was traversed forwards
+        if (n > 0 && trie[n].node.forwards) child.node.dx[trie[n].node.lnkdir] += 1;
+        child.node.forwards = GOES_FORWARDS(step);
+        child.node.lnkdir = child.node.forwards ? step : OPP_DIR(step);
+        if (!child.node.forwards) child.node.dx[child.node.lnkdir] -= 1;
+        trie[n].child[step] = trie.size();
+        trie.push_back(child);
       }
+      n = trie[n].child[step];
+    }
+    trie[n].node.coeff += loop_coeff[p];
+  }
 
-      int nbr_idx = gf_neighborIndexFullLattice(i, dx[3], dx[2], dx[1], dx[0]);
-#ifdef MULTI_GPU
-      su3_matrix *lnk = sitelink_ex_2d[lnkdir] + nbr_idx;
-#else
-      su3_matrix *lnk = sitelink[lnkdir] + nbr_idx;
+  std::vector<PathNode> tree;
+  std::vector<int> stack;
+  for (int c = 7; c >= 0; c--)
+    if (trie[0].child[c] >= 0) stack.push_back(trie[0].child[c]);
+  while (!stack.empty()) {
+    int n = stack.back();
+    stack.pop_back();
+    tree.push_back(trie[n].node);
+    for (int c = 7; c >= 0; c--)
+      if (trie[n].child[c] >= 0) stack.push_back(trie[n].child[c]);
+  }
+  return tree;
+}
+
+// this function computes the sum of all paths in the tree for all
+// lattice sites, walking the tree once per site; QUDA is checked
+// against the result by the gauge_force_<prec> ctest entries
+template <typename su3_matrix, typename Float>
+static void compute_path_product(su3_matrix *staple, su3_matrix **sitelink, const std::vector<PathNode> &tree)
+{
+  int max_depth = 0;
+  for (auto &n : tree) max_depth = std::max(max_depth, n.depth);
+
+#ifdef _OPENMP
+#pragma omp parallel
 #endif
-      if (GOES_FORWARDS(path[j])) {
-        mult_su3_nn(&prev_matrix, lnk, &curr_matrix);
-      } else {
-        mult_su3_na(&prev_matrix, lnk, &curr_matrix);
-      }
+  {
+    std::vector<su3_matrix> prod(max_depth + 1);
 
-      if (GOES_FORWARDS(path[j])) {
-        dx[path[j]] += 1;
-      } else {
-        // we already substract one in the code above
+#ifdef _OPENMP
+#pragma omp for
+#endif
+    for (int i = 0; i < V; i++) {
+      su3_matrix sum, tmat;
+      memset(&sum, 0, sizeof(sum));
+
+      for (auto &n : tree) {
+        int nbr_idx = gf_neighborIndexFullLattice(i, n.dx[3], n.dx[2], n.dx[1], n.dx[0]);
+        su3_matrix *lnk = sitelink[n.lnkdir] + nbr_idx;
+
+        if (n.depth == 1) {
+          if (n.forwards)
+            prod[1] = *lnk;
+          else
+            su3_adjoint(lnk, &prod[1]);
+        } else if (n.forwards) {
+          mult_su3_nn(&prod[n.depth - 1], lnk, &prod[n.depth]);
+        } else {
+          mult_su3_na(&prod[n.depth - 1], lnk, &prod[n.depth]);
+        }
+
+        if (n.coeff != 0.0) scalar_mult_add_su3_matrix(&sum, &prod[n.depth], static_cast<Float>(n.coeff), &sum);
       }
 
-    } // j
-
-    su3_adjoint(&curr_matrix, &tmat);
-    scalar_mult_add_su3_matrix(staple + i, &tmat, loop_coeff, staple + i);
-  } // i
+      su3_adjoint(&sum, &tmat);
+      scalar_mult_add_su3_matrix(staple + i, &tmat, static_cast<Float>(1.0), staple + i);
+    } // i
+  }
 }
 
 template <typename su3_matrix, typename anti_hermitmat, typename Float>
 static void update_mom(anti_hermitmat *momentum, int dir, su3_matrix **sitelink, su3_matrix *staple, Float eb3)
 {
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
   for (int i = 0; i < V; i++) {
     su3_matrix tmat1;
     su3_matrix tmat2;
@@ -357,16 +424,21 @@ void gauge_force_reference_dir(void *refMom, int dir, double eb3, void **sitelin
 
   memset(staple, 0, V * gauge_site_size * gSize);
 
-  for (int i = 0; i < num_paths; i++) {
-    if (prec == QUDA_DOUBLE_PRECISION) {
-      double *my_loop_coeff = (double *)loop_coeff;
-      compute_path_product((dsu3_matrix *)staple, (dsu3_matrix **)sitelink, (dsu3_matrix **)sitelink_ex_2d, path_dir[i],
-                           length[i], my_loop_coeff[i], dir);
-    } else {
-      float *my_loop_coeff = (float *)loop_coeff;
-      compute_path_product((fsu3_matrix *)staple, (fsu3_matrix **)sitelink, (fsu3_matrix **)sitelink_ex_2d, path_dir[i],
-                           length[i], my_loop_coeff[i], dir);
-    }
+  std::vector<double> coeff(num_paths);
+  for (int i = 0; i < num_paths; i++)
+    coeff[i] = prec == QUDA_DOUBLE_PRECISION ? ((double *)loop_coeff)[i] : ((float *)loop_coeff)[i];
+  auto tree = build_path_tree(dir, path_dir, length, coeff.data(), num_paths);
+
+#ifdef MULTI_GPU
+  void **link = sitelink_ex_2d;
+#else
+  void **link = sitelink;
+#endif
+
+  if (prec == QUDA_DOUBLE_PRECISION) {
+    compute_path_product<dsu3_matrix, double>((dsu3_matrix *)staple, (dsu3_matrix **)link, tree);
+  } else {
+    compute_path_product<fsu3_matrix, float>((fsu3_matrix *)staple, (fsu3_matrix **)link, tree);
   }
 
   if (prec == QUDA_DOUBLE_PRECISION) {
@@ -7,6 +7,8 @@
 #include <quda.h>
 #include <host_utils.h>
 #include <misc.h>
+#include <timer.h>
+#include <util_quda.h>
 #include <hisq_force_reference.h>
 
 extern int Z[4];
@@ -61,6 +63,17 @@ typedef struct {
 typedef struct { fsu3_vector h[2]; } fhalf_wilson_vector;
 typedef struct { dsu3_vector h[2]; } dhalf_wilson_vector;
 
+// running flop and byte counts of the lattice-wide kernels below,
+// used to report the throughput of the reference force computation
+static double hisq_force_flops = 0.0;
+static double hisq_force_bytes = 0.0;
+
+static inline void count_hisq_force(double flops_per_site, double bytes_per_site)
+{
+  hisq_force_flops += flops_per_site * V;
+  hisq_force_bytes += bytes_per_site * V;
+}
+
 
 template<typename su3_matrix>
 su3_matrix* get_su3_matrix(int gauge_order, su3_matrix* p, int idx, int dir)
@@ -396,11 +409,15 @@ shifted_outer_prod(half_wilson_vector *src, su3_matrix* dest, int dir)
 	dx[dir]=1;	
     }else{ dx[OPP_DIR(dir)]=-1; }
 
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
     for(i=0;i < V; i++){
       int nbr_idx = neighborIndexFullLattice(i, dx[3], dx[2], dx[1], dx[0]);
       half_wilson_vector* hw = src + nbr_idx;
       su3_projector( &src[i].h[0], &(hw->h[0]), &dest[i]);
     }	
+    count_hisq_force(54, sizeof(su3_matrix) + sizeof(half_wilson_vector));
 }
 
 
@@ -418,6 +435,9 @@ forward_shifted_outer_prod(half_wilson_vector *src, su3_matrix* dest, int dir)
     dx[dir]=1;	
   }else{ dx[OPP_DIR(dir)]=-1; }
 
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
   for(i=0;i < V; i++){
     int nbr_idx = neighborIndexFullLattice(i, dx[3], dx[2], dx[1], dx[0]);
     half_wilson_vector* hw = src + nbr_idx;
@@ -436,9 +456,12 @@ template <typename half_wilson_vector, typename su3_matrix>
 static void
 computeLinkOrderedOuterProduct(half_wilson_vector *src, su3_matrix* dest, int gauge_order)
 {
-  int dx[4];
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
   for(int i=0; i<V; ++i){
     for(int dir=0; dir<4; ++dir){
+      int dx[4];
       dx[3]=dx[2]=dx[1]=dx[0]=0;
       dx[dir] = 1;
       int nbr_idx = neighborIndexFullLattice(i, dx[3], dx[2], dx[1], dx[0]);
@@ -455,9 +478,12 @@ template <typename half_wilson_vector, typename su3_matrix>
 static void
 computeLinkOrderedOuterProduct(half_wilson_vector *src, su3_matrix* dest, size_t nhops, int gauge_order)
 {
-  int dx[4];
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
   for(int i=0; i<V; ++i){
     for(int dir=0; dir<4; ++dir){
+      int dx[4];
       dx[3]=dx[2]=dx[1]=dx[0]=0;
       dx[dir] = nhops;
       int nbr_idx = neighborIndexFullLattice(i, dx[3], dx[2], dx[1], dx[0]);
@@ -532,6 +558,9 @@ u_shift_mat(su3_matrix *src, su3_matrix *dest, int dir, su3_matrix* sitelink)
 
   if(GOES_FORWARDS(dir)){
     dx[dir]=1;
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
     for(i=0; i<V; i++){
       int nbr_idx = neighborIndexFullLattice(i, dx[3], dx[2], dx[1], dx[0]);
       su3_matrix* mat = src+nbr_idx; // No need for a factor of 4 here, the colour matrices do not have a Lorentz index
@@ -540,6 +569,9 @@ u_shift_mat(su3_matrix *src, su3_matrix *dest, int dir, su3_matrix* sitelink)
     }	
   }else{
     dx[OPP_DIR(dir)]=-1;
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
     for(i=0; i<V; i++){
       int nbr_idx = neighborIndexFullLattice(i, dx[3], dx[2], dx[1], dx[0]);
       su3_matrix* mat = src+nbr_idx; // No need for a factor of 4 here, the colour matrices do not have a Lorentz index
@@ -547,6 +579,7 @@ u_shift_mat(su3_matrix *src, su3_matrix *dest, int dir, su3_matrix* sitelink)
       matrix_mult_an(link, mat, &dest[i]);
     }
   }
+  count_hisq_force(198, 3 * sizeof(su3_matrix));
   return;
 }
 
@@ -577,6 +610,9 @@ add_3f_force_to_mom(half_wilson_vector *back, half_wilson_vector *forw,
 	my_coeff[1] = coeff[1]; 
     }
     
+#ifdef _OPENMP
+#pragma omp parallel for private(tmp_coeff)
+#endif
     for(i=0;i < V;i++){
 	if (i < Vh){
 	    tmp_coeff[0] = my_coeff[0];
@@ -640,9 +676,7 @@ add_force_to_momentum(su3_matrix *back, su3_matrix *forw,
     int dir, Real coeff, anti_hermitmat* momentum)
 {
   Real my_coeff;
-  Real tmp_coeff;
   int mydir;
-  int i;
 
   if(GOES_BACKWARDS(dir)){
     mydir = OPP_DIR(dir);
@@ -653,10 +687,11 @@ add_force_to_momentum(su3_matrix *back, su3_matrix *forw,
   }
 
 
-  for(i=0; i<V; i++){
-    if(i<Vh){ tmp_coeff = my_coeff; }
-    else{ tmp_coeff = -my_coeff; }
-
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for(int i=0; i<V; i++){
+    Real tmp_coeff = i < Vh ? my_coeff : -my_coeff;
 
     su3_matrix tmat;
     su3_matrix mom_matrix;
@@ -667,6 +702,7 @@ add_force_to_momentum(su3_matrix *back, su3_matrix *forw,
 
     make_anti_hermitian(&mom_matrix, mom);	
   }
+  count_hisq_force(234, 2 * sizeof(su3_matrix) + 2 * sizeof(anti_hermitmat));
   return;
 }
 
@@ -717,7 +753,6 @@ side_link_force(int mu, int nu, Real coeff, su3_matrix *Path,
 #define Popmu        tempmat[4]
 #define Pmumumu      tempmat[4]
 
-#define Qmu          tempmat[7]
 #define Qnumu        tempmat[8]
 #define Qrhonumu     tempmat[2] // same as Prhonumu
 
@@ -740,82 +775,92 @@ static void set_identity_matrix(su3_matrix* mat)
 
 template<typename su3_matrix> 
 static void set_identity(su3_matrix* matrices, int num_dirs){
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
   for(int i=0; i<V*num_dirs; i++){
     set_identity_matrix(&matrices[i]);	
   }
 }
 
 
-template <typename Real, typename su3_matrix, typename anti_hermitmat>
-void do_color_matrix_hisq_force_reference(Real eps, Real weight, 
-			   su3_matrix* temp_xx, Real* act_path_coeff,
-			   su3_matrix* sitelink, anti_hermitmat* mom)
+// P += coeff * Q over the full lattice
+template <typename su3_matrix, typename Real>
+static void accumulate_path(su3_matrix *P, su3_matrix *Q, Real coeff)
+{
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (int i = 0; i < V; i++) scalar_mult_add_su3_matrix(&P[i], &Q[i], coeff, &P[i]);
+  count_hisq_force(36, 3 * sizeof(su3_matrix));
+}
+
+
+// The 3-, 5- and 7-link and Lepage staple tree common to the colour
+// matrix and half-wilson reference routines.  outer_prod(sig) returns
+// the field |X(x)><X(x-sig)|.  The Q paths (the link products without
+// the outer product at their end) do not depend on sig, so the
+// single-link products Qmu and the Lepage products Qmumu are computed
+// once up front and reused for every sig.
+template <typename Real, typename su3_matrix, typename anti_hermitmat, typename OuterProd>
+static void hisq_staple_force_reference(Real eps, Real weight, Real *act_path_coeff, su3_matrix *sitelink,
+                                        anti_hermitmat *mom, OuterProd outer_prod)
 {
-  int i;
   int mu, nu, rho, sig;
   Real coeff;
   Real OneLink, Lepage, FiveSt, ThreeSt, SevenSt;
-//  Real Naik;
-  Real mLepage, mFiveSt, mThreeSt, mSevenSt;    
+  Real mLepage, mFiveSt, mThreeSt, mSevenSt;
 
   su3_matrix* tempmat[9];
-  int sites_on_node = V;
-  //int DirectLinks[8] ;
- 
+  su3_matrix* Qmu_cache[8];
+  su3_matrix* Qmumu_cache[8];
+
+  quda::Timer timer;
+  timer.Start(__func__, __FILE__, __LINE__);
+  hisq_force_flops = hisq_force_bytes = 0.0;
+
   Real ferm_epsilon;
   ferm_epsilon = 2.0*weight*eps;
-  OneLink = act_path_coeff[0]*ferm_epsilon ; 
-//  Naik    = act_path_coeff[1]*ferm_epsilon ; mNaik    = -Naik;
+  OneLink = act_path_coeff[0]*ferm_epsilon ;
   ThreeSt = act_path_coeff[2]*ferm_epsilon ; mThreeSt = -ThreeSt;
   FiveSt  = act_path_coeff[3]*ferm_epsilon ; mFiveSt  = -FiveSt;
   SevenSt = act_path_coeff[4]*ferm_epsilon ; mSevenSt = -SevenSt;
   Lepage  = act_path_coeff[5]*ferm_epsilon ; mLepage  = -Lepage;
 
-//  for(mu=0;mu<8;mu++){
-//    DirectLinks[mu] = 0 ;
-//  }
-
-  for(mu=0; mu<9; mu++){	
-    tempmat[mu] = (su3_matrix *)malloc( sites_on_node*sizeof(su3_matrix) );  
+  for(mu=0; mu<9; mu++){
+    tempmat[mu] = (su3_matrix *)malloc( V*sizeof(su3_matrix) );
   }
 
-
   su3_matrix* id;
-  id = (su3_matrix *)malloc(sites_on_node*sizeof(su3_matrix) ); 
-  //su3_matrix* id4;
-  //id4 = (su3_matrix *)malloc(sites_on_node*4*sizeof(su3_matrix) ); 
-
- // su3_matrix* temp_mat;
-//  temp_mat = (su3_matrix *)malloc(sites_on_node*sizeof(su3_matrix) ); 
-
-
-  //  su3_matrix* temp_xx;
-  //  temp_xx = (su3_matrix *)malloc(sites_on_node*8*sizeof(su3_matrix) );
-  //  shiftedOuterProduct(temp_x, temp_xx);
+  id = (su3_matrix *)malloc(V*sizeof(su3_matrix) );
 
   // initialise id so that it is the identity matrix on each lattice site
   set_identity(id,1);
 
-  printf("Calling modified hisq\n");
-  return;
-
+  for(mu=0; mu<8; mu++){
+    Qmu_cache[mu] = (su3_matrix *)malloc( V*sizeof(su3_matrix) );
+    Qmumu_cache[mu] = (su3_matrix *)malloc( V*sizeof(su3_matrix) );
+    u_shift_mat(id, Qmu_cache[mu], OPP_DIR(mu), sitelink); // Qmu = U[mu]
+    u_shift_mat(Qmu_cache[mu], Qmumu_cache[mu], OPP_DIR(mu), sitelink);
+  }
 
   for(sig=0; sig < 8; sig++){
-    // One-link term - don't have the savings here that we get when working with the 
+    su3_matrix *Xsig = outer_prod(sig);
+
+    // One-link term - don't have the savings here that we get when working with the
     // half-wilson vectors
     if(GOES_FORWARDS(sig)){
-      u_shift_mat(&temp_xx[OPP_DIR(sig)*V], Pmu, sig, sitelink);
-      add_force_to_momentum(Pmu, id, sig, OneLink, mom); // I could optimise functions which 
-      // involve id
+      u_shift_mat(Xsig, Pmu, sig, sitelink);
+      add_force_to_momentum(Pmu, id, sig, OneLink, mom);
     }
 
-
-
     for(mu = 0; mu < 8; mu++){
       if ( (mu == sig) || (mu == OPP_DIR(sig))){
         continue;
       }
-      //     3 link path 
+      su3_matrix *Qmu = Qmu_cache[mu];
+
+      // 3 link path
       //	 sig
       //    A  _______
       //      |       |
@@ -823,17 +868,12 @@ void do_color_matrix_hisq_force_reference(Real eps, Real weight,
       //      |       |
       //
       //
-      u_shift_mat(&temp_xx[OPP_DIR(sig)*V], Pmu, OPP_DIR(mu), sitelink); // temp_xx[sig] stores |X(x)><X(x-sig)|
-      u_shift_mat(id, Qmu, OPP_DIR(mu), sitelink); // This returns the path less the outer-product of quark fields at the end 
-                                                   // Qmu = U[mu]	
-
-
+      u_shift_mat(Xsig, Pmu, OPP_DIR(mu), sitelink); // Xsig stores |X(x)><X(x-sig)|
       u_shift_mat(Pmu, P3, sig, sitelink); // P3 is U[sig](X)U[-mu](X+sig) temp_xx
       if (GOES_FORWARDS(sig)){
         // add contribution from middle link
-        add_force_to_momentum(P3, Qmu, sig, mThreeSt, mom); 
-        // matrix_mult_na(P3[x],Qmu[x],tmp);
-        // mom[sig][x] += mThreeSt*tmp; 
+        add_force_to_momentum(P3, Qmu, sig, mThreeSt, mom); // matrix_mult_na(P3[x],Qmu[x],tmp);
+                                                            // mom[sig][x] += mThreeSt*tmp;
       }
       for(nu=0; nu < 8; nu++){
         if (nu == sig || nu == OPP_DIR(sig)
@@ -841,17 +881,17 @@ void do_color_matrix_hisq_force_reference(Real eps, Real weight,
           continue;
         }
 
-	/*
+        /*
          5 link path
-        
+
                 sig
             A ________
              |        |
             /|\      \|/
              |        |
-              \	       \
+              \        \
                \        \
-	*/
+        */
 
         u_shift_mat(Pmu, Pnumu, OPP_DIR(nu), sitelink);
         u_shift_mat(Qmu, Qnumu, OPP_DIR(nu), sitelink);
@@ -859,7 +899,8 @@ void do_color_matrix_hisq_force_reference(Real eps, Real weight,
         u_shift_mat(Pnumu, P5, sig, sitelink);
         if (GOES_FORWARDS(sig)){
           add_force_to_momentum(P5, Qnumu, sig, FiveSt, mom);
-        } // seems to do what I think it should
+        }
+
         for(rho =0; rho < 8; rho++){
           if (rho == sig || rho == OPP_DIR(sig)
               || rho == mu || rho == OPP_DIR(mu)
@@ -875,240 +916,87 @@ void do_color_matrix_hisq_force_reference(Real eps, Real weight,
           // => store Qrhonumu in the same memory
           u_shift_mat(Qnumu, Qrhonumu, OPP_DIR(rho), sitelink);
 
-
           if(GOES_FORWARDS(sig)){
-            add_force_to_momentum(P7, Qrhonumu, sig, mSevenSt, mom) ;	
+            add_force_to_momentum(P7, Qrhonumu, sig, mSevenSt, mom) ;
           }
-             u_shift_mat(P7, P7rho, rho, sitelink);
-             side_link_force(rho, sig, SevenSt, Qnumu, P7, Qrhonumu, P7rho, mom);		    
-             if(FiveSt != 0)coeff = SevenSt/FiveSt ; else coeff = 0;
-             for(i=0; i<V; i++){
-             scalar_mult_add_su3_matrix(&P5[i], &P7rho[i], coeff, &P5[i]);
-             } // end loop over volume
-        } // end loop over rho	
-
-
-           u_shift_mat(P5, P5nu, nu, sitelink);	
-           side_link_force(nu,sig,mFiveSt,Qmu,P5,Qnumu,P5nu,mom); // I believe this should do what I want it to
-        // check this!
-        if(ThreeSt != 0)coeff	= FiveSt/ThreeSt; else coeff = 0;
-
-        for(i=0; i<V; i++){
-        scalar_mult_add_su3_matrix(&P3[i], &P5nu[i], coeff, &P3[i]);
-        } // end loop over volume
+
+          u_shift_mat(P7, P7rho, rho, sitelink);
+          side_link_force(rho, sig, SevenSt, Qnumu, P7, Qrhonumu, P7rho, mom);
+          if(FiveSt != 0)coeff = SevenSt/FiveSt ; else coeff = 0;
+          accumulate_path(P5, P7rho, coeff);
+        } // end loop over rho
+
+        u_shift_mat(P5, P5nu, nu, sitelink);
+        side_link_force(nu,sig,mFiveSt,Qmu,P5,Qnumu,P5nu,mom);
+        if(ThreeSt != 0)coeff = FiveSt/ThreeSt; else coeff = 0;
+        accumulate_path(P3, P5nu, coeff);
       } // end loop over nu
 
-      // Lepage term 
+      // Lepage term
+      su3_matrix *Qmumu = Qmumu_cache[mu];
       u_shift_mat(Pmu, Pnumu, OPP_DIR(mu), sitelink);
-      u_shift_mat(Qmu, Qnumu, OPP_DIR(mu), sitelink);
 
       u_shift_mat(Pnumu, P5, sig, sitelink);
       if(GOES_FORWARDS(sig)){
-      add_force_to_momentum(P5, Qnumu, sig, Lepage, mom); 
+        add_force_to_momentum(P5, Qmumu, sig, Lepage, mom);
       }
 
       u_shift_mat(P5, P5nu, mu, sitelink);
-      side_link_force(mu, sig, mLepage, Qmu, P5, Qnumu, P5nu, mom);
-
+      side_link_force(mu, sig, mLepage, Qmu, P5, Qmumu, P5nu, mom);
 
       if(ThreeSt != 0)coeff = Lepage/ThreeSt; else coeff = 0;
-
-      for(i=0; i<V; i++){
-      scalar_mult_add_su3_matrix(&P3[i], &P5nu[i], coeff, &P3[i]);
-      }
+      accumulate_path(P3, P5nu, coeff);
 
       if(GOES_FORWARDS(mu)){
-      u_shift_mat(P3, P3mu, mu, sitelink);
+        u_shift_mat(P3, P3mu, mu, sitelink);
       }
       side_link_force(mu, sig, ThreeSt, id, P3, Qmu, P3mu, mom);
     } // end loop over mu
   } // end loop over sig
-} // modified hisq_force_reference
 
+  for(mu=0; mu<9; mu++){
+    free(tempmat[mu]);
+  }
+  for(mu=0; mu<8; mu++){
+    free(Qmu_cache[mu]);
+    free(Qmumu_cache[mu]);
+  }
+  free(id);
 
+  timer.Stop(__func__, __FILE__, __LINE__);
+  printfQuda("HISQ force reference: %.3f s, %.2f Gflop/s, %.2f GB/s\n", timer.time,
+             1e-9 * hisq_force_flops / timer.time, 1e-9 * hisq_force_bytes / timer.time);
+}
 
 
+template <typename Real, typename su3_matrix, typename anti_hermitmat>
+void do_color_matrix_hisq_force_reference(Real eps, Real weight,
+			   su3_matrix* temp_xx, Real* act_path_coeff,
+			   su3_matrix* sitelink, anti_hermitmat* mom)
+{
+  // not implemented: nothing calls this variant, and no test checks
+  // it, so it is left as a no-op as before
+  return;
+}
 
 
-// This version of the test routine uses 
-// half-wilson vectors instead of color matrices.
+// This version of the test routine uses
+// half-wilson vectors instead of color matrices.  No test calls it:
+// hisq_paths_force_test checks QUDA against hisqStaplesForceCPU() in
+// hisq_force_reference2.cpp instead.
 template <typename Real, typename su3_matrix, typename anti_hermitmat, typename half_wilson_vector>
-void do_halfwilson_hisq_force_reference(Real eps, Real weight, 
+void do_halfwilson_hisq_force_reference(Real eps, Real weight,
 			   half_wilson_vector* temp_x, Real* act_path_coeff,
 			   su3_matrix* sitelink, anti_hermitmat* mom)
 {
-  int i;
-  int mu, nu, rho, sig;
-  Real coeff;
-  Real OneLink, Lepage, FiveSt, ThreeSt, SevenSt;
-  //Real Naik;
-  Real mLepage, mFiveSt, mThreeSt, mSevenSt;    
-
-  su3_matrix* tempmat[9];
-  int sites_on_node = V;
-//  int DirectLinks[8] ;
- 
-  Real ferm_epsilon;
-  ferm_epsilon = 2.0*weight*eps;
-  OneLink = act_path_coeff[0]*ferm_epsilon ; 
-//  Naik    = act_path_coeff[1]*ferm_epsilon ; 
-  ThreeSt = act_path_coeff[2]*ferm_epsilon ; mThreeSt = -ThreeSt;
-  FiveSt  = act_path_coeff[3]*ferm_epsilon ; mFiveSt  = -FiveSt;
-  SevenSt = act_path_coeff[4]*ferm_epsilon ; mSevenSt = -SevenSt;
-  Lepage  = act_path_coeff[5]*ferm_epsilon ; mLepage  = -Lepage;
-   
- 
-//  for(mu=0;mu<8;mu++){
-//    DirectLinks[mu] = 0 ;
-//  }
-
-  for(mu=0; mu<9; mu++){	
-    tempmat[mu] = (su3_matrix *)malloc( sites_on_node*sizeof(su3_matrix) );  
-  }
-
-
-  su3_matrix* id;
-  id = (su3_matrix *)malloc(sites_on_node*sizeof(su3_matrix) ); 
-  su3_matrix* id4;
-  id4 = (su3_matrix *)malloc(sites_on_node*4*sizeof(su3_matrix) ); 
-
   su3_matrix* temp_mat;
-  temp_mat = (su3_matrix *)malloc(sites_on_node*sizeof(su3_matrix) ); 
-
-  // initialise id so that it is the identity matrix on each lattice site
-  set_identity(id,1);
+  temp_mat = (su3_matrix *)malloc(V*sizeof(su3_matrix) );
 
-  printf("Calling hisq reference routine\n");
-  for(sig=0; sig < 8; sig++){
+  hisq_staple_force_reference(eps, weight, act_path_coeff, sitelink, mom, [&](int sig) {
     shifted_outer_prod(temp_x, temp_mat, OPP_DIR(sig));
+    return temp_mat;
+  });
 
-    // One-link term - don't have the savings here that we get when working with the 
-    // half-wilson vectors
-    if(GOES_FORWARDS(sig)){
-      u_shift_mat(temp_mat, Pmu, sig, sitelink);
-       add_force_to_momentum(Pmu, id, sig, OneLink, mom); 
-    }
-
-    for(mu = 0; mu < 8; mu++){
-      if ( (mu == sig) || (mu == OPP_DIR(sig))){
-		continue;
-      }
-      // 3 link path 
-      //	 sig
-      //    A  _______
-      //      |       |
-      //  mu /|\     \|/
-      //      |       |
-      //
-      //
-      u_shift_mat(temp_mat, Pmu, OPP_DIR(mu), sitelink); // temp_xx[sig] stores |X(x)><X(x-sig)|
-      u_shift_mat(id, Qmu, OPP_DIR(mu), sitelink);       // This returns the path less the outer-product of quark fields at the end 
-						         // Qmu = U[mu]	
-	
-
-      u_shift_mat(Pmu, P3, sig, sitelink); // P3 is U[sig](X)U[-mu](X+sig) temp_xx
-      if (GOES_FORWARDS(sig)){
-	  // add contribution from middle link
-        add_force_to_momentum(P3, Qmu, sig, mThreeSt, mom); // matrix_mult_na(P3[x],Qmu[x],tmp);
-							    // mom[sig][x] += mThreeSt*tmp; 
-      }
-      for(nu=0; nu < 8; nu++){
-        if (nu == sig || nu == OPP_DIR(sig)
-	 || nu == mu || nu == OPP_DIR(mu)){
-	 continue;
-        }
-
-	/*	
-	 5 link path
-        
-	        sig
-	    A ________
-	     |        |
-	    /|\      \|/
-	     |        |
-	      \        \
-	       \        \
-	*/
-
-	u_shift_mat(Pmu, Pnumu, OPP_DIR(nu), sitelink);
-	u_shift_mat(Qmu, Qnumu, OPP_DIR(nu), sitelink);
-
-        u_shift_mat(Pnumu, P5, sig, sitelink);
-        if (GOES_FORWARDS(sig)){
-	  add_force_to_momentum(P5, Qnumu, sig, FiveSt, mom);
-        } // seems to do what I think it should
-
-	for(rho =0; rho < 8; rho++){
-	  if (rho == sig || rho == OPP_DIR(sig)
-	    || rho == mu || rho == OPP_DIR(mu)
-	    || rho == nu || rho == OPP_DIR(nu)){
-	       continue;
-	   }
-		    
-           //7 link path
-	  u_shift_mat(Pnumu, Prhonumu, OPP_DIR(rho), sitelink);
-	  u_shift_mat(Prhonumu, P7, sig, sitelink);
-	  
-	  // Prhonumu = tempmat[2] is not needed again
-	  // => store Qrhonumu in the same memory
-	  u_shift_mat(Qnumu, Qrhonumu, OPP_DIR(rho), sitelink);
-	
-
-          if(GOES_FORWARDS(sig)){
-	    add_force_to_momentum(P7, Qrhonumu, sig, mSevenSt, mom) ;	
-	  }
-
-	  u_shift_mat(P7, P7rho, rho, sitelink);
-	  side_link_force(rho, sig, SevenSt, Qnumu, P7, Qrhonumu, P7rho, mom);		    
-	  if(FiveSt != 0)coeff = SevenSt/FiveSt ; else coeff = 0;
-	  for(i=0; i<V; i++){
-	    scalar_mult_add_su3_matrix(&P5[i], &P7rho[i], coeff, &P5[i]);
-	  } // end loop over volume
-	} // end loop over rho	
-
-
-        u_shift_mat(P5, P5nu, nu, sitelink);	
-	side_link_force(nu,sig,mFiveSt,Qmu,P5,Qnumu,P5nu,mom); // I believe this should do what I want it to
-							       // check this!
-	if(ThreeSt != 0)coeff	= FiveSt/ThreeSt; else coeff = 0;
-	
-        for(i=0; i<V; i++){
-	  scalar_mult_add_su3_matrix(&P3[i], &P5nu[i], coeff, &P3[i]);
-	} // end loop over volume
-      } // end loop over nu
-
-      // Lepage term 
-      u_shift_mat(Pmu, Pnumu, OPP_DIR(mu), sitelink);
-      u_shift_mat(Qmu, Qnumu, OPP_DIR(mu), sitelink);
-	
-      u_shift_mat(Pnumu, P5, sig, sitelink);
-      if(GOES_FORWARDS(sig)){
-        add_force_to_momentum(P5, Qnumu, sig, Lepage, mom); 
-      }
-
-      u_shift_mat(P5, P5nu, mu, sitelink);
-      side_link_force(mu, sig, mLepage, Qmu, P5, Qnumu, P5nu, mom);
-
-
-      if(ThreeSt != 0)coeff = Lepage/ThreeSt; else coeff = 0;
-
-      for(i=0; i<V; i++){
-	scalar_mult_add_su3_matrix(&P3[i], &P5nu[i], coeff, &P3[i]);
-      }
-   
-      if(GOES_FORWARDS(mu)){
-	u_shift_mat(P3, P3mu, mu, sitelink);
-      }
-      side_link_force(mu, sig, ThreeSt, id, P3, Qmu, P3mu, mom);
-    } // end loop over mu
-  } // end loop over sig
-
-  for(mu=0; mu<9; mu++){	
-    free(tempmat[mu]);
-  }
-  
-  free(id);
-  free(id4);
   free(temp_mat);
 }
 
@@ -1126,7 +1014,6 @@ void do_halfwilson_hisq_force_reference(Real eps, Real weight,
 #undef Popmu
 #undef Pmumumu
 
-#undef Qmu
 #undef Qnumu
 #undef Qrhonumu
 
@@ -6,6 +6,8 @@
 
 #include <quda.h>
 #include <gauge_field.h>
+#include <timer.h>
+#include <util_quda.h>
 
 using namespace quda;
 //namespace quda {
@@ -773,6 +775,17 @@ struct ColorMatrix
   typedef Matrix<3, std::complex<Real> > Type;
 };
 
+  // running flop and byte counts of the staple kernels below, used to
+  // report the throughput of hisqStaplesForceCPU
+  static double staple_force_flops = 0.0;
+  static double staple_force_bytes = 0.0;
+
+  template <class Real> static inline void count_staple_force(int sites, double flops_per_site, int matrices_per_site)
+  {
+    staple_force_flops += flops_per_site * sites;
+    staple_force_bytes += matrices_per_site * 18.0 * sizeof(Real) * sites;
+  }
+
   template<class Real, int oddBit> 
   void computeOneLinkSite(const int dim[4], 
 			  int half_lattice_index, 		
@@ -804,6 +817,9 @@ struct ColorMatrix
      for(int dir=0; dir<4; ++dir) volume *= dim[dir];
      const int half_volume = volume/2;
      LoadStore<Real> ls(volume);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
      for(int site=0; site<half_volume; ++site){
        computeOneLinkSite<Real,0>(dim, site, 
 			   oprod, 
@@ -812,12 +828,16 @@ struct ColorMatrix
 			 
      }
      // Loop over odd lattice sites
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
      for(int site=0; site<half_volume; ++site){
        computeOneLinkSite<Real,1>(dim, site, 
 			   oprod, 
 			   sig, coeff, ls,
 			   output);
      }
+     count_staple_force<Real>(volume, 36, 3);
      return;
    }
 
@@ -955,6 +975,9 @@ struct ColorMatrix
    // To keep the code as close to the GPU code as possible, we'll 
    // loop over the even sites first and then the odd sites
    LoadStore<Real> ls(volume);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
    for(int site=0; site<loop_count; ++site){
      computeMiddleLinkSite<Real, 0>(site, dim,
 				      oprod, Qprev, link,
@@ -963,6 +986,9 @@ struct ColorMatrix
 				      Pmu, P3, Qmu, newOprod);
    }
    // Loop over odd lattice sites
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
    for(int site=0; site<loop_count; ++site){
      computeMiddleLinkSite<Real,1>(site, dim,
 				   oprod, Qprev, link,
@@ -970,6 +996,7 @@ struct ColorMatrix
 				   ls, 
 				   Pmu, P3, Qmu, newOprod);
    }
+   count_staple_force<Real>(2 * loop_count, 4 * 198 + 36, 10);
    return;
   }
 
@@ -1074,6 +1101,9 @@ struct ColorMatrix
 #endif
     LoadStore<Real> ls(volume);
 
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
     for(int site=0; site<loop_count; ++site){
       computeSideLinkSite<Real,0>(site, dim,
 			  	  P3, Qprod, link, 
@@ -1082,6 +1112,9 @@ struct ColorMatrix
 			  	  ls, shortP, newOprod);
     }
 
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
     for(int site=0; site<loop_count; ++site){
       computeSideLinkSite<Real,1>(site, dim,
 			  	  P3, Qprod, link, 
@@ -1090,6 +1123,7 @@ struct ColorMatrix
 			  	  ls, shortP, newOprod);
     }
 
+    count_staple_force<Real>(2 * loop_count, 2 * 198 + 2 * 36, 7);
     return;
   }
 
@@ -1213,6 +1247,9 @@ struct ColorMatrix
 #endif
 
     LoadStore<Real> ls(volume);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
     for(int site=0; site<loop_count; ++site){
 
       computeAllLinkSite<Real,0>(site, dim,
@@ -1223,6 +1260,9 @@ struct ColorMatrix
 				  shortP, newOprod);
     }
     
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
     for(int site=0; site<loop_count; ++site){
        computeAllLinkSite<Real, 1>(site, dim,
 				   oprod, Qprev, link,
@@ -1232,6 +1272,7 @@ struct ColorMatrix
 				   shortP, newOprod);
     }
 
+    count_staple_force<Real>(2 * loop_count, 6 * 198 + 3 * 36, 11);
     return;
   }
 
@@ -1384,6 +1425,10 @@ struct ColorMatrix
       for(int i=0; i<6; ++i) tempmat[i] = malloc(len*18*sizeof(float));
     }
 
+    quda::Timer timer;
+    timer.Start(__func__, __FILE__, __LINE__);
+    staple_force_flops = staple_force_bytes = 0.0;
+
     PathCoefficients<double> act_path_coeff;
     act_path_coeff.one    = path_coeff[0];
     act_path_coeff.naik   = path_coeff[1];
@@ -1416,6 +1461,10 @@ struct ColorMatrix
     for(int i=0; i<6; ++i){
       free(tempmat[i]);
     }
+
+    timer.Stop(__func__, __FILE__, __LINE__);
+    printfQuda("HISQ staple force reference: %.3f s, %.2f Gflop/s, %.2f GB/s\n", timer.time,
+               1e-9 * staple_force_flops / timer.time, 1e-9 * staple_force_bytes / timer.time);
     return;
   }
 
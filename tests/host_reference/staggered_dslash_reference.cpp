@@ -12,6 +12,10 @@
 #include "misc.h"
 #include <blas_quda.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
 extern void *memset(void *s, int c, size_t n);
 
 #include <dslash_reference.h>
@@ -28,99 +32,260 @@ template <typename Float> void display_link_internal(Float *link)
   return;
 }
 
+/**
+   Neighbour table for the staggered reference dslash.  For each
+   site, direction and hop length (one-hop fat link, three-hop long
+   link) we store where the neighbouring colour vector and the
+   backwards link live.  The upper bits of each entry encode the
+   buffer (body, or the forwards / backwards ghost zone of a given
+   dimension) and the lower bits the index into that buffer.  Ghost
+   spinor entries hold the un-halved face index, since the source
+   index has to be folded in before checkerboarding.  The tables only
+   depend on the local geometry, partitioning, ghost depth and number
+   of sources, so are built once per parity and reused.
+*/
+class StaggeredNeighborTable
+{
+  static constexpr int src_shift = 28;
+  static constexpr uint32_t idx_mask = (1u << src_shift) - 1;
+
+  int dims[4] = {};
+  int partitioned[4] = {};
+  int nFace = 0;
+  int nSrc = 0;
+  std::vector<uint32_t> table[2];
+
+  void build(int oddBit)
+  {
+    std::vector<uint32_t> &nbr = table[oddBit];
+    nbr.resize(entries * static_cast<size_t>(Vh));
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (int i = 0; i < Vh; i++) {
+      int Y = fullLatticeIndex_5d_4dpc(i, oddBit);
+      const int x[4] = {Y % Z[0], (Y / Z[0]) % Z[1], (Y / (Z[1] * Z[0])) % Z[2], (Y / (Z[2] * Z[1] * Z[0])) % Z[3]};
+
+      for (int dir = 0; dir < 8; dir++) {
+        const int d = dir / 2;
+        const int fwd = dir % 2 == 0;
+
+        for (int hop = 0; hop < 2; hop++) {
+          const int nb = hop == 0 ? 1 : 3;
+          uint32_t *entry = &nbr[i * entries + (dir * 2 + hop) * 2];
+
+          int y[4] = {x[0], x[1], x[2], x[3]};
+          y[d] += fwd ? +nb : -nb;
+
+          if ((y[d] < 0 || y[d] >= Z[d]) && partitioned[d]) {
+            // ghost zones are ordered by depth, then source, then face coordinate
+            const int F = faceVolume[d];
+            const int depth = fwd ? y[d] - Z[d] : y[d] + nFace;
+            int face = 0;
+            for (int e = 3; e >= 0; e--)
+              if (e != d) face = face * Z[e] + x[e];
+
+            entry[0] = ((fwd ? 1 + d : 5 + d) << src_shift) | (depth * nSrc * F + face);
+            // the backwards gauge ghost zone depth matches the hop length
+            entry[1] = fwd ? i : ((nb + y[d]) * F) / 2 + face / 2;
+          } else {
+            y[d] = (y[d] + Z[d]) % Z[d];
+            entry[0] = (((y[3] * Z[2] + y[2]) * Z[1] + y[1]) * Z[0] + y[0]) / 2;
+            entry[1] = fwd ? i : entry[0];
+          }
+        }
+      }
+    }
+  }
+
+public:
+  /** entries per site: 8 directions x 2 hops x (spinor, link) */
+  static constexpr int entries = 8 * 2 * 2;
+
+  static int source(uint32_t entry) { return entry >> src_shift; }
+  static int index(uint32_t entry) { return entry & idx_mask; }
+
+  const uint32_t *get(int oddBit, int nFace_, int nSrc_)
+  {
+    bool stale = nFace != nFace_ || nSrc != nSrc_;
+    nFace = nFace_;
+    nSrc = nSrc_;
+    for (int d = 0; d < 4; d++) {
+#ifdef MULTI_GPU
+      int p = comm_dim_partitioned(d);
+#else
+      int p = 0;
+#endif
+      if (dims[d] != Z[d] || partitioned[d] != p) stale = true;
+      dims[d] = Z[d];
+      partitioned[d] = p;
+    }
+    if (stale) table[0].clear(), table[1].clear();
+    if (static_cast<uint64_t>(3) * nSrc * V > idx_mask) errorQuda("Local volume %d too large for neighbour table", V);
+    if (table[oddBit].empty()) build(oddBit);
+    return table[oddBit].data();
+  }
+};
+
+/**
+   Number of sites processed together by the staggered reference
+   kernel.  Within a block the links and colour vectors are gathered
+   into a structure-of-arrays layout so that the SU(3) matrix-vector
+   products vectorize across sites.
+*/
+constexpr int stag_block = 8;
+
+/**
+   @brief Gather the link for one hop of a block of sites into SoA
+   order, taking the Hermitian conjugate for the backwards hops.
+*/
+template <typename sFloat, typename gFloat>
+inline void gatherLink(sFloat U[3 * 3 * 2][stag_block], gFloat *const link[stag_block], int n, bool dagger)
+{
+  for (int s = 0; s < stag_block; s++) {
+    if (s < n) {
+      for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+          const int src = dagger ? c * 3 + r : r * 3 + c;
+          U[(r * 3 + c) * 2 + 0][s] = link[s][src * 2 + 0];
+          U[(r * 3 + c) * 2 + 1][s] = dagger ? -link[s][src * 2 + 1] : link[s][src * 2 + 1];
+        }
+      }
+    } else {
+      for (int k = 0; k < 3 * 3 * 2; k++) U[k][s] = 0.0;
+    }
+  }
+}
+
+/**
+   @brief Apply the SoA link block to the SoA colour vector block and
+   accumulate the result with the given sign.
+*/
+template <typename sFloat>
+inline void su3MulAccum(sFloat out[3 * 2][stag_block], const sFloat U[3 * 3 * 2][stag_block],
+                        const sFloat v[3 * 2][stag_block], sFloat sign)
+{
+  for (int r = 0; r < 3; r++) {
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+    for (int s = 0; s < stag_block; s++) {
+      sFloat re = 0.0, im = 0.0;
+      for (int c = 0; c < 3; c++) {
+        re += U[(r * 3 + c) * 2 + 0][s] * v[c * 2 + 0][s] - U[(r * 3 + c) * 2 + 1][s] * v[c * 2 + 1][s];
+        im += U[(r * 3 + c) * 2 + 0][s] * v[c * 2 + 1][s] + U[(r * 3 + c) * 2 + 1][s] * v[c * 2 + 0][s];
+      }
+      out[r * 2 + 0][s] += sign * re;
+      out[r * 2 + 1][s] += sign * im;
+    }
+  }
+}
+
 // staggeredDslashReferenece()
 //
 // if oddBit is zero: calculate even parity spinor elements (using odd parity spinor)
 // if oddBit is one:  calculate odd parity spinor elements
 // if daggerBit is zero: perform ordinary dslash operator
 // if daggerBit is one:  perform hermitian conjugate of dslash
+//
+// The fat-link (one-hop) and long-link (three-hop) terms are applied
+// in a single sweep over blocks of sites, threaded over blocks and
+// right-hand sides.  The ghost pointers are only dereferenced for
+// partitioned dimensions so may be null for single-process builds.
+//
+// QUDA is checked against this by staggered_dslash_ctest, i.e., the
+// dslash_improved_staggered-policy* and dslash_naive_staggered-policy*
+// ctest entries.
 template <typename sFloat, typename gFloat>
 void staggeredDslashReference(sFloat *res, gFloat **fatlink, gFloat **longlink, gFloat **ghostFatlink,
                               gFloat **ghostLonglink, sFloat *spinorField, sFloat **fwd_nbr_spinor,
                               sFloat **back_nbr_spinor, int oddBit, int daggerBit, int nSrc, QudaDslashType dslash_type)
 {
-  for (int i = 0; i < Vh * my_spinor_site_size * nSrc; i++) res[i] = 0.0;
+  const bool improved = dslash_type == QUDA_ASQTAD_DSLASH;
+  const int nFace = improved ? 3 : 1;
+
+  static StaggeredNeighborTable neighbors;
+  const uint32_t *nbr = neighbors.get(oddBit, nFace, nSrc);
 
   gFloat *fatlinkEven[4], *fatlinkOdd[4];
   gFloat *longlinkEven[4], *longlinkOdd[4];
-
-#ifdef MULTI_GPU
-  gFloat *ghostFatlinkEven[4], *ghostFatlinkOdd[4];
-  gFloat *ghostLonglinkEven[4], *ghostLonglinkOdd[4];
-#endif
+  gFloat *ghostFatlinkEven[4] = {}, *ghostFatlinkOdd[4] = {};
+  gFloat *ghostLonglinkEven[4] = {}, *ghostLonglinkOdd[4] = {};
 
   for (int dir = 0; dir < 4; dir++) {
     fatlinkEven[dir] = fatlink[dir];
     fatlinkOdd[dir] = fatlink[dir] + Vh * gauge_site_size;
-    longlinkEven[dir] = longlink[dir];
-    longlinkOdd[dir] = longlink[dir] + Vh * gauge_site_size;
+    longlinkEven[dir] = improved ? longlink[dir] : nullptr;
+    longlinkOdd[dir] = improved ? longlink[dir] + Vh * gauge_site_size : nullptr;
 
-#ifdef MULTI_GPU
-    ghostFatlinkEven[dir] = ghostFatlink[dir];
-    ghostFatlinkOdd[dir] = ghostFatlink[dir] + (faceVolume[dir] / 2) * gauge_site_size;
-    ghostLonglinkEven[dir] = ghostLonglink[dir];
-    ghostLonglinkOdd[dir] = ghostLonglink[dir] + 3 * (faceVolume[dir] / 2) * gauge_site_size;
-#endif
+    if (ghostFatlink) {
+      ghostFatlinkEven[dir] = ghostFatlink[dir];
+      ghostFatlinkOdd[dir] = ghostFatlink[dir] + (faceVolume[dir] / 2) * gauge_site_size;
+    }
+    if (improved && ghostLonglink) {
+      ghostLonglinkEven[dir] = ghostLonglink[dir];
+      ghostLonglinkOdd[dir] = ghostLonglink[dir] + 3 * (faceVolume[dir] / 2) * gauge_site_size;
+    }
   }
 
+  const int nBlock = (Vh + stag_block - 1) / stag_block;
+
+#ifdef _OPENMP
+#pragma omp parallel for collapse(2)
+#endif
   for (int xs = 0; xs < nSrc; xs++) {
+    for (int b = 0; b < nBlock; b++) {
+      const int i0 = b * stag_block;
+      const int n = std::min(stag_block, Vh - i0);
 
-    for (int i = 0; i < Vh; i++) {
-      int sid = i + xs * Vh;
-      int offset = my_spinor_site_size * sid;
+      sFloat accum[3 * 2][stag_block] = {};
+      sFloat U[3 * 3 * 2][stag_block];
+      sFloat v[3 * 2][stag_block];
 
       for (int dir = 0; dir < 8; dir++) {
-#ifdef MULTI_GPU
-        const int nFace = dslash_type == QUDA_ASQTAD_DSLASH ? 3 : 1;
-        gFloat *fatlnk
-          = gaugeLink_mg4dir(i, dir, oddBit, fatlinkEven, fatlinkOdd, ghostFatlinkEven, ghostFatlinkOdd, 1, 1);
-        gFloat *longlnk = dslash_type == QUDA_ASQTAD_DSLASH ?
-          gaugeLink_mg4dir(i, dir, oddBit, longlinkEven, longlinkOdd, ghostLonglinkEven, ghostLonglinkOdd, 3, 3) :
-          nullptr;
-        sFloat *first_neighbor_spinor = spinorNeighbor_5d_mgpu<QUDA_4D_PC>(
-          sid, dir, oddBit, spinorField, fwd_nbr_spinor, back_nbr_spinor, 1, nFace, my_spinor_site_size);
-        sFloat *third_neighbor_spinor = dslash_type == QUDA_ASQTAD_DSLASH ?
-          spinorNeighbor_5d_mgpu<QUDA_4D_PC>(sid, dir, oddBit, spinorField, fwd_nbr_spinor, back_nbr_spinor, 3, nFace,
-                                             my_spinor_site_size) :
-          nullptr;
-#else
-        gFloat *fatlnk = gaugeLink(i, dir, oddBit, fatlinkEven, fatlinkOdd, 1);
-        gFloat *longlnk
-          = dslash_type == QUDA_ASQTAD_DSLASH ? gaugeLink(i, dir, oddBit, longlinkEven, longlinkOdd, 3) : nullptr;
-        sFloat *first_neighbor_spinor
-          = spinorNeighbor_5d<QUDA_4D_PC>(sid, dir, oddBit, spinorField, 1, my_spinor_site_size);
-        sFloat *third_neighbor_spinor = dslash_type == QUDA_ASQTAD_DSLASH ?
-          spinorNeighbor_5d<QUDA_4D_PC>(sid, dir, oddBit, spinorField, 3, my_spinor_site_size) :
-          nullptr;
-#endif
-        sFloat gaugedSpinor[my_spinor_site_size];
+        const int d = dir / 2;
+        const bool fwd = dir % 2 == 0;
 
-        if (dir % 2 == 0) {
-          su3Mul(gaugedSpinor, fatlnk, first_neighbor_spinor);
-          sum(&res[offset], &res[offset], gaugedSpinor, my_spinor_site_size);
+        for (int hop = 0; hop < (improved ? 2 : 1); hop++) {
+          gFloat **local = hop == 0 ? (oddBit ? fatlinkOdd : fatlinkEven) : (oddBit ? longlinkOdd : longlinkEven);
+          gFloat **body = hop == 0 ? (oddBit ? fatlinkEven : fatlinkOdd) : (oddBit ? longlinkEven : longlinkOdd);
+          gFloat **ghost
+            = hop == 0 ? (oddBit ? ghostFatlinkEven : ghostFatlinkOdd) : (oddBit ? ghostLonglinkEven : ghostLonglinkOdd);
 
-          if (dslash_type == QUDA_ASQTAD_DSLASH) {
-            su3Mul(gaugedSpinor, longlnk, third_neighbor_spinor);
-            sum(&res[offset], &res[offset], gaugedSpinor, my_spinor_site_size);
-          }
-        } else {
-          su3Tmul(gaugedSpinor, fatlnk, first_neighbor_spinor);
-          if (dslash_type == QUDA_LAPLACE_DSLASH) {
-            sum(&res[offset], &res[offset], gaugedSpinor, my_spinor_site_size);
-          } else {
-            sub(&res[offset], &res[offset], gaugedSpinor, my_spinor_site_size);
-          }
+          gFloat *link[stag_block];
+          for (int s = 0; s < stag_block; s++) {
+            const int i = i0 + std::min(s, n - 1);
+            const uint32_t *entry = &nbr[i * StaggeredNeighborTable::entries + (dir * 2 + hop) * 2];
+            const int src = StaggeredNeighborTable::source(entry[0]);
+            const int j = StaggeredNeighborTable::index(entry[0]);
+
+            sFloat *spinor;
+            if (src == 0) {
+              spinor = spinorField + (j + xs * Vh) * my_spinor_site_size;
+            } else {
+              const int offset = (j + xs * faceVolume[d]) >> 1;
+              spinor = (src <= 4 ? fwd_nbr_spinor[d] : back_nbr_spinor[d]) + offset * my_spinor_site_size;
+            }
+            for (int k = 0; k < 3 * 2; k++) v[k][s] = s < n ? spinor[k] : 0.0;
 
-          if (dslash_type == QUDA_ASQTAD_DSLASH) {
-            su3Tmul(gaugedSpinor, longlnk, third_neighbor_spinor);
-            sub(&res[offset], &res[offset], gaugedSpinor, my_spinor_site_size);
+            if (fwd) link[s] = local[d] + entry[1] * gauge_site_size;
+            else link[s] = (src == 0 ? body[d] : ghost[d]) + entry[1] * gauge_site_size;
           }
+
+          gatherLink(U, link, n, !fwd);
+
+          // the backwards hopping term is subtracted, except for the Laplace operator
+          const sFloat sign = (fwd || (hop == 0 && dslash_type == QUDA_LAPLACE_DSLASH)) ? 1.0 : -1.0;
+          su3MulAccum(accum, U, v, sign);
         }
       }
 
-      if (daggerBit) negx(&res[offset], my_spinor_site_size);
-    } // 4-d volume
-  }   // right-hand-side
+      const sFloat scale = daggerBit ? -1.0 : 1.0;
+      for (int s = 0; s < n; s++)
+        for (int k = 0; k < 3 * 2; k++) res[((i0 + s) + xs * Vh) * my_spinor_site_size + k] = scale * accum[k][s];
+    }
+  }
 }
 
 void staggeredDslash(ColorSpinorField *out, void **fatlink, void **longlink, void **ghost_fatlink,
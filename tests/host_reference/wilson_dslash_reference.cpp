@@ -13,6 +13,9 @@
 #include <dslash_reference.h>
 #include <string.h>
 
+#include <cstdint>
+#include <vector>
+
 using namespace quda;
 
 static const double projector[8][4][4][2] = {
@@ -67,26 +70,86 @@ static const double projector[8][4][4][2] = {
 };
 
 
-// todo pass projector
-template <typename Float>
-void multiplySpinorByDiracProjector(Float *res, int projIdx, Float *spinorIn) {
-  for (int i=0; i<4*3*2; i++) res[i] = 0.0;
-
-  for (int s = 0; s < 4; s++) {
-    for (int t = 0; t < 4; t++) {
-      Float projRe = projector[projIdx][s][t][0];
-      Float projIm = projector[projIdx][s][t][1];
-      
-      for (int m = 0; m < 3; m++) {
-	Float spinorRe = spinorIn[t*(3*2) + m*(2) + 0];
-	Float spinorIm = spinorIn[t*(3*2) + m*(2) + 1];
-	res[s*(3*2) + m*(2) + 0] += projRe*spinorRe - projIm*spinorIm;
-	res[s*(3*2) + m*(2) + 1] += projRe*spinorIm + projIm*spinorRe;
+static const HalfProjector *halfProjectors()
+{
+  static const auto table = extractHalfProjectors<8>(projector);
+  return table.data();
+}
+
+/**
+   Neighbour table for the Wilson reference dslash.  For every site
+   and direction we store where the neighbouring spinor lives: the
+   upper bits encode the buffer (body, or the forwards / backwards
+   ghost zone of a given dimension) and the lower bits the site index
+   into that buffer.  The same entry locates the gauge link for the
+   backwards directions, while the forwards link is always the local
+   one.  The tables depend only on the local geometry and partitioning
+   so are built once per parity and reused across calls.
+*/
+class WilsonNeighborTable
+{
+  static constexpr int src_shift = 28;
+  static constexpr uint32_t idx_mask = (1u << src_shift) - 1;
+
+  int dims[4] = {};
+  int partitioned[4] = {};
+  std::vector<uint32_t> table[2];
+
+  void build(int oddBit)
+  {
+    std::vector<uint32_t> &nbr = table[oddBit];
+    nbr.resize(8 * static_cast<size_t>(Vh));
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (int i = 0; i < Vh; i++) {
+      int Y = fullLatticeIndex(i, oddBit);
+      const int x[4] = {Y % Z[0], (Y / Z[0]) % Z[1], (Y / (Z[1] * Z[0])) % Z[2], Y / (Z[2] * Z[1] * Z[0])};
+
+      for (int dir = 0; dir < 8; dir++) {
+        const int d = dir / 2;
+        const int fwd = dir % 2 == 0;
+        int y[4] = {x[0], x[1], x[2], x[3]};
+        y[d] += fwd ? +1 : -1;
+
+        if ((y[d] < 0 || y[d] >= Z[d]) && partitioned[d]) {
+          // ghost zones are indexed by the checkerboarded face coordinate
+          int face = 0;
+          for (int e = 3; e >= 0; e--)
+            if (e != d) face = face * Z[e] + x[e];
+          nbr[i * 8 + dir] = ((fwd ? 1 + d : 5 + d) << src_shift) | (face / 2);
+        } else {
+          y[d] = (y[d] + Z[d]) % Z[d];
+          nbr[i * 8 + dir] = (((y[3] * Z[2] + y[2]) * Z[1] + y[1]) * Z[0] + y[0]) / 2;
+        }
       }
     }
   }
-}
 
+public:
+  static int source(uint32_t entry) { return entry >> src_shift; }
+  static int index(uint32_t entry) { return entry & idx_mask; }
+
+  const uint32_t *get(int oddBit)
+  {
+    bool stale = false;
+    for (int d = 0; d < 4; d++) {
+#ifdef MULTI_GPU
+      int p = comm_dim_partitioned(d);
+#else
+      int p = 0;
+#endif
+      if (dims[d] != Z[d] || partitioned[d] != p) stale = true;
+      dims[d] = Z[d];
+      partitioned[d] = p;
+    }
+    if (stale) table[0].clear(), table[1].clear();
+    if (Vh > static_cast<int>(idx_mask)) errorQuda("Local volume %d too large for neighbour table", Vh);
+    if (table[oddBit].empty()) build(oddBit);
+    return table[oddBit].data();
+  }
+};
 
 //
 // dslashReference()
@@ -97,87 +160,78 @@ void multiplySpinorByDiracProjector(Float *res, int projIdx, Float *spinorIn) {
 // if daggerBit is zero: perform ordinary dslash operator
 // if daggerBit is one:  perform hermitian conjugate of dslash
 //
-
-#ifndef MULTI_GPU
+// The ghost pointers are only dereferenced for partitioned
+// dimensions, so may be null for single-process builds.
+//
+// QUDA is checked against this by dslash_ctest, e.g., the
+// dslash_wilson-policy*, dslash_clover-* and dslash_twisted-* ctest
+// entries on a 2x4x6x8 lattice.
+//
 
 template <typename sFloat, typename gFloat>
-void dslashReference(sFloat *res, gFloat **gaugeFull, sFloat *spinorField, int oddBit, int daggerBit) {
-  for (int i = 0; i < Vh * my_spinor_site_size; i++) res[i] = 0.0;
+void dslashReference(sFloat *res, gFloat **gaugeFull, gFloat **ghostGauge, sFloat *spinorField, sFloat **fwdSpinor,
+                     sFloat **backSpinor, int oddBit, int daggerBit)
+{
+  static WilsonNeighborTable neighbors;
+  const uint32_t *nbr = neighbors.get(oddBit);
+  const HalfProjector *half = halfProjectors();
 
   gFloat *gaugeEven[4], *gaugeOdd[4];
-  for (int dir = 0; dir < 4; dir++) {  
+  gFloat *ghostGaugeEven[4] = {}, *ghostGaugeOdd[4] = {};
+  for (int dir = 0; dir < 4; dir++) {
     gaugeEven[dir] = gaugeFull[dir];
     gaugeOdd[dir] = gaugeFull[dir] + Vh * gauge_site_size;
-  }
-  
-  for (int i = 0; i < Vh; i++) {
-    for (int dir = 0; dir < 8; dir++) {
-      gFloat *gauge = gaugeLink(i, dir, oddBit, gaugeEven, gaugeOdd, 1);
-      sFloat *spinor = spinorNeighbor(i, dir, oddBit, spinorField, 1);
-      
-      sFloat projectedSpinor[4*3*2], gaugedSpinor[4*3*2];
-      int projIdx = 2*(dir/2)+(dir+daggerBit)%2;
-      multiplySpinorByDiracProjector(projectedSpinor, projIdx, spinor);
-      
-      for (int s = 0; s < 4; s++) {
-	if (dir % 2 == 0) su3Mul(&gaugedSpinor[s*(3*2)], gauge, &projectedSpinor[s*(3*2)]);
-	else su3Tmul(&gaugedSpinor[s*(3*2)], gauge, &projectedSpinor[s*(3*2)]);
-      }
-      
-      sum(&res[i*(4*3*2)], &res[i*(4*3*2)], gaugedSpinor, 4*3*2);
+
+    if (ghostGauge) {
+      ghostGaugeEven[dir] = ghostGauge[dir];
+      ghostGaugeOdd[dir] = ghostGauge[dir] + (faceVolume[dir] / 2) * gauge_site_size;
     }
   }
-}
-
-#else
-
-template <typename sFloat, typename gFloat>
-void dslashReference(sFloat *res, gFloat **gaugeFull,  gFloat **ghostGauge, sFloat *spinorField, 
-		     sFloat **fwdSpinor, sFloat **backSpinor, int oddBit, int daggerBit) {
-  for (int i = 0; i < Vh * my_spinor_site_size; i++) res[i] = 0.0;
 
-  gFloat *gaugeEven[4], *gaugeOdd[4];
-  gFloat *ghostGaugeEven[4], *ghostGaugeOdd[4];
-  for (int dir = 0; dir < 4; dir++) {  
-    gaugeEven[dir] = gaugeFull[dir];
-    gaugeOdd[dir] = gaugeFull[dir] + Vh * gauge_site_size;
-
-    ghostGaugeEven[dir] = ghostGauge[dir];
-    ghostGaugeOdd[dir] = ghostGauge[dir] + (faceVolume[dir] / 2) * gauge_site_size;
-  }
-  
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
   for (int i = 0; i < Vh; i++) {
+    sFloat accum[4 * 3 * 2] = {};
 
     for (int dir = 0; dir < 8; dir++) {
-      gFloat *gauge = gaugeLink_mg4dir(i, dir, oddBit, gaugeEven, gaugeOdd, ghostGaugeEven, ghostGaugeOdd, 1, 1);
-      sFloat *spinor = spinorNeighbor_mg4dir(i, dir, oddBit, spinorField, fwdSpinor, backSpinor, 1, 1);
-
-      sFloat projectedSpinor[my_spinor_site_size], gaugedSpinor[my_spinor_site_size];
-      int projIdx = 2*(dir/2)+(dir+daggerBit)%2;
-      multiplySpinorByDiracProjector(projectedSpinor, projIdx, spinor);
-      
-      for (int s = 0; s < 4; s++) {
-	if (dir % 2 == 0) su3Mul(&gaugedSpinor[s*(3*2)], gauge, &projectedSpinor[s*(3*2)]);
-	else su3Tmul(&gaugedSpinor[s*(3*2)], gauge, &projectedSpinor[s*(3*2)]);
-      }
-      
-      sum(&res[i*(4*3*2)], &res[i*(4*3*2)], gaugedSpinor, 4*3*2);
+      const int d = dir / 2;
+      const uint32_t entry = nbr[i * 8 + dir];
+      const int src = WilsonNeighborTable::source(entry);
+      const int j = WilsonNeighborTable::index(entry);
+
+      sFloat *spinor;
+      if (src == 0) spinor = spinorField + j * my_spinor_site_size;
+      else if (src <= 4) spinor = fwdSpinor[src - 1] + j * my_spinor_site_size;
+      else spinor = backSpinor[src - 5] + j * my_spinor_site_size;
+
+      gFloat *gauge;
+      if (dir % 2 == 0) gauge = (oddBit ? gaugeOdd : gaugeEven)[d] + i * gauge_site_size;
+      else if (src == 0) gauge = (oddBit ? gaugeEven : gaugeOdd)[d] + j * gauge_site_size;
+      else gauge = (oddBit ? ghostGaugeEven : ghostGaugeOdd)[d] + j * gauge_site_size;
+
+      gFloat link[3 * 3 * 2];
+      if (dir % 2 == 0) for (int k = 0; k < 3 * 3 * 2; k++) link[k] = gauge[k];
+      else su3Transpose(link, gauge);
+
+      halfSpinorHop(accum, link, spinor, half[2 * d + (dir + daggerBit) % 2]);
     }
 
+    for (int k = 0; k < 4 * 3 * 2; k++) res[i * (4 * 3 * 2) + k] = accum[k];
   }
 }
 
-#endif
-
 // this actually applies the preconditioned dslash, e.g., D_ee^{-1} D_eo or D_oo^{-1} D_oe
 void wil_dslash(void *out, void **gauge, void *in, int oddBit, int daggerBit,
 		QudaPrecision precision, QudaGaugeParam &gauge_param) {
   
 #ifndef MULTI_GPU  
   if (precision == QUDA_DOUBLE_PRECISION)
-    dslashReference((double*)out, (double**)gauge, (double*)in, oddBit, daggerBit);
+    dslashReference((double *)out, (double **)gauge, (double **)nullptr, (double *)in, (double **)nullptr,
+                    (double **)nullptr, oddBit, daggerBit);
   else
-    dslashReference((float*)out, (float**)gauge, (float*)in, oddBit, daggerBit);
+    dslashReference((float *)out, (float **)gauge, (float **)nullptr, (float *)in, (float **)nullptr,
+                    (float **)nullptr, oddBit, daggerBit);
 #else
 
   GaugeFieldParam gauge_field_param(gauge, gauge_param);
@@ -247,6 +301,9 @@ void twistGamma5(sFloat *out, sFloat *in, const int dagger, const sFloat kappa,
 
   if (dagger) a *= -1.0;
 
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
   for(int i = 0; i < V; i++) {
     sFloat tmp[24];
     for(int s = 0; s < 4; s++)
@@ -373,12 +373,18 @@ int main(int argc, char **argv)
   // Compute performance statistics
   if (Nsrc > 1 && !use_split_grid) performanceStats(time, gflops, iter);
 
-  // Perform host side verification of inversion if requested
+  // Perform host side verification of inversion if requested; the
+  // test fails if any residual misses its tolerance by more than the
+  // margin allowed for the difference between host and QUDA precision
+  const double max_deviation = 10.0;
+  bool pass = true;
   if (verify_results) {
     for (int i = 0; i < Nsrc; i++) {
-      verifyInversion(out[i]->V(), _hp_multi_x[i].data(), in[i]->V(), check->V(), gauge_param, inv_param, gauge, clover,
-                      clover_inv);
+      double deviation = verifyInversion(out[i]->V(), _hp_multi_x[i].data(), in[i]->V(), check->V(), gauge_param,
+                                         inv_param, gauge, clover, clover_inv);
+      if (!(deviation <= max_deviation)) pass = false;
     }
+    if (!pass) printfQuda("Host residual exceeds %g times the solver tolerance\n", max_deviation);
   }
 
   // Clean up memory allocations
@@ -403,5 +409,5 @@ int main(int argc, char **argv)
   endQuda();
   finalizeComms();
 
-  return 0;
+  return pass ? 0 : 1;
 }
@@ -19,7 +19,7 @@
 
 static QudaGaugeFieldOrder gauge_order = QUDA_MILC_GAUGE_ORDER;
 
-static void llfat_test()
+static int llfat_test()
 {
   QudaGaugeParam qudaGaugeParam;
 #ifdef MULTI_GPU
@@ -249,6 +249,7 @@ static void llfat_test()
     }
   }
 
+  int fails = 0;
   if (verify_results) {
     printfQuda("Checking fat links...\n");
     int res=1;
@@ -261,6 +262,7 @@ static void llfat_test()
 		      V, qudaGaugeParam.cpu_prec);
     
     printfQuda("Fat-link test %s\n\n",(1 == res) ? "PASSED" : "FAILED");
+    if (res != 1) fails++;
 
     printfQuda("Checking long links...\n");
     res = 1;
@@ -273,6 +275,7 @@ static void llfat_test()
 		      V, qudaGaugeParam.cpu_prec);
       
     printfQuda("Long-link test %s\n\n",(1 == res) ? "PASSED" : "FAILED");
+    if (res != 1) fails++;
   }
 
   int volume = qudaGaugeParam.X[0]*qudaGaugeParam.X[1]*qudaGaugeParam.X[2]*qudaGaugeParam.X[3];
@@ -313,6 +316,8 @@ static void llfat_test()
   exchange_llfat_cleanup();
 #endif
   endQuda();
+
+  return fails;
 }
 
 static void display_test_info()
@@ -362,8 +367,10 @@ int main(int argc, char **argv)
 
   initComms(argc, argv, gridsize_from_cmdline);
   display_test_info();
-  llfat_test();
+  int fails = llfat_test();
   finalizeComms();
+
+  return fails == 0 ? 0 : 1;
 }
 
 
@@ -0,0 +1,46 @@
+#include <cstdio>
+
+#include <quda_internal.h>
+#include <tune_quda.h>
+#include <comm_quda.h>
+
+/**
+   @file tune_cache_convert.cpp
+
+   Converts a tunecache between the text format (tunecache.tsv) and
+   the binary format (tunecache.bin) read when
+   QUDA_TUNECACHE_BINARY=1, e.g., after a tunecache.tsv was updated
+   by a job that ran without the binary tunecache:
+
+     tune_cache_convert $QUDA_RESOURCE_PATH/tunecache.tsv $QUDA_RESOURCE_PATH/tunecache.bin
+
+   The direction is set by the file extensions.  Files are checked
+   against the version of this build of QUDA.
+ */
+
+using namespace quda;
+
+static int rank_from_coords(const int *coords, void *fdata)
+{
+  auto dims = static_cast<int *>(fdata);
+  int rank = coords[3];
+  for (int i = 2; i >= 0; i--) rank = dims[i] * rank + coords[i];
+  return rank;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc != 3) {
+    fprintf(stderr, "Usage: %s <input tunecache (.tsv or .bin)> <output tunecache (.tsv or .bin)>\n", argv[0]);
+    return 1;
+  }
+
+  int dims[4] = {1, 1, 1, 1};
+  comm_init(4, dims, rank_from_coords, dims);
+  setVerbosity(QUDA_SUMMARIZE);
+
+  convertTuneCache(argv[1], argv[2]);
+
+  comm_finalize();
+  return 0;
+}
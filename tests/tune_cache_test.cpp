@@ -0,0 +1,388 @@
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <quda_internal.h>
+#include <tune_quda.h>
+#include <tune_cache.h>
+#include <tune_cache_binary.h>
+#include <comm_quda.h>
+
+#include <gtest/gtest.h>
+
+/**
+   @file tune_cache_test.cpp
+
+   Tests of the tunecache: the TuneKey digest and the hash index
+   over the entries, the journal written by concurrent
+   processes and its compaction into tunecache.tsv, and the binary
+   tunecache and its conversion from and to the text format.  The
+   cache is saved to a temporary QUDA_RESOURCE_PATH.
+ */
+
+using namespace quda;
+
+static std::string resource_path;
+
+static TuneKey make_key(const char *aux, int i)
+{
+  char volume[TuneKey::volume_n];
+  snprintf(volume, sizeof(volume), "%dx%dx%dx%d", 4 + i % 5, 4 + i % 7, 8, 8 + i);
+  return TuneKey(volume, "tune_cache_test", aux);
+}
+
+static TuneParam make_param(int i, float time)
+{
+  TuneParam param;
+  param.block = dim3(32 * (1 + i % 8), 1 + i % 3, 1);
+  param.grid = dim3(1 + i, 2, 1);
+  param.shared_bytes = 16 * (i % 4);
+  param.aux = make_int4(i, -i, 1, 2);
+  param.time = time;
+  param.comment = "# tune_cache_test\n";
+  return param;
+}
+
+/**
+   @brief Add an entry to the tunecache as the autotuner does, so
+   that it is written by the next saveTuneCache()
+ */
+static void tune(const TuneKey &key, const TuneParam &param)
+{
+  tuneCache()[key] = param;
+  markTuneCacheUnsaved(tuneCache().find(key));
+}
+
+static std::vector<std::string> list_dir(const std::string &path)
+{
+  std::vector<std::string> names;
+  DIR *dir = opendir(path.c_str());
+  if (!dir) return names;
+  while (struct dirent *entry = readdir(dir)) {
+    std::string name(entry->d_name);
+    if (name != "." && name != "..") names.push_back(name);
+  }
+  closedir(dir);
+  return names;
+}
+
+/**
+   @return The number of entries in a tunecache file, i.e., the lines
+   that follow the version, blank and description lines
+ */
+static int count_entries(const std::string &path)
+{
+  std::ifstream file(path.c_str());
+  std::string line;
+  int n = 0;
+  for (int i = 0; getline(file, line); i++)
+    if (i >= 3 && !line.empty()) n++;
+  return n;
+}
+
+static void remove_dir(const std::string &path)
+{
+  for (auto &name : list_dir(path)) {
+    std::string file = path + "/" + name;
+    if (remove(file.c_str())) remove_dir(file);
+  }
+  rmdir(path.c_str());
+}
+
+TEST(tune_key, digest)
+{
+  const TuneKey key("16x16x16x32", "N4quda6KernelE", "policy=1,nParity=2");
+
+  // the digest depends on all three strings, including where one ends and the next begins
+  EXPECT_EQ(key.digest, TuneKey("16x16x16x32", "N4quda6KernelE", "policy=1,nParity=2").digest);
+  EXPECT_NE(key.digest, TuneKey("16x16x16x16", "N4quda6KernelE", "policy=1,nParity=2").digest);
+  EXPECT_NE(key.digest, TuneKey("16x16x16x32", "N4quda7KernelE", "policy=1,nParity=2").digest);
+  EXPECT_NE(key.digest, TuneKey("16x16x16x32", "N4quda6KernelE", "policy=1,nParity=1").digest);
+  EXPECT_NE(TuneKey("ab", "c", "").digest, TuneKey("a", "bc", "").digest);
+
+  // copies keep the digest, and in-place edits are picked up by rehash()
+  TuneKey copy(key);
+  EXPECT_EQ(copy.digest, key.digest);
+  EXPECT_TRUE(copy == key);
+  strcat(copy.aux, ",managed");
+  copy.rehash();
+  EXPECT_EQ(copy.digest, TuneKey(key.volume, key.name, "policy=1,nParity=2,managed").digest);
+  EXPECT_FALSE(copy == key);
+  copy = key;
+  EXPECT_EQ(copy.digest, key.digest);
+
+  // equal digests alone do not make equal keys
+  TuneKey forged(key);
+  strcpy(forged.name, "N4quda6KerneLE");
+  EXPECT_EQ(forged.digest, key.digest);
+  EXPECT_FALSE(forged == key);
+}
+
+TEST(tune_cache, index)
+{
+  const int n = 5000;
+  TuneCache cache;
+  EXPECT_EQ(cache.find(make_key("index", 0)), cache.end());
+
+  // grow through several rebuilds of the index
+  for (int i = 0; i < n; i++) {
+    cache[make_key("index", i)] = make_param(i, 1.0f + i);
+    ASSERT_EQ(cache.size(), static_cast<size_t>(i + 1));
+  }
+  for (int i = 0; i < n; i++) {
+    auto entry = cache.find(make_key("index", i));
+    ASSERT_NE(entry, cache.end()) << "entry " << i;
+    EXPECT_EQ(entry->second.time, 1.0f + i);
+    EXPECT_EQ(entry->second.grid.x, make_param(i, 0.0f).grid.x);
+  }
+  EXPECT_EQ(cache.find(make_key("index", n)), cache.end());
+  EXPECT_EQ(cache.find(make_key("indeX", 0)), cache.end());
+
+  // a key whose digest collides with an entry is not found
+  TuneKey forged = make_key("index", 0);
+  forged.name[0] = 'T';
+  EXPECT_EQ(cache.find(forged), cache.end());
+
+  // overwriting an entry keeps a single copy
+  cache[make_key("index", 7)].time = 0.5f;
+  EXPECT_EQ(cache.size(), static_cast<size_t>(n));
+  EXPECT_EQ(static_cast<const TuneCache &>(cache).find(make_key("index", 7))->second.time, 0.5f);
+
+  // the index holds iterators into the map, so a cache cannot be copied
+  static_assert(!std::is_copy_constructible<TuneCache>::value && !std::is_copy_assignable<TuneCache>::value,
+                "TuneCache must not be copyable");
+
+  // iteration is in the sorted order used when serializing
+  int count = 0;
+  const TuneKey *prev = nullptr;
+  for (auto &entry : cache) {
+    if (prev) EXPECT_TRUE(*prev < entry.first);
+    prev = &entry.first;
+    count++;
+  }
+  EXPECT_EQ(count, n);
+}
+
+TEST(tune_cache, concurrent_journal)
+{
+  const int n_writer = 4;
+  const int n_round = 3;
+  const int n_entry = 20;
+  const TuneKey shared_key = make_key("shared", 0);
+
+  // every writer appends its own entries, and a version of the shared
+  // entry, over several saves that race with the others' compactions
+  std::vector<pid_t> pids;
+  for (int w = 0; w < n_writer; w++) {
+    pid_t pid = fork();
+    ASSERT_NE(pid, -1);
+    if (pid == 0) {
+      char aux[TuneKey::aux_n];
+      snprintf(aux, sizeof(aux), "writer=%d", w);
+      for (int r = 0; r < n_round; r++) {
+        for (int i = 0; i < n_entry; i++) tune(make_key(aux, r * n_entry + i), make_param(i, 1.0f + i));
+        if (r == 0) tune(shared_key, make_param(w, 1.0f + w));
+        saveTuneCache();
+      }
+      _exit(0);
+    }
+    pids.push_back(pid);
+  }
+  for (auto pid : pids) {
+    int status;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  }
+
+  // whatever the outcome of the race, tunecache.tsv and the journal together hold every entry
+  loadTuneCache();
+  for (int w = 0; w < n_writer; w++) {
+    char aux[TuneKey::aux_n];
+    snprintf(aux, sizeof(aux), "writer=%d", w);
+    for (int i = 0; i < n_round * n_entry; i++) {
+      auto entry = tuneCache().find(make_key(aux, i));
+      ASSERT_NE(entry, tuneCache().end()) << aux << " entry " << i;
+      EXPECT_EQ(entry->second.block.x, make_param(i % n_entry, 0.0f).block.x);
+      EXPECT_EQ(entry->second.aux.y, -(i % n_entry));
+    }
+  }
+
+  // of the duplicates, the fastest is kept
+  auto shared = tuneCache().find(shared_key);
+  ASSERT_NE(shared, tuneCache().end());
+  EXPECT_EQ(shared->second.time, 1.0f);
+  EXPECT_EQ(shared->second.aux.x, 0);
+
+  // a save without contention compacts the whole journal
+  tune(make_key("final", 0), make_param(0, 1.0f));
+  saveTuneCache();
+  for (auto &name : list_dir(resource_path + "/tunecache.journal")) ADD_FAILURE() << "segment left: " << name;
+  EXPECT_EQ(count_entries(resource_path + "/tunecache.tsv"), n_writer * n_round * n_entry + 2);
+  for (auto &name : list_dir(resource_path))
+    EXPECT_TRUE(name == "tunecache.tsv" || name == "tunecache.journal") << "unexpected file " << name;
+}
+
+TEST(tune_cache, compaction_lock)
+{
+  const int n_before = count_entries(resource_path + "/tunecache.tsv");
+
+  // while another process holds the lock, the save only appends to the journal
+  const std::string lock_path = resource_path + "/tunecache.lock";
+  std::ofstream(lock_path.c_str()) << "held by tune_cache_test\n";
+  tune(make_key("locked", 0), make_param(0, 2.0f));
+  saveTuneCache();
+  EXPECT_EQ(list_dir(resource_path + "/tunecache.journal").size(), 1u);
+  EXPECT_EQ(count_entries(resource_path + "/tunecache.tsv"), n_before);
+
+  // a lock held while the journal keeps growing is reported as stale
+  const int n_locked = 10;
+  setVerbosity(QUDA_SUMMARIZE);
+  std::string output;
+  for (int i = 1; i < n_locked; i++) {
+    tune(make_key("locked", i), make_param(i, 2.0f));
+    testing::internal::CaptureStdout();
+    saveTuneCache();
+    output = testing::internal::GetCapturedStdout();
+    // the first few segments are the normal back-off of a concurrent compaction
+    if (i < 8) EXPECT_EQ(output.find("stale"), std::string::npos) << "save " << i << ": " << output;
+  }
+  setVerbosity(QUDA_SILENT);
+  EXPECT_EQ(list_dir(resource_path + "/tunecache.journal").size(), static_cast<size_t>(n_locked));
+  EXPECT_NE(output.find("WARNING: " + lock_path + " has been held while 10 tunecache journal segments accumulated"),
+            std::string::npos)
+    << output;
+
+  // and the next save after it is released folds the left-over segments in too
+  remove(lock_path.c_str());
+  tune(make_key("locked", n_locked), make_param(n_locked, 2.0f));
+  saveTuneCache();
+  EXPECT_TRUE(list_dir(resource_path + "/tunecache.journal").empty());
+  EXPECT_EQ(count_entries(resource_path + "/tunecache.tsv"), n_before + n_locked + 1);
+}
+
+/**
+   @return The lines of a tunecache file after the version line, which
+   holds the time it was written
+ */
+static std::vector<std::string> read_lines(const std::string &path)
+{
+  std::ifstream file(path.c_str());
+  std::vector<std::string> lines;
+  std::string line;
+  getline(file, line);
+  while (getline(file, line)) lines.push_back(line);
+  return lines;
+}
+
+TEST(tune_cache, binary)
+{
+  TuneCache cache;
+  for (int i = 0; i < 1000; i++) cache[make_key("binary", i)] = make_param(i, 1.0f + i);
+  const std::string path = resource_path + "/binary_test.bin";
+  ASSERT_TRUE(writeTuneCacheBinary(path, cache, "build_a"));
+
+  TuneCacheBinary binary;
+  EXPECT_FALSE(binary.open(resource_path + "/missing.bin", "build_a"));
+  EXPECT_FALSE(binary.isOpen());
+
+  ASSERT_TRUE(binary.open(path, "build_a"));
+  EXPECT_EQ(binary.size(), cache.size());
+  for (auto &entry : cache) {
+    TuneParam param;
+    ASSERT_TRUE(binary.find(entry.first, param)) << entry.first.volume;
+    EXPECT_EQ(param.block.x, entry.second.block.x);
+    EXPECT_EQ(param.block.y, entry.second.block.y);
+    EXPECT_EQ(param.grid.x, entry.second.grid.x);
+    EXPECT_EQ(param.shared_bytes, entry.second.shared_bytes);
+    EXPECT_EQ(param.aux.y, entry.second.aux.y);
+    EXPECT_EQ(param.time, entry.second.time);
+    EXPECT_EQ(param.comment, entry.second.comment);
+  }
+
+  // keys that differ in any one string are not found
+  TuneParam param;
+  EXPECT_FALSE(binary.find(make_key("binary", 1000), param));
+  EXPECT_FALSE(binary.find(make_key("binary ", 0), param));
+  EXPECT_FALSE(binary.find(TuneKey(make_key("binary", 0).volume, "tune_cache_test_", "binary"), param));
+
+  TuneCache read;
+  binary.read(read);
+  EXPECT_EQ(read.size(), cache.size());
+  binary.close();
+  EXPECT_FALSE(binary.isOpen());
+
+  // an empty build string skips the check, while a different one is fatal
+  EXPECT_TRUE(binary.open(path, ""));
+  binary.close();
+  EXPECT_DEATH(binary.open(path, "build_b"), "");
+}
+
+TEST(tune_cache, convert)
+{
+  for (int i = 0; i < 500; i++) tune(make_key("convert", i), make_param(i, 1.0f + i));
+  saveTuneCache();
+
+  // text to binary: every key of tunecache.tsv can be found in tunecache.bin
+  const std::string text_path = resource_path + "/tunecache.tsv";
+  const std::string binary_path = resource_path + "/convert_test.bin";
+  convertTuneCache(text_path, binary_path);
+
+  TuneCacheBinary binary;
+  ASSERT_TRUE(binary.open(binary_path, ""));
+  const std::vector<std::string> lines = read_lines(text_path);
+  ASSERT_GE(lines.size(), 502u);
+  EXPECT_EQ(binary.size(), lines.size() - 2);
+  for (size_t i = 2; i < lines.size(); i++) {
+    std::stringstream ls(lines[i]);
+    std::string volume, name, aux;
+    ls >> volume >> name >> aux;
+    TuneKey key(volume.c_str(), name.c_str(), aux.c_str());
+    TuneParam param;
+    ASSERT_TRUE(binary.find(key, param)) << lines[i];
+    auto entry = tuneCache().find(key);
+    ASSERT_NE(entry, tuneCache().end()) << lines[i];
+    EXPECT_EQ(param.block.x, entry->second.block.x);
+    EXPECT_EQ(param.time, entry->second.time);
+  }
+  binary.close();
+
+  // and back to text, reproducing the original file
+  const std::string round_trip_path = resource_path + "/convert_test.tsv";
+  convertTuneCache(binary_path, round_trip_path);
+  EXPECT_EQ(read_lines(round_trip_path), lines);
+}
+
+static int rank_from_coords(const int *coords, void *fdata)
+{
+  auto dims = static_cast<int *>(fdata);
+  int rank = coords[3];
+  for (int i = 2; i >= 0; i--) rank = dims[i] * rank + coords[i];
+  return rank;
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+
+  int dims[4] = {1, 1, 1, 1};
+  comm_init(4, dims, rank_from_coords, dims);
+  setVerbosity(QUDA_SILENT);
+
+  char path[] = "/tmp/quda_tune_cache_test.XXXXXX";
+  if (!mkdtemp(path)) errorQuda("Unable to create a temporary resource path");
+  resource_path = path;
+  setenv("QUDA_RESOURCE_PATH", path, 1);
+  loadTuneCache();
+
+  int result = RUN_ALL_TESTS();
+
+  remove_dir(resource_path);
+  comm_finalize();
+  return result;
+}
@@ -333,7 +333,8 @@ namespace
                                                            {"ca-cg", QUDA_CA_CG_INVERTER},
                                                            {"ca-cgne", QUDA_CA_CGNE_INVERTER},
                                                            {"ca-cgnr", QUDA_CA_CGNR_INVERTER},
-                                                           {"ca-gcr", QUDA_CA_GCR_INVERTER}};
+                                                           {"ca-gcr", QUDA_CA_GCR_INVERTER},
+                                                           {"pipelined-cg", QUDA_PIPELINED_CG_INVERTER}};
 
   CLI::TransformPairs<QudaPrecision> precision_map {{"double", QUDA_DOUBLE_PRECISION},
                                                     {"single", QUDA_SINGLE_PRECISION},
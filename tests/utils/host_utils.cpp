@@ -280,12 +280,22 @@ void initComms(int argc, char **argv, int *const commDims)
 
   QudaCommsMap func = rank_order == 0 ? lex_rank_from_coords_t : lex_rank_from_coords_x;
 
+#if !defined(QMP_COMMS)
+  // leave the mapping to the library, which only applies the topology
+  // mapping when no map is given (with QMP the declared logical topology is used)
+  char *topology_env = getenv("QUDA_ENABLE_TOPOLOGY_MAPPING");
+  if (topology_env && strcmp(topology_env, "1") == 0) func = nullptr;
+#endif
+
   initCommsGridQuda(4, commDims, func, NULL);
   initRand();
 
-  printfQuda("Rank order is %s major (%s running fastest)\n",
-	     rank_order == 0 ? "column" : "row", rank_order == 0 ? "t" : "x");
-
+  if (func) {
+    printfQuda("Rank order is %s major (%s running fastest)\n", rank_order == 0 ? "column" : "row",
+               rank_order == 0 ? "t" : "x");
+  } else {
+    printfQuda("Rank order is set by the topology mapping (QUDA_ENABLE_TOPOLOGY_MAPPING=1)\n");
+  }
 }
 
 void finalizeComms()
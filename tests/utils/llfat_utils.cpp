@@ -12,6 +12,7 @@
 
 #include <quda_internal.h>
 #include <complex>
+#include <vector>
 
 #define XUP 0
 #define YUP 1
@@ -20,54 +21,101 @@
 
 using namespace quda;
 
-static int Vs[4];
-static int Vsh[4];
-
-template <typename su3_matrix, typename Real>
-void llfat_compute_gen_staple_field(su3_matrix *staple, int mu, int nu, su3_matrix *mulink, su3_matrix **sitelink,
-                                    void **fatlink, Real coef, int use_staple)
+/**
+   Link accessor for the staple computation on a local lattice with
+   periodic boundary conditions.  The nearest-neighbour tables are
+   built once per fattening and shared by every staple.
+ */
+template <typename su3_matrix> class LocalStapleLinks
 {
-  su3_matrix tmat1, tmat2;
-  int i;
-  su3_matrix *fat1;
-
-  /* Upper staple */
-  /* Computes the staple :
-   *                mu (B)
-   *               +-------+
-   *       nu	   |	   |
-   *	     (A)   |	   |(C)
-   *		   X	   X
-   *
-   * Where the mu link can be any su3_matrix. The result is saved in staple.
-   * if staple==NULL then the result is not saved.
-   * It also adds the computed staple to the fatlink[mu] with weight coef.
-   */
-
-  int dx[4];
-
-  /* upper staple */
-
-  for (i = 0; i < V; i++) {
+  su3_matrix **sitelink;
+  std::vector<int> fwd[4];
+  std::vector<int> back[4];
+
+public:
+  LocalStapleLinks(su3_matrix **sitelink) : sitelink(sitelink)
+  {
+    for (int d = 0; d < 4; d++) {
+      fwd[d].resize(V);
+      back[d].resize(V);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+      for (int i = 0; i < V; i++) {
+        int dx[4] = {0, 0, 0, 0};
+        dx[d] = 1;
+        fwd[d][i] = neighborIndexFullLattice(i, dx[3], dx[2], dx[1], dx[0]);
+        dx[d] = -1;
+        back[d][i] = neighborIndexFullLattice(i, dx[3], dx[2], dx[1], dx[0]);
+      }
+    }
+  }
 
-    fat1 = ((su3_matrix *)fatlink[mu]) + i;
-    su3_matrix *A = sitelink[nu] + i;
+  /**
+     No halo is needed on a local lattice
+   */
+  void exchange(su3_matrix *, int) { }
 
-    memset(dx, 0, sizeof(dx));
-    dx[nu] = 1;
-    int nbr_idx = neighborIndexFullLattice(i, dx[3], dx[2], dx[1], dx[0]);
-    su3_matrix *B;
-    if (use_staple) {
-      B = mulink + nbr_idx;
-    } else {
-      B = mulink + nbr_idx;
-    }
+  /**
+     @brief Return the links A, B, C of the upper staple at site i,
+     A(x) B(x+nu) C^dagger(x+mu), where B is the mu link mulink.  The
+     ghost argument is only used for ghosted lattices.
+   */
+  void upper(int i, int mu, int nu, su3_matrix *mulink, int, su3_matrix *&A, su3_matrix *&B, su3_matrix *&C) const
+  {
+    A = sitelink[nu] + i;
+    B = mulink + fwd[nu][i];
+    C = sitelink[nu] + fwd[mu][i];
+  }
 
-    memset(dx, 0, sizeof(dx));
-    dx[mu] = 1;
-    nbr_idx = neighborIndexFullLattice(i, dx[3], dx[2], dx[1], dx[0]);
-    su3_matrix *C = sitelink[nu] + nbr_idx;
+  /**
+     @brief Return the links A, B, C of the lower staple at site i,
+     A^dagger(x-nu) B(x-nu) C(x-nu+mu)
+   */
+  void lower(int i, int mu, int nu, su3_matrix *mulink, int, su3_matrix *&A, su3_matrix *&B, su3_matrix *&C) const
+  {
+    int j = back[nu][i];
+    A = sitelink[nu] + j;
+    B = mulink + j;
+    C = sitelink[nu] + fwd[mu][j];
+  }
+};
+
+/**
+   @brief Compute the upper and lower staples in the mu-nu plane
+   with the mu link taken from mulink, for all sites in a single
+   sweep.  Computes the staples:
+
+                  mu (B)
+                 +-------+
+         nu      |       |
+             (A) |       |(C)
+                 X       X
+
+                 X       X
+         nu      |       |
+             (A) |       |(C)
+                 +-------+
+                  mu (B)
+
+   If staple is non-null the sum of the two is saved there and then
+   added to fatlink[mu] with weight coef, else both are added to the
+   fatlink directly.  ghost identifies the halo of mulink on ghosted
+   lattices (-1 when mulink is the gauge field itself).
+*/
+template <typename su3_matrix, typename Real, typename Links>
+void llfat_compute_gen_staple_field(su3_matrix *staple, int mu, int nu, su3_matrix *mulink, int ghost,
+                                    const Links &links, void **fatlink, Real coef)
+{
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (int i = 0; i < V; i++) {
+    su3_matrix tmat1, tmat2;
+    su3_matrix *A, *B, *C;
+    su3_matrix *fat1 = ((su3_matrix *)fatlink[mu]) + i;
 
+    links.upper(i, mu, nu, mulink, ghost, A, B, C);
     llfat_mult_su3_nn(A, B, &tmat1);
 
     if (staple != NULL) { /* Save the staple */
@@ -76,53 +124,19 @@ void llfat_compute_gen_staple_field(su3_matrix *staple, int mu, int nu, su3_matr
       llfat_mult_su3_na(&tmat1, C, &tmat2);
       llfat_scalar_mult_add_su3_matrix(fat1, &tmat2, coef, fat1);
     }
-  }
-  /***************lower staple****************
-   *
-   *               X       X
-   *       nu	   |	   |
-   *	     (A)   |       |(C)
-   *		   +-------+
-   *                mu (B)
-   *
-   *********************************************/
-
-  for (i = 0; i < V; i++) {
-
-    fat1 = ((su3_matrix *)fatlink[mu]) + i;
-    memset(dx, 0, sizeof(dx));
-    dx[nu] = -1;
-    int nbr_idx = neighborIndexFullLattice(i, dx[3], dx[2], dx[1], dx[0]);
-    if (nbr_idx >= V || nbr_idx < 0) {
-      fprintf(stderr, "ERROR: invliad nbr_idx(%d), line=%d\n", nbr_idx, __LINE__);
-      exit(1);
-    }
-    su3_matrix *A = sitelink[nu] + nbr_idx;
-
-    su3_matrix *B;
-    if (use_staple) {
-      B = mulink + nbr_idx;
-    } else {
-      B = mulink + nbr_idx;
-    }
-
-    memset(dx, 0, sizeof(dx));
-    dx[mu] = 1;
-    nbr_idx = neighborIndexFullLattice(nbr_idx, dx[3], dx[2], dx[1], dx[0]);
-    su3_matrix *C = sitelink[nu] + nbr_idx;
 
+    links.lower(i, mu, nu, mulink, ghost, A, B, C);
     llfat_mult_su3_an(A, B, &tmat1);
     llfat_mult_su3_nn(&tmat1, C, &tmat2);
 
     if (staple != NULL) { /* Save the staple */
       llfat_add_su3_matrix(&staple[i], &tmat2, &staple[i]);
       llfat_scalar_mult_add_su3_matrix(fat1, &staple[i], coef, fat1);
-
     } else { /* No need to save the staple. Add it to the fatlinks */
       llfat_scalar_mult_add_su3_matrix(fat1, &tmat2, coef, fat1);
     }
   }
-} /* compute_gen_staple_site */
+}
 
 /*  Optimized fattening code for the Asq and Asqtad actions.
  *  I assume that:
@@ -133,21 +147,16 @@ void llfat_compute_gen_staple_field(su3_matrix *staple, int mu, int nu, su3_matr
  *  path 5 the Lapage term.
  *  Path 1 is the Naik term
  *
+ *  The lattice geometry (local or ghosted) is abstracted by links,
+ *  which also exchanges the halos of the intermediate staples.  The
+ *  3-staple in each (dir, nu) plane is computed once and reused by the
+ *  Lepage term and by every 5- and 7-staple built on it.
  */
-template <typename su3_matrix, typename Float>
-void llfat_cpu(void **fatlink, su3_matrix **sitelink, Float *act_path_coeff)
+template <typename su3_matrix, typename Float, typename Links>
+void llfat_cpu(void **fatlink, su3_matrix **sitelink, Links &links, Float *act_path_coeff)
 {
-  su3_matrix *staple = (su3_matrix *)malloc(V * sizeof(su3_matrix));
-  if (staple == NULL) {
-    fprintf(stderr, "Error: malloc failed for staple in function %s\n", __FUNCTION__);
-    exit(1);
-  }
-
-  su3_matrix *tempmat1 = (su3_matrix *)malloc(V * sizeof(su3_matrix));
-  if (tempmat1 == NULL) {
-    fprintf(stderr, "ERROR:  malloc failed for tempmat1 in function %s\n", __FUNCTION__);
-    exit(1);
-  }
+  std::vector<su3_matrix> staple(V);
+  std::vector<su3_matrix> tempmat1(V);
 
   // to fix up the Lepage term, included by a trick below
   Float one_link = (act_path_coeff[0] - 6.0 * act_path_coeff[5]);
@@ -155,6 +164,9 @@ void llfat_cpu(void **fatlink, su3_matrix **sitelink, Float *act_path_coeff)
   for (int dir = XUP; dir <= TUP; dir++) {
 
     // Intialize fat links with c_1*U_\mu(x)
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
     for (int i = 0; i < V; i++) {
       su3_matrix *fat1 = ((su3_matrix *)fatlink[dir]) + i;
       llfat_scalar_mult_su3_matrix(sitelink[dir] + i, one_link, fat1);
@@ -164,21 +176,25 @@ void llfat_cpu(void **fatlink, su3_matrix **sitelink, Float *act_path_coeff)
   for (int dir = XUP; dir <= TUP; dir++) {
     for (int nu = XUP; nu <= TUP; nu++) {
       if (nu != dir) {
-        llfat_compute_gen_staple_field(staple, dir, nu, sitelink[dir], sitelink, fatlink, act_path_coeff[2], 0);
+        llfat_compute_gen_staple_field(staple.data(), dir, nu, sitelink[dir], -1, links, fatlink, act_path_coeff[2]);
+        links.exchange(staple.data(), 0);
 
         // The Lepage term
         // Note this also involves modifying c_1 (above)
 
-        llfat_compute_gen_staple_field((su3_matrix *)NULL, dir, nu, staple, sitelink, fatlink, act_path_coeff[5], 1);
+        llfat_compute_gen_staple_field((su3_matrix *)NULL, dir, nu, staple.data(), 0, links, fatlink,
+                                       act_path_coeff[5]);
 
         for (int rho = XUP; rho <= TUP; rho++) {
           if ((rho != dir) && (rho != nu)) {
-            llfat_compute_gen_staple_field(tempmat1, dir, rho, staple, sitelink, fatlink, act_path_coeff[3], 1);
+            llfat_compute_gen_staple_field(tempmat1.data(), dir, rho, staple.data(), 0, links, fatlink,
+                                           act_path_coeff[3]);
+            links.exchange(tempmat1.data(), 1);
 
             for (int sig = XUP; sig <= TUP; sig++) {
               if ((sig != dir) && (sig != nu) && (sig != rho)) {
-                llfat_compute_gen_staple_field((su3_matrix *)NULL, dir, sig, tempmat1, sitelink, fatlink,
-                                               act_path_coeff[4], 1);
+                llfat_compute_gen_staple_field((su3_matrix *)NULL, dir, sig, tempmat1.data(), 1, links, fatlink,
+                                               act_path_coeff[4]);
               }
             } // sig
           }
@@ -186,32 +202,21 @@ void llfat_cpu(void **fatlink, su3_matrix **sitelink, Float *act_path_coeff)
       }
     } // nu
   }   // dir
-
-  free(staple);
-  free(tempmat1);
 }
 
 void llfat_reference(void **fatlink, void **sitelink, QudaPrecision prec, void *act_path_coeff)
 {
-  Vs[0] = Vs_x;
-  Vs[1] = Vs_y;
-  Vs[2] = Vs_z;
-  Vs[3] = Vs_t;
-
-  Vsh[0] = Vsh_x;
-  Vsh[1] = Vsh_y;
-  Vsh[2] = Vsh_z;
-  Vsh[3] = Vsh_t;
-
   switch (prec) {
-  case QUDA_DOUBLE_PRECISION:
-    llfat_cpu((void **)fatlink, (su3_matrix<double> **)sitelink, (double *)act_path_coeff);
+  case QUDA_DOUBLE_PRECISION: {
+    LocalStapleLinks<su3_matrix<double>> links((su3_matrix<double> **)sitelink);
+    llfat_cpu((void **)fatlink, (su3_matrix<double> **)sitelink, links, (double *)act_path_coeff);
     break;
-
-  case QUDA_SINGLE_PRECISION:
-    llfat_cpu((void **)fatlink, (su3_matrix<float> **)sitelink, (float *)act_path_coeff);
+  }
+  case QUDA_SINGLE_PRECISION: {
+    LocalStapleLinks<su3_matrix<float>> links((su3_matrix<float> **)sitelink);
+    llfat_cpu((void **)fatlink, (su3_matrix<float> **)sitelink, links, (float *)act_path_coeff);
     break;
-
+  }
   default:
     fprintf(stderr, "ERROR: unsupported precision(%d)\n", prec);
     exit(1);
@@ -222,196 +227,158 @@ void llfat_reference(void **fatlink, void **sitelink, QudaPrecision prec, void *
 
 #ifdef MULTI_GPU
 
-template <typename su3_matrix, typename Real>
-void llfat_compute_gen_staple_field_mg(su3_matrix *staple, int mu, int nu, su3_matrix *mulink,
-                                       su3_matrix **ghost_mulink, su3_matrix **sitelink, su3_matrix **ghost_sitelink,
-                                       su3_matrix **ghost_sitelink_diag, void **fatlink, Real coef, int use_staple)
-{
-  su3_matrix tmat1, tmat2;
-  int i;
-  su3_matrix *fat1;
-
-  int X1 = Z[0];
-  int X2 = Z[1];
-  int X3 = Z[2];
-  // int X4 = Z[3];
-  int X1h = X1 / 2;
-
-  int X2X1 = X1 * X2;
-  int X3X2 = X3 * X2;
-  int X3X1 = X3 * X1;
-
-  /* Upper staple */
-  /* Computes the staple :
-   *                mu (B)
-   *               +-------+
-   *       nu	   |	   |
-   *	     (A)   |	   |(C)
-   *		   X	   X
-   *
-   * Where the mu link can be any su3_matrix. The result is saved in staple.
-   * if staple==NULL then the result is not saved.
-   * It also adds the computed staple to the fatlink[mu] with weight coef.
-   */
-
-  int dx[4];
+static int Vs[4];
+static int Vsh[4];
 
-  // upper staple
+/**
+   Link accessor for the staple computation on a partitioned lattice.
+   Links and staples that fall outside the local volume are read from
+   the face ghost zones, and the link across the corner of the lower
+   staple from the diagonal ghost zone.  The halos of the intermediate
+   staples are held here and filled by exchange().
+ */
+template <typename su3_matrix> class GhostStapleLinks
+{
+  su3_matrix **sitelink;
+  su3_matrix **ghost_sitelink;
+  su3_matrix **ghost_sitelink_diag;
+  su3_matrix *ghost_staple[2][4];
+  QudaPrecision prec;
 
-  for (i = 0; i < V; i++) {
+  struct Coords {
+    int oddBit;
+    int x[4];
+    int space_con[4];
+  };
+
+  static void space_con(const int x[4], int con[4])
+  {
+    int X1 = Z[0], X2 = Z[1], X3 = Z[2];
+    con[0] = (x[3] * X3 * X2 + x[2] * X2 + x[1]) / 2;
+    con[1] = (x[3] * X3 * X1 + x[2] * X1 + x[0]) / 2;
+    con[2] = (x[3] * X2 * X1 + x[1] * X1 + x[0]) / 2;
+    con[3] = (x[2] * X2 * X1 + x[1] * X1 + x[0]) / 2;
+  }
 
+  static Coords coords(int i)
+  {
+    Coords c;
     int half_index = i;
-    int oddBit = 0;
+    c.oddBit = 0;
     if (i >= Vh) {
-      oddBit = 1;
+      c.oddBit = 1;
       half_index = i - Vh;
     }
-    // int x4 = x4_from_full_index(i);
-
-    int sid = half_index;
-    int za = sid / X1h;
-    int x1h = sid - za * X1h;
-    int zb = za / X2;
-    int x2 = za - zb * X2;
-    int x4 = zb / X3;
-    int x3 = zb - x4 * X3;
-    int x1odd = (x2 + x3 + x4 + oddBit) & 1;
-    int x1 = 2 * x1h + x1odd;
-    int x[4] = {x1, x2, x3, x4};
-    int space_con[4] = {(x4 * X3X2 + x3 * X2 + x2) / 2, (x4 * X3X1 + x3 * X1 + x1) / 2, (x4 * X2X1 + x2 * X1 + x1) / 2,
-                        (x3 * X2X1 + x2 * X1 + x1) / 2};
-
-    fat1 = ((su3_matrix *)fatlink[mu]) + i;
-    su3_matrix *A = sitelink[nu] + i;
-
-    memset(dx, 0, sizeof(dx));
-    dx[nu] = 1;
-    int nbr_idx;
-
-    su3_matrix *B;
-    if (use_staple) {
-      if (x[nu] + dx[nu] >= Z[nu]) {
-        B = ghost_mulink[nu] + Vs[nu] + (1 - oddBit) * Vsh[nu] + space_con[nu];
-      } else {
-        nbr_idx = neighborIndexFullLattice_mg(i, dx[3], dx[2], dx[1], dx[0]);
-        B = mulink + nbr_idx;
-      }
-    } else {
-      if (x[nu] + dx[nu] >= Z[nu]) { // out of boundary, use ghost data
-        B = ghost_sitelink[nu] + 4 * Vs[nu] + mu * Vs[nu] + (1 - oddBit) * Vsh[nu] + space_con[nu];
-      } else {
-        nbr_idx = neighborIndexFullLattice_mg(i, dx[3], dx[2], dx[1], dx[0]);
-        B = sitelink[mu] + nbr_idx;
-      }
-    }
 
-    // we could be in the ghost link area if mu is T and we are at high T boundary
-    su3_matrix *C;
-    memset(dx, 0, sizeof(dx));
-    dx[mu] = 1;
-    if (x[mu] + dx[mu] >= Z[mu]) { // out of boundary, use ghost data
-      C = ghost_sitelink[mu] + 4 * Vs[mu] + nu * Vs[mu] + (1 - oddBit) * Vsh[mu] + space_con[mu];
-    } else {
-      nbr_idx = neighborIndexFullLattice_mg(i, dx[3], dx[2], dx[1], dx[0]);
-      C = sitelink[nu] + nbr_idx;
-    }
+    int X1h = Z[0] / 2;
+    int za = half_index / X1h;
+    int x1h = half_index - za * X1h;
+    int zb = za / Z[1];
+    c.x[1] = za - zb * Z[1];
+    c.x[3] = zb / Z[2];
+    c.x[2] = zb - c.x[3] * Z[2];
+    int x1odd = (c.x[1] + c.x[2] + c.x[3] + c.oddBit) & 1;
+    c.x[0] = 2 * x1h + x1odd;
+    space_con(c.x, c.space_con);
+    return c;
+  }
 
-    llfat_mult_su3_nn(A, B, &tmat1);
+  /**
+     @brief Return the backward (dir == 0) or forward (dir == 1) face
+     ghost zone in dimension d holding the mu link mulink.
+   */
+  su3_matrix *ghost_mulink(int d, int dir, int mu, int ghost) const
+  {
+    if (ghost < 0)
+      return ghost_sitelink[d] + (dir ? 4 * Vs[d] : 0) + mu * Vs[d];
+    else
+      return ghost_staple[ghost][d] + (dir ? Vs[d] : 0);
+  }
 
-    if (staple != NULL) { /* Save the staple */
-      llfat_mult_su3_na(&tmat1, C, &staple[i]);
-    } else { /* No need to save the staple. Add it to the fatlinks */
-      llfat_mult_su3_na(&tmat1, C, &tmat2);
-      llfat_scalar_mult_add_su3_matrix(fat1, &tmat2, coef, fat1);
+public:
+  GhostStapleLinks(su3_matrix **sitelink, su3_matrix **ghost_sitelink, su3_matrix **ghost_sitelink_diag,
+                   QudaPrecision prec) :
+    sitelink(sitelink), ghost_sitelink(ghost_sitelink), ghost_sitelink_diag(ghost_sitelink_diag), prec(prec)
+  {
+    for (int g = 0; g < 2; g++) {
+      for (int d = 0; d < 4; d++) {
+        ghost_staple[g][d] = (su3_matrix *)malloc(2 * Vs[d] * sizeof(su3_matrix));
+        if (ghost_staple[g][d] == NULL) {
+          fprintf(stderr, "Error: malloc failed for ghost staple in function %s\n", __FUNCTION__);
+          exit(1);
+        }
+      }
     }
   }
-  /***************lower staple****************
-   *
-   *               X       X
-   *       nu	   |	   |
-   *	     (A)   |       |(C)
-   *		   +-------+
-   *                mu (B)
-   *
-   *********************************************/
-
-  for (i = 0; i < V; i++) {
 
-    int half_index = i;
-    int oddBit = 0;
-    if (i >= Vh) {
-      oddBit = 1;
-      half_index = i - Vh;
-    }
+  ~GhostStapleLinks()
+  {
+    for (int g = 0; g < 2; g++)
+      for (int d = 0; d < 4; d++) free(ghost_staple[g][d]);
+  }
 
-    int sid = half_index;
-    int za = sid / X1h;
-    int x1h = sid - za * X1h;
-    int zb = za / X2;
-    int x2 = za - zb * X2;
-    int x4 = zb / X3;
-    int x3 = zb - x4 * X3;
-    int x1odd = (x2 + x3 + x4 + oddBit) & 1;
-    int x1 = 2 * x1h + x1odd;
-    int x[4] = {x1, x2, x3, x4};
-    int space_con[4] = {(x4 * X3X2 + x3 * X2 + x2) / 2, (x4 * X3X1 + x3 * X1 + x1) / 2, (x4 * X2X1 + x2 * X1 + x1) / 2,
-                        (x3 * X2X1 + x2 * X1 + x1) / 2};
+  /**
+     @brief Fill ghost zone buffer ghost with the halo of staple
+   */
+  void exchange(su3_matrix *staple, int ghost)
+  {
+    exchange_cpu_staple(Z, staple, (void **)ghost_staple[ghost], prec);
+  }
 
-    // int x4 = x4_from_full_index(i);
+  void upper(int i, int mu, int nu, su3_matrix *mulink, int ghost, su3_matrix *&A, su3_matrix *&B,
+             su3_matrix *&C) const
+  {
+    Coords c = coords(i);
+    int dx[4] = {0, 0, 0, 0};
 
-    fat1 = ((su3_matrix *)fatlink[mu]) + i;
+    A = sitelink[nu] + i;
 
-    // we could be in the ghost link area if nu is T and we are at low T boundary
-    su3_matrix *A;
-    memset(dx, 0, sizeof(dx));
-    dx[nu] = -1;
+    dx[nu] = 1;
+    if (c.x[nu] + dx[nu] >= Z[nu]) { // out of boundary, use ghost data
+      B = ghost_mulink(nu, 1, mu, ghost) + (1 - c.oddBit) * Vsh[nu] + c.space_con[nu];
+    } else {
+      B = mulink + neighborIndexFullLattice_mg(i, dx[3], dx[2], dx[1], dx[0]);
+    }
 
-    int nbr_idx;
-    if (x[nu] + dx[nu] < 0) { // out of boundary, use ghost data
-      A = ghost_sitelink[nu] + nu * Vs[nu] + (1 - oddBit) * Vsh[nu] + space_con[nu];
+    // we could be in the ghost link area if mu is T and we are at high T boundary
+    dx[nu] = 0;
+    dx[mu] = 1;
+    if (c.x[mu] + dx[mu] >= Z[mu]) { // out of boundary, use ghost data
+      C = ghost_sitelink[mu] + 4 * Vs[mu] + nu * Vs[mu] + (1 - c.oddBit) * Vsh[mu] + c.space_con[mu];
     } else {
-      nbr_idx = neighborIndexFullLattice_mg(i, dx[3], dx[2], dx[1], dx[0]);
-      A = sitelink[nu] + nbr_idx;
+      C = sitelink[nu] + neighborIndexFullLattice_mg(i, dx[3], dx[2], dx[1], dx[0]);
     }
+  }
 
-    su3_matrix *B;
-    if (use_staple) {
-      nbr_idx = neighborIndexFullLattice_mg(i, dx[3], dx[2], dx[1], dx[0]);
-      if (x[nu] + dx[nu] < 0) {
-        B = ghost_mulink[nu] + (1 - oddBit) * Vsh[nu] + space_con[nu];
-      } else {
-        B = mulink + nbr_idx;
-      }
+  void lower(int i, int mu, int nu, su3_matrix *mulink, int ghost, su3_matrix *&A, su3_matrix *&B,
+             su3_matrix *&C) const
+  {
+    Coords c = coords(i);
+    int dx[4] = {0, 0, 0, 0};
+
+    // we could be in the ghost link area if nu is T and we are at low T boundary
+    dx[nu] = -1;
+    if (c.x[nu] + dx[nu] < 0) { // out of boundary, use ghost data
+      A = ghost_sitelink[nu] + nu * Vs[nu] + (1 - c.oddBit) * Vsh[nu] + c.space_con[nu];
+      B = ghost_mulink(nu, 0, mu, ghost) + (1 - c.oddBit) * Vsh[nu] + c.space_con[nu];
     } else {
-      if (x[nu] + dx[nu] < 0) { // out of boundary, use ghost data
-        B = ghost_sitelink[nu] + mu * Vs[nu] + (1 - oddBit) * Vsh[nu] + space_con[nu];
-      } else {
-        nbr_idx = neighborIndexFullLattice_mg(i, dx[3], dx[2], dx[1], dx[0]);
-        B = sitelink[mu] + nbr_idx;
-      }
+      int nbr_idx = neighborIndexFullLattice_mg(i, dx[3], dx[2], dx[1], dx[0]);
+      A = sitelink[nu] + nbr_idx;
+      B = mulink + nbr_idx;
     }
 
     // we could be in the ghost link area if nu is T and we are at low T boundary
     // or mu is T and we are on high T boundary
-    su3_matrix *C;
-    memset(dx, 0, sizeof(dx));
-    dx[nu] = -1;
     dx[mu] = 1;
-    nbr_idx = neighborIndexFullLattice_mg(i, dx[3], dx[2], dx[1], dx[0]);
+    int nbr_idx = neighborIndexFullLattice_mg(i, dx[3], dx[2], dx[1], dx[0]);
 
     // space con must be recomputed because we have coodinates change in 2 directions
-    int new_x1, new_x2, new_x3, new_x4;
-    new_x1 = (x[0] + dx[0] + Z[0]) % Z[0];
-    new_x2 = (x[1] + dx[1] + Z[1]) % Z[1];
-    new_x3 = (x[2] + dx[2] + Z[2]) % Z[2];
-    new_x4 = (x[3] + dx[3] + Z[3]) % Z[3];
-    int new_x[4] = {new_x1, new_x2, new_x3, new_x4};
-    space_con[0] = (new_x4 * X3X2 + new_x3 * X2 + new_x2) / 2;
-    space_con[1] = (new_x4 * X3X1 + new_x3 * X1 + new_x1) / 2;
-    space_con[2] = (new_x4 * X2X1 + new_x2 * X1 + new_x1) / 2;
-    space_con[3] = (new_x3 * X2X1 + new_x2 * X1 + new_x1) / 2;
-
-    if ((x[nu] + dx[nu]) < 0 && (x[mu] + dx[mu] >= Z[mu])) {
+    int new_x[4];
+    for (int d = 0; d < 4; d++) new_x[d] = (c.x[d] + dx[d] + Z[d]) % Z[d];
+    int new_con[4];
+    space_con(new_x, new_con);
+
+    if ((c.x[nu] + dx[nu]) < 0 && (c.x[mu] + dx[mu] >= Z[mu])) {
       // find the other 2 directions, dir1, dir2
       // with dir2 the slowest changing direction
       int dir1, dir2; // other two dimensions
@@ -421,122 +388,16 @@ void llfat_compute_gen_staple_field_mg(su3_matrix *staple, int mu, int nu, su3_m
       for (dir2 = 0; dir2 < 4; dir2++) {
         if (dir2 != nu && dir2 != mu && dir2 != dir1) { break; }
       }
-      C = ghost_sitelink_diag[nu * 4 + mu] + oddBit * Z[dir1] * Z[dir2] / 2 + (new_x[dir2] * Z[dir1] + new_x[dir1]) / 2;
-    } else if (x[nu] + dx[nu] < 0) {
-      C = ghost_sitelink[nu] + nu * Vs[nu] + oddBit * Vsh[nu] + space_con[nu];
-    } else if (x[mu] + dx[mu] >= Z[mu]) {
-      C = ghost_sitelink[mu] + 4 * Vs[mu] + nu * Vs[mu] + oddBit * Vsh[mu] + space_con[mu];
+      C = ghost_sitelink_diag[nu * 4 + mu] + c.oddBit * Z[dir1] * Z[dir2] / 2 + (new_x[dir2] * Z[dir1] + new_x[dir1]) / 2;
+    } else if (c.x[nu] + dx[nu] < 0) {
+      C = ghost_sitelink[nu] + nu * Vs[nu] + c.oddBit * Vsh[nu] + new_con[nu];
+    } else if (c.x[mu] + dx[mu] >= Z[mu]) {
+      C = ghost_sitelink[mu] + 4 * Vs[mu] + nu * Vs[mu] + c.oddBit * Vsh[mu] + new_con[mu];
     } else {
       C = sitelink[nu] + nbr_idx;
     }
-    llfat_mult_su3_an(A, B, &tmat1);
-    llfat_mult_su3_nn(&tmat1, C, &tmat2);
-
-    if (staple != NULL) { /* Save the staple */
-      llfat_add_su3_matrix(&staple[i], &tmat2, &staple[i]);
-      llfat_scalar_mult_add_su3_matrix(fat1, &staple[i], coef, fat1);
-
-    } else { /* No need to save the staple. Add it to the fatlinks */
-      llfat_scalar_mult_add_su3_matrix(fat1, &tmat2, coef, fat1);
-    }
-  }
-
-} // compute_gen_staple_site
-
-template <typename su3_matrix, typename Float>
-void llfat_cpu_mg(void **fatlink, su3_matrix **sitelink, su3_matrix **ghost_sitelink, su3_matrix **ghost_sitelink_diag,
-                  Float *act_path_coeff)
-{
-  QudaPrecision prec;
-  if (sizeof(Float) == 4) {
-    prec = QUDA_SINGLE_PRECISION;
-  } else {
-    prec = QUDA_DOUBLE_PRECISION;
   }
-
-  su3_matrix *staple = (su3_matrix *)malloc(V * sizeof(su3_matrix));
-  if (staple == NULL) {
-    fprintf(stderr, "Error: malloc failed for staple in function %s\n", __FUNCTION__);
-    exit(1);
-  }
-
-  su3_matrix *ghost_staple[4];
-  su3_matrix *ghost_staple1[4];
-
-  for (int i = 0; i < 4; i++) {
-    ghost_staple[i] = (su3_matrix *)malloc(2 * Vs[i] * sizeof(su3_matrix));
-    if (ghost_staple[i] == NULL) {
-      fprintf(stderr, "Error: malloc failed for ghost staple in function %s\n", __FUNCTION__);
-      exit(1);
-    }
-
-    ghost_staple1[i] = (su3_matrix *)malloc(2 * Vs[i] * sizeof(su3_matrix));
-    if (ghost_staple1[i] == NULL) {
-      fprintf(stderr, "Error: malloc failed for ghost staple1 in function %s\n", __FUNCTION__);
-      exit(1);
-    }
-  }
-
-  su3_matrix *tempmat1 = (su3_matrix *)malloc(V * sizeof(su3_matrix));
-  if (tempmat1 == NULL) {
-    fprintf(stderr, "ERROR:  malloc failed for tempmat1 in function %s\n", __FUNCTION__);
-    exit(1);
-  }
-
-  // to fix up the Lepage term, included by a trick below
-  Float one_link = (act_path_coeff[0] - 6.0 * act_path_coeff[5]);
-
-  for (int dir = XUP; dir <= TUP; dir++) {
-
-    // Intialize fat links with c_1*U_\mu(x)
-    for (int i = 0; i < V; i++) {
-      su3_matrix *fat1 = ((su3_matrix *)fatlink[dir]) + i;
-      llfat_scalar_mult_su3_matrix(sitelink[dir] + i, one_link, fat1);
-    }
-  }
-
-  for (int dir = XUP; dir <= TUP; dir++) {
-    for (int nu = XUP; nu <= TUP; nu++) {
-      if (nu != dir) {
-        llfat_compute_gen_staple_field_mg(staple, dir, nu, sitelink[dir], (su3_matrix **)NULL, sitelink, ghost_sitelink,
-                                          ghost_sitelink_diag, fatlink, act_path_coeff[2], 0);
-        // The Lepage term */
-        // Note this also involves modifying c_1 (above)
-
-        exchange_cpu_staple(Z, staple, (void **)ghost_staple, prec);
-
-        llfat_compute_gen_staple_field_mg((su3_matrix *)NULL, dir, nu, staple, ghost_staple, sitelink, ghost_sitelink,
-                                          ghost_sitelink_diag, fatlink, act_path_coeff[5], 1);
-
-        for (int rho = XUP; rho <= TUP; rho++) {
-          if ((rho != dir) && (rho != nu)) {
-            llfat_compute_gen_staple_field_mg(tempmat1, dir, rho, staple, ghost_staple, sitelink, ghost_sitelink,
-                                              ghost_sitelink_diag, fatlink, act_path_coeff[3], 1);
-
-            exchange_cpu_staple(Z, tempmat1, (void **)ghost_staple1, prec);
-
-            for (int sig = XUP; sig <= TUP; sig++) {
-              if ((sig != dir) && (sig != nu) && (sig != rho)) {
-
-                llfat_compute_gen_staple_field_mg((su3_matrix *)NULL, dir, sig, tempmat1, ghost_staple1, sitelink,
-                                                  ghost_sitelink, ghost_sitelink_diag, fatlink, act_path_coeff[4], 1);
-                // FIXME
-                // return;
-              }
-            } // sig
-          }
-        } // rho
-      }
-    } // nu
-  }   // dir
-
-  free(staple);
-  for (int i = 0; i < 4; i++) {
-    free(ghost_staple[i]);
-    free(ghost_staple1[i]);
-  }
-  free(tempmat1);
-}
+};
 
 void llfat_reference_mg(void **fatlink, void **sitelink, void **ghost_sitelink, void **ghost_sitelink_diag,
                         QudaPrecision prec, void *act_path_coeff)
@@ -553,13 +414,16 @@ void llfat_reference_mg(void **fatlink, void **sitelink, void **ghost_sitelink,
 
   switch (prec) {
   case QUDA_DOUBLE_PRECISION: {
-    llfat_cpu_mg((void **)fatlink, (su3_matrix<double> **)sitelink, (su3_matrix<double> **)ghost_sitelink,
-                 (su3_matrix<double> **)ghost_sitelink_diag, (double *)act_path_coeff);
+    GhostStapleLinks<su3_matrix<double>> links((su3_matrix<double> **)sitelink,
+                                               (su3_matrix<double> **)ghost_sitelink,
+                                               (su3_matrix<double> **)ghost_sitelink_diag, prec);
+    llfat_cpu((void **)fatlink, (su3_matrix<double> **)sitelink, links, (double *)act_path_coeff);
     break;
   }
   case QUDA_SINGLE_PRECISION: {
-    llfat_cpu_mg((void **)fatlink, (su3_matrix<float> **)sitelink, (su3_matrix<float> **)ghost_sitelink,
-                 (su3_matrix<float> **)ghost_sitelink_diag, (float *)act_path_coeff);
+    GhostStapleLinks<su3_matrix<float>> links((su3_matrix<float> **)sitelink, (su3_matrix<float> **)ghost_sitelink,
+                                              (su3_matrix<float> **)ghost_sitelink_diag, prec);
+    llfat_cpu((void **)fatlink, (su3_matrix<float> **)sitelink, links, (float *)act_path_coeff);
     break;
   }
   default: